@@ -1,21 +1,40 @@
-#include <cctype>
 #include <cerrno>
+#include <charconv>
 #include <climits>
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
-#include <locale>
 #include <memory>
-#include <sstream>
 #include <stdexcept>
 #include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "LutCube.h"
 
 namespace timecube {
 namespace {
 
-// 5.3  A line of text shall not be longer than 250 bytes. Lines of text do not contain newline characters.
-constexpr size_t LINE_LEN = 250 + 1 + 1;
+// Binary cache ("<cache_dir>/<hash>.cubebin"): header, title (padded to 4 bytes), LUT entries.
+constexpr char CACHE_MAGIC[8] = { 'T', 'C', 'U', 'B', 'E', 'B', 'I', 'N' };
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr uint32_t CACHE_ENDIAN = 0x01020304;
+
+struct CacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t endian;
+	uint64_t source_size;
+	int64_t source_mtime;
+	uint32_t n;
+	uint32_t is_3d;
+	float domain_min[3];
+	float domain_max[3];
+	uint32_t title_len;
+	uint32_t reserved;
+};
 
 struct FileCloser {
 	void operator()(std::FILE *f) { std::fclose(f); }
@@ -26,99 +45,158 @@ struct FileCloser {
 	throw std::system_error{ errno, std::system_category() };
 }
 
-void read_line(char *buf, FILE *f)
-{
-	do {
-		if (!std::fgets(buf, LINE_LEN, f)) {
-			if (std::feof(f))
+// Read only mapping of an entire file, errno is preserved on failure.
+class MappedFile {
+	void *m_data = MAP_FAILED;
+	size_t m_size = 0;
+	bool m_open = false;
+public:
+	explicit MappedFile(const char *path)
+	{
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0)
+			return;
+
+		struct stat st;
+		if (::fstat(fd, &st) == 0) {
+			m_size = static_cast<size_t>(st.st_size);
+			if (m_size == 0)
+				m_open = true;
+			else if ((m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED)
+				m_open = true;
+		}
+
+		int err = errno;
+		::close(fd);
+		errno = err;
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	~MappedFile()
+	{
+		if (m_data != MAP_FAILED)
+			::munmap(m_data, m_size);
+	}
+
+	bool is_open() const { return m_open; }
+	size_t size() const { return m_size; }
+	const char *begin() const { return m_data == MAP_FAILED ? nullptr : static_cast<const char *>(m_data); }
+	const char *end() const { return begin() + (m_data == MAP_FAILED ? 0 : m_size); }
+};
+
+// Iterates lines in place (no copies). Lines exclude the terminator ("\n" or "\r\n").
+class LineReader {
+	const char *m_pos;
+	const char *m_end;
+public:
+	LineReader(const char *first, const char *last) : m_pos{ first }, m_end{ last } {}
+
+	// Next line which is not empty or a comment.
+	std::pair<const char *, const char *> read_line()
+	{
+		while (true) {
+			if (m_pos == m_end)
 				throw std::runtime_error{ "end of file" };
-			else
-				throw_system_error();
+
+			const char *first = m_pos;
+			const char *last = static_cast<const char *>(std::memchr(first, '\n', m_end - first));
+			m_pos = last ? last + 1 : m_end;
+			if (!last)
+				last = m_end;
+			if (last != first && last[-1] == '\r')
+				--last;
+
+			if (first != last && *first != '#')
+				return{ first, last };
 		}
-	} while (buf[0] == '#' || buf[0] == '\n');
-}
+	}
+};
 
-const char *skip_space(const char *buf)
+const char *skip_space(const char *buf, const char *end)
 {
-	while (*buf && (*buf == ' ' || *buf == '\t')) {
+	while (buf != end && (*buf == ' ' || *buf == '\t')) {
 		++buf;
 	}
 	return buf;
 }
 
 template <class T>
-const char *parse_number(const char *buf, T *dst)
+const char *parse_number(const char *buf, const char *end, T *dst)
 {
 	const char *first = buf;
 
-	while (*buf != '\0' && *buf != ' ' && *buf != '\t' && *buf != '\n') {
+	while (buf != end && *buf != ' ' && *buf != '\t') {
 		++buf;
 	}
 
-	std::istringstream ss{ std::string{ first, buf } };
-	ss.imbue(std::locale::classic());
+	// std::from_chars is locale independent, but does not accept a leading '+'.
+	if (first != buf && *first == '+' && (buf - first) > 1 && first[1] != '-' && first[1] != '+')
+		++first;
 
-	char eof_test;
-	if (!(ss >> *dst) || (ss >> eof_test))
+	std::from_chars_result res = std::from_chars(first, buf, *dst);
+	if (first == buf || res.ec != std::errc{} || res.ptr != buf)
 		throw std::runtime_error{ "invalid number" };
 
 	return buf;
 }
 
-bool is_keyword(const char *buf, const char *keyword)
+bool is_keyword(const char *buf, const char *end, const char *keyword)
 {
 	size_t len = std::strlen(keyword);
-	return !std::strncmp(buf, keyword, len) && (buf[len] == ' ' || buf[len] == '\t' || buf[len] == '\n');
+	return static_cast<size_t>(end - buf) >= len && !std::strncmp(buf, keyword, len) &&
+		(buf + len == end || buf[len] == ' ' || buf[len] == '\t');
 }
 
-std::string parse_title(const char *buf)
+std::string parse_title(const char *buf, const char *end)
 {
 	const char *first;
 
 	buf += std::strlen("TITLE");
-	buf = skip_space(buf);
+	buf = skip_space(buf, end);
 
-	if (*buf++ != '"')
+	if (buf == end || *buf++ != '"')
 		throw std::runtime_error{ "missing opening quote in TITLE" };
 
 	first = buf;
 
-	if (!(buf = std::strchr(buf, '"')))
+	if (!(buf = static_cast<const char *>(std::memchr(buf, '"', end - buf))))
 		throw std::runtime_error{ "missing closing quote in TITLE" };
 
 	return{ first, buf };
 }
 
-void parse_domain_minmax(const char *buf, float dst[3])
+void parse_domain_minmax(const char *buf, const char *end, float dst[3])
 {
 	buf += std::strlen("DOMAIN_MIN");
-	buf = skip_space(buf);
+	buf = skip_space(buf, end);
 
-	buf = parse_number(buf, dst + 0);
-	buf = skip_space(buf);
-	buf = parse_number(buf, dst + 1);
-	buf = skip_space(buf);
-	buf = parse_number(buf, dst + 2);
+	buf = parse_number(buf, end, dst + 0);
+	buf = skip_space(buf, end);
+	buf = parse_number(buf, end, dst + 1);
+	buf = skip_space(buf, end);
+	buf = parse_number(buf, end, dst + 2);
 }
 
-uint_least32_t parse_lut_size(const char *buf)
+uint_least32_t parse_lut_size(const char *buf, const char *end)
 {
 	uint_least32_t n;
 
 	buf += std::strlen("LUT_1D_SIZE");
-	buf = skip_space(buf);
-	buf = parse_number(buf, &n);
+	buf = skip_space(buf, end);
+	buf = parse_number(buf, end, &n);
 
 	return n;
 }
 
-void parse_lut_entry(const char *buf, float dst[3])
+void parse_lut_entry(const char *buf, const char *end, float dst[3])
 {
-	buf = parse_number(buf, dst + 0);
-	buf = skip_space(buf);
-	buf = parse_number(buf, dst + 1);
-	buf = skip_space(buf);
-	buf = parse_number(buf, dst + 2);
+	buf = parse_number(buf, end, dst + 0);
+	buf = skip_space(buf, end);
+	buf = parse_number(buf, end, dst + 1);
+	buf = skip_space(buf, end);
+	buf = parse_number(buf, end, dst + 2);
 }
 
 size_t lut_size(uint_least32_t n, bool is_3d)
@@ -131,6 +209,104 @@ size_t lut_size(uint_least32_t n, bool is_3d)
 	return size;
 }
 
+bool is_valid_size(uint_least32_t n, bool is_3d)
+{
+	return n >= 2 && n <= (is_3d ? 256U : 65536U);
+}
+
+// FNV-1a of the source path and modification time (the header still validates size and mtime).
+std::string cache_file_name(const char *cache_dir, const char *path, const struct stat &source)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	auto mix = [&hash](const void *data, size_t size) {
+		const unsigned char *p = static_cast<const unsigned char *>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= p[i];
+			hash *= 0x100000001b3ULL;
+		}
+	};
+	int64_t mtime = static_cast<int64_t>(source.st_mtime);
+	mix(path, std::strlen(path));
+	mix(&mtime, sizeof(mtime));
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "/%016llx.cubebin", static_cast<unsigned long long>(hash));
+	return std::string{ cache_dir } + name;
+}
+
+size_t cache_title_size(size_t title_len)
+{
+	return (title_len + 3) & ~static_cast<size_t>(3);
+}
+
+// Returns false if the cache is missing, stale or corrupt.
+bool read_cache(const char *cache_path, const struct stat &source, Cube *cube)
+{
+	MappedFile file{ cache_path };
+	if (!file.is_open() || file.size() < sizeof(CacheHeader))
+		return false;
+
+	CacheHeader header;
+	std::memcpy(&header, file.begin(), sizeof(header));
+
+	if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) || header.version != CACHE_VERSION || header.endian != CACHE_ENDIAN)
+		return false;
+	if (header.source_size != static_cast<uint64_t>(source.st_size) || header.source_mtime != static_cast<int64_t>(source.st_mtime))
+		return false;
+	if (!is_valid_size(header.n, header.is_3d != 0))
+		return false;
+
+	size_t size = lut_size(header.n, header.is_3d != 0);
+	size_t title_size = cache_title_size(header.title_len);
+	if (header.title_len > file.size() || file.size() != sizeof(CacheHeader) + title_size + size * 3 * sizeof(float))
+		return false;
+
+	const char *p = file.begin() + sizeof(CacheHeader);
+	cube->title.assign(p, header.title_len);
+	cube->n = header.n;
+	cube->is_3d = header.is_3d != 0;
+	std::memcpy(cube->domain_min, header.domain_min, sizeof(cube->domain_min));
+	std::memcpy(cube->domain_max, header.domain_max, sizeof(cube->domain_max));
+	cube->lut.resize(size * 3);
+	std::memcpy(cube->lut.data(), p + title_size, size * 3 * sizeof(float));
+	return true;
+}
+
+// Best effort, written to a temporary file then renamed (readers never see a partial cache).
+void write_cache(const char *cache_path, const struct stat &source, const Cube &cube)
+{
+	CacheHeader header{};
+	std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.endian = CACHE_ENDIAN;
+	header.source_size = static_cast<uint64_t>(source.st_size);
+	header.source_mtime = static_cast<int64_t>(source.st_mtime);
+	header.n = cube.n;
+	header.is_3d = cube.is_3d;
+	std::memcpy(header.domain_min, cube.domain_min, sizeof(header.domain_min));
+	std::memcpy(header.domain_max, cube.domain_max, sizeof(header.domain_max));
+	header.title_len = static_cast<uint32_t>(cube.title.size());
+
+	std::string tmp_path = std::string{ cache_path } + ".tmp";
+	bool ok;
+	{
+		std::unique_ptr<std::FILE, FileCloser> file_uptr{ std::fopen(tmp_path.c_str(), "wb") };
+		std::FILE *file = file_uptr.get();
+		if (!file)
+			return;
+
+		const char padding[4] = {};
+		ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+		ok = ok && std::fwrite(cube.title.data(), 1, cube.title.size(), file) == cube.title.size();
+		ok = ok && std::fwrite(padding, 1, cache_title_size(cube.title.size()) - cube.title.size(), file) == cache_title_size(cube.title.size()) - cube.title.size();
+		ok = ok && std::fwrite(cube.lut.data(), sizeof(float), cube.lut.size(), file) == cube.lut.size();
+		ok = (std::fclose(file_uptr.release()) == 0) && ok;
+	}
+
+	if (!ok || std::rename(tmp_path.c_str(), cache_path) != 0)
+		std::remove(tmp_path.c_str());
+}
+
 } // namespace
 
 
@@ -138,51 +314,53 @@ Cube read_cube_from_file(const char *path)
 {
 	Cube cube;
 
-	std::unique_ptr<std::FILE, FileCloser> file_uptr{ std::fopen(path, "r") };
-	std::FILE *file = file_uptr.get();
-	char buf[LINE_LEN];
-
-	if (!file)
+	MappedFile file{ path };
+	if (!file.is_open())
 		throw_system_error();
 
+	LineReader reader{ file.begin(), file.end() };
+	std::pair<const char *, const char *> line;
+
 	// Headers.
 	bool has_lut_size = false;
 
 	while (true) {
-		read_line(buf, file);
+		line = reader.read_line();
+		const char *buf = line.first;
+		const char *end = line.second;
 
-		if (is_keyword(buf, "TITLE")) {
+		if (is_keyword(buf, end, "TITLE")) {
 			try {
-				cube.title = parse_title(buf);
+				cube.title = parse_title(buf, end);
 			} catch (...) {
 				// Non-fatal.
 			}
-		} else if (is_keyword(buf, "DOMAIN_MIN")) {
-			parse_domain_minmax(buf, cube.domain_min);
-		} else if (is_keyword(buf, "DOMAIN_MAX")) {
-			parse_domain_minmax(buf, cube.domain_max);
-		} else if (is_keyword(buf, "LUT_1D_SIZE")) {
+		} else if (is_keyword(buf, end, "DOMAIN_MIN")) {
+			parse_domain_minmax(buf, end, cube.domain_min);
+		} else if (is_keyword(buf, end, "DOMAIN_MAX")) {
+			parse_domain_minmax(buf, end, cube.domain_max);
+		} else if (is_keyword(buf, end, "LUT_1D_SIZE")) {
 			if (has_lut_size)
 				throw std::runtime_error{ "duplicate LUT declaration" };
 
-			cube.n = parse_lut_size(buf);
+			cube.n = parse_lut_size(buf, end);
 			cube.is_3d = false;
 			has_lut_size = true;
-		} else if (is_keyword(buf, "LUT_3D_SIZE")) {
+		} else if (is_keyword(buf, end, "LUT_3D_SIZE")) {
 			if (has_lut_size)
 				throw std::runtime_error{ "duplicate LUT declaration" };
 
-			cube.n = parse_lut_size(buf);
+			cube.n = parse_lut_size(buf, end);
 			cube.is_3d = true;
 			has_lut_size = true;
-		} else if (std::isdigit(buf[0], std::locale::classic()) || buf[0] == '+' || buf[0] == '-' || buf[0] == '.') {
+		} else if ((buf[0] >= '0' && buf[0] <= '9') || buf[0] == '+' || buf[0] == '-' || buf[0] == '.') {
 			break;
 		}
 	}
 	if (!has_lut_size)
 		throw std::runtime_error{ "missing LUT declaration" };
 
-	if (cube.n < 2 || cube.n > (cube.is_3d ? 256U : 65536U))
+	if (!is_valid_size(cube.n, cube.is_3d))
 		throw std::runtime_error{ "invalid LUT size" };
 	if (cube.domain_min[0] > cube.domain_max[0] || cube.domain_min[1] > cube.domain_max[1] || cube.domain_min[2] > cube.domain_max[2])
 		throw std::runtime_error{ "invalid domain" };
@@ -190,17 +368,32 @@ Cube read_cube_from_file(const char *path)
 	// LUT.
 	size_t size = lut_size(cube.n, cube.is_3d);
 
-	cube.lut.insert(cube.lut.end(), 3, 0.0f);
-	parse_lut_entry(buf, &*(cube.lut.end() - 3));
-
-	for (unsigned i = 1; i < size; ++i) {
-		read_line(buf, file);
+	cube.lut.resize(size * 3);
+	float *dst = cube.lut.data();
+	parse_lut_entry(line.first, line.second, dst);
 
-		cube.lut.insert(cube.lut.end(), 3, 0.0f);
-		parse_lut_entry(buf, &*(cube.lut.end() - 3));
+	for (size_t i = 1; i < size; ++i) {
+		line = reader.read_line();
+		parse_lut_entry(line.first, line.second, dst + i * 3);
 	}
 
 	return cube;
 }
 
+Cube read_cube_cached(const char *path, const char *cache_dir)
+{
+	struct stat source;
+	if (::stat(path, &source) != 0)
+		throw_system_error();
+
+	std::string cache_path = cache_file_name(cache_dir, path, source);
+	Cube cube;
+	if (read_cache(cache_path.c_str(), source, &cube))
+		return cube;
+
+	cube = read_cube_from_file(path);
+	write_cache(cache_path.c_str(), source, cube);
+	return cube;
+}
+
 } // namespace timecube
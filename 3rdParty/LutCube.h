@@ -28,6 +28,10 @@ struct Cube : public ::timecube_lut {
 
 Cube read_cube_from_file(const char *path);
 
+// Same as read_cube_from_file, but loads a binary copy from cache_dir (written on first parse, named by a hash of path
+// and modification time) if it matches path (size and modification time).  cache_dir must exist, write failures are ignored.
+Cube read_cube_cached(const char *path, const char *cache_dir);
+
 } // namespace timecube
 
 #endif /* TIMECUBE_CUBE_H_ */
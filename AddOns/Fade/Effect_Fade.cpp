@@ -21,6 +21,7 @@
 #include "Editor/LanguageJson.h"
 #include "Editor/Project.h"
 #include "Editor/RenderActor.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Effect_Fade.h"
 
@@ -311,6 +312,33 @@ void Effect_Fade :: RenderEffect(BBitmap *source, MediaEffect *data, int64 frame
 	fRenderNode->Render(0.0f);
 }
 
+/*	FUNCTION:		Effect_Fade :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					data
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect()
+*/
+bool Effect_Fade :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)
+{
+	float t = float(frame_idx - data->mTimelineFrameStart)/float(data->Duration());
+	if (t > 1.0f)
+		t = 1.0f;
+	int index = ((EffectFadeData *)data->mEffectData)->direction;
+	const ymath::YVector4 fade_colour = sFadeColours[index][0] + (sFadeColours[index][1] - sFadeColours[index][0])*t;
+
+	const SoftwareRender::TEXTURE texture(source);
+	render->RenderFragments(destination, [&texture, &fade_colour](const float s, const float t, float fragment[4])
+	{
+		SoftwareRender::Sample(texture, s, t, fragment);
+		for (int c=0; c < 4; c++)
+			fragment[c] *= fade_colour.v[c];
+	});
+	return true;
+}
+
 /*	FUNCTION:		Effect_Fade :: MessageReceived
 	ARGS:			msg
 	RETURN:			n/a
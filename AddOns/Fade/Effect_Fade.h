@@ -44,6 +44,7 @@ public:
 	MediaEffect		*CreateMediaEffect()							override;
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 	
 	void			MessageReceived(BMessage *msg)					override;
 	
@@ -6,6 +6,8 @@
 
 #include <cstdio>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 
 #include <InterfaceKit.h>
 #include <translation/TranslationUtils.h>
@@ -21,6 +23,7 @@
 #include "Editor/LanguageJson.h"
 #include "Editor/Project.h"
 #include "Editor/RenderActor.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Effect_Wipe.h"
 
@@ -501,6 +504,74 @@ void Effect_Wipe :: RenderEffect(BBitmap *source, MediaEffect *effect, int64 fra
 	fRenderNode->Render(0.0f);
 }
 
+/*	FUNCTION:		WipeSmoothStep
+	ARGS:			edge0, edge1
+					x
+	RETURN:			GLSL smoothstep()
+	DESCRIPTION:	Hermite interpolation
+*/
+static inline float WipeSmoothStep(const float edge0, const float edge1, const float x)
+{
+	const float t = std::clamp((x - edge0)/(edge1 - edge0), 0.0f, 1.0f);
+	return t*t*(3.0f - 2.0f*t);
+}
+
+/*	FUNCTION:		Effect_Wipe :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					effect
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect() (see wipe fragment shaders)
+*/
+bool Effect_Wipe :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *effect, int64 frame_idx)
+{
+	if (!effect)
+		return true;
+	EffectWipeData *data = (EffectWipeData *)effect->mEffectData;
+
+	float time = float(frame_idx - effect->mTimelineFrameStart)/float(effect->Duration());
+	if (time > 1.0f)
+		time = 1.0f;
+	const uint32 direction = data->direction;
+	const bool swap = data->swap > 0;
+	const float w = gProject->mResolution.width;
+	const float h = gProject->mResolution.height;
+	const float radius = (h/w)*sqrtf(w*w + h*h)/std::max(w, h);
+
+	const SoftwareRender::TEXTURE texture(source);
+	render->RenderFragments(destination, [&texture, direction, swap, time, radius](const float s, const float t, float fragment[4])
+	{
+		SoftwareRender::Sample(texture, s, t, fragment);
+		const float width = (direction <= 1) ? 0.2f : 0.05f;
+		float choose;
+		switch (direction)
+		{
+			case 0:		//	left right
+				choose = WipeSmoothStep(time - width, time + width, s + width - 2.0f*width*time);
+				break;
+			case 1:		//	right left
+			{
+				const float tr = 1.0f - time;
+				choose = 1.0f - WipeSmoothStep(tr - width, tr + width, s + width - 2.0f*width*tr);
+				break;
+			}
+			case 2:		//	middle out
+				choose = WipeSmoothStep(0.5f*time - width, 0.5f*time + width, fabsf(s - 0.5f) + width - 2.0f*width*time);
+				break;
+			case 3:		//	cross
+				choose = WipeSmoothStep(0.5f*time - width, 0.5f*time + width, std::min(fabsf(s - 0.5f), fabsf(t - 0.5f)) + width - 2.0f*width*time);
+				break;
+			default:	//	circle
+				choose = WipeSmoothStep(time*radius - width, time*radius + width, hypotf(s - 0.5f, t - 0.5f) + width - 2.0f*width*time);
+				break;
+		}
+		fragment[3] = swap ? choose : 1.0f - choose;
+	});
+	return true;
+}
+
 /*	FUNCTION:		Effect_Wipe :: MessageReceived
 	ARGS:			msg
 	RETURN:			n/a
@@ -0,0 +1,135 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Benchmark Editor/ImageScaler.cpp against nearest neighbour point sampling
+ *
+ *	Standalone (not part of the Medo build), from the repository root:
+ *		g++ -std=c++17 -O2 -I. -IEditor Benchmarks/ImageScaler/ImageScaler_Benchmark.cpp Editor/ImageScaler.cpp Editor/ParallelFor.cpp \
+ *			Actor/Actor.cpp Actor/ActorManager.cpp Actor/ActorTimer.cpp Actor/Platform_Haiku.cpp Actor/WorkThread.cpp -lbe -o imagescaler_benchmark
+ *		./imagescaler_benchmark
+ *	Nearest neighbour is the previous thumbnail scaler (aliased, for reference only).
+ *	Returns non zero if the box filter fails the exact 2:1 / constant colour checks.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "Actor/ActorManager.h"
+#include "ImageScaler.h"
+#include "ParallelFor.h"
+
+static const int kIterations = 20;
+
+struct IMAGE
+{
+	int					width;
+	int					height;
+	std::vector<uint8>	pixels;
+	IMAGE(const int w, const int h) : width(w), height(h), pixels(4*(size_t)w*h) {}
+	int32 BytesPerRow() const {return 4*width;}
+};
+
+static void ScaleNearest(const IMAGE &source, IMAGE &dest)
+{
+	for (int y=0; y < dest.height; y++)
+	{
+		const uint32 *s = (const uint32 *)source.pixels.data() + (size_t)(y*source.height/dest.height)*source.width;
+		uint32 *d = (uint32 *)dest.pixels.data() + (size_t)y*dest.width;
+		for (int x=0; x < dest.width; x++)
+			d[x] = s[x*source.width/dest.width];
+	}
+}
+
+template <class F>
+static double BestTime(F fn)
+{
+	double best = 1e9;
+	for (int i=0; i < kIterations; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+static void Scale(const IMAGE &source, IMAGE &dest, const SCALE_FILTER filter)
+{
+	ScaleImage(source.pixels.data(), source.width, source.height, source.BytesPerRow(),
+			   dest.pixels.data(), dest.width, dest.height, dest.BytesPerRow(), filter);
+}
+
+//	Exact 2:1 box must equal the rounded 2x2 average (odd width covers the scalar tail), constant colour must be preserved
+static int CheckBox()
+{
+	int failures = 0;
+	for (int width : {32, 37})
+	{
+		IMAGE source(2*width, 48), dest(width, 24);
+		for (auto &p : source.pixels)
+			p = (uint8)rand();
+		Scale(source, dest, SCALE_FILTER_BOX);
+		for (int y=0; y < dest.height; y++)
+		{
+			for (int x=0; x < dest.width; x++)
+			{
+				for (int c=0; c < 4; c++)
+				{
+					auto s = [&](int sx, int sy) {return (int)source.pixels[4*((size_t)sy*source.width + sx) + c];};
+					const int expected = (s(2*x, 2*y) + s(2*x + 1, 2*y) + s(2*x, 2*y + 1) + s(2*x + 1, 2*y + 1) + 2)/4;
+					failures += (dest.pixels[4*((size_t)y*dest.width + x) + c] != expected);
+				}
+			}
+		}
+	}
+
+	IMAGE flat(333, 171), flat_dest(37, 19);
+	for (size_t i=0; i < flat.pixels.size(); i++)
+		flat.pixels[i] = (uint8)(17 + 60*(i & 3));
+	for (SCALE_FILTER filter : {SCALE_FILTER_BOX, SCALE_FILTER_BILINEAR})
+	{
+		Scale(flat, flat_dest, filter);
+		for (size_t i=0; i < flat_dest.pixels.size(); i++)
+			failures += (flat_dest.pixels[i] != (uint8)(17 + 60*(i & 3)));
+	}
+	printf("Box / constant colour checks: %d failures\n", failures);
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	yarra::ActorManager actor_manager;
+	printf("ParallelForConcurrency() = %d\n", ParallelForConcurrency());
+	int failures = CheckBox();
+
+	struct CASE
+	{
+		int		source_width, source_height;
+		int		dest_width, dest_height;
+	};
+	const CASE kCases[] =
+	{
+		{3840, 2160, 96, 54},
+		{3840, 2160, 1920, 1080},
+		{1920, 1080, 960, 540},
+	};
+	for (auto &c : kCases)
+	{
+		IMAGE source(c.source_width, c.source_height);
+		for (auto &p : source.pixels)
+			p = (uint8)rand();
+		IMAGE dest(c.dest_width, c.dest_height);
+
+		double box = BestTime([&]() {Scale(source, dest, SCALE_FILTER_BOX);});
+		double bilinear = BestTime([&]() {Scale(source, dest, SCALE_FILTER_BILINEAR);});
+		double nearest = BestTime([&]() {ScaleNearest(source, dest);});
+		printf("%dx%d -> %dx%d: box %.2f ms, bilinear %.2f ms, nearest %.2f ms (best of %d)\n",
+			c.source_width, c.source_height, c.dest_width, c.dest_height, box, bilinear, nearest, kIterations);
+	}
+	actor_manager.Quit(false);
+	return failures ? 1 : 0;
+}
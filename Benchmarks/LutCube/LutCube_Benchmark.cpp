@@ -0,0 +1,175 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Benchmark 3rdParty/LutCube.cpp (mapped parser, binary cache) against the original parser
+ *
+ *	Standalone (not part of the Medo build), from the repository root:
+ *		g++ -std=c++17 -O2 -I. Benchmarks/LutCube/LutCube_Benchmark.cpp Benchmarks/LutCube/LutCube_Reference.cpp 3rdParty/LutCube.cpp -o lutcube_benchmark
+ *		./lutcube_benchmark [work_directory]		(default /tmp, a 65^3 test cube is written there)
+ *	Returns non zero if any parse result or error differs from the reference parser.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "3rdParty/LutCube.h"
+
+namespace timecube
+{
+	Cube read_cube_from_file_reference(const char *path);
+};
+using namespace timecube;
+
+static const int kLutSize = 65;
+static const int kIterations = 3;
+
+static bool Equal(const Cube &a, const Cube &b)
+{
+	return (a.title == b.title) && (a.n == b.n) && (a.is_3d == b.is_3d) && (a.lut == b.lut) &&
+			!memcmp(a.domain_min, b.domain_min, sizeof(a.domain_min)) && !memcmp(a.domain_max, b.domain_max, sizeof(a.domain_max));
+}
+
+static std::string Error(Cube (*fn)(const char *), const char *path)
+{
+	try {
+		fn(path);
+		return "ok";
+	}
+	catch (const std::exception &e)
+	{
+		return e.what();
+	}
+}
+
+static void WriteFile(const char *path, const char *data)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file)
+	{
+		printf("Cannot create %s\n", path);
+		exit(1);
+	}
+	fputs(data, file);
+	fclose(file);
+}
+
+static void ClearDirectory(const std::string &dir)
+{
+	DIR *d = opendir(dir.c_str());
+	if (!d)
+		return;
+	while (struct dirent *entry = readdir(d))
+	{
+		if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
+			unlink((dir + "/" + entry->d_name).c_str());
+	}
+	closedir(d);
+}
+
+template <class F>
+static double Time(F fn, Cube &result)
+{
+	auto start = std::chrono::steady_clock::now();
+	result = fn();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char **argv)
+{
+	const std::string work_dir = argc > 1 ? argv[1] : "/tmp";
+	const std::string cache_dir = work_dir + "/lutcube_cache";
+	const std::string big_path = work_dir + "/lutcube_benchmark.cube";
+	const std::string case_path = work_dir + "/lutcube_case.cube";
+	mkdir(cache_dir.c_str(), 0755);
+	ClearDirectory(cache_dir);
+
+	//	Edge cases, results (or error messages) must match the reference parser
+	const char *cases[] =
+	{
+		"LUT_3D_SIZE 2\r\n0 0 0\r\n1 0 0\r\n0 1 0\r\n1 1 0\r\n0 0 1\r\n1 0 1\r\n0 1 1\r\n+1 1e0 1.\r\n",
+		"TITLE \"x\"\nLUT_1D_SIZE 2\n#c\n0 0 0\n.5 -0.25 1 extra\n",
+		"LUT_3D_SIZE 2\n0 0 0\n",
+		"LUT_3D_SIZE 1\n0 0 0\n",
+		"0 0 0\n",
+		"LUT_3D_SIZE 2\n0 0 x\n",
+		"LUT_3D_SIZE 2\nLUT_1D_SIZE 2\n0 0 0\n",
+		"DOMAIN_MIN 1 1 1\nDOMAIN_MAX 0 0 0\nLUT_1D_SIZE 2\n0 0 0\n1 1 1\n",
+		"TITLE \"broken\nLUT_1D_SIZE 2\n0 0 0\n1 1 1",
+		"",
+	};
+	int mismatches = 0;
+	for (auto c : cases)
+	{
+		WriteFile(case_path.c_str(), c);
+		std::string e0 = Error(read_cube_from_file_reference, case_path.c_str());
+		std::string e1 = Error(read_cube_from_file, case_path.c_str());
+		bool equal = (e0 == e1) && ((e0 != "ok") || Equal(read_cube_from_file_reference(case_path.c_str()), read_cube_from_file(case_path.c_str())));
+		if (!equal)
+		{
+			printf("MISMATCH reference(%s) new(%s)\n", e0.c_str(), e1.c_str());
+			mismatches++;
+		}
+	}
+	printf("Edge cases: %d / %zu mismatches\n", mismatches, sizeof(cases)/sizeof(cases[0]));
+
+	//	65^3 cube (274625 entries), pseudo random values with 6 decimals
+	FILE *file = fopen(big_path.c_str(), "w");
+	if (!file)
+	{
+		printf("Cannot create %s\n", big_path.c_str());
+		return 1;
+	}
+	fprintf(file, "# comment\nTITLE \"Benchmark LUT\"\nDOMAIN_MIN 0 0 0\nDOMAIN_MAX 1.0 1.0 1.0\nLUT_3D_SIZE %d\n\n", kLutSize);
+	unsigned seed = 1;
+	for (int i=0; i < kLutSize*kLutSize*kLutSize; i++)
+	{
+		float v[3];
+		for (int k=0; k < 3; k++)
+		{
+			seed = seed*1103515245 + 12345;
+			v[k] = (seed >> 8)/16777216.0f;
+		}
+		fprintf(file, "%.6f %.6f %.6f\n", v[0], v[1], v[2]);
+	}
+	fclose(file);
+
+	const char *path = big_path.c_str();
+	for (int it=0; it < kIterations; it++)
+	{
+		Cube reference, parsed, cached_first, cached;
+		double t0 = Time([&]() {return read_cube_from_file_reference(path);}, reference);
+		double t1 = Time([&]() {return read_cube_from_file(path);}, parsed);
+		double t2 = Time([&]() {return read_cube_cached(path, cache_dir.c_str());}, cached_first);
+		double t3 = Time([&]() {return read_cube_cached(path, cache_dir.c_str());}, cached);
+		bool equal = Equal(reference, parsed) && Equal(reference, cached_first) && Equal(reference, cached);
+		if (!equal)
+			mismatches++;
+		printf("reference %.1f ms, read_cube_from_file %.1f ms, read_cube_cached (miss) %.1f ms, (hit) %.2f ms, equal=%d\n",
+			t0, t1, t2, t3, equal);
+		ClearDirectory(cache_dir);		//	next iteration starts with a cold binary cache
+	}
+
+	//	Stale cache: rewriting the source (new size / mtime) must not return the cached copy
+	WriteFile(case_path.c_str(), "LUT_1D_SIZE 2\n0 0 0\n1 1 1\n");
+	read_cube_cached(case_path.c_str(), cache_dir.c_str());
+	sleep(1);
+	WriteFile(case_path.c_str(), "LUT_1D_SIZE 3\n0 0 0\n.5 .5 .5\n1 1 1\n");
+	bool fresh = Equal(read_cube_cached(case_path.c_str(), cache_dir.c_str()), read_cube_from_file(case_path.c_str()));
+	printf("Modified source reparsed: %d\n", fresh);
+	if (!fresh)
+		mismatches++;
+
+	ClearDirectory(cache_dir);
+	unlink(case_path.c_str());
+	unlink(big_path.c_str());
+	rmdir(cache_dir.c_str());
+	return mismatches ? 1 : 0;
+}
@@ -96,6 +96,12 @@ AudioManager :: AudioManager()
 	fPreviewStartFrame = 0;
 	fPreviewEndFrame = 0;
 	fPreviewSource = nullptr;
+	fPreviewGeneration = 0;
+	fClockSequence = 0;
+	fClockFrame = 0;
+	fClockEndFrame = 0;
+	fClockTimestamp = 0;
+	fClockValid = false;
 
 #if 1
 	fSoundPlayer = new BSoundPlayer("Medo", SoundPlayerCallback, nullptr, this);
@@ -17,6 +17,10 @@
 #include <vector>
 #endif
 
+#ifndef _GLIBCXX_ATOMIC
+#include <atomic>
+#endif
+
 class BBitmap;
 class MediaSource;
 class AudioCache;
@@ -45,6 +49,14 @@ private:
 	int64			fPreviewStartFrame;
 	int64			fPreviewEndFrame;
 	MediaSource		*fPreviewSource;
+	uint32			fPreviewGeneration;		//	incremented by PlayPreview/StopPreview (fCacheSemaphore)
+
+	//	Playback master clock, published by SoundPlayerCallback under fCacheSemaphore (seqlock for GetPreviewPosition)
+	std::atomic<uint32>		fClockSequence;
+	std::atomic<int64>		fClockFrame;		//	timeline frame of first sample in most recent buffer
+	std::atomic<int64>		fClockEndFrame;		//	timeline frame after most recent buffer
+	std::atomic<bigtime_t>	fClockTimestamp;	//	system time when first sample audible
+	std::atomic<bool>		fClockValid;
 
 	struct ResamplerContext
 	{
@@ -72,6 +84,8 @@ public:
 	void			ClearPendingThumbnails();
 
 	void			PlayPreview(const int64 start_frame, const int64 end_frame, MediaSource *preview_source = nullptr);
+	void			StopPreview();
+	const bool		GetPreviewPosition(int64 &position);
 	const int64		GetOutputBuffer(const int64 start_frame, const int64 end_frame,
 									void *buffer, size_t buffer_size, const media_raw_audio_format &format);
 
@@ -49,6 +49,8 @@ void AudioManager :: PlayPreview(const int64 start_frame, const int64 end_frame,
 			fPreviewStartFrame = start_frame;
 		fPreviewEndFrame = end_frame;
 		fPreviewSource = preview_source;
+		fPreviewGeneration++;
+		fClockValid = false;
 
 		//printf("--- AudioManager::PlayPreview(start=%ld, end=%ld), fPreviewStartFrame=%ld\n\n", start_frame, end_frame, fPreviewStartFrame);
 
@@ -59,17 +61,78 @@ void AudioManager :: PlayPreview(const int64 start_frame, const int64 end_frame,
 		DEBUG("Failed to acquire_sem\n");
 }
 
+/*	FUNCTION:		AudioManager :: StopPreview
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Stop sound preview (SoundPlayerCallback will output silence)
+*/
+void AudioManager :: StopPreview()
+{
+	status_t err;
+	while ((err = acquire_sem(fCacheSemaphore)) == B_INTERRUPTED) ;
+	if (err == B_OK)
+	{
+		fPreviewEndFrame = fPreviewStartFrame;
+		fPreviewGeneration++;
+		fClockValid = false;
+		release_sem(fCacheSemaphore);
+	}
+}
+
+/*	FUNCTION:		AudioManager :: GetPreviewPosition
+	ARGS:			position (output, timeline frame)
+	RETURN:			true if valid (sound preview active)
+	DESCRIPTION:	Timeline position of audible sample, used as playback master clock.
+					Extrapolated from the most recent buffer (system time), does not advance beyond buffered audio.
+*/
+const bool AudioManager :: GetPreviewPosition(int64 &position)
+{
+	if (!fSoundPlayer || !fClockValid)
+		return false;
+
+	uint32 sequence;
+	int64 frame, end_frame;
+	bigtime_t timestamp;
+	do
+	{
+		sequence = fClockSequence;
+		frame = fClockFrame;
+		end_frame = fClockEndFrame;
+		timestamp = fClockTimestamp;
+	} while ((sequence & 1) || (sequence != fClockSequence));
+
+	position = frame + (system_time() - timestamp)*kFramesSecond/1'000'000;
+	if (position > end_frame)
+		position = end_frame;
+	return true;
+}
+
 /*	FUNCTION:		AudioManager :: SoundPlayerCallback
 	ARGS:			cookie
 					buffer, buffer_size
 					format
 	RETURN:			n/a
-	DESCRIPTION:	Hook function called by BSoundPlayer
+	DESCRIPTION:	Hook function called by BSoundPlayer.
+					Preview position is read and updated under fCacheSemaphore, a buffer mixed while
+					PlayPreview/StopPreview changed the preview (generation) is discarded.
 */
 void AudioManager :: SoundPlayerCallback(void *cookie, void *buffer, size_t buffer_size, const media_raw_audio_format &format)
 {
 	AudioManager *amgr = (AudioManager *)cookie;
-	if (amgr->fPreviewEndFrame - amgr->fPreviewStartFrame <= 0)
+
+	status_t err;
+	while ((err = acquire_sem(amgr->fCacheSemaphore)) == B_INTERRUPTED) ;
+	if (err != B_OK)
+	{
+		memset(buffer, 0, buffer_size);
+		return;
+	}
+	const uint32 generation = amgr->fPreviewGeneration;
+	const int64 preview_start = amgr->fPreviewStartFrame;
+	const int64 preview_remaining = amgr->fPreviewEndFrame - amgr->fPreviewStartFrame;
+	release_sem(amgr->fCacheSemaphore);
+
+	if (preview_remaining <= 0)
 	{
 		amgr->fSoundPlayer->SetHasData(false);
 
@@ -87,8 +150,28 @@ void AudioManager :: SoundPlayerCallback(void *cookie, void *buffer, size_t buff
 	const int64 kTargetSampleSize = format.channel_count * sizeof(float);
 	const int64 kTargetNumberSamples = buffer_size / kTargetSampleSize;
 	const double kTargetConversionFactor = double(kFramesSecond) / format.frame_rate;
-	const int64 preview_end = amgr->fPreviewStartFrame + kTargetNumberSamples*kTargetConversionFactor;
-	amgr->fPreviewStartFrame = amgr->GetOutputBuffer(amgr->fPreviewStartFrame, preview_end, buffer, buffer_size, format);
+	const int64 preview_end = preview_start + kTargetNumberSamples*kTargetConversionFactor;
+	const int64 buffer_end = amgr->GetOutputBuffer(preview_start, preview_end, buffer, buffer_size, format);
+
+	//	Publish master clock, buffer becomes audible after output latency
+	while ((err = acquire_sem(amgr->fCacheSemaphore)) == B_INTERRUPTED) ;
+	if (err != B_OK)
+		return;
+	if (generation != amgr->fPreviewGeneration)
+	{
+		//	Seek/stop while mixing, next callback starts from new position
+		release_sem(amgr->fCacheSemaphore);
+		memset(buffer, 0, buffer_size);
+		return;
+	}
+	amgr->fPreviewStartFrame = buffer_end;
+	amgr->fClockSequence++;
+	amgr->fClockFrame = preview_start;
+	amgr->fClockEndFrame = buffer_end;
+	amgr->fClockTimestamp = system_time() + amgr->fSoundPlayer->Latency();
+	amgr->fClockSequence++;
+	amgr->fClockValid = true;
+	release_sem(amgr->fCacheSemaphore);
 
 	//	Set visualisation
 	AudioMixer *mixer = MedoWindow::GetInstance()->GetAudioMixer();
@@ -132,7 +215,7 @@ const int64	AudioManager :: GetOutputBuffer(const int64 start_frame, const int64
 	{
 		TimelineTrack				*track;
 		int32						track_idx;
-		MediaClip					*clip;
+		MediaClip					clip;		//	copy (TimelineTrack::FindClips)
 		std::vector<MediaEffect *>	effects;
 	};
 	std::vector<TRACK_CLIP>		track_clips;
@@ -147,14 +230,16 @@ const int64	AudioManager :: GetOutputBuffer(const int64 start_frame, const int64
 		preview_clip.mTimelineFrameStart = 0;
 
 		TRACK_CLIP aClip = {};
-		aClip.clip = &preview_clip;
+		aClip.clip = preview_clip;
 		track_clips.push_back(aClip);
 	}
 	else
 	{
 		int32 track_idx = gProject->mTimelineTracks.size();
+		std::vector<MediaClip> clips;
+		std::vector<MediaEffect *> effects;
 
-		//	Reverse iterate each track, find clips
+		//	Reverse iterate each track, find clips (interval index)
 		for (std::vector<TimelineTrack *>::const_reverse_iterator t = gProject->mTimelineTracks.rbegin(); t < gProject->mTimelineTracks.rend(); ++t)
 		{
 			assert(--track_idx >= 0);
@@ -162,28 +247,26 @@ const int64	AudioManager :: GetOutputBuffer(const int64 start_frame, const int64
 			if (!(*t)->mAudioEnabled)
 				continue;
 
-			//	TODO binary search
-			for (auto &clip : (*t)->mClips)
-			{
-				if (clip.mTimelineFrameStart > actual_end_frame)
-					break;
+			(*t)->FindClips(start_frame, actual_end_frame, clips);
+			if (clips.empty())
+				continue;
+			(*t)->FindEffects(start_frame, actual_end_frame, effects);
 
-				if ((start_frame < clip.GetTimelineEndFrame()) && (actual_end_frame > clip.mTimelineFrameStart) && clip.mAudioEnabled &&
+			for (auto &clip : clips)
+			{
+				if (clip.mAudioEnabled &&
 					((clip.mMediaSourceType == MediaSource::MEDIA_AUDIO) || (clip.mMediaSourceType == MediaSource::MEDIA_VIDEO_AND_AUDIO)))
 				{
 					TRACK_CLIP c;
 					c.track = *t;
 					c.track_idx = track_idx;
-					c.clip = &clip;
+					c.clip = clip;
 
 					//	add effects
-					for (auto &e : c.track->mEffects)
+					for (auto e : effects)
 					{
-						if ((start_frame < e->mTimelineFrameEnd) && (actual_end_frame > e->mTimelineFrameStart))
-						{
-							if (e->Type() == MediaEffect::MEDIA_EFFECT_AUDIO)
-								c.effects.push_back(e);
-						}
+						if (e->Type() == MediaEffect::MEDIA_EFFECT_AUDIO)
+							c.effects.push_back(e);
 					}
 					track_clips.emplace_back(c);
 				}
@@ -206,13 +289,13 @@ const int64	AudioManager :: GetOutputBuffer(const int64 start_frame, const int64
 	size_t total_output = 0;
 #endif
 
-		MediaSource *media_source =c.clip->mMediaSource;
+		MediaSource *media_source =c.clip.mMediaSource;
 		const double kSourceConversionFactor = double(kFramesSecond) / media_source->GetAudioFrameRate();
 
 		uint8 *buffer_start = (uint8 *) buffer;
 		uint8 *buffer_end = buffer_start + buffer_size;
 
-		int64 audio_start = round(((start_frame - c.clip->mTimelineFrameStart) + c.clip->mSourceFrameStart) / kSourceConversionFactor);
+		int64 audio_start = round(((start_frame - c.clip.mTimelineFrameStart) + c.clip.mSourceFrameStart) / kSourceConversionFactor);
 		if (audio_start >= media_source->GetAudioNumberSamples())
 		{
 			printf("AudioManager::GetOutputBuffer() - audio_start > media_source->GetAudioNumberSamples()\n");
@@ -221,14 +304,14 @@ const int64	AudioManager :: GetOutputBuffer(const int64 start_frame, const int64
 			continue;
 		}
 		//	Cater for scenario where clip starts within interval
-		if (c.clip->mTimelineFrameStart > start_frame)
+		if (c.clip.mTimelineFrameStart > start_frame)
 		{
 			DEBUG("AudioManager::GetOutputBuffer() [1] buffer_start = %p, buffer_end = %p, buffer_size = %ld\n", buffer_start, buffer_end, buffer_size);
-			size_t num_zero =  kTargetSampleSize * (c.clip->mTimelineFrameStart - start_frame)/kTargetConversionFactor;
+			size_t num_zero =  kTargetSampleSize * (c.clip.mTimelineFrameStart - start_frame)/kTargetConversionFactor;
 			if (track_clip_index == 0)
 				memset(buffer_start, 0, num_zero);
 			buffer_start += num_zero;
-			audio_start = round(c.clip->mSourceFrameStart / kSourceConversionFactor);
+			audio_start = round(c.clip.mSourceFrameStart / kSourceConversionFactor);
 #if DEBUG_TOTAL_OUT
 			if (track_clip_index == 0)
 				total_output += num_zero;
@@ -236,15 +319,15 @@ const int64	AudioManager :: GetOutputBuffer(const int64 start_frame, const int64
 			DEBUG("AudioManager::GetOutputBuffer() [2] buffer_start = %p, num_zero = %ld\n", buffer_start, num_zero);
 		}
 
-		int64 audio_end = round(((actual_end_frame - c.clip->mTimelineFrameStart) + c.clip->mSourceFrameStart) / kSourceConversionFactor);
+		int64 audio_end = round(((actual_end_frame - c.clip.mTimelineFrameStart) + c.clip.mSourceFrameStart) / kSourceConversionFactor);
 		if (audio_end >= media_source->GetAudioNumberSamples())
 			audio_end = media_source->GetAudioNumberSamples();
 
 		//	cater for scenario where clip ends within interval
-		if (c.clip->GetTimelineEndFrame() < actual_end_frame)
+		if (c.clip.GetTimelineEndFrame() < actual_end_frame)
 		{
 			DEBUG("AudioManager::GetOutputBuffer() [3] audio_end=%ld, buffer_start = %p, buffer_end = %p, buffer_size = %ld\n", audio_end, buffer_start, buffer_end, buffer_size);
-			size_t num_zero = kTargetSampleSize * (actual_end_frame - c.clip->GetTimelineEndFrame())/kTargetConversionFactor;
+			size_t num_zero = kTargetSampleSize * (actual_end_frame - c.clip.GetTimelineEndFrame())/kTargetConversionFactor;
 			if (num_zero > buffer_size)
 			{
 				printf("AudioManager::GetOutputBuffer() num_zero > buffer_size\n");
@@ -257,7 +340,7 @@ const int64	AudioManager :: GetOutputBuffer(const int64 start_frame, const int64
 			if (track_clip_index == 0)
 				total_output += num_zero;
 #endif
-			audio_end = c.clip->mSourceFrameEnd / kSourceConversionFactor;
+			audio_end = c.clip.mSourceFrameEnd / kSourceConversionFactor;
 			DEBUG("AudioManager::GetOutputBuffer() [4] audio_end=%ld, buffer_end = %p, num_zero = %ld\n", audio_end, buffer_end, num_zero);
 		}
 		DEBUG("AudioManager::GetOutputBuffer() [5] start_frame[%ld] end_frame[%ld] audio_start[%ld], audio_end[%ld], num_frames=%ld\n",
@@ -0,0 +1,330 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Colour fusion (consecutive per pixel effects rendered in single shader pass)
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <string_view>
+
+#include "Yarra/Render/SceneNode.h"
+#include "Yarra/Render/Shader.h"
+#include "Yarra/Render/Texture.h"
+#include "Yarra/Render/MatrixStack.h"
+#include "Yarra/Render/RenderState.h"
+
+#include "ColourFusion.h"
+#include "EffectNode.h"
+#include "Project.h"
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+using namespace yrender;
+
+static const size_t kMaxCachedPrograms = 32;
+
+static const YGeometry_P3T2 kFusionGeometry[] =
+{
+	{-1, -1, 0,		0, 0},
+	{1, -1, 0,		1, 0},
+	{-1, 1, 0,		0, 1},
+	{1, 1, 0,		1, 1},
+};
+
+static const char *kVertexShader = "\
+	uniform mat4	uTransform;\
+	in vec3			aPosition;\
+	in vec2			aTexture0;\
+	out vec2		vTexCoord0;\
+	void main(void) {\
+		gl_Position = uTransform * vec4(aPosition, 1.0);\
+		vTexCoord0 = aTexture0;\
+	}";
+
+static const char *kFragmentShaderHeader = "\
+uniform sampler2D	uTextureUnit0;\n\
+in vec2				vTexCoord0;\n\
+out vec4			fFragColour;\n";
+
+/***************************
+	ColourFusionProgram
+****************************/
+
+/*	FUNCTION:		ColourFusionProgram :: ColourFusionProgram
+	ARGS:			sources
+	RETURN:			n/a
+	DESCRIPTION:	Generate fragment shader from stage fusion sources
+*/
+ColourFusionProgram :: ColourFusionProgram(const std::vector<const char *> &sources)
+{
+	std::string fragment(kFragmentShaderHeader);
+	std::string main_body;
+	char suffix[8];
+	for (size_t stage=0; stage < sources.size(); stage++)
+	{
+		sprintf(suffix, "_%d", (int)stage);
+		for (const char *p = sources[stage]; *p; p++)
+		{
+			if (*p == '@')
+				fragment.append(suffix);
+			else
+				fragment.push_back(*p);
+		}
+		fragment.push_back('\n');
+
+		main_body.append("\tcolour = Fusion");
+		main_body.append(suffix);
+		main_body.append("(colour, vTexCoord0);\n");
+	}
+	fragment.append("void main(void) {\n\tvec4 colour = texture(uTextureUnit0, vTexCoord0);\n");
+	fragment.append(main_body);
+	fragment.append("\tfFragColour = colour;\n}\n");
+	DEBUG("ColourFusionProgram()\n%s\n", fragment.c_str());
+
+	std::vector <std::string> attributes;
+	attributes.push_back("aPosition");
+	attributes.push_back("aTexture0");
+	fShader = new YShader(&attributes, kVertexShader, fragment.c_str());
+	if (fShader->GetProgram() == 0)
+	{
+		printf("ColourFusionProgram() - failed to compile fused shader (%lu stages)\n", sources.size());
+		return;
+	}
+	fLocation_uTransform = fShader->GetUniformLocation("uTransform");
+	fLocation_uTextureUnit0 = fShader->GetUniformLocation("uTextureUnit0");
+}
+
+/*	FUNCTION:		ColourFusionProgram :: ~ColourFusionProgram
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Destructor
+*/
+ColourFusionProgram :: ~ColourFusionProgram()
+{
+	delete fShader;
+}
+
+/*	FUNCTION:		ColourFusionProgram :: IsValid
+	ARGS:			none
+	RETURN:			true if program compiled
+	DESCRIPTION:	Check program
+*/
+const bool ColourFusionProgram :: IsValid() const
+{
+	return fShader->GetProgram() > 0;
+}
+
+/*	FUNCTION:		ColourFusionProgram :: EnableProgram
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Enable program and set common uniforms
+*/
+void ColourFusionProgram :: EnableProgram()
+{
+	fShader->EnableProgram();
+	glUniformMatrix4fv(fLocation_uTransform, 1, GL_FALSE, yrender::yMatrixStack.GetMVPMatrix().m);
+	glUniform1i(fLocation_uTextureUnit0, 0);
+}
+
+/*	FUNCTION:		ColourFusionProgram :: GetUniformLocation
+	ARGS:			name
+					stage
+	RETURN:			uniform location
+	DESCRIPTION:	Get (cached) location of stage uniform
+*/
+const GLint ColourFusionProgram :: GetUniformLocation(const char *name, const int stage)
+{
+	std::string key(name);
+	char suffix[8];
+	sprintf(suffix, "_%d", stage);
+	key.append(suffix);
+
+	auto it = fUniformLocations.find(key);
+	if (it != fUniformLocations.end())
+		return it->second;
+
+	GLint location = fShader->GetUniformLocation(key.c_str());
+	fUniformLocations[key] = location;
+	return location;
+}
+
+/***************************
+	ColourFusionShaderNode
+****************************/
+class ColourFusionShaderNode : public yrender::YShaderNode
+{
+public:
+	ColourFusionProgram					*mProgram;
+	const std::vector<MediaEffect *>	*mEffects;
+	int64								mFrameIdx;
+
+	ColourFusionShaderNode() : mProgram(nullptr), mEffects(nullptr), mFrameIdx(0) { }
+	void Render(float)
+	{
+		mProgram->EnableProgram();
+		for (size_t stage=0; stage < mEffects->size(); stage++)
+		{
+			MediaEffect *effect = (*mEffects)[stage];
+			effect->mEffectNode->SetColourFusionUniforms(mProgram, (int)stage, effect, mFrameIdx);
+		}
+		yrender::yRenderState.ActiveTexture(GL_TEXTURE0);
+	}
+};
+
+/***************************
+	ColourFusion
+****************************/
+
+/*	FUNCTION:		ColourFusion :: ColourFusion
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Constructor (RenderActor thread)
+*/
+ColourFusion :: ColourFusion()
+	: fFrameCounter(0)
+{
+	fRenderNode = new yrender::YRenderNode(false);
+	fRenderNode->mGeometryNode = new yrender::YGeometryNode(GL_TRIANGLE_STRIP, Y_GEOMETRY_P3T2, (float *)kFusionGeometry, 4);
+	fShaderNode = new ColourFusionShaderNode;
+	fRenderNode->mShaderNode = fShaderNode;
+}
+
+/*	FUNCTION:		ColourFusion :: ~ColourFusion
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Destructor (RenderActor thread)
+*/
+ColourFusion :: ~ColourFusion()
+{
+	for (auto &i : fPrograms)
+		delete i.program;
+	delete fRenderNode->mGeometryNode;
+	delete fShaderNode;
+	delete fRenderNode;
+}
+
+/*	FUNCTION:		ColourFusion :: GetRunLength
+	ARGS:			item
+					pending
+	RETURN:			number of pending items which can be fused with item
+	DESCRIPTION:	Runs are consecutive fusable effects on the same track and frame buffer
+*/
+const size_t ColourFusion :: GetRunLength(const FRAME_ITEM &item, const std::deque<FRAME_ITEM> &pending) const
+{
+	if (!item.effect || !item.effect->mEffectNode->GetColourFusionSource(item.effect))
+		return 0;
+
+	size_t count = 0;
+	for (auto &i : pending)
+	{
+		if ((count + 1 >= kMaxStages) || !i.effect || (i.track != item.track) || (i.secondary_framebuffer != item.secondary_framebuffer))
+			break;
+		if ((i.effect->Type() != MediaEffect::MEDIA_EFFECT_IMAGE) || !i.effect->mEffectNode->GetColourFusionSource(i.effect))
+			break;
+		count++;
+	}
+	return count;
+}
+
+/*	FUNCTION:		ColourFusion :: MatchSources
+	ARGS:			sources
+	RETURN:			true if sources have the same contents as fSources
+	DESCRIPTION:	Compare cached program sources with current stage sources
+*/
+const bool ColourFusion :: MatchSources(const std::vector<std::string> &sources) const
+{
+	if (sources.size() != fSources.size())
+		return false;
+	for (size_t i=0; i < sources.size(); i++)
+	{
+		if (strcmp(sources[i].c_str(), fSources[i]) != 0)
+			return false;
+	}
+	return true;
+}
+
+/*	FUNCTION:		ColourFusion :: GetProgram
+	ARGS:			effects
+	RETURN:			program (nullptr if not valid)
+	DESCRIPTION:	Find cached program for effect sequence, otherwise generate new program.
+					Lookup compares the hash of the stage sources, then the contents.
+					Least recently used program is evicted when cache is full.
+*/
+ColourFusionProgram * ColourFusion :: GetProgram(const std::vector<MediaEffect *> &effects)
+{
+	fSources.clear();
+	size_t hash = 0;
+	for (auto e : effects)
+	{
+		const char *source = e->mEffectNode->GetColourFusionSource(e);
+		fSources.push_back(source);
+		hash = hash*31 + std::hash<std::string_view>()(std::string_view(source));
+	}
+
+	for (auto &i : fPrograms)
+	{
+		if ((i.hash == hash) && MatchSources(i.sources))
+		{
+			i.last_used = fFrameCounter;
+			return i.program->IsValid() ? i.program : nullptr;
+		}
+	}
+
+	if (fPrograms.size() >= kMaxCachedPrograms)
+	{
+		size_t lru = 0;
+		for (size_t i=1; i < fPrograms.size(); i++)
+		{
+			if (fPrograms[i].last_used < fPrograms[lru].last_used)
+				lru = i;
+		}
+		delete fPrograms[lru].program;
+		fPrograms.erase(fPrograms.begin() + lru);
+	}
+
+	PROGRAM_ITEM item;
+	item.hash = hash;
+	item.sources.assign(fSources.begin(), fSources.end());
+	item.program = new ColourFusionProgram(fSources);
+	item.last_used = fFrameCounter;
+	fPrograms.push_back(item);
+	DEBUG("ColourFusion::GetProgram() new program, stages=%lu, cached=%lu\n", fSources.size(), fPrograms.size());
+	return item.program->IsValid() ? item.program : nullptr;
+}
+
+/*	FUNCTION:		ColourFusion :: Render
+	ARGS:			source
+					effects
+					frame_idx
+	RETURN:			true if rendered (otherwise caller must render effects individually)
+	DESCRIPTION:	Render fused effects into active frame buffer
+*/
+bool ColourFusion :: Render(yrender::YTexture *source, const std::vector<MediaEffect *> &effects, int64 frame_idx)
+{
+	assert(source);
+	fFrameCounter++;
+
+	ColourFusionProgram *program = GetProgram(effects);
+	if (!program)
+		return false;
+
+	const float width = gProject->mResolution.width;
+	const float height = gProject->mResolution.height;
+	fRenderNode->mSpatial.SetPosition(ymath::YVector3(0.5f*width, 0.5f*height, 0.5f));
+	fRenderNode->mSpatial.SetScale(ymath::YVector3(0.5f*width, 0.5f*height, 0));
+
+	fShaderNode->mProgram = program;
+	fShaderNode->mEffects = &effects;
+	fShaderNode->mFrameIdx = frame_idx;
+	fRenderNode->mTexture = source;
+	fRenderNode->Render(0.0f);
+	fRenderNode->mTexture = nullptr;
+	fShaderNode->mEffects = nullptr;
+	return true;
+}
@@ -0,0 +1,101 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Colour fusion (consecutive per pixel effects rendered in single shader pass)
+ */
+
+#ifndef _COLOUR_FUSION_H_
+#define _COLOUR_FUSION_H_
+
+#ifndef __gl_h_
+#include <GL/gl.h>
+#endif
+
+#ifndef _GLIBCXX_STRING
+#include <string>
+#endif
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _GLIBCXX_UNORDERED_MAP
+#include <unordered_map>
+#endif
+
+#ifndef EFFECT_NODE_H
+#include "EffectNode.h"
+#endif
+
+namespace yrender
+{
+	class YRenderNode;
+	class YShader;
+	class YTexture;
+};
+class ColourFusionShaderNode;
+
+/*****************************
+	ColourFusionProgram is a generated fragment shader which chains the fusion source of
+	each stage:  colour = Fusion_N(colour, uv).
+	Stage globals are suffixed with "_N" (the '@' placeholder), so uniforms are queried
+	with GetUniformLocation(name, stage) where name excludes the suffix.
+	Stage N may use texture unit GetTextureUnit(N), unit 0 is the source texture.
+******************************/
+class ColourFusionProgram
+{
+public:
+						ColourFusionProgram(const std::vector<const char *> &sources);
+						~ColourFusionProgram();
+
+	const bool			IsValid() const;
+	void				EnableProgram();
+	const GLint			GetUniformLocation(const char *name, const int stage);
+	const GLint			GetTextureUnit(const int stage) const	{return 1 + stage;}
+
+private:
+	yrender::YShader	*fShader;
+	GLint				fLocation_uTransform;
+	GLint				fLocation_uTextureUnit0;
+	std::unordered_map<std::string, GLint>	fUniformLocations;
+};
+
+/*****************************
+	ColourFusion detects runs of consecutive per pixel effects (EffectNode::GetColourFusionSource())
+	on the same track and frame buffer, and renders them in one pass (one target switch and one
+	texture fetch instead of N).
+	Generated programs are cached, keyed by the contents of the stage sources (add-ons may
+	build the fusion source at runtime, so pointer identity is not a valid key).
+	Accessed only from the RenderActor thread (GL context locked).
+******************************/
+class ColourFusion
+{
+public:
+	static const size_t	kMaxStages = 8;
+
+						ColourFusion();
+						~ColourFusion();
+
+	const size_t		GetRunLength(const FRAME_ITEM &item, const std::deque<FRAME_ITEM> &pending) const;
+	bool				Render(yrender::YTexture *source, const std::vector<MediaEffect *> &effects, int64 frame_idx);
+
+private:
+	ColourFusionProgram	*GetProgram(const std::vector<MediaEffect *> &effects);
+	const bool			MatchSources(const std::vector<std::string> &sources) const;
+
+	struct PROGRAM_ITEM
+	{
+		size_t						hash;
+		std::vector<std::string>	sources;
+		ColourFusionProgram			*program;
+		uint32						last_used;
+	};
+	std::vector<PROGRAM_ITEM>		fPrograms;
+	uint32							fFrameCounter;
+
+	yrender::YRenderNode			*fRenderNode;
+	ColourFusionShaderNode			*fShaderNode;
+	std::vector<const char *>		fSources;
+};
+
+#endif	//#ifndef _COLOUR_FUSION_H_
@@ -5,271 +5,112 @@
  */
 
 #include <cstdio>
+#include <cstdlib>
 #include <cassert>
 
 #include <InterfaceKit.h>
 #include <app/MessageQueue.h>
 
+#include "Actor/Actor.h"
+
 #include "ColourScope.h"
+#include "ColourScopeEngine.h"
 #include "Language.h"
 #include "MedoWindow.h"
 #include "PersistantWindow.h"
 #include "Project.h"
 
 /*************************************
-	ScopeView
+	ScopeActor
 **************************************/
-class ScopeView : public BView
+class ScopeActor : public yarra::Actor
 {
+	ColourScopeEngine	*fEngine;
+	BLooper				*fTarget;
+	sem_id				fRenderSemaphore;
 public:
-	enum class ScopeType {eScopeHistogramSeparate, eScopeHistogramUnified};
-
-private:
-	BBitmap		*fBitmap;
-	struct COLOUR_VALUES
+	ScopeActor(ColourScopeEngine *engine, BLooper *target, sem_id render_semaphore)
+		: fEngine(engine), fTarget(target), fRenderSemaphore(render_semaphore)
+	{ }
+	void AsyncRender(const ColourScopeEngine::SCOPE_TYPE type)
 	{
-		uint16		lum;
-		uint16		red;
-		uint16		green;
-		uint16		blue;
-		void SetOne() {lum = 1, red = 1, green = 1, blue = 1;}
-	};
-	enum ScopeMessage {eMsgHistogramSeparate = 'esp0', eMsgHistogramUnified};
-	ScopeType fScopeType;
-
-	/*	FUNCTION:		ScopeView :: PrepareHistogram
-		ARGS:			source
-		RETURN:			n/a
-		DESCRIPTION:	Prepare Histogram (luminance, red/green/blue)
-	*/
-	void	PrepareHistogramSeparate(BBitmap *source)
-	{
-		assert(source);
-		int32 source_width = source->Bounds().IntegerWidth() + 1;
-		int32 source_height = source->Bounds().IntegerHeight() + 1;
-
-		int32 bytes_per_row = source->BytesPerRow();
-		assert(bytes_per_row == source_width*4);	//	B_RGBA32
-
-		std::vector<COLOUR_VALUES> histogram;
-		histogram.resize(source_width*256);
-		memset(histogram.data(), 0, source_width*256*sizeof(COLOUR_VALUES));
-
-		std::vector<COLOUR_VALUES> max_colour;
-		max_colour.resize(source_width);
-		memset(max_colour.data(), 0, source_width*sizeof(COLOUR_VALUES));
-
-		//	Colour Histogram
-		uint8 *s = (uint8 *)source->Bits();
-		for (int32 row=0; row < source_height; ++row)
+		BBitmap *result = fEngine->Render(type);
 		{
-			for (int32 col=0; col < source_width; col++)
-			{
-				//	BGRA
-				uint8 b = *s++;
-				uint8 g = *s++;
-				uint8 r = *s++;
-				s++;
-
-				//const vec3 LumCoeff = vec3(0.2125, 0.7154, 0.0721);
-				uint8 lum = 0.2125f*r + 0.7154f*g + 0.0721f*b;
-				histogram[col*256 + lum].lum++;
-
-				histogram[col*256 + r].red++;
-				histogram[col*256 + g].green++;
-				histogram[col*256 + b].blue++;
-			}
+			BMessage msg(ColourScope::eMsgScopeReady);
+			msg.AddPointer("BBitmap", result);
+			msg.AddInt32("type", type);
+			fTarget->PostMessage(&msg);
 		}
+		release_sem(fRenderSemaphore);		//	last access, ColourScope destructor waits for this
+	}
+};
 
-		//	Determine max occurance
-		for (int32 col=0; col < source_width; col++)
-		{
-			COLOUR_VALUES &max = max_colour[col];
-			max.SetOne();
-
-			for (int32 row=1; row < 256; ++row)
-			{
-				const COLOUR_VALUES &h = histogram[col*256 + row];
-				if (h.lum > max.lum)
-					max.lum = h.lum;
-				if (h.red > max.red)
-					max.red = h.red;
-				if (h.green > max.green)
-					max.green = h.green;
-				if (h.blue > max.blue)
-					max.blue = h.blue;
-			}
-
-		}
-
-		//	Create fBitmap
-		uint8 *d = (uint8 *)fBitmap->Bits();
-
-		//	Luminance
-		for (int32 row=255; row >= 0; --row)
-		{
-			for (int32 col=0; col < source_width; col++)
-			{
-				uint8 v = 256*histogram[col*256 + row].lum / max_colour[col].lum;
-				*d++ = v;
-				*d++ = v;
-				*d++ = v;
-				*d++ = 255;
-			}
-		}
+/*************************************
+	ScopeView
+**************************************/
+class ScopeView : public BView
+{
+	BBitmap								*fBitmap;		//	owned by ColourScopeEngine
+	ColourScopeEngine::SCOPE_TYPE		fBitmapType;
+	ColourScopeEngine::SCOPE_TYPE		fScopeType;
+	int									fStride;
 
-		//	Red
-		for (int32 row=255; row >= 0; --row)
-		{
-			for (int32 col=0; col < source_width; col++)
-			{
-				uint8 v = 256*histogram[col*256 + row].red / max_colour[col].red;
-				*d++ = 0;
-				*d++ = 0;
-				*d++ = v;
-				*d++ = 255;
-			}
-		}
-		//	Green
-		for (int32 row=255; row >= 0; --row)
-		{
-			for (int32 col=0; col < source_width; col++)
-			{
-				uint8 v = 256*histogram[col*256 + row].green / max_colour[col].green;
-				*d++ = 0;
-				*d++ = v;
-				*d++ = 0;
-				*d++ = 255;
-			}
-		}
-		//	Blue
-		for (int32 row=255; row >= 0; --row)
-		{
-			for (int32 col=0; col < source_width; col++)
-			{
-				uint8 v = 256*histogram[col*256 + row].blue / max_colour[col].blue;
-				*d++ = v;
-				*d++ = 0;
-				*d++ = 0;
-				*d++ = 255;
-			}
-		}
-	}
+	enum ScopeMessage {eMsgHistogramSeparate = 'esp0', eMsgHistogramUnified, eMsgWaveformLuma, eMsgWaveformParade, eMsgVectorscope, eMsgSampling};
+	static_assert(eMsgVectorscope - eMsgHistogramSeparate == ColourScopeEngine::SCOPE_VECTORSCOPE, "ScopeMessage / SCOPE_TYPE mismatch");
 
-	/*	FUNCTION:		ScopeView :: PrepareHistogramUnified
-		ARGS:			source
+	/*	FUNCTION:		ScopeView :: DrawVectorscope
+		ARGS:			none
 		RETURN:			n/a
-		DESCRIPTION:	Prepare Histogram (luminance, red/green/blue) unified
+		DESCRIPTION:	Vectorscope (square, centred) with graticule
 	*/
-	void	PrepareHistogramUnified(BBitmap *source)
+	void DrawVectorscope()
 	{
-		assert(source);
-		int32 source_width = source->Bounds().IntegerWidth() + 1;
-		int32 source_height = source->Bounds().IntegerHeight() + 1;
-
-		int32 bytes_per_row = source->BytesPerRow();
-		assert(bytes_per_row == source_width*4);	//	B_RGBA32
-
-		std::vector<COLOUR_VALUES> histogram;
-		histogram.resize(source_width*256);
-		memset(histogram.data(), 0, source_width*256*sizeof(COLOUR_VALUES));
-
-		std::vector<COLOUR_VALUES> max_colour;
-		max_colour.resize(source_width);
-		memset(max_colour.data(), 0, source_width*sizeof(COLOUR_VALUES));
-
-		//	Colour Histogram
-		uint8 *s = (uint8 *)source->Bits();
-		for (int32 row=0; row < source_height; ++row)
-		{
-			for (int32 col=0; col < source_width; col++)
-			{
-				//	BGRA
-				uint8 b = *s++;
-				uint8 g = *s++;
-				uint8 r = *s++;
-				s++;
-
-				//const vec3 LumCoeff = vec3(0.2125, 0.7154, 0.0721);
-				uint8 lum = 0.2125f*r + 0.7154f*g + 0.0721f*b;
-				histogram[col*256 + lum].lum++;
-
-				histogram[col*256 + r].red++;
-				histogram[col*256 + g].green++;
-				histogram[col*256 + b].blue++;
-			}
-		}
-
-		//	Determine max occurance
-		for (int32 col=0; col < source_width; col++)
-		{
-			COLOUR_VALUES &max = max_colour[col];
-			max.SetOne();
-
-			for (int32 row=1; row < 256; ++row)
-			{
-				const COLOUR_VALUES &h = histogram[col*256 + row];
-				if (h.lum > max.lum)
-					max.lum = h.lum;
-				if (h.red > max.red)
-					max.red = h.red;
-				if (h.green > max.green)
-					max.green = h.green;
-				if (h.blue > max.blue)
-					max.blue = h.blue;
-			}
-
-		}
-
-		//	Create fBitmap
-		uint8 *d = (uint8 *)fBitmap->Bits();
-
-		//	Luminance
-		for (int32 row=256; row >= 0; --row)
-		{
-			for (int32 col=0; col < source_width; col++)
-			{
-				uint8 v = 256*histogram[col*256 + row].lum / max_colour[col].lum;
-				*d++ = v;
-				*d++ = v;
-				*d++ = v;
-				*d++ = 255;
-			}
-		}
+		BRect bounds = Bounds();
+		const float size = bounds.Width() < bounds.Height() ? bounds.Width() : bounds.Height();
+		BRect square(0, 0, size, size);
+		square.OffsetTo(bounds.left + 0.5f*(bounds.Width() - size), bounds.top + 0.5f*(bounds.Height() - size));
 
-		//	Unified
-		for (int32 row=256; row >= 0; --row)
-		{
-			for (int32 col=0; col < source_width; col++)
-			{
-				*d++ = 256*histogram[col*256 + row].blue / max_colour[col].blue;
-				*d++ = 256*histogram[col*256 + row].green / max_colour[col].green;
-				*d++ = 256*histogram[col*256 + row].red / max_colour[col].red;
-				*d++ = 255;
-			}
-		}
+		SetHighColor(0, 0, 0);
+		FillRect(bounds);
+		if (fBitmap)
+			DrawBitmapAsync(fBitmap, square);
+
+		const BPoint centre(0.5f*(square.left + square.right), 0.5f*(square.top + square.bottom));
+		SetHighColor(128, 128, 128);
+		StrokeLine(BPoint(square.left, centre.y), BPoint(square.right, centre.y));
+		StrokeLine(BPoint(centre.x, square.top), BPoint(centre.x, square.bottom));
+		StrokeEllipse(centre, 0.5f*size, 0.5f*size);
+		StrokeEllipse(centre, 0.25f*size, 0.25f*size);
 	}
 
 public:
 	ScopeView(BRect bounds)
 	: BView(bounds, nullptr, B_FOLLOW_ALL, B_WILL_DRAW | B_FRAME_EVENTS)
 	{
-		fScopeType = ScopeType::eScopeHistogramSeparate;
+		fScopeType = ColourScopeEngine::SCOPE_HISTOGRAM_SEPARATE;
+		fBitmapType = fScopeType;
+		fStride = 1;
+		fBitmap = nullptr;
 		SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
-		fBitmap = new BBitmap(BRect(0, 0, gProject->mResolution.width - 1, 4*256 - 1), B_RGBA32);
-	}
-	~ScopeView()	override
-	{
-		delete fBitmap;
 	}
 	void Draw(BRect frame)
 	{
+		if (fBitmapType == ColourScopeEngine::SCOPE_VECTORSCOPE)
+		{
+			DrawVectorscope();
+			return;
+		}
+
 		if (fBitmap)
 			DrawBitmapAsync(fBitmap, Bounds());
 
-		int num_segments = 4;
-		if (fScopeType == ScopeType::eScopeHistogramUnified)
-			num_segments = 2;
+		int num_segments;
+		switch (fBitmapType)
+		{
+			case ColourScopeEngine::SCOPE_HISTOGRAM_SEPARATE:	num_segments = 4;	break;
+			case ColourScopeEngine::SCOPE_HISTOGRAM_UNIFIED:	num_segments = 2;	break;
+			default:											num_segments = 1;	break;
+		}
 
 		BRect bounds = Bounds();
 		const float kSegmentSize = bounds.Height()/num_segments;
@@ -286,21 +127,27 @@ public:
 				StrokeLine(BPoint(bounds.left, i*kSegmentSize + j*kSegmentSize/4.0f), BPoint(bounds.right, i*kSegmentSize + j*kSegmentSize/4.0f));
 			}
 		}
+
+		if (fBitmapType == ColourScopeEngine::SCOPE_WAVEFORM_PARADE)
+		{
+			SetHighColor(255, 255, 255);
+			for (int i=1; i < 3; i++)
+				StrokeLine(BPoint(bounds.left + i*bounds.Width()/3.0f, bounds.top), BPoint(bounds.left + i*bounds.Width()/3.0f, bounds.bottom));
+		}
 	}
 	void FrameResized(float width, float height) override
 	{
 		Invalidate();
 	}
-	void SetBitmap(BBitmap *bitmap)
+	void SetResult(BBitmap *bitmap, const ColourScopeEngine::SCOPE_TYPE type)
 	{
-		switch (fScopeType)
-		{
-			case ScopeType::eScopeHistogramSeparate:		PrepareHistogramSeparate(bitmap);			break;
-			case ScopeType::eScopeHistogramUnified:			PrepareHistogramUnified(bitmap);			break;
-			default:	assert(0);
-		}
+		fBitmap = bitmap;
+		fBitmapType = type;
 		Invalidate();
 	}
+	ColourScopeEngine::SCOPE_TYPE	GetScopeType() const	{return fScopeType;}
+	int								GetStride() const		{return fStride;}
+
 	void MouseDown(BPoint point)
 	{
 		uint32 buttons;
@@ -314,14 +161,39 @@ public:
 			BPopUpMenu *aPopUpMenu = new BPopUpMenu("ContextMenuColourScope", false, false);
 			aPopUpMenu->SetAsyncAutoDestruct(true);
 
-			BMenuItem *aMenuItem = new BMenuItem(GetText(TXT_COLOUR_SCOPE_SEPARATE_COLOURS), new BMessage(ScopeMessage::eMsgHistogramSeparate));
-			if (fScopeType == ScopeType::eScopeHistogramSeparate)
-				aMenuItem->SetMarked(true);
-			aPopUpMenu->AddItem(aMenuItem);
-			aMenuItem = new BMenuItem(GetText(TXT_COLOUR_SCOPE_UNIFIED_COLOURS), new BMessage(ScopeMessage::eMsgHistogramUnified));
-			if (fScopeType == ScopeType::eScopeHistogramUnified)
-				aMenuItem->SetMarked(true);
-			aPopUpMenu->AddItem(aMenuItem);
+			const LANGUAGE_TEXT kScopeText[ColourScopeEngine::NUMBER_SCOPE_TYPES] =
+			{
+				TXT_COLOUR_SCOPE_SEPARATE_COLOURS,
+				TXT_COLOUR_SCOPE_UNIFIED_COLOURS,
+				TXT_COLOUR_SCOPE_WAVEFORM_LUMA,
+				TXT_COLOUR_SCOPE_WAVEFORM_RGB_PARADE,
+				TXT_COLOUR_SCOPE_VECTORSCOPE,
+			};
+			for (int i=0; i < ColourScopeEngine::NUMBER_SCOPE_TYPES; i++)
+			{
+				BMenuItem *aMenuItem = new BMenuItem(GetText(kScopeText[i]), new BMessage(ScopeMessage::eMsgHistogramSeparate + i));
+				if (fScopeType == i)
+					aMenuItem->SetMarked(true);
+				aPopUpMenu->AddItem(aMenuItem);
+			}
+
+			//	Sampling stride
+			BMenu *sampling_menu = new BMenu(GetText(TXT_COLOUR_SCOPE_SAMPLING));
+			const int kStrides[] = {1, 2, 4};
+			for (auto stride : kStrides)
+			{
+				char buffer[8];
+				sprintf(buffer, "1:%d", stride);
+				BMessage *sampling_msg = new BMessage(ScopeMessage::eMsgSampling);
+				sampling_msg->AddInt32("stride", stride);
+				BMenuItem *aMenuItem = new BMenuItem(buffer, sampling_msg);
+				if (fStride == stride)
+					aMenuItem->SetMarked(true);
+				sampling_menu->AddItem(aMenuItem);
+			}
+			sampling_menu->SetTargetForItems(this);
+			aPopUpMenu->AddSeparatorItem();
+			aPopUpMenu->AddItem(sampling_menu);
 
 			aPopUpMenu->SetTargetForItems(this);
 			aPopUpMenu->Go(point, true /*notify*/, false /*stay open when mouse away*/, true /*async*/);
@@ -335,17 +207,23 @@ public:
 		switch (msg->what)
 		{
 			case ScopeMessage::eMsgHistogramSeparate:
-				fScopeType = ScopeType::eScopeHistogramSeparate;
-				delete fBitmap;
-				fBitmap = new BBitmap(BRect(0, 0, gProject->mResolution.width - 1, 4*256 - 1), B_RGBA32);
-				gProject->InvalidatePreview();
-				break;
 			case ScopeMessage::eMsgHistogramUnified:
-				delete fBitmap;
-				fBitmap = new BBitmap(BRect(0, 0, gProject->mResolution.width - 1, 2*256 - 1), B_RGBA32);
-				fScopeType = ScopeType::eScopeHistogramUnified;
+			case ScopeMessage::eMsgWaveformLuma:
+			case ScopeMessage::eMsgWaveformParade:
+			case ScopeMessage::eMsgVectorscope:
+				fScopeType = (ColourScopeEngine::SCOPE_TYPE)(msg->what - ScopeMessage::eMsgHistogramSeparate);
 				gProject->InvalidatePreview();
 				break;
+			case ScopeMessage::eMsgSampling:
+			{
+				int32 stride;
+				if (msg->FindInt32("stride", &stride) == B_OK)
+				{
+					fStride = stride;
+					gProject->InvalidatePreview();
+				}
+				break;
+			}
 			default:
 				BView::MessageReceived(msg);
 				break;
@@ -368,6 +246,16 @@ ColourScope :: ColourScope(BRect frame, const char *title)
 {
 	fScopeView = new ScopeView(Bounds());
 	AddChild(fScopeView);
+
+	if ((fRenderSemaphore = create_sem(0, "ColourScope Semaphore")) < B_OK)
+	{
+		printf("ColourScope() - cannot create fRenderSemaphore\n");
+		exit(1);
+	}
+	fEngine = new ColourScopeEngine;
+	fScopeActor = new ScopeActor(fEngine, this, fRenderSemaphore);
+	fRenderPending = false;
+	fFramePending = false;
 }
 
 /*	FUNCTION:		ColourScope :: ~ColourScope
@@ -377,6 +265,43 @@ ColourScope :: ColourScope(BRect frame, const char *title)
 */
 ColourScope :: ~ColourScope()
 {
+	if (fRenderPending)
+		acquire_sem(fRenderSemaphore);
+	delete fScopeActor;
+	delete fEngine;
+	delete_sem(fRenderSemaphore);
+}
+
+/*	FUNCTION:		ColourScope :: StartRender
+	ARGS:			frame
+	RETURN:			n/a
+	DESCRIPTION:	Snapshot frame immediately (the bitmap is owned by the RenderActor / FrameCache and
+					may be recycled or evicted once this message is processed), analyse on fScopeActor.
+					Only one render in flight, newer frames replace the staged snapshot.
+*/
+void ColourScope :: StartRender(BBitmap *frame)
+{
+	fEngine->SetFrame(frame, fScopeView->GetStride());
+	if (fRenderPending)
+	{
+		fFramePending = true;
+		return;
+	}
+	RenderStagedFrame();
+}
+
+/*	FUNCTION:		ColourScope :: RenderStagedFrame
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Analyse most recent snapshot on fScopeActor (no render in flight)
+*/
+void ColourScope :: RenderStagedFrame()
+{
+	assert(!fRenderPending);
+	fEngine->CommitFrame();
+	fFramePending = false;
+	fRenderPending = true;
+	fScopeActor->Async<&ScopeActor::AsyncRender>(fScopeView->GetScopeType());
 }
 
 /*	FUNCTION:		ColourScope :: MessageReceived
@@ -402,12 +327,25 @@ void ColourScope :: MessageReceived(BMessage *msg)
 						delete msg;
 					}
 				}
-				fScopeView->SetBitmap(bitmap);
+				StartRender(bitmap);
 			}
 			break;
 		}
+		case eMsgScopeReady:
+		{
+			acquire_sem(fRenderSemaphore);
+			fRenderPending = false;
+
+			BBitmap *result;
+			int32 type;
+			if ((msg->FindPointer("BBitmap", (void **)&result) == B_OK) && (msg->FindInt32("type", &type) == B_OK))
+				fScopeView->SetResult(result, (ColourScopeEngine::SCOPE_TYPE)type);
+
+			if (fFramePending)
+				RenderStagedFrame();
+			break;
+		}
 		default:
 			BWindow::MessageReceived(msg);
 	}
 }
-
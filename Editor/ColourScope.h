@@ -13,6 +13,8 @@
 
 class BBitmap;
 class ScopeView;
+class ScopeActor;
+class ColourScopeEngine;
 
 class ColourScope : public PersistantWindow
 {
@@ -21,8 +23,18 @@ public:
 						~ColourScope()					override;
 	void				MessageReceived(BMessage *msg)	override;
 
+	enum {eMsgScopeReady = 'escr'};
+
 private:
 	ScopeView			*fScopeView;
+	ColourScopeEngine	*fEngine;
+	ScopeActor			*fScopeActor;
+	sem_id				fRenderSemaphore;
+	bool				fRenderPending;
+	bool				fFramePending;		//	staged in fEngine, waiting for fRenderPending to clear
+
+	void				StartRender(BBitmap *frame);
+	void				RenderStagedFrame();
 };
 
 
@@ -0,0 +1,385 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Colour scope engine (histograms, waveforms, vectorscope)
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <mutex>
+
+#include <interface/Bitmap.h>
+
+#include "ColourScopeEngine.h"
+#include "ParallelFor.h"
+
+#if defined (__GNUC__)
+	#if defined(__amd64__)
+		#define Y_CPU_X86
+	#endif
+#elif defined (_MSC_VER)
+	#define Y_CPU_X86
+#endif
+
+#ifdef Y_CPU_X86
+#include <emmintrin.h>
+#endif
+
+static const int kColumnStrip = 64;			//	columns per tile (histogram fits in L2)
+static const int kMinRowBand = 16;
+
+//	BT.709, Q15 fixed point (B, G, R order to match BGRA memory layout)
+static const int16 kLuma[3] = {2363, 23442, 6963};
+static const int16 kChromaB[3] = {16384, -12632, -3752};
+static const int16 kChromaR[3] = {-1499, -14885, 16384};
+
+#ifdef Y_CPU_X86
+/*	FUNCTION:		DotBGR4
+	ARGS:			pixels (4 x BGRA)
+					coefficients (B, G, R, 0, B, G, R, 0)
+					bias (Q15)
+	RETURN:			4 x uint8 (saturated)
+	DESCRIPTION:	Weighted sum of 4 pixels
+*/
+static inline uint32 DotBGR4(const __m128i pixels, const __m128i coefficients, const __m128i bias)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coefficients);		//	(b*cb + g*cg, r*cr) for pixels 0, 1
+	__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coefficients);		//	pixels 2, 3
+	lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+	hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+	__m128i sum = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+	sum = _mm_srai_epi32(_mm_add_epi32(sum, bias), 15);
+	sum = _mm_packs_epi32(sum, sum);
+	return (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+}
+#endif
+
+/*	FUNCTION:		DotBGR
+	ARGS:			pixels (BGRA)
+					count
+					coefficients (B, G, R)
+					offset (added to result, eg. 128 for chroma)
+					result (uint8 per pixel)
+	RETURN:			n/a
+	DESCRIPTION:	Weighted sum of BGR components (luma / chroma), rounded and saturated
+*/
+static void DotBGR(const uint32 *pixels, const int count, const int16 coefficients[3], const int offset, uint8 *result)
+{
+	const int32 bias = (offset << 15) + (1 << 14);
+	int i = 0;
+#ifdef Y_CPU_X86
+	const __m128i c = _mm_setr_epi16(coefficients[0], coefficients[1], coefficients[2], 0, coefficients[0], coefficients[1], coefficients[2], 0);
+	const __m128i b = _mm_set1_epi32(bias);
+	for (; i + 4 <= count; i += 4)
+	{
+		const uint32 v = DotBGR4(_mm_loadu_si128((const __m128i *)(pixels + i)), c, b);
+		memcpy(result + i, &v, 4);
+	}
+#endif
+	for (; i < count; i++)
+	{
+		const uint8 *p = (const uint8 *)(pixels + i);
+		const int32 v = (p[0]*coefficients[0] + p[1]*coefficients[1] + p[2]*coefficients[2] + bias) >> 15;
+		result[i] = (uint8)std::clamp(v, 0, 255);
+	}
+}
+
+/*	FUNCTION:		SetPixel
+	ARGS:			d (B_RGBA32)
+					b, g, r
+	RETURN:			n/a
+	DESCRIPTION:	Opaque output pixel
+*/
+static inline void SetPixel(uint8 *d, const uint8 b, const uint8 g, const uint8 r)
+{
+	d[0] = b;
+	d[1] = g;
+	d[2] = r;
+	d[3] = 255;
+}
+
+/*	FUNCTION:		ColourScopeEngine :: ColourScopeEngine
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+ColourScopeEngine :: ColourScopeEngine()
+	: fWidth(0), fHeight(0), fStagingWidth(0), fStagingHeight(0), fResultIndex(0)
+{
+	fResult[0] = nullptr;
+	fResult[1] = nullptr;
+}
+
+/*	FUNCTION:		ColourScopeEngine :: ~ColourScopeEngine
+	ARGS:			n/a
+	RETURN:			n/a
+	DESCRIPTION:	Destructor
+*/
+ColourScopeEngine :: ~ColourScopeEngine()
+{
+	delete fResult[0];
+	delete fResult[1];
+}
+
+/*	FUNCTION:		ColourScopeEngine :: SetFrame
+	ARGS:			source (B_RGBA32)
+					stride (sample every stride'th pixel and row)
+	RETURN:			n/a
+	DESCRIPTION:	Snapshot frame into staging buffer (source may be modified after return)
+					Safe while Render() is in flight, see CommitFrame()
+*/
+void ColourScopeEngine :: SetFrame(BBitmap *source, const int stride)
+{
+	assert(source && (stride > 0));
+	const int source_width = source->Bounds().IntegerWidth() + 1;
+	const int source_height = source->Bounds().IntegerHeight() + 1;
+	const int32 bytes_per_row = source->BytesPerRow();
+	const uint8 *bits = (const uint8 *)source->Bits();
+
+	const int width = (source_width + stride - 1)/stride;
+	const int height = (source_height + stride - 1)/stride;
+	assert(height < 0x8000);		//	uint16 column counters, signed SIMD max
+	fStagingWidth = width;
+	fStagingHeight = height;
+	fStagingFrame.resize((size_t)width*height);
+
+	ParallelFor(height, 32, [&](const int row_start, const int row_end)
+	{
+		for (int y=row_start; y < row_end; y++)
+		{
+			const uint32 *s = (const uint32 *)(bits + (size_t)y*stride*bytes_per_row);
+			uint32 *d = fStagingFrame.data() + (size_t)y*width;
+			if (stride == 1)
+				memcpy(d, s, width*sizeof(uint32));
+			else
+			{
+				for (int x=0; x < width; x++)
+					d[x] = s[x*stride];
+			}
+		}
+	});
+}
+
+/*	FUNCTION:		ColourScopeEngine :: CommitFrame
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Staged frame (SetFrame) becomes the Render() source.  Caller ensures no Render() in flight.
+*/
+void ColourScopeEngine :: CommitFrame()
+{
+	fFrame.swap(fStagingFrame);
+	fWidth = fStagingWidth;
+	fHeight = fStagingHeight;
+}
+
+/*	FUNCTION:		ColourScopeEngine :: GetResultBitmap
+	ARGS:			width
+					height
+	RETURN:			result bitmap (not the most recently returned result)
+	DESCRIPTION:	Reuse bitmap if dimensions match
+*/
+BBitmap * ColourScopeEngine :: GetResultBitmap(const int width, const int height)
+{
+	fResultIndex ^= 1;
+	BBitmap *&bitmap = fResult[fResultIndex];
+	if (bitmap && ((bitmap->Bounds().IntegerWidth() + 1 != width) || (bitmap->Bounds().IntegerHeight() + 1 != height)))
+	{
+		delete bitmap;
+		bitmap = nullptr;
+	}
+	if (!bitmap)
+		bitmap = new BBitmap(BRect(0, 0, width - 1, height - 1), B_RGBA32);
+	return bitmap;
+}
+
+/*	FUNCTION:		ColourScopeEngine :: Render
+	ARGS:			type
+	RETURN:			scope bitmap (owned by engine, valid until the Render() after next)
+	DESCRIPTION:	Analyse frame from SetFrame()
+*/
+BBitmap * ColourScopeEngine :: Render(const SCOPE_TYPE type)
+{
+	if ((fWidth == 0) || (fHeight == 0))
+		return nullptr;
+
+	BBitmap *result = nullptr;
+	switch (type)
+	{
+		case SCOPE_HISTOGRAM_SEPARATE:	result = GetResultBitmap(fWidth, 4*256);							break;
+		case SCOPE_HISTOGRAM_UNIFIED:	result = GetResultBitmap(fWidth, 2*256);							break;
+		case SCOPE_WAVEFORM_LUMA:		result = GetResultBitmap(fWidth, 256);								break;
+		case SCOPE_WAVEFORM_PARADE:		result = GetResultBitmap(3*fWidth, 256);							break;
+		case SCOPE_VECTORSCOPE:			result = GetResultBitmap(kVectorscopeSize, kVectorscopeSize);		break;
+		default:						assert(0);															return nullptr;
+	}
+
+	if (type == SCOPE_VECTORSCOPE)
+		RenderVectorscope(result);
+	else
+		RenderColumns(type, result);
+	return result;
+}
+
+/*	FUNCTION:		ColourScopeEngine :: RenderColumns
+	ARGS:			type
+					result
+	RETURN:			n/a
+	DESCRIPTION:	Column scopes, tiled into column strips
+*/
+void ColourScopeEngine :: RenderColumns(const SCOPE_TYPE type, BBitmap *result)
+{
+	ParallelFor(fWidth, kColumnStrip, [&](const int col_start, const int col_end)
+	{
+		std::vector<COLOUR_VALUES> histogram(kColumnStrip*256);
+		RenderColumnStrip(type, result, col_start, col_end, histogram.data());
+	});
+}
+
+/*	FUNCTION:		ColourScopeEngine :: RenderColumnStrip
+	ARGS:			type
+					result
+					col_start, col_end
+					histogram (zeroed, kColumnStrip*256)
+	RETURN:			n/a
+	DESCRIPTION:	Per column value counts, normalised by column maximum (black excluded)
+*/
+void ColourScopeEngine :: RenderColumnStrip(const SCOPE_TYPE type, BBitmap *result, const int col_start, const int col_end, COLOUR_VALUES *histogram)
+{
+	const int count = col_end - col_start;
+	assert(count <= kColumnStrip);
+
+	//	Accumulate
+	uint8 lum[kColumnStrip];
+	for (int y=0; y < fHeight; y++)
+	{
+		const uint32 *s = fFrame.data() + (size_t)y*fWidth + col_start;
+		DotBGR(s, count, kLuma, 0, lum);
+		for (int c=0; c < count; c++)
+		{
+			const uint8 *p = (const uint8 *)(s + c);
+			COLOUR_VALUES *h = histogram + c*256;
+			h[lum[c]].lum++;
+			h[p[2]].red++;
+			h[p[1]].green++;
+			h[p[0]].blue++;
+		}
+	}
+
+	uint8 *bits = (uint8 *)result->Bits();
+	const int32 bytes_per_row = result->BytesPerRow();
+	for (int c=0; c < count; c++)
+	{
+		const COLOUR_VALUES *h = histogram + c*256;
+
+		//	Max occurrence (excluding black)
+		COLOUR_VALUES max;
+#ifdef Y_CPU_X86
+		__m128i m = _mm_loadl_epi64((const __m128i *)(h + 1));
+		for (int v=2; v < 256; v += 2)
+			m = _mm_max_epi16(m, _mm_loadu_si128((const __m128i *)(h + v)));
+		m = _mm_max_epi16(m, _mm_srli_si128(m, 8));
+		_mm_storel_epi64((__m128i *)&max, m);
+#else
+		max = h[1];
+		for (int v=2; v < 256; v++)
+		{
+			max.lum = std::max(max.lum, h[v].lum);
+			max.red = std::max(max.red, h[v].red);
+			max.green = std::max(max.green, h[v].green);
+			max.blue = std::max(max.blue, h[v].blue);
+		}
+#endif
+		const float scale_lum = 255.0f/std::max<uint16>(max.lum, 1);
+		const float scale_red = 255.0f/std::max<uint16>(max.red, 1);
+		const float scale_green = 255.0f/std::max<uint16>(max.green, 1);
+		const float scale_blue = 255.0f/std::max<uint16>(max.blue, 1);
+		auto intensity = [](const uint16 value, const float scale) {return (uint8)std::min(value*scale, 255.0f);};
+
+		//	Output (value 255 at top of each segment), BGRA
+		const int x = col_start + c;
+		for (int v=0; v < 256; v++)
+		{
+			const uint8 l = intensity(h[v].lum, scale_lum);
+			const uint8 r = intensity(h[v].red, scale_red);
+			const uint8 g = intensity(h[v].green, scale_green);
+			const uint8 b = intensity(h[v].blue, scale_blue);
+			uint8 *d = bits + (255 - v)*bytes_per_row + 4*x;
+			const int32 segment = 256*bytes_per_row;
+			switch (type)
+			{
+				case SCOPE_HISTOGRAM_SEPARATE:
+					SetPixel(d, l, l, l);
+					SetPixel(d + segment, 0, 0, r);
+					SetPixel(d + 2*segment, 0, g, 0);
+					SetPixel(d + 3*segment, b, 0, 0);
+					break;
+				case SCOPE_HISTOGRAM_UNIFIED:
+					SetPixel(d, l, l, l);
+					SetPixel(d + segment, b, g, r);
+					break;
+				case SCOPE_WAVEFORM_LUMA:
+					SetPixel(d, l, l, l);
+					break;
+				case SCOPE_WAVEFORM_PARADE:
+					SetPixel(d, 0, 0, r);
+					SetPixel(d + 4*fWidth, 0, g, 0);
+					SetPixel(d + 8*fWidth, b, 0, 0);
+					break;
+				default:
+					assert(0);
+			}
+		}
+	}
+}
+
+/*	FUNCTION:		ColourScopeEngine :: RenderVectorscope
+	ARGS:			result
+	RETURN:			n/a
+	DESCRIPTION:	Cb/Cr density, tiled into row bands (per band histogram merged into fVectorscope)
+*/
+void ColourScopeEngine :: RenderVectorscope(BBitmap *result)
+{
+	const int kSize = kVectorscopeSize;
+	fVectorscope.assign(kSize*kSize, 0);
+	std::mutex merge_lock;
+
+	const int band = std::max(kMinRowBand, (fHeight + ParallelForConcurrency() - 1)/ParallelForConcurrency());
+	ParallelFor(fHeight, band, [&](const int row_start, const int row_end)
+	{
+		std::vector<uint32> histogram(kSize*kSize, 0);
+		std::vector<uint8> cb(fWidth);
+		std::vector<uint8> cr(fWidth);
+		for (int y=row_start; y < row_end; y++)
+		{
+			const uint32 *s = fFrame.data() + (size_t)y*fWidth;
+			DotBGR(s, fWidth, kChromaB, 128, cb.data());
+			DotBGR(s, fWidth, kChromaR, 128, cr.data());
+			for (int x=0; x < fWidth; x++)
+				histogram[cr[x]*kSize + cb[x]]++;
+		}
+
+		std::lock_guard<std::mutex> lock(merge_lock);
+		for (int i=0; i < kSize*kSize; i++)
+			fVectorscope[i] += histogram[i];
+	});
+
+	//	Square root response, otherwise the neutral axis hides everything else
+	const uint32 max = std::max<uint32>(*std::max_element(fVectorscope.begin(), fVectorscope.end()), 1);
+	const float scale = 255.0f/sqrtf((float)max);
+	uint8 *bits = (uint8 *)result->Bits();
+	const int32 bytes_per_row = result->BytesPerRow();
+	for (int y=0; y < kSize; y++)
+	{
+		const uint32 *h = fVectorscope.data() + (kSize - 1 - y)*kSize;		//	Cr increases upwards
+		uint8 *d = bits + y*bytes_per_row;
+		for (int x=0; x < kSize; x++)
+		{
+			const uint8 v = (uint8)std::min(sqrtf((float)h[x])*scale, 255.0f);
+			SetPixel(d + 4*x, v, v, v);
+		}
+	}
+}
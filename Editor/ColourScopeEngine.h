@@ -0,0 +1,77 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Colour scope engine (histograms, waveforms, vectorscope)
+ */
+
+#ifndef _COLOUR_SCOPE_ENGINE_H_
+#define _COLOUR_SCOPE_ENGINE_H_
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _SUPPORT_DEFS_H
+#include <support/SupportDefs.h>
+#endif
+
+class BBitmap;
+
+/*****************************
+	ColourScopeEngine analyses a snapshot of the output frame.
+	SetFrame() copies every stride'th pixel / row of the frame into a staging buffer (the preview
+	bitmap is reused or evicted by the RenderActor, the snapshot is not), so it must be called as
+	soon as the frame arrives, even while a Render() is in flight.  CommitFrame() makes the staged
+	frame the Render() source and must not overlap Render(), which may then run on any thread.
+	Column scopes are tiled into column strips (no merging, each strip owns its histogram),
+	the vectorscope is tiled into row bands with per band histograms.  Tiles are processed
+	by ParallelFor, luma/chroma conversion uses SSE2 (fixed point, BT.709).
+	Render() alternates between 2 result bitmaps, so the previous result can be drawn
+	while the next is prepared.
+******************************/
+class ColourScopeEngine
+{
+public:
+	enum SCOPE_TYPE
+	{
+		SCOPE_HISTOGRAM_SEPARATE,		//	luma, red, green, blue waveforms (stacked)
+		SCOPE_HISTOGRAM_UNIFIED,		//	luma, combined RGB waveforms (stacked)
+		SCOPE_WAVEFORM_LUMA,
+		SCOPE_WAVEFORM_PARADE,			//	red, green, blue waveforms (side by side)
+		SCOPE_VECTORSCOPE,				//	Cb (x) / Cr (y)
+		NUMBER_SCOPE_TYPES
+	};
+	static const int	kVectorscopeSize = 256;
+
+						ColourScopeEngine();
+						~ColourScopeEngine();
+
+	void				SetFrame(BBitmap *source, const int stride);
+	void				CommitFrame();
+	BBitmap				*Render(const SCOPE_TYPE type);
+
+private:
+	struct COLOUR_VALUES
+	{
+		uint16			lum;
+		uint16			red;
+		uint16			green;
+		uint16			blue;
+	};
+	void				RenderColumns(const SCOPE_TYPE type, BBitmap *result);
+	void				RenderColumnStrip(const SCOPE_TYPE type, BBitmap *result, const int col_start, const int col_end, COLOUR_VALUES *histogram);
+	void				RenderVectorscope(BBitmap *result);
+	BBitmap				*GetResultBitmap(const int width, const int height);
+
+	std::vector<uint32>	fFrame;				//	sampled BGRA pixels (Render source)
+	int					fWidth;
+	int					fHeight;
+	std::vector<uint32>	fStagingFrame;		//	SetFrame() target
+	int					fStagingWidth;
+	int					fStagingHeight;
+	std::vector<uint32>	fVectorscope;
+	BBitmap				*fResult[2];
+	int					fResultIndex;
+};
+
+#endif	//#ifndef _COLOUR_SCOPE_ENGINE_H_
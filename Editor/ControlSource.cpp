@@ -534,7 +534,7 @@ void PreviewActor :: AsyncTimerTick()
 */
 ControlSource :: ControlSource(BRect frame)
 	: BView(frame, "ControlSource", B_FOLLOW_LEFT | B_FOLLOW_TOP, B_WILL_DRAW | B_FRAME_EVENTS | B_FULL_UPDATE_ON_RESIZE),
-	fBitmap(nullptr)
+	fBitmap(nullptr), fVideoFrame(nullptr)
 {
 	SetViewColor(B_TRANSPARENT_COLOR);
 	
@@ -551,6 +551,19 @@ ControlSource :: ControlSource(BRect frame)
 */
 ControlSource :: ~ControlSource()
 {
+	gVideoManager->ReleaseFrameBitmap(fVideoFrame);
+}
+
+/*	FUNCTION:		ControlSource :: SetVideoFrame
+	ARGS:			bitmap (pinned video frame or nullptr)
+	RETURN:			n/a
+	DESCRIPTION:	Release previous video frame, display bitmap
+*/
+void ControlSource :: SetVideoFrame(BBitmap *bitmap)
+{
+	gVideoManager->ReleaseFrameBitmap(fVideoFrame);
+	fVideoFrame = bitmap;
+	fBitmap = bitmap;
 }
 
 /*	FUNCTION:		ControlSource :: FrameResized
@@ -639,7 +652,7 @@ void ControlSource :: SetMediaSource(MediaSource *media)
 		case MediaSource::MEDIA_VIDEO_AND_AUDIO:
 		{
 			assert(fMediaSource->GetVideoTrack() != nullptr);
-			fBitmap = gVideoManager->GetFrameBitmap(fMediaSource, 0);
+			SetVideoFrame(gVideoManager->GetFrameBitmap(fMediaSource, 0));
 			if (fClipTimeline->Parent() == nullptr)
 				AddChild(fClipTimeline);
 			fClipTimeline->Init(fMediaSource->GetVideoTrack(), fMediaSource);
@@ -649,6 +662,7 @@ void ControlSource :: SetMediaSource(MediaSource *media)
 		{
 			assert(fMediaSource->GetAudioTrack() != nullptr);
 			BRect frame = Bounds();
+			SetVideoFrame(nullptr);
 			fBitmap = gAudioManager->GetBitmapAsync(fMediaSource, 0, fMediaSource->GetAudioNumberSamples() * kFramesSecond/fMediaSource->GetAudioFrameRate(), frame.Width(), frame.Height());
 			if (fClipTimeline->Parent() == nullptr)
 				AddChild(fClipTimeline);
@@ -657,6 +671,7 @@ void ControlSource :: SetMediaSource(MediaSource *media)
 		}
 		case MediaSource::MEDIA_PICTURE:
 		{
+			SetVideoFrame(nullptr);
 			fBitmap = fMediaSource->GetBitmap();
 			if (fClipTimeline->Parent() == nullptr)
 				AddChild(fClipTimeline);
@@ -680,11 +695,12 @@ void ControlSource :: ShowPreview(int64 frame_idx)
 {
 	if (fMediaSource->GetVideoTrack())
 	{
-		fBitmap = gVideoManager->GetFrameBitmap(fMediaSource, frame_idx);
+		SetVideoFrame(gVideoManager->GetFrameBitmap(fMediaSource, frame_idx));
 	}
 	else if (fMediaSource->GetAudioTrack())
 	{
 		BRect frame = Bounds();
+		SetVideoFrame(nullptr);
 		fBitmap = gAudioManager->GetBitmapAsync(fMediaSource, 0, fMediaSource->GetAudioNumberSamples() * kFramesSecond/fMediaSource->GetAudioFrameRate(), frame.Width(), frame.Height());
 	}
 
@@ -29,7 +29,10 @@ public:
 	void			ShowPreview(int64 frame);
 
 private:
+	void			SetVideoFrame(BBitmap *bitmap);
+
 	BBitmap			*fBitmap;
+	BBitmap			*fVideoFrame;		//	pinned by VideoManager::GetFrameBitmap()
 	MediaSource		*fMediaSource;
 	ClipTimeline	*fClipTimeline;
 };
@@ -10,6 +10,7 @@
 #include "Language.h"
 #include "MedoWindow.h"
 #include "Project.h"
+#include "RenderActor.h"
 #include "TimelineEdit.h"
 #include "Theme.h"
 
@@ -119,6 +120,7 @@ EffectNode :: EffectNode(BRect frame, const char *view_name, const bool scroll_v
 
 	mRenderObjectsInitialised = false;
 	mSwapTexturesCheckbox = nullptr;
+	fGuiCreated = false;
 
 	if (!sMsgEffectSelected)
 	{
@@ -138,6 +140,19 @@ void EffectNode :: MouseDown(BPoint point)
 		Window()->Activate();
 }
 
+/*	FUNCTION:		EffectNode :: CreateGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects once (most effects are never used in a session)
+*/
+void EffectNode :: CreateGui()
+{
+	if (fGuiCreated)
+		return;
+	fGuiCreated = true;
+	InitGui();
+}
+
 /*	FUNCTION:		MedoWindow :: FrameResized
 	ARGS:			width
 					height
@@ -169,6 +184,20 @@ void EffectNode :: FrameResized(float width, float height)
 	BView::FrameResized(width, height);
 }
 
+/*	FUNCTION:		EffectNode :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			n/a
+	DESCRIPTION:	Texture based render.  Legacy effects (and add-ons) only implement the BBitmap version,
+					so read back the render target and fall back.  Effects override this to stay GPU resident.
+*/
+void EffectNode :: RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	RenderEffect(source ? gRenderActor->GetTextureBitmap(source) : nullptr, data, frame_idx, chained_effects);
+}
+
 /*	FUNCTION:		EffectNode :: SetViewIdealSize
 	ARGS:			width
 					height
@@ -257,8 +286,12 @@ void EffectNode :: MediaEffectDeselectedBase(MediaEffect *effect)
 	ARGS:			none
 	RETURN:			n/a
 	DESCRIPTION:	Redraw preview
+					Effect parameter changes only modify the effect timeline range
 */
 void EffectNode :: InvalidatePreview()
 {
-	gProject->InvalidatePreview();
+	if (sCurrentMediaEffect)
+		gProject->InvalidatePreview(sCurrentMediaEffect->mTimelineFrameStart, sCurrentMediaEffect->mTimelineFrameEnd);
+	else
+		gProject->InvalidatePreview();
 }
@@ -31,6 +31,13 @@ class MediaEffect;
 class TimelineTrack;
 class MediaClip;
 class EffectDragDropButton;
+class ColourFusionProgram;
+class SoftwareRender;
+
+namespace yrender
+{
+	class YTexture;
+};
 
 struct FRAME_ITEM
 {
@@ -57,6 +64,12 @@ public:
 	virtual void			InitRenderObjects() { }
 	virtual void			DestroyRenderObjects() { }
 	bool					mRenderObjectsInitialised;
+
+	//	Gui objects are created on first use, not at startup.  CreateGui() is called by EffectsWindow before
+	//	the node is shown and by EffectsManager before CreateMediaEffect(), derived classes build their controls
+	//	in InitGui().  Called from window thread.
+	void					CreateGui();
+	virtual void			InitGui() { }
 		
 	//	Project load/save
 	virtual EFFECT_GROUP	GetEffectGroup() const = 0;
@@ -80,6 +93,13 @@ public:
 	//	Render effect
 	virtual void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx,
 										std::deque<FRAME_ITEM> & chained_effects) { }
+	//	GPU resident render, source is a RenderActor render target texture (no readback).
+	//	Default implementation reads back source and calls the BBitmap version (legacy add-ons)
+	virtual void			RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx,
+										std::deque<FRAME_ITEM> & chained_effects);
+	//	CPU render (--software-render, see SoftwareRender.h).  Destination holds the frame buffer contents,
+	//	output is blended into destination.  Return false if not supported (effect is skipped).
+	virtual bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx) {return false;}
 	virtual int				AudioEffect(MediaEffect *effect, uint8 *destination, uint8 *source,
 										const int64 start_frame, const int64 end_frame,
 										const int64 audio_start, const int64 audio_end,
@@ -95,9 +115,15 @@ public:
 	virtual bool			IsColourEffect() const {return false;}
 	virtual rgb_color		ChainedColourEffect(MediaEffect *data, int64 frame_idx) {return {0, 0, 0, 0}; }
 
+	//	Per pixel effects which can be fused with neighbours into a single shader pass (see ColourFusion.h).
+	//	Source defines "vec4 Fusion@(vec4 colour, vec2 uv)", all global identifiers end with '@'.
+	virtual const char		*GetColourFusionSource(MediaEffect *data) {return nullptr;}
+	virtual void			SetColourFusionUniforms(ColourFusionProgram *program, const int stage, MediaEffect *data, int64 frame_idx) { }
+
 //	Inherited drag/drop button
 private:
 	EffectDragDropButton	*fEffectDragDropButton;
+	bool					fGuiCreated;
 	static MediaEffect		*sCurrentMediaEffect;
 	static BMessage			*sMsgEffectSelected;
 protected:
@@ -10,6 +10,7 @@
  
 #include "EffectNode.h"
 #include "EffectsManager.h"
+#include "ParallelFor.h"
 #include "RenderActor.h"
 #include "Project.h" 
 
@@ -44,6 +45,7 @@
 */
 EffectsManager :: EffectsManager(BRect preview_frame)
 {
+	const bigtime_t start_time = system_time();
 	preview_frame.OffsetTo(0, 0);
 	
 	fEffectNone = new Effect_None(preview_frame, nullptr);
@@ -73,9 +75,11 @@ EffectsManager :: EffectsManager(BRect preview_frame)
 	fEffectNodes.push_back(new Effect_Marker(preview_frame, nullptr));
 
 	//	Load AddOns
+	const bigtime_t addons_time = system_time();
 	LoadAllAddOns(preview_frame);
 
-	//	Load plugins from application path
+	//	Load plugins from application path, then Config path (descriptors parsed in parallel)
+	const bigtime_t plugins_time = system_time();
 	app_info appInfo;
 	be_app->GetAppInfo(&appInfo);
 	BPath executable_path(&appInfo.ref);
@@ -83,21 +87,27 @@ EffectsManager :: EffectsManager(BRect preview_frame)
 	int last_dir = plugin_path.FindLast('/');
 	plugin_path.Truncate(last_dir+1);
 	plugin_path.Append("Plugins");
-	LoadPlugins(plugin_path.String());
+	std::vector<std::string> plugin_files;
+	FindFiles(plugin_path.String(), ".plugin", plugin_files);
 
-	// Load plugins from Config path
 	BPath config_path;
 	find_directory(B_USER_CONFIG_DIRECTORY, &config_path);
 	plugin_path.SetTo(config_path.Path());
 	plugin_path.Append("/settings/Medo/Plugins");
-	LoadPlugins(plugin_path);
+	FindFiles(plugin_path.String(), ".plugin", plugin_files);
+	LoadPlugins(plugin_files);
 
-	//	Reverse add plugins
+	//	Reverse add plugins (GUI created when first used, see EffectNode::CreateGui())
 	for (std::vector<EffectPlugin *>::const_reverse_iterator ri = fEffectPlugins.rbegin(); ri != fEffectPlugins.rend(); ri++)
 	{
 		Effect_Plugin *node_plugin = new Effect_Plugin((*ri), preview_frame, nullptr);
 		fEffectNodes.push_back(node_plugin);
 	}
+
+	const bigtime_t end_time = system_time();
+	printf("EffectsManager() %0.1f ms (built-in %0.1f ms, add-ons %0.1f ms, %ld plugins %0.1f ms)\n",
+		0.001f*(end_time - start_time), 0.001f*(addons_time - start_time), 0.001f*(plugins_time - addons_time),
+		fEffectPlugins.size(), 0.001f*(end_time - plugins_time));
 }
  
 /*	FUNCTION:		EffectsManager :: ~EffectsManager
@@ -113,49 +123,51 @@ EffectsManager :: ~EffectsManager()
 
 }
 
-/*	FUNCTION:		EffectsManager :: LoadAllAddOns
-	ARGS:			preview_frame
+/*	FUNCTION:		EffectsManager :: FindFiles
+	ARGS:			directory
+					extension
+					files (appended)
 	RETURN:			n/a
-	DESCRIPTION:	Search for and load all AddOns
+	DESCRIPTION:	Search directory (and one level of subdirectories) for files with extension
 */
-void EffectsManager :: LoadAllAddOns(BRect preview_frame)
+void EffectsManager :: FindFiles(const char *directory, const char *extension, std::vector<std::string> &files)
 {
-	auto load_addons = [&](const char *addons_path, BRect preview_frame)
+	BEntry entry;
+	BDirectory dir(directory);
+	while (dir.GetNextEntry(&entry) == B_OK)
 	{
-		BEntry entry;
-		BDirectory dir(addons_path);
-		while (dir.GetNextEntry(&entry) == B_OK)
+		if (entry.IsDirectory())
 		{
-			if (entry.IsDirectory())
-			{
-				//	Recurse one level only
-				BPath path(&entry);
-				BDirectory subdir(path.Path());
-				while (subdir.GetNextEntry(&entry) == B_OK)
-				{
-					if (!entry.IsDirectory())
-					{
-						BPath path(&entry);
-						if (strstr(path.Path(), ".so"))
-						{
-							if (!LoadAddOn(&path, preview_frame))
-								printf("Error loading AddOn(%s)\n", path.Path());
-						}
-					}
-				}
-			}
-			else
+			//	Recurse one level only
+			BPath path(&entry);
+			BDirectory subdir(path.Path());
+			while (subdir.GetNextEntry(&entry) == B_OK)
 			{
-				BPath path(&entry);
-				if (strstr(path.Path(), ".so"))
+				if (!entry.IsDirectory())
 				{
-					if (!LoadAddOn(&path, preview_frame))
-						printf("Error loading AddOn(%s)\n", path.Path());
+					BPath path(&entry);
+					if (strstr(path.Path(), extension))
+						files.push_back(path.Path());
 				}
 			}
 		}
-	};
+		else
+		{
+			BPath path(&entry);
+			if (strstr(path.Path(), extension))
+				files.push_back(path.Path());
+		}
+	}
+}
 
+/*	FUNCTION:		EffectsManager :: LoadAllAddOns
+	ARGS:			preview_frame
+	RETURN:			n/a
+	DESCRIPTION:	Search for and load all AddOns.
+					Images are loaded in parallel, effects are instantiated in directory order.
+*/
+void EffectsManager :: LoadAllAddOns(BRect preview_frame)
+{
 	//	Load from application path
 	app_info appInfo;
 	be_app->GetAppInfo(&appInfo);
@@ -164,42 +176,46 @@ void EffectsManager :: LoadAllAddOns(BRect preview_frame)
 	int last_dir = addons_path.FindLast('/');
 	addons_path.Truncate(last_dir+1);
 	addons_path.Append("AddOns");
-	load_addons(addons_path.String(), preview_frame);
+	std::vector<std::string> files;
+	FindFiles(addons_path.String(), ".so", files);
 
 	//	Load from Config path
 	BPath config_path;
 	find_directory(B_USER_CONFIG_DIRECTORY, &config_path);
 	addons_path.SetTo(config_path.Path());
 	addons_path.Append("/settings/Medo/AddOns");
-	load_addons(addons_path.String(), preview_frame);
-}
+	FindFiles(addons_path.String(), ".so", files);
 
-/*	FUNCTION:		EffectsManager :: LoadAddOn
-	ARGS:			path
-					preview_frame
-	RETURN:			true if valid
-	DESCRIPTION:	Load add-ons
-*/
-bool EffectsManager :: LoadAddOn(BPath *path, BRect preview_frame)
-{
-	//	Load Addons
-	image_id add_on;
-	add_on = load_add_on(path->Path());
-	if (add_on > 0)
+	typedef EffectNode * (*INIT_FUNCTION)(BRect);
+	std::vector<INIT_FUNCTION> init_functions(files.size(), nullptr);
+	ParallelFor((int)files.size(), 1, [&](const int start, const int end)
 	{
-		EffectNode * (*init_function)(BRect);
-		if (B_OK == get_image_symbol(add_on, "instantiate_effect", B_SYMBOL_TYPE_TEXT, (void **)&init_function))
+		for (int i=start; i < end; i++)
 		{
-			EffectNode *node = (*init_function)(preview_frame);
-			if (node)
+			image_id add_on = load_add_on(files[i].c_str());
+			if (add_on > 0)
 			{
-				printf("LoadAddOn(%s) Success\n", path->Path());
-				fEffectNodes.push_back(node);
-				return true;
+				if (get_image_symbol(add_on, "instantiate_effect", B_SYMBOL_TYPE_TEXT, (void **)&init_functions[i]) != B_OK)
+				{
+					init_functions[i] = nullptr;
+					unload_add_on(add_on);
+				}
 			}
 		}
+	});
+
+	//	EffectNode is a BView, instantiate from this thread
+	for (size_t i=0; i < files.size(); i++)
+	{
+		EffectNode *node = init_functions[i] ? (*init_functions[i])(preview_frame) : nullptr;
+		if (node)
+		{
+			printf("LoadAddOn(%s) Success\n", files[i].c_str());
+			fEffectNodes.push_back(node);
+		}
+		else
+			printf("Error loading AddOn(%s)\n", files[i].c_str());
 	}
-	return false;
 }
 
 /*	FUNCTION:		EffectsManager :: CreateMediaEffect
@@ -216,6 +232,7 @@ MediaEffect * EffectsManager :: CreateMediaEffect(const char *vendor_name, const
 		if ((strcmp(vendor_name, i->GetVendorName()) == 0) &&
 			(strcmp(effect_name, i->GetEffectName()) == 0))
 		{
+			i->CreateGui();		//	effects initialise from Gui defaults
 			MediaEffect *media_effect = i->CreateMediaEffect();
 			media_effect->mEffectNode = i;
 
@@ -11,6 +11,10 @@
 #include <vector>
 #endif
 
+#ifndef _GLIBCXX_STRING
+#include <string>
+#endif
+
 class BPath;
 
 class EffectNode;
@@ -30,11 +34,12 @@ public:
 	void			ProjectSettingsChanged();
 	
 private:
+	static void		FindFiles(const char *directory, const char *extension, std::vector<std::string> &files);
+
 	void			LoadAllAddOns(BRect preview_frame);
-	bool			LoadAddOn(BPath *path, BRect preview_frame);
 
-	void			LoadPlugins(const char *path);
-	bool			LoadPlugin(BPath *path);
+	void			LoadPlugins(const std::vector<std::string> &files);
+	static EffectPlugin	*LoadPlugin(BPath *path);		//	thread safe
 
 	std::vector<EffectNode *>		fEffectNodes;
 	std::vector<EffectPlugin *>		fEffectPlugins;
@@ -11,6 +11,8 @@
 #include <storage/Directory.h>
 #include <support/String.h>
 #include <AppKit.h>
+#include <interface/Bitmap.h>
+#include <translation/TranslationUtils.h>
 
 #include "rapidjson/document.h"
 #include "rapidjson/error/en.h"
@@ -20,70 +22,102 @@
 #include "FileUtility.h"
 #include "Language.h"
 #include "LanguageJson.h"
+#include "ParallelFor.h"
 
 #include "Effects/Effect_Plugin.h"
 
 static const std::vector<const char *>	kUniformTypes = {"sampler2D", "float", "vec2", "vec3", "vec4", "colour", "int", "timestamp", "interval", "resolution"};		//	Must match PluginUniform::UniformType
 static const std::vector<const char *> kGuiWidgets = {"slider", "checkbox", "radiobutton", "vec2", "vec3", "vec4", "colour", "text"};												//	Must match PluginGuiWidget::GuiWidget
 
+/*	FUNCTION:		ReadPluginFile
+	ARGS:			filename
+					config_directory
+	RETURN:			file contents (caller acquires ownership), nullptr if not found
+	DESCRIPTION:	Locate plugin file (current directory, application directory, then user config directory)
+*/
+static char * ReadPluginFile(const char *filename, bool *config_directory = nullptr)
+{
+	if (config_directory)
+		*config_directory = false;
+
+	char *source_buffer = ReadFileToBuffer(filename);
+	if (!source_buffer)
+	{
+		// 2nd attempt, from application directory
+		app_info appInfo;
+		be_app->GetAppInfo(&appInfo);
+		BPath executable_path(&appInfo.ref);
+		BString shader_path(executable_path.Path());
+		int last_dir = shader_path.FindLast('/');
+		shader_path.Truncate(last_dir+1);
+		shader_path.Append(filename);
+		source_buffer = ReadFileToBuffer(shader_path.String());
+	}
+	if (!source_buffer)
+	{
+		//	3rd attempt, from B_USER_CONFIG_DIRECTORY directory
+		BPath config_path;
+		find_directory(B_USER_CONFIG_DIRECTORY, &config_path);
+		BString shader_path(config_path.Path());
+		shader_path.Append("/settings/Medo/");
+		shader_path.Append(filename);
+		source_buffer = ReadFileToBuffer(shader_path.String());
+		if (source_buffer && config_directory)
+			*config_directory = true;
+	}
+	return source_buffer;
+}
+
 /*	FUNCTION:		EffectsManager :: LoadPlugins
-	ARGS:			plugin_path
+	ARGS:			files (plugin descriptors)
 	RETURN:			n/a
-	DESCRIPTION:	Parse Plugins directory for effects
+	DESCRIPTION:	Parse plugin descriptors in parallel, add valid plugins in file order.
+					Icons are decoded on the loader thread (Translation Kit add-ons are not
+					guaranteed to be reentrant).
 */
-void EffectsManager :: LoadPlugins(const char *plugin_path)
+void EffectsManager :: LoadPlugins(const std::vector<std::string> &files)
 {
-	BEntry entry;
-	BDirectory dir(plugin_path);
-
-	while (dir.GetNextEntry(&entry) == B_OK)
+	std::vector<EffectPlugin *> plugins(files.size(), nullptr);
+	ParallelFor((int)files.size(), 1, [&](const int start, const int end)
 	{
-		if (entry.IsDirectory())
+		for (int i=start; i < end; i++)
 		{
-			//	Recurse one level only
-			BPath path(&entry);
-			BDirectory subdir(path.Path());
-			while (subdir.GetNextEntry(&entry) == B_OK)
-			{
-				if (!entry.IsDirectory())
-				{
-					BPath path(&entry);
-					if (strstr(path.Path(), ".plugin"))
-					{
-						if (!LoadPlugin(&path))
-							printf("Error loading pluging(%s)\n", path.Path());
-					}
-				}
-			}
+			BPath path(files[i].c_str());
+			plugins[i] = LoadPlugin(&path);
 		}
-		else
+	});
+
+	for (size_t i=0; i < files.size(); i++)
+	{
+		if (plugins[i])
 		{
-			BPath path(&entry);
-			if (strstr(path.Path(), ".plugin"))
-			{
-				if (!LoadPlugin(&path))
-					printf("Error loading pluging(%s)\n", path.Path());
-			}
+			//	Icon (decoded here, since EffectsTab displays every plugin at startup)
+			plugins[i]->mIcon = BTranslationUtils::GetBitmap(plugins[i]->mHeader.icon.c_str());
+			fEffectPlugins.push_back(plugins[i]);
+			printf("Plugin(%s)\n", files[i].c_str());
 		}
+		else
+			printf("Error loading pluging(%s)\n", files[i].c_str());
 	}
 }
 
 /*	FUNCTION:		EffectsManager :: LoadPlugin
 	ARGS:			path
-	RETURN:			n/a
-	DESCRIPTION:	Load plugin
+	RETURN:			plugin (nullptr if invalid)
+	DESCRIPTION:	Load plugin descriptor and shader source (icon is decoded by LoadPlugins).
+					Called from ParallelFor workers, must not modify EffectsManager.
 */
-bool EffectsManager :: LoadPlugin(BPath *path)
+EffectPlugin * EffectsManager :: LoadPlugin(BPath *path)
 {
 	char *data = ReadFileToBuffer(path->Path());
 	if (!data)
-		return false;
+		return nullptr;
 
 	const uint32 kCountAvailableLanguages = gLanguageManager->GetNumberAvailableLanguages();
 
 	EffectPlugin *aPlugin = new EffectPlugin;
 
-#define ERROR_EXIT(a) {printf("ERROR(%s) %s\n", path->Path(), a);	delete [] data; delete aPlugin; return false;}
+#define ERROR_EXIT(a) {printf("ERROR(%s) %s\n", path->Path(), a);	delete [] data; delete aPlugin->mLanguage; delete aPlugin; return nullptr;}
 
 	rapidjson::Document document;
 	rapidjson::ParseResult res = document.Parse<rapidjson::kParseTrailingCommasFlag>(data);
@@ -109,7 +143,7 @@ bool EffectsManager :: LoadPlugin(BPath *path)
 	if (aPlugin->mLanguage->GetTextCount() == 0)
 	{
 		printf("Missing file \"%s\"\n", languages_path.String());
-		return false;
+		ERROR_EXIT("Missing Languages.json");
 	}
 
 /****************************
@@ -264,35 +298,16 @@ bool EffectsManager :: LoadPlugin(BPath *path)
 			aPlugin->mFragmentShader.source_file.assign(source["file"].GetString());
 
 			//	Attempt to locate file
-			char *source_buffer = ReadFileToBuffer(aPlugin->mFragmentShader.source_file.c_str());
-			if (!source_buffer)
+			bool config_directory;
+			char *source_buffer = ReadPluginFile(aPlugin->mFragmentShader.source_file.c_str(), &config_directory);
+			if (config_directory)
 			{
-				// 2nd attempt, from application directory
-				app_info appInfo;
-				be_app->GetAppInfo(&appInfo);
-				BPath executable_path(&appInfo.ref);
-				BString shader_path(executable_path.Path());
-				int last_dir = shader_path.FindLast('/');
-				shader_path.Truncate(last_dir+1);
-				shader_path.Append(aPlugin->mFragmentShader.source_file.c_str());
-				source_buffer = ReadFileToBuffer(shader_path.String());
-			}
-			if (!source_buffer)
-			{
-				//	3rd attempt, from B_USER_CONFIG_DIRECTORY directory
 				BPath config_path;
 				find_directory(B_USER_CONFIG_DIRECTORY, &config_path);
-				BString shader_path(config_path.Path());
-				shader_path.Append("/settings/Medo/");
-				shader_path.Append(aPlugin->mFragmentShader.source_file.c_str());
-				source_buffer = ReadFileToBuffer(shader_path.String());
-				if (source_buffer)
-				{
-					BString icon_path(config_path.Path());
-					icon_path.Append("/settings/Medo/");
-					icon_path.Append(aPlugin->mHeader.icon.c_str());
-					aPlugin->mHeader.icon.assign(icon_path.String());
-				}
+				BString icon_path(config_path.Path());
+				icon_path.Append("/settings/Medo/");
+				icon_path.Append(aPlugin->mHeader.icon.c_str());
+				aPlugin->mHeader.icon.assign(icon_path.String());
 			}
 
 			if (source_buffer)
@@ -316,6 +331,39 @@ bool EffectsManager :: LoadPlugin(BPath *path)
 		else
 			ERROR_EXIT("Missing attribute \"fragment\":\"source\": \"file\" or \"text\"");
 
+		/****************************
+			"fusion" (optional)
+			Per pixel effects can provide "vec4 Fusion@(vec4 colour, vec2 uv)",
+			which allows RenderActor to fuse consecutive colour effects into a single pass.
+		*****************************/
+		if (fragment.HasMember("fusion"))
+		{
+			const rapidjson::Value &fusion = fragment["fusion"];
+			if (fusion.HasMember("file"))
+			{
+				if (!fusion["file"].IsString())
+					ERROR_EXIT("Invalid attribute \"fragment\":\"fusion\":\"file\"");
+				aPlugin->mFragmentShader.fusion_file.assign(fusion["file"].GetString());
+
+				char *fusion_buffer = ReadPluginFile(aPlugin->mFragmentShader.fusion_file.c_str());
+				if (fusion_buffer)
+				{
+					aPlugin->mFragmentShader.fusion_text.assign(fusion_buffer);
+					delete [] fusion_buffer;
+				}
+				else	//	not fatal, effect will not be fused
+					printf("Plugin(%s) failed to open \"fragment\":\"fusion\":\"file\" %s\n", path->Path(), aPlugin->mFragmentShader.fusion_file.c_str());
+			}
+			else if (fusion.HasMember("text"))
+			{
+				if (!fusion["text"].IsString())
+					ERROR_EXIT("Invalid attribute \"fragment\":\"fusion\":\"text\"");
+				aPlugin->mFragmentShader.fusion_text.assign(fusion["text"].GetString());
+			}
+			else
+				ERROR_EXIT("Missing attribute \"fragment\":\"fusion\": \"file\" or \"text\"");
+		}
+
 #if 0
 		if (aPlugin->mFragmentShader.source_file.size() > 0)
 			printf("Plugin(%s) FragmentShader::Source::File = %s\n", path->Path(), aPlugin->mFragmentShader.source_file.c_str());
@@ -581,8 +629,5 @@ bool EffectsManager :: LoadPlugin(BPath *path)
 #endif
 	}
 	delete [] data;
-
-	fEffectPlugins.push_back(aPlugin);
-	printf("Plugin(%s)\n", path->Path());
-	return true;
+	return aPlugin;
 }
@@ -83,6 +83,7 @@ void EffectsWindow :: MessageReceived(BMessage *msg)
 					fEffectNode = node;
 					if (fEffectNode)
 					{
+						fEffectNode->CreateGui();
 						AddChild(fEffectNode);
 						SetTitle(fEffectNode->GetTextEffectName(gLanguageManager->GetCurrentLanguageIndex()));
 						fEffectNode->ResizeTo(Bounds().Width(), Bounds().Height());
@@ -0,0 +1,512 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Export colour conversion stage (BGRA to YUV)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+}
+
+#include <kernel/OS.h>
+#include <interface/Bitmap.h>
+
+#include "Actor/Actor.h"
+
+#include "ExportConverter.h"
+#include "ParallelFor.h"
+
+#if defined (__GNUC__)
+	#if defined(__amd64__)
+		#define Y_CPU_X86
+		#define Y_CONVERTER_AVX2
+	#endif
+#elif defined (_MSC_VER)
+	#define Y_CPU_X86
+#endif
+
+#ifdef Y_CPU_X86
+#include <emmintrin.h>
+#endif
+#ifdef Y_CONVERTER_AVX2
+#include <immintrin.h>
+#endif
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+/*	BT.601 limited range, Q15 (B, G, R order to match BGRA memory layout).
+	Chroma is calculated from the sum of 4 pixels (2x2, or 2x1 counted twice), hence Q17. */
+static const int16 kCoeffY[3] = {3208, 16520, 8414};
+static const int16 kCoeffU[3] = {14392, -9535, -4857};
+static const int16 kCoeffV[3] = {-2341, -12051, 14392};
+static const int32 kBiasY = (16 << 15) + (1 << 14);
+static const int32 kBiasC = (128 << 17) + (1 << 16);
+
+/*************************************
+	Scalar kernels (reference)
+**************************************/
+
+/*	FUNCTION:		ConvertLuma_Scalar
+	ARGS:			bgra
+					width
+					y
+	RETURN:			n/a
+	DESCRIPTION:	One row of luma
+*/
+static void ConvertLuma_Scalar(const uint8 *bgra, const int width, uint8 *y)
+{
+	for (int x=0; x < width; x++)
+	{
+		const uint8 *p = bgra + 4*x;
+		const int32 v = (kCoeffY[0]*p[0] + kCoeffY[1]*p[1] + kCoeffY[2]*p[2] + kBiasY) >> 15;
+		y[x] = (uint8)std::clamp(v, 0, 255);
+	}
+}
+
+/*	FUNCTION:		ConvertChromaRange_Scalar
+	ARGS:			row0, row1 (row1 == row0 for 4:2:2)
+					x_start (source pixel, even)
+					width (source pixels)
+					u, v (planar), or u (interleaved UV, v ignored)
+					interleaved
+	RETURN:			n/a
+	DESCRIPTION:	Chroma for source pixels [x_start, width), odd width repeats the last pixel
+*/
+static void ConvertChromaRange_Scalar(const uint8 *row0, const uint8 *row1, const int x_start, const int width, uint8 *u, uint8 *v, const bool interleaved)
+{
+	for (int x=x_start; x < width; x += 2)
+	{
+		const int x1 = std::min(x + 1, width - 1);
+		int32 sum[3];
+		for (int c=0; c < 3; c++)
+			sum[c] = row0[4*x + c] + row0[4*x1 + c] + row1[4*x + c] + row1[4*x1 + c];
+		const int32 cu = (kCoeffU[0]*sum[0] + kCoeffU[1]*sum[1] + kCoeffU[2]*sum[2] + kBiasC) >> 17;
+		const int32 cv = (kCoeffV[0]*sum[0] + kCoeffV[1]*sum[1] + kCoeffV[2]*sum[2] + kBiasC) >> 17;
+		const int i = x/2;
+		if (interleaved)
+		{
+			u[2*i] = (uint8)std::clamp(cu, 0, 255);
+			u[2*i + 1] = (uint8)std::clamp(cv, 0, 255);
+		}
+		else
+		{
+			u[i] = (uint8)std::clamp(cu, 0, 255);
+			v[i] = (uint8)std::clamp(cv, 0, 255);
+		}
+	}
+}
+
+#if !defined (Y_CPU_X86)
+static void ConvertChroma_Scalar(const uint8 *row0, const uint8 *row1, const int width, uint8 *u, uint8 *v, const bool interleaved)
+{
+	ConvertChromaRange_Scalar(row0, row1, 0, width, u, v, interleaved);
+}
+#endif
+
+/*************************************
+	SSE2 kernels (16 pixels per iteration)
+**************************************/
+#ifdef Y_CPU_X86
+
+/*	FUNCTION:		Dot4_SSE2
+	ARGS:			s0, s1 (2 pixels each, 16 bit BGRA)
+					coeff (B, G, R, 0, B, G, R, 0)
+					bias
+	RETURN:			4 x int32 (s0.0, s0.1, s1.0, s1.1)
+	DESCRIPTION:	(coeff.pixel + bias) >> shift
+*/
+template <int kShift>
+static inline __m128i Dot4_SSE2(const __m128i s0, const __m128i s1, const __m128i coeff, const __m128i bias)
+{
+	__m128i m0 = _mm_madd_epi16(s0, coeff);
+	__m128i m1 = _mm_madd_epi16(s1, coeff);
+	m0 = _mm_add_epi32(m0, _mm_srli_epi64(m0, 32));
+	m1 = _mm_add_epi32(m1, _mm_srli_epi64(m1, 32));
+	const __m128i sum = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(m0), _mm_castsi128_ps(m1), _MM_SHUFFLE(2, 0, 2, 0)));
+	return _mm_srai_epi32(_mm_add_epi32(sum, bias), kShift);
+}
+
+static void ConvertLuma_SSE2(const uint8 *bgra, const int width, uint8 *y)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i coeff = _mm_setr_epi16(kCoeffY[0], kCoeffY[1], kCoeffY[2], 0, kCoeffY[0], kCoeffY[1], kCoeffY[2], 0);
+	const __m128i bias = _mm_set1_epi32(kBiasY);
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		__m128i luma[4];
+		for (int i=0; i < 4; i++)
+		{
+			const __m128i p = _mm_loadu_si128((const __m128i *)(bgra + 4*(x + 4*i)));
+			luma[i] = Dot4_SSE2<15>(_mm_unpacklo_epi8(p, zero), _mm_unpackhi_epi8(p, zero), coeff, bias);
+		}
+		const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(luma[0], luma[1]), _mm_packs_epi32(luma[2], luma[3]));
+		_mm_storeu_si128((__m128i *)(y + x), packed);
+	}
+	ConvertLuma_Scalar(bgra + 4*x, width - x, y + x);
+}
+
+/*	FUNCTION:		PairSum_SSE2
+	ARGS:			a, b (4 pixels from row0 / row1)
+	RETURN:			2 x 16 bit BGRA sums (pixels 0+1, pixels 2+3, both rows)
+	DESCRIPTION:	Chroma siting (2x2 box)
+*/
+static inline __m128i PairSum_SSE2(const __m128i a, const __m128i b)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+	const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+	return _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+}
+
+static void ConvertChroma_SSE2(const uint8 *row0, const uint8 *row1, const int width, uint8 *u, uint8 *v, const bool interleaved)
+{
+	const __m128i coeff_u = _mm_setr_epi16(kCoeffU[0], kCoeffU[1], kCoeffU[2], 0, kCoeffU[0], kCoeffU[1], kCoeffU[2], 0);
+	const __m128i coeff_v = _mm_setr_epi16(kCoeffV[0], kCoeffV[1], kCoeffV[2], 0, kCoeffV[0], kCoeffV[1], kCoeffV[2], 0);
+	const __m128i bias = _mm_set1_epi32(kBiasC);
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		__m128i s[4];
+		for (int i=0; i < 4; i++)
+			s[i] = PairSum_SSE2(_mm_loadu_si128((const __m128i *)(row0 + 4*(x + 4*i))), _mm_loadu_si128((const __m128i *)(row1 + 4*(x + 4*i))));
+		const __m128i cu = _mm_packs_epi32(Dot4_SSE2<17>(s[0], s[1], coeff_u, bias), Dot4_SSE2<17>(s[2], s[3], coeff_u, bias));
+		const __m128i cv = _mm_packs_epi32(Dot4_SSE2<17>(s[0], s[1], coeff_v, bias), Dot4_SSE2<17>(s[2], s[3], coeff_v, bias));
+		const __m128i packed = _mm_packus_epi16(cu, cv);		//	8 x U, 8 x V
+		if (interleaved)
+			_mm_storeu_si128((__m128i *)(u + x), _mm_unpacklo_epi8(packed, _mm_srli_si128(packed, 8)));
+		else
+		{
+			_mm_storel_epi64((__m128i *)(u + x/2), packed);
+			_mm_storel_epi64((__m128i *)(v + x/2), _mm_srli_si128(packed, 8));
+		}
+	}
+	ConvertChromaRange_Scalar(row0, row1, x, width, u, v, interleaved);
+}
+#endif	//#ifdef Y_CPU_X86
+
+/*************************************
+	AVX2 kernels (32 pixels per iteration)
+	Pack instructions operate per 128 bit lane, results are reordered before storing.
+**************************************/
+#ifdef Y_CONVERTER_AVX2
+
+template <int kShift>
+__attribute__((target("avx2")))
+static inline __m256i Dot8_AVX2(const __m256i s0, const __m256i s1, const __m256i coeff, const __m256i bias)
+{
+	__m256i m0 = _mm256_madd_epi16(s0, coeff);
+	__m256i m1 = _mm256_madd_epi16(s1, coeff);
+	m0 = _mm256_add_epi32(m0, _mm256_srli_epi64(m0, 32));
+	m1 = _mm256_add_epi32(m1, _mm256_srli_epi64(m1, 32));
+	const __m256i sum = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(m0), _mm256_castsi256_ps(m1), _MM_SHUFFLE(2, 0, 2, 0)));
+	return _mm256_srai_epi32(_mm256_add_epi32(sum, bias), kShift);
+}
+
+__attribute__((target("avx2")))
+static void ConvertLuma_AVX2(const uint8 *bgra, const int width, uint8 *y)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i coeff = _mm256_setr_epi16(kCoeffY[0], kCoeffY[1], kCoeffY[2], 0, kCoeffY[0], kCoeffY[1], kCoeffY[2], 0,
+											kCoeffY[0], kCoeffY[1], kCoeffY[2], 0, kCoeffY[0], kCoeffY[1], kCoeffY[2], 0);
+	const __m256i bias = _mm256_set1_epi32(kBiasY);
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	int x = 0;
+	for (; x + 32 <= width; x += 32)
+	{
+		__m256i luma[4];		//	8 pixels each, in order
+		for (int i=0; i < 4; i++)
+		{
+			const __m256i p = _mm256_loadu_si256((const __m256i *)(bgra + 4*(x + 8*i)));
+			luma[i] = Dot8_AVX2<15>(_mm256_unpacklo_epi8(p, zero), _mm256_unpackhi_epi8(p, zero), coeff, bias);
+		}
+		const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(luma[0], luma[1]), _mm256_packs_epi32(luma[2], luma[3]));
+		_mm256_storeu_si256((__m256i *)(y + x), _mm256_permutevar8x32_epi32(packed, order));
+	}
+	ConvertLuma_Scalar(bgra + 4*x, width - x, y + x);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i PairSum_AVX2(const __m256i a, const __m256i b)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+	const __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+	return _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+}
+
+__attribute__((target("avx2")))
+static void ConvertChroma_AVX2(const uint8 *row0, const uint8 *row1, const int width, uint8 *u, uint8 *v, const bool interleaved)
+{
+	const __m256i coeff_u = _mm256_setr_epi16(kCoeffU[0], kCoeffU[1], kCoeffU[2], 0, kCoeffU[0], kCoeffU[1], kCoeffU[2], 0,
+											  kCoeffU[0], kCoeffU[1], kCoeffU[2], 0, kCoeffU[0], kCoeffU[1], kCoeffU[2], 0);
+	const __m256i coeff_v = _mm256_setr_epi16(kCoeffV[0], kCoeffV[1], kCoeffV[2], 0, kCoeffV[0], kCoeffV[1], kCoeffV[2], 0,
+											  kCoeffV[0], kCoeffV[1], kCoeffV[2], 0, kCoeffV[0], kCoeffV[1], kCoeffV[2], 0);
+	const __m256i bias = _mm256_set1_epi32(kBiasC);
+	int x = 0;
+	for (; x + 32 <= width; x += 32)
+	{
+		__m256i s[4];
+		for (int i=0; i < 4; i++)
+			s[i] = PairSum_AVX2(_mm256_loadu_si256((const __m256i *)(row0 + 4*(x + 8*i))), _mm256_loadu_si256((const __m256i *)(row1 + 4*(x + 8*i))));
+
+		//	Lane 0 holds samples (0 1 4 5 8 9 12 13), lane 1 holds (2 3 6 7 10 11 14 15)
+		const __m256i cu = _mm256_packs_epi32(Dot8_AVX2<17>(s[0], s[1], coeff_u, bias), Dot8_AVX2<17>(s[2], s[3], coeff_u, bias));
+		const __m256i cv = _mm256_packs_epi32(Dot8_AVX2<17>(s[0], s[1], coeff_v, bias), Dot8_AVX2<17>(s[2], s[3], coeff_v, bias));
+		const __m256i packed = _mm256_packus_epi16(cu, cv);		//	per lane: 8 x U, 8 x V
+		const __m128i lane0 = _mm256_castsi256_si128(packed);
+		const __m128i lane1 = _mm256_extracti128_si256(packed, 1);
+		const __m128i pu = _mm_unpacklo_epi16(lane0, lane1);		//	16 x U
+		const __m128i pv = _mm_unpackhi_epi16(lane0, lane1);		//	16 x V
+		if (interleaved)
+		{
+			_mm_storeu_si128((__m128i *)(u + x), _mm_unpacklo_epi8(pu, pv));
+			_mm_storeu_si128((__m128i *)(u + x + 16), _mm_unpackhi_epi8(pu, pv));
+		}
+		else
+		{
+			_mm_storeu_si128((__m128i *)(u + x/2), pu);
+			_mm_storeu_si128((__m128i *)(v + x/2), pv);
+		}
+	}
+	ConvertChromaRange_Scalar(row0, row1, x, width, u, v, interleaved);
+}
+#endif	//#ifdef Y_CONVERTER_AVX2
+
+/*************************************
+	Kernel selection
+**************************************/
+typedef void (*CONVERT_LUMA)(const uint8 *, const int, uint8 *);
+typedef void (*CONVERT_CHROMA)(const uint8 *, const uint8 *, const int, uint8 *, uint8 *, const bool);
+struct CONVERT_KERNELS
+{
+	CONVERT_LUMA		luma;
+	CONVERT_CHROMA		chroma;
+	const char			*name;
+};
+
+/*	FUNCTION:		GetKernels
+	ARGS:			none
+	RETURN:			kernels for this cpu
+	DESCRIPTION:	Selected once
+*/
+static const CONVERT_KERNELS &GetKernels()
+{
+	static const CONVERT_KERNELS sKernels = []()
+	{
+#if defined (Y_CONVERTER_AVX2)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return CONVERT_KERNELS{&ConvertLuma_AVX2, &ConvertChroma_AVX2, "AVX2"};
+#endif
+#if defined (Y_CPU_X86)
+		return CONVERT_KERNELS{&ConvertLuma_SSE2, &ConvertChroma_SSE2, "SSE2"};
+#else
+		return CONVERT_KERNELS{&ConvertLuma_Scalar, &ConvertChroma_Scalar, "scalar"};
+#endif
+	}();
+	return sKernels;
+}
+
+/*************************************
+	ConverterActor
+**************************************/
+class ConverterActor : public yarra::Actor
+{
+	ExportConverter		*fParent;
+	sem_id				fSemaphore;
+public:
+	ConverterActor(ExportConverter *parent, sem_id semaphore)
+		: fParent(parent), fSemaphore(semaphore)
+	{ }
+	void AsyncConvert(BBitmap *source, AVFrame *dest)
+	{
+		fParent->Convert(source, dest);
+		release_sem(fSemaphore);
+	}
+};
+
+/*************************************
+	ExportConverter
+**************************************/
+
+/*	FUNCTION:		ExportConverter :: ExportConverter
+	ARGS:			source_width, source_height (project resolution)
+					dest_width, dest_height (encoder resolution)
+					pix_fmt (encoder AVPixelFormat)
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+ExportConverter :: ExportConverter(const int source_width, const int source_height, const int dest_width, const int dest_height, const int pix_fmt)
+	: fSourceWidth(source_width), fSourceHeight(source_height), fPixelFormat(pix_fmt), fSwsContext(nullptr),
+	fPending(false), fConversionTime(0), fCountFrames(0), fWaitTime(0)
+{
+	const bool resize = (source_width != dest_width) || (source_height != dest_height);
+	const bool supported = (pix_fmt == AV_PIX_FMT_YUV420P) || (pix_fmt == AV_PIX_FMT_NV12) || (pix_fmt == AV_PIX_FMT_YUV422P);
+	if (resize || !supported)
+	{
+		fSwsContext = sws_alloc_context();
+		if (fSwsContext)
+		{
+			av_opt_set_int(fSwsContext, "srcw", source_width, 0);
+			av_opt_set_int(fSwsContext, "srch", source_height, 0);
+			av_opt_set_int(fSwsContext, "src_format", AV_PIX_FMT_BGRA, 0);
+			av_opt_set_int(fSwsContext, "dstw", dest_width, 0);
+			av_opt_set_int(fSwsContext, "dsth", dest_height, 0);
+			av_opt_set_int(fSwsContext, "dst_format", pix_fmt, 0);
+			av_opt_set_int(fSwsContext, "sws_flags", SWS_BICUBIC, 0);
+			av_opt_set_int(fSwsContext, "threads", ParallelForConcurrency(), 0);
+			if (sws_init_context(fSwsContext, nullptr, nullptr) < 0)
+			{
+				sws_freeContext(fSwsContext);
+				fSwsContext = nullptr;
+			}
+		}
+		if (!fSwsContext)
+		{
+			printf("ExportConverter() Could not initialise the conversion context\n");
+			exit(1);
+		}
+		fKernelName = "swscale";
+	}
+	else
+		fKernelName = GetKernels().name;
+
+	if ((fSemaphore = create_sem(0, "ExportConverter Semaphore")) < B_OK)
+	{
+		printf("ExportConverter() Cannot create semaphore\n");
+		exit(1);
+	}
+	fConverterActor = new ConverterActor(this, fSemaphore);
+}
+
+/*	FUNCTION:		ExportConverter :: ~ExportConverter
+	ARGS:			n/a
+	RETURN:			n/a
+	DESCRIPTION:	Destructor, waits for conversion in flight (export may be cancelled)
+*/
+ExportConverter :: ~ExportConverter()
+{
+	Wait();
+	delete fConverterActor;
+	delete_sem(fSemaphore);
+	sws_freeContext(fSwsContext);
+}
+
+/*	FUNCTION:		ExportConverter :: Convert
+	ARGS:			source (B_RGB32 / B_RGBA32, source dimensions)
+					dest (writable)
+	RETURN:			n/a
+	DESCRIPTION:	Synchronous conversion
+*/
+void ExportConverter :: Convert(BBitmap *source, AVFrame *dest)
+{
+	assert((source != nullptr) && (dest != nullptr));
+	const bigtime_t start_time = system_time();
+
+	const uint8 *bits = (const uint8 *)source->Bits();
+	const int32 bytes_per_row = source->BytesPerRow();
+
+	if (fSwsContext)
+	{
+		const uint8_t *in_data[1] = {bits};
+		const int in_linesize[1] = {(int)bytes_per_row};
+		sws_scale(fSwsContext, in_data, in_linesize, 0, fSourceHeight, dest->data, dest->linesize);
+	}
+	else
+	{
+		const CONVERT_KERNELS &kernels = GetKernels();
+		const int count_pairs = (fSourceHeight + 1)/2;
+		const int chunk_size = std::max(8, count_pairs/(4*ParallelForConcurrency()));
+		ParallelFor(count_pairs, chunk_size, [&](const int pair_start, const int pair_end)
+		{
+			for (int pair=pair_start; pair < pair_end; pair++)
+			{
+				const int y = 2*pair;
+				const bool has_row1 = (y + 1 < fSourceHeight);
+				const uint8 *row0 = bits + (size_t)y*bytes_per_row;
+				const uint8 *row1 = has_row1 ? row0 + bytes_per_row : row0;
+
+				kernels.luma(row0, fSourceWidth, dest->data[0] + (size_t)y*dest->linesize[0]);
+				if (has_row1)
+					kernels.luma(row1, fSourceWidth, dest->data[0] + (size_t)(y + 1)*dest->linesize[0]);
+
+				switch (fPixelFormat)
+				{
+					case AV_PIX_FMT_YUV420P:
+						kernels.chroma(row0, row1, fSourceWidth, dest->data[1] + (size_t)pair*dest->linesize[1], dest->data[2] + (size_t)pair*dest->linesize[2], false);
+						break;
+					case AV_PIX_FMT_NV12:
+						kernels.chroma(row0, row1, fSourceWidth, dest->data[1] + (size_t)pair*dest->linesize[1], nullptr, true);
+						break;
+					case AV_PIX_FMT_YUV422P:
+						kernels.chroma(row0, row0, fSourceWidth, dest->data[1] + (size_t)y*dest->linesize[1], dest->data[2] + (size_t)y*dest->linesize[2], false);
+						if (has_row1)
+							kernels.chroma(row1, row1, fSourceWidth, dest->data[1] + (size_t)(y + 1)*dest->linesize[1], dest->data[2] + (size_t)(y + 1)*dest->linesize[2], false);
+						break;
+					default:
+						assert(0);
+				}
+			}
+		});
+	}
+
+	fConversionTime += system_time() - start_time;
+	fCountFrames++;
+}
+
+/*	FUNCTION:		ExportConverter :: ConvertAsync
+	ARGS:			source (must remain valid until Wait())
+					dest (writable)
+	RETURN:			n/a
+	DESCRIPTION:	Convert on fConverterActor
+*/
+void ExportConverter :: ConvertAsync(BBitmap *source, AVFrame *dest)
+{
+	assert(!fPending);
+	fPending = true;
+	fConverterActor->Async(&ConverterActor::AsyncConvert, fConverterActor, source, dest);
+}
+
+/*	FUNCTION:		ExportConverter :: Wait
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Block until ConvertAsync() complete
+*/
+void ExportConverter :: Wait()
+{
+	if (!fPending)
+		return;
+	const bigtime_t start_time = system_time();
+	while (acquire_sem(fSemaphore) == B_INTERRUPTED) ;
+	fPending = false;
+	fWaitTime += system_time() - start_time;
+}
+
+/*	FUNCTION:		ExportConverter :: PrintStatistics
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Conversion throughput (wait = time the encoder actor was blocked)
+*/
+void ExportConverter :: PrintStatistics() const
+{
+	if (fCountFrames == 0)
+		return;
+	const double ms_per_frame = 0.001*fConversionTime/fCountFrames;
+	printf("[ExportConverter] %s %dx%d (%s): %ld frames, %0.2f ms/frame (%0.1f fps), encoder waited %0.2f ms/frame\n",
+		   av_get_pix_fmt_name((AVPixelFormat)fPixelFormat), fSourceWidth, fSourceHeight, fKernelName,
+		   fCountFrames, ms_per_frame, ms_per_frame > 0.0 ? 1000.0/ms_per_frame : 0.0, 0.001*fWaitTime/fCountFrames);
+}
@@ -0,0 +1,58 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Export colour conversion stage (BGRA to YUV)
+ */
+
+#ifndef _EXPORT_CONVERTER_H_
+#define _EXPORT_CONVERTER_H_
+
+#ifndef _OS_H
+#include <kernel/OS.h>
+#endif
+
+class BBitmap;
+class ConverterActor;
+struct AVFrame;
+struct SwsContext;
+
+/*****************************
+	ExportConverter converts rendered frames (B_RGB32, BGRA memory order) to the encoder
+	pixel format.  YUV420P, NV12 and YUV422P without resizing use our own kernels
+	(BT.601 limited range, matching swscale defaults): AVX2 / SSE2 with a scalar fallback,
+	the frame is sliced into row pairs across ParallelFor.  Other formats and resizing use a
+	threaded swscale context.
+	ConvertAsync() runs on a dedicated actor, so conversion of frame N+1 overlaps with
+	encoding of frame N.  Only one conversion may be in flight, Wait() before touching
+	the destination frame (or the source bitmap).
+	Throughput is accumulated and printed by PrintStatistics().
+	Accessed only from the encoder actor (Ffmpeg_Actor).
+******************************/
+class ExportConverter
+{
+public:
+						ExportConverter(const int source_width, const int source_height, const int dest_width, const int dest_height, const int pix_fmt);
+						~ExportConverter();
+
+	void				Convert(BBitmap *source, AVFrame *dest);
+	void				ConvertAsync(BBitmap *source, AVFrame *dest);
+	void				Wait();
+	void				PrintStatistics() const;
+
+private:
+	int					fSourceWidth;
+	int					fSourceHeight;
+	int					fPixelFormat;
+	SwsContext			*fSwsContext;			//	nullptr when using own kernels
+	const char			*fKernelName;
+
+	ConverterActor		*fConverterActor;
+	sem_id				fSemaphore;
+	bool				fPending;
+
+	bigtime_t			fConversionTime;		//	written by actor, read after Wait()
+	int64				fCountFrames;
+	bigtime_t			fWaitTime;
+};
+
+#endif	//#ifndef _EXPORT_CONVERTER_H_
@@ -17,9 +17,27 @@
 #include "Language.h"
 #include "ExportMediaWindow.h"
 #include "ExportMedia_MediaKit.h"
+#include "ExportPipeline.h"
+#include "Actor/Actor.h"
 
 #include "RenderActor.h"
 
+/*****************************
+	MediaKit_Actor drives the encoder, one step (video frame or audio buffer) per message.
+	Frames are scheduled and rendered by the ExportPipeline (RenderActor), the actor
+	writes the tracks.  Each step re-posts itself, so cancel (fKeepAlive) and quit
+	requests are processed between steps and the BMediaFile is always closed by the actor.
+******************************/
+class MediaKit_Actor : public yarra::Actor
+{
+	Export_MediaKit		*fParent;
+public:
+			MediaKit_Actor(Export_MediaKit *parent) : fParent(parent) {}
+	void	Async_Start();
+	void	Async_EncodeStep(const int32 session_id);
+	void	Async_Quit();
+};
+
 /*	FUNCTION:		Export_MediaKit :: Export_MediaKit
 	ARGS:			parent
 	RETURN:			n/a
@@ -28,9 +46,13 @@
 Export_MediaKit :: Export_MediaKit(ExportMediaWindow *parent)
 	: ExportEngine(parent)
 {
-	if ((fRenderSemaphore = create_sem(0, "ExportFfmpeg Semaphore")) < B_OK)
+	fWorkActor = nullptr;
+	fKeepAlive = false;
+	fSession = nullptr;
+	fSessionId = 0;
+	if ((fQuitSemaphore = create_sem(0, "ExportMediaKit Semaphore")) < B_OK)
 	{
-		printf("Export_MediaKit() Cannot create fRenderSemaphore\n");
+		printf("Export_MediaKit() Cannot create fQuitSemaphore\n");
 		exit(1);
 	}
 }
@@ -42,8 +64,16 @@ Export_MediaKit :: Export_MediaKit(ExportMediaWindow *parent)
 */
 Export_MediaKit :: ~Export_MediaKit()
 {
-	if (fRenderSemaphore >= B_OK)
-		delete_sem(fRenderSemaphore);
+	if (fWorkActor)
+	{
+		//	Cancel export in progress, Async_Quit() closes the session
+		fKeepAlive = false;
+		fWorkActor->Async<&MediaKit_Actor::Async_Quit>();
+		acquire_sem(fQuitSemaphore);
+		delete fWorkActor;
+	}
+	if (fQuitSemaphore >= B_OK)
+		delete_sem(fQuitSemaphore);
 }
 
 /*	FUNCTION:		Export_MediaKit :: BuildFileFormatOptions
@@ -276,48 +306,54 @@ float Export_MediaKit :: AddCustomAudioGui(float start_y)
 void Export_MediaKit :: StartEncode()
 {
 	printf("Export_MediaKit::StartEncode(%s)\n", mParent->fTextOutFile->Text());
+	if (!fWorkActor)
+		fWorkActor = new MediaKit_Actor(this);
 	fKeepAlive = true;
-	fThread = spawn_thread((status_t (*)(void *))WorkThread, "Export_MediaKit::WorkThread", B_NORMAL_PRIORITY, this);
-	resume_thread(fThread);
+	fWorkActor->Async<&MediaKit_Actor::Async_Start>();
 }
 
-/*	FUNCTION:		Export_MediaKit :: StartEncode
-	ARGS:			none
+/*	FUNCTION:		Export_MediaKit :: StopEncode
+	ARGS:			complete
 	RETURN:			n/a
-	DESCRIPTION:	Export Media
+	DESCRIPTION:	Complete export already closed by MediaKit_Actor, cancelled export is closed on next step
 */
 void Export_MediaKit :: StopEncode(const bool complete)
 {
 	printf("Export_MediaKit::StopEncode(%d)\n", complete);
 	if (!complete)
-	{
 		fKeepAlive = false;
-		int attempt = 0;
-		while ((fThread > 0) && (attempt < 2000))
-		{
-			snooze(1000);
-			attempt++;
-		}
-		if (fThread > B_OK)
-			kill_thread(fThread);
-	}
 }
 
-
-/**************************************************************************
-	The Export_MediaKit::WorkThread() needs to be replaced with Actors
-****************************************************************************/
-
-/*	FUNCTION:		Export_MediaKit :: WorkThread
-	ARGS:			arg
-	RETURN:			thread exit status
-	DESCRIPTION:	Export Media thread
+/**************************************************************
+	Encode session state, owned by the actor
+	Video track is written first, then the audio track
+****************************************************************/
+struct MediaKitSession
+{
+	enum PHASE {PHASE_VIDEO, PHASE_AUDIO, PHASE_COMPLETE};
+
+	int32			id;
+	BMediaFile		*out;
+	BMediaTrack		*video_track;
+	BMediaTrack		*audio_track;
+	media_format	audio_format;
+	ExportPipeline	*pipeline;
+	unsigned char	*audio_buffer;
+	PHASE			phase;
+	bigtime_t		timeline;
+	int64			frame_number;
+	double			previous_progress;
+};
+
+/*	FUNCTION:		Export_MediaKit :: OpenSession
+	ARGS:			none
+	RETURN:			true if session created
+	DESCRIPTION:	Create media file, tracks, commit header
+					Called from MediaKit_Actor
 */
-int32 Export_MediaKit :: WorkThread(void *arg)
+bool Export_MediaKit :: OpenSession()
 {
-	assert(arg != nullptr);
-	Export_MediaKit *instance = (Export_MediaKit *) arg;
-	ExportMediaWindow *mParent = instance->mParent;
+	assert(fSession == nullptr);
 
 	//	entry_ref
 	entry_ref ref;
@@ -325,10 +361,10 @@ int32 Export_MediaKit :: WorkThread(void *arg)
 	err = get_ref_for_path(mParent->fTextOutFile->Text(), &ref);
 	if ((err != B_OK) && (err != B_ENTRY_NOT_FOUND))
 	{
-		printf("Export_MediaKit::StartEncode() Problem with get_ref_for_path() %s\n", strerror(err));
-		BAlert *alert = new BAlert("Export_MediaKit::Start Encode()", "Cannot open file (1)", "OK");
+		printf("Export_MediaKit::OpenSession() Problem with get_ref_for_path() %s\n", strerror(err));
+		BAlert *alert = new BAlert("Export_MediaKit::OpenSession()", "Cannot open file (1)", "OK");
 		alert->Go();
-		return err;
+		return false;
 	}
 
 	//	BMediaFormat
@@ -340,7 +376,7 @@ int32 Export_MediaKit :: WorkThread(void *arg)
 	float video_frame_rate;
 
 	int32 cookie = 0;
-	int32 selected_cookie = instance->fFileFormatCookies[mParent->fOptionFileFormat->SelectedOption()];
+	int32 selected_cookie = fFileFormatCookies[mParent->fOptionFileFormat->SelectedOption()];
 	while (get_next_file_format(&cookie, &mfi) == B_OK)
 	{
 		if (cookie == selected_cookie)
@@ -357,7 +393,7 @@ int32 Export_MediaKit :: WorkThread(void *arg)
 		delete out;
 		BAlert *alert = new BAlert("Start Encode", "Cannot open file (2)", "OK");
 		alert->Go();
-		return err;
+		return false;
 	}
 
 	//	Video Encoder
@@ -409,9 +445,10 @@ int32 Export_MediaKit :: WorkThread(void *arg)
 
 		if (video_track == nullptr)
 		{
+			delete out;
 			BAlert *alert = new BAlert("Start Encode", "Failed to create Video Track", "OK");
 			alert->Go();
-			return err;
+			return false;
 		}
 	}
 
@@ -463,9 +500,12 @@ int32 Export_MediaKit :: WorkThread(void *arg)
 
 		if (audio_track == nullptr)
 		{
+			if (video_track)
+				out->ReleaseTrack(video_track);
+			delete out;
 			BAlert *alert = new BAlert("Start Encode", "Failed to create Audio Track", "OK");
 			alert->Go();
-			return err;
+			return false;
 		}
 	}
 
@@ -473,94 +513,203 @@ int32 Export_MediaKit :: WorkThread(void *arg)
 	out->AddCopyright("Copyright 2021 Medo");
 	out->CommitHeader();
 
-	//	Fill video track
-	double previous_progress = 0.0;
-	if ((mParent->fEnableVideo->Value() > 0) && video_track)
+	MediaKitSession *session = new MediaKitSession;
+	session->id = ++fSessionId;
+	session->out = out;
+	session->video_track = video_track;
+	session->audio_track = audio_track;
+	session->audio_format = audio_format;
+	session->pipeline = nullptr;
+	session->audio_buffer = nullptr;
+	session->timeline = 0;
+	session->frame_number = 0;
+	session->previous_progress = 0.0;
+
+	if (video_track)
+	{
+		//	Pipelined, frames in flight while encoding (time base 1000/(1000*fps) supports fractional rates, eg. 29.97fps)
+		session->pipeline = new ExportPipeline(1000, (int64)(video_frame_rate*1000.0f + 0.5f), mParent->fTextOutFile->Text());
+		session->phase = MediaKitSession::PHASE_VIDEO;
+	}
+	else
+		session->phase = audio_track ? MediaKitSession::PHASE_AUDIO : MediaKitSession::PHASE_COMPLETE;
+
+	if (audio_track)
+	{
+		media_raw_audio_format *raf = &session->audio_format.u.raw_audio;
+		printf("audio_format.u.raw_audio.buffer_size = %ld\n", raf->buffer_size);
+		session->audio_buffer = new unsigned char [raf->buffer_size];
+		raf->format = media_raw_audio_format::B_AUDIO_FLOAT;
+	}
+
+	fSession = session;
+	return true;
+}
+
+/*	FUNCTION:		Export_MediaKit :: EncodeStep
+	ARGS:			none
+	RETURN:			true when encoding is finished
+	DESCRIPTION:	Write one video frame or audio buffer, update progress
+					Called from MediaKit_Actor
+*/
+bool Export_MediaKit :: EncodeStep()
+{
+	MediaKitSession *session = fSession;
+	assert(session != nullptr);
+	status_t err;
+
+	switch (session->phase)
 	{
-		bigtime_t timeline = 0;
-		//while (timeline < gProject->mTotalDuration)
-		while ((timeline < gProject->mTotalDuration) && instance->fKeepAlive)
+		case MediaKitSession::PHASE_VIDEO:
 		{
-			BBitmap *frame;
-			gRenderActor->Async<&RenderActor::AsyncPrepareExportFrame>(timeline, instance->fRenderSemaphore, &frame);
-			status_t err;
-			while ((err = acquire_sem(instance->fRenderSemaphore)) == B_INTERRUPTED) ;
-			if (err == B_OK)
+			BBitmap *frame = session->pipeline->GetFrame(session->frame_number++);
+			if (frame)
 			{
 				int attempt = 0;
 				do
 				{
-					err = video_track->WriteFrames(frame->Bits(), 1);
+					err = session->video_track->WriteFrames(frame->Bits(), 1);
 					++attempt;
 				} while ((err != B_OK) && (attempt < 3));
 				if (err != B_OK)
-					printf("Error writing video track (frame_index=%ld) error=%d (%s)\n", timeline, err, strerror(err));
+					printf("Error writing video track (frame_index=%ld) error=%d (%s)\n", session->timeline, err, strerror(err));
 			}
 			else
-				printf("Export_MediaKit::WorkThread() - cannot acquire fRenderSemaphore\n");
-			timeline += kFramesSecond/video_frame_rate;
+				printf("Export_MediaKit::EncodeStep() - cannot acquire export frame\n");
+			session->timeline = session->pipeline->GetFrameIndex(session->frame_number);
 
-			double progress = 100.0*(double)timeline / (double)gProject->mTotalDuration;
-			if ((progress - previous_progress > 0.1) && (progress < 100.0))
+			if (session->timeline >= gProject->mTotalDuration)
 			{
-				mParent->fMsgExportEngine->ReplaceFloat("progress", (float)progress);
-				mParent->PostMessage(mParent->fMsgExportEngine);
-				previous_progress = progress;
+				session->video_track->Flush();
+				session->timeline = 0;
+				session->previous_progress = 0.0;
+				session->phase = session->audio_track ? MediaKitSession::PHASE_AUDIO : MediaKitSession::PHASE_COMPLETE;
 			}
+			break;
 		}
-		video_track->Flush();
-	}
-
-	//	Audio track
-	previous_progress = 0.0;
-	if ((mParent->fEnableAudio->Value() > 0) && audio_track)
-	{
-		uint32 sample_rate = mParent->GetSelectedAudioSampleRate();
-		media_raw_audio_format *raf = &audio_format.u.raw_audio;
-		printf("audio_format.u.raw_audio.buffer_size = %ld\n", raf->buffer_size);
-		unsigned char *audio_buffer = new unsigned char [raf->buffer_size];
-		raf->format = media_raw_audio_format::B_AUDIO_FLOAT;
 
-		bigtime_t timeline = 0;
-		while ((timeline < gProject->mTotalDuration) && instance->fKeepAlive)
+		case MediaKitSession::PHASE_AUDIO:
 		{
-			bigtime_t new_timeline = gAudioManager->GetOutputBuffer(timeline, gProject->mTotalDuration,
-													  audio_buffer, audio_format.u.raw_audio.buffer_size,
+			uint32 sample_rate = mParent->GetSelectedAudioSampleRate();
+			media_raw_audio_format *raf = &session->audio_format.u.raw_audio;
+			bigtime_t new_timeline = gAudioManager->GetOutputBuffer(session->timeline, gProject->mTotalDuration,
+													  session->audio_buffer, raf->buffer_size,
 													  *raf);
 			const double kTargetConversionRate = (double)kFramesSecond/(double)sample_rate;
-			int32 done_frames = int32(double(new_timeline - timeline)/kTargetConversionRate);
+			int32 done_frames = int32(double(new_timeline - session->timeline)/kTargetConversionRate);
 			printf("done_frames = %d (%f)\n", done_frames, kTargetConversionRate);
 			int attempt = 0;
 			do
 			{
-				err = audio_track->WriteFrames(audio_buffer, done_frames);
+				err = session->audio_track->WriteFrames(session->audio_buffer, done_frames);
 				++attempt;
 			} while ((err != B_OK) && (attempt < 3));
 			if (err != B_OK)
-				printf("Error exporting audio (frame_index=%ld) error=%d (%s)\n", timeline, err, strerror(err));
+				printf("Error exporting audio (frame_index=%ld) error=%d (%s)\n", session->timeline, err, strerror(err));
 
-			timeline = new_timeline;
-
-			double progress = (double)timeline / (double)gProject->mTotalDuration;
-			if ((progress - previous_progress > 0.1) && (progress < 100.0))
+			session->timeline = new_timeline;
+			if (session->timeline >= gProject->mTotalDuration)
 			{
-				mParent->fMsgExportEngine->ReplaceFloat("progress", (float)progress);
-				mParent->PostMessage(mParent->fMsgExportEngine);
-				previous_progress = progress;
+				session->audio_track->Flush();
+				session->phase = MediaKitSession::PHASE_COMPLETE;
 			}
+			break;
 		}
-		audio_track->Flush();
+
+		case MediaKitSession::PHASE_COMPLETE:
+			break;
 	}
 
-	if (video_track)
-		out->ReleaseTrack(video_track);
-	if (audio_track)
-		out->ReleaseTrack(audio_track);
-	out->CloseFile();
-	delete out;
-
-	mParent->fMsgExportEngine->ReplaceFloat("progress", 100.0f);
-	mParent->PostMessage(mParent->fMsgExportEngine);
-	instance->fThread = 0;
-	return B_OK;
+	double progress = 100.0*(double)session->timeline / (double)gProject->mTotalDuration;
+	if ((progress - session->previous_progress > 0.1) && (progress < 100.0))
+	{
+		mParent->fMsgExportEngine->ReplaceFloat("progress", (float)progress);
+		mParent->PostMessage(mParent->fMsgExportEngine);
+		session->previous_progress = progress;
+	}
+
+	return (session->phase == MediaKitSession::PHASE_COMPLETE);
+}
+
+/*	FUNCTION:		Export_MediaKit :: CloseSession
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Drain pipeline, release tracks, close file (complete or cancelled export)
+					Called from MediaKit_Actor
+*/
+void Export_MediaKit :: CloseSession()
+{
+	MediaKitSession *session = fSession;
+	assert(session != nullptr);
+
+	delete session->pipeline;
+	delete [] session->audio_buffer;
+
+	if (session->video_track)
+		session->out->ReleaseTrack(session->video_track);
+	if (session->audio_track)
+		session->out->ReleaseTrack(session->audio_track);
+	session->out->CloseFile();
+	delete session->out;
+
+	delete session;
+	fSession = nullptr;
+	printf("Export_MediaKit::CloseSession()\n");
+}
+
+/**************************************************************/
+/* MediaKit_Actor */
+
+/*	FUNCTION:		MediaKit_Actor :: Async_Start
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Open encode session and schedule first step
+*/
+void MediaKit_Actor :: Async_Start()
+{
+	//	Restarted before previous (cancelled) session processed its next step
+	if (fParent->fSession)
+		fParent->CloseSession();
+
+	if (fParent->OpenSession())
+		Async<&MediaKit_Actor::Async_EncodeStep>(fParent->fSession->id);
+}
+
+/*	FUNCTION:		MediaKit_Actor :: Async_EncodeStep
+	ARGS:			session_id
+	RETURN:			n/a
+	DESCRIPTION:	Encode one step, then reschedule (other messages are processed between steps)
+*/
+void MediaKit_Actor :: Async_EncodeStep(const int32 session_id)
+{
+	if (!fParent->fSession || (fParent->fSession->id != session_id))
+		return;		//	stale step from closed session
+
+	if (!fParent->fKeepAlive)
+	{
+		fParent->CloseSession();
+		return;
+	}
+
+	if (fParent->EncodeStep())
+	{
+		fParent->CloseSession();
+		fParent->mParent->fMsgExportEngine->ReplaceFloat("progress", 100.0f);
+		fParent->mParent->PostMessage(fParent->mParent->fMsgExportEngine);
+		return;
+	}
+
+	Async<&MediaKit_Actor::Async_EncodeStep>(session_id);
+}
+
+/*	FUNCTION:		MediaKit_Actor :: Async_Quit
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Close session (if any), signal Export_MediaKit destructor
+*/
+void MediaKit_Actor :: Async_Quit()
+{
+	if (fParent->fSession)
+		fParent->CloseSession();
+	release_sem(fParent->fQuitSemaphore);		//	last access, Export_MediaKit destructor waits for this
 }
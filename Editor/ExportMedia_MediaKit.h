@@ -11,10 +11,17 @@
 #include <vector>
 #endif
 
+#ifndef _GLIBCXX_ATOMIC
+#include <atomic>
+#endif
+
 #ifndef _EXPORT_MEDIA_WINDOW_H_
 #include "ExportMediaWindow.h"
 #endif
 
+class MediaKit_Actor;
+struct MediaKitSession;
+
 class Export_MediaKit : public ExportEngine
 {
 public:
@@ -32,10 +39,16 @@ public:
 private:
 	std::vector<int32>	fFileFormatCookies;
 
-	static status_t		WorkThread(void *arg);
-	int32				fThread;
-	sem_id				fRenderSemaphore;
-	bool				fKeepAlive;
+	friend class MediaKit_Actor;
+	MediaKit_Actor		*fWorkActor;
+	std::atomic<bool>	fKeepAlive;			//	cleared by StopEncode(), polled by MediaKit_Actor between steps
+	sem_id				fQuitSemaphore;
+	MediaKitSession		*fSession;			//	owned by MediaKit_Actor
+	int32				fSessionId;
+
+	bool				OpenSession();
+	bool				EncodeStep();
+	void				CloseSession();
 };
 
 #endif	//#ifndef _EXPORT_MEDIA_KIT_H_
@@ -13,7 +13,6 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavutil/opt.h>
 #include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
 }
 
 #include <InterfaceKit.h>
@@ -24,6 +23,9 @@ extern "C" {
 #include "Language.h"
 #include "ExportMediaWindow.h"
 #include "ExportMedia_ffmpeg.h"
+#include "ExportPipeline.h"
+#include "ExportConverter.h"
+#include "ExportSegments.h"
 #include "Actor/Actor.h"
 
 #include "RenderActor.h"
@@ -54,18 +56,26 @@ enum kFfmpegGuiMessages
 	kMsgAudioComplianceSelected,
 };
 
-/******************************************/
+/*****************************
+	Ffmpeg_Actor drives the encoder, one step (video frame or audio packet) per message.
+	The export is an actor pipeline:
+		frame scheduler + render (ExportPipeline, RenderActor)
+		colour conversion (ExportConverter actor)
+		video encode / audio mix / mux (Ffmpeg_Actor)
+	Optionally, video is encoded by several segment encoders (ExportSegmentEncoder),
+	their closed GOP segments are concatenated into the container by Ffmpeg_Actor.
+	Each step re-posts itself, so cancel (fKeepAlive) and quit requests are processed
+	between steps and the ffmpeg context is always closed by the actor.
+	Back-pressure comes from the bounded ExportPipeline depth and one conversion in flight.
+******************************/
 class Ffmpeg_Actor : public yarra::Actor
 {
 	Export_ffmpeg		*fParent;
 public:
 			Ffmpeg_Actor(Export_ffmpeg *parent);
-	void	Async_Start(int i);
-	void	Async_Stop(const bool complete);
-	void	Async_VideoFrameAvailable(BBitmap *frame);
-	void	Async_AudioFrameAvailable(void *);
-private:
-	void	PrepareNextFrame();
+	void	Async_Start();
+	void	Async_EncodeStep(const int32 session_id);
+	void	Async_Quit();
 };
 
 /*	FUNCTION:		Export_ffmpeg :: Export_ffmpeg
@@ -77,10 +87,15 @@ Export_ffmpeg :: Export_ffmpeg(ExportMediaWindow *parent)
 	: ExportEngine(parent)
 {
 	fWorkActor = nullptr;
-	fThread = 0;
-	if ((fRenderSemaphore = create_sem(0, "ExportFfmpeg Semaphore")) < B_OK)
+	fKeepAlive = false;
+	fSession = nullptr;
+	fSessionId = 0;
+	fExportPipeline = nullptr;
+	fExportConverter = nullptr;
+	fOptionVideoSegments = nullptr;
+	if ((fQuitSemaphore = create_sem(0, "ExportFfmpeg Semaphore")) < B_OK)
 	{
-		printf("Export_ffmpeg() Cannot create fRenderSemaphore\n");
+		printf("Export_ffmpeg() Cannot create fQuitSemaphore\n");
 		exit(1);
 	}
 }
@@ -92,14 +107,22 @@ Export_ffmpeg :: Export_ffmpeg(ExportMediaWindow *parent)
 */
 Export_ffmpeg :: ~Export_ffmpeg()
 {
-	if (fRenderSemaphore >= B_OK)
-		delete_sem(fRenderSemaphore);
+	if (fWorkActor)
+	{
+		//	Cancel export in progress, Async_Quit() closes the session
+		fKeepAlive = false;
+		fWorkActor->Async<&Ffmpeg_Actor::Async_Quit>();
+		acquire_sem(fQuitSemaphore);
+		delete fWorkActor;
+	}
+	if (fQuitSemaphore >= B_OK)
+		delete_sem(fQuitSemaphore);
 }
 
 /*	FUNCTION:		Export_ffmpeg :: AddCustomVideoGui
 	ARGS:			start_y
 	RETURN:			Updated start_y
-	DESCRIPTION:	Add Compliance popup to video codec
+	DESCRIPTION:	Add Compliance popup to video codec, segment encoders popup to bitrate row
 */
 float Export_ffmpeg :: AddCustomVideoGui(float start_y)
 {
@@ -112,6 +135,16 @@ float Export_ffmpeg :: AddCustomVideoGui(float start_y)
 		for (int32 i=0; i < sizeof(kCompliance)/sizeof(FFMPEG_CODEC_COMPLIANCE); i++)
 			fOptionVideoCodecCompliance->AddOption(GetText(kCompliance[i].text), i);
 		start_y += 152;
+
+		//	Segmented parallel encode (number of encoder instances)
+		fOptionVideoSegments = new BOptionPopUp(BRect(480, start_y-98, 640, start_y-98+44), "segments", GetText(TXT_EXPORT_PARALLEL_SEGMENTS), nullptr);
+		mParent->fBackgroundView->AddChild(fOptionVideoSegments);
+		for (int32 i=1; i <= 32; i *= 2)
+		{
+			char buffer[8];
+			sprintf(buffer, "%d", i);
+			fOptionVideoSegments->AddOption(buffer, i);
+		}
 	}
 	return start_y;
 }
@@ -439,8 +472,7 @@ void Export_ffmpeg :: BuildAudioCodecOptions()
 /**************************************************************************
 	This is the ffmpeg encoder, C API
 	Should be replaced with modern C++ API since the C code is terrible
-	The Export_ffmpeg::WorkThread() needs to be replaced with Actors
-	Lots of static variables to allow abrupt thread termination
+	Only called from Ffmpeg_Actor
 ****************************************************************************/
 
 
@@ -449,9 +481,6 @@ extern "C" {
 #include <libswresample/swresample.h>
 }
 
-#define SCALE_FLAGS			SWS_BICUBIC
-
-static AVFormatContext		*sAVFormatContext = nullptr;
 static const size_t sErrorBufferSize = 0x100;
 static char sErrorBuffer[sErrorBufferSize];
 
@@ -461,9 +490,6 @@ static void AlertFfmpegExit(int ret, const char *title)
 	printf("AlertFfmpegExit(%s) %s\n", title, sErrorBuffer);
 	BAlert *alert = new BAlert("ffmpeg alert", sErrorBuffer, "Dismiss");
 	alert->Go();
-
-	if (sAVFormatContext)
-		avformat_free_context(sAVFormatContext);
 	exit(1);
 }
 
@@ -479,7 +505,9 @@ struct OutputStream
 	AVFrame *frame;
 	AVFrame *tmp_frame;
 
-	struct SwsContext *sws_ctx;
+	/* video frame N+1, converted while frame N is encoded */
+	AVFrame *next_frame;
+	bool next_pending;
 };
 
 static int write_frame(AVFormatContext *fmt_ctx, const AVRational *time_base, AVStream *st, AVPacket *pkt)
@@ -774,6 +802,10 @@ void Export_ffmpeg :: open_video(AVFormatContext *oc, const AVCodec *codec, Outp
 	ost->frame = alloc_picture(c->pix_fmt, c->width, c->height);
 	if (!ost->frame)
 		AlertFfmpegExit(ret, "could not allocate frame data (video)");
+	ost->next_frame = alloc_picture(c->pix_fmt, c->width, c->height);
+	if (!ost->next_frame)
+		AlertFfmpegExit(ret, "could not allocate frame data (video)");
+	ost->next_pending = false;
 
 	/* If the output format is not YUV420P, then a temporary YUV420P
 	* picture is needed too. It is then converted to the required
@@ -801,51 +833,36 @@ AVFrame * Export_ffmpeg :: get_video_frame(OutputStream *ost)
 	if (frame_idx >= gProject->mTotalDuration)
 		return nullptr;
 
-	/* when we pass a frame to the encoder, it may keep a reference to it
-	* internally; make sure we do not overwrite it here */
-	if (av_frame_make_writable(ost->frame) < 0)
-		exit(1);
-
-	if (1)//c->pix_fmt != AV_PIX_FMT_YUV420P)
+	//	Pipelined (frames N+2.. are decoded/composited, N+1 is converted while N is encoded)
+	if (ost->next_pending)
 	{
-		/* as we only generate a YUV420P picture, we must convert it
-		* to the codec pixel format if needed */
-		if (!ost->sws_ctx)
-		{
-			const bool resize = (gProject->mResolution.width != c->width) || (gProject->mResolution.height != c->height);
-			ost->sws_ctx = sws_getContext(gProject->mResolution.width, gProject->mResolution.height, AV_PIX_FMT_BGRA,
-										  c->width, c->height, AV_PIX_FMT_YUV420P,
-										  resize ? SCALE_FLAGS : 0, nullptr, nullptr, nullptr);
-			if (!ost->sws_ctx) {
-				fprintf(stderr, "Could not initialize the conversion context\n");
-				exit(1);
-			}
-		}
+		fExportConverter->Wait();
+		std::swap(ost->frame, ost->next_frame);
+		ost->next_pending = false;
+	}
+	else
+	{
+		/* when we pass a frame to the encoder, it may keep a reference to it
+		* internally; make sure we do not overwrite it here */
+		if (av_frame_make_writable(ost->frame) < 0)
+			exit(1);
 
-		BBitmap *output = nullptr;
-		gRenderActor->Async(&RenderActor::AsyncPrepareExportFrame, gRenderActor, frame_idx, fRenderSemaphore, &output);
-		status_t err;
-		while ((err = acquire_sem(fRenderSemaphore)) == B_INTERRUPTED) ;
-		if (err == B_OK)
-		{
-			// colour conversion
-			if (output)
-			{
-				uint8_t *inData[1]     = { (uint8_t *)output->Bits()};
-				int      inLinesize[1] = { 4 * (int)gProject->mResolution.width };
-				sws_scale(ost->sws_ctx, inData, inLinesize, 0, gProject->mResolution.height, ost->frame->data, ost->frame->linesize);
-			}
-			else
-				printf("Export_ffmpeg::get_video_frame(), warning output = nullptr\n");
-		}
+		//	First frame (later frames are converted in advance, unless GetFrame() failed)
+		BBitmap *output = (ost->next_pts == 0) ? fExportPipeline->GetFrame(ost->next_pts) : nullptr;
+		if (output)
+			fExportConverter->Convert(output, ost->frame);
 		else
-		{
-			fprintf(stderr, "ffmpeg - error acquiring fRenderSemaphore(%d)\n", err);
-			exit(1);
-		}
+			printf("Export_ffmpeg::get_video_frame(), warning output = nullptr\n");
+	}
 
-	} else {
-		;//fill_yuv_image(ost->frame, ost->next_pts, c->width, c->height);
+	//	Convert frame N+1 on the ExportConverter actor (bitmap valid until next GetFrame())
+	BBitmap *next_output = fExportPipeline->GetFrame(ost->next_pts + 1);
+	if (next_output)
+	{
+		if (av_frame_make_writable(ost->next_frame) < 0)
+			exit(1);
+		fExportConverter->ConvertAsync(next_output, ost->next_frame);
+		ost->next_pending = true;
 	}
 
 	ost->frame->pts = ost->next_pts;
@@ -900,146 +917,140 @@ int Export_ffmpeg :: write_video_frame(AVFormatContext *oc, OutputStream *ost)
 	return (frame) ? 0 : 1;
 }
 
+/*	FUNCTION:		Export_ffmpeg :: write_video_segment
+	ARGS:			oc
+					ost
+					segments
+	RETURN:			1 when encoding is finished, 0 otherwise
+	DESCRIPTION:	Concatenate next closed GOP segment into container (no re-encoding)
+*/
+int Export_ffmpeg :: write_video_segment(AVFormatContext *oc, OutputStream *ost, ExportSegmentEncoder *segments)
+{
+	std::vector<AVPacket *> packets;
+	int64 end_frame;
+	bool cancelled;
+	if (!segments->ReceiveSegment(packets, &end_frame, &cancelled))
+		return cancelled ? 0 : 1;		//	cancelled: not finished, Async_EncodeStep() closes the session
+
+	for (auto &pkt : packets)
+	{
+		int ret = write_frame(oc, &ost->enc->time_base, ost->st, pkt);
+		if (ret < 0)
+			AlertFfmpegExit(ret, "write_frame (video segment)");
+		av_packet_free(&pkt);
+	}
+	ost->next_pts = end_frame;
+	return 0;
+}
+
 void Export_ffmpeg :: close_stream(AVFormatContext *oc, OutputStream *ost)
 {
 	avcodec_free_context(&ost->enc);
 	av_frame_free(&ost->frame);
 	av_frame_free(&ost->tmp_frame);
-	sws_freeContext(ost->sws_ctx);
+	av_frame_free(&ost->next_frame);
 }
 
 /**************************************************************
-	TODO - need to refactor from using encoding thread to actors
+	Encode session state, owned by the actor
 	Also check if ffmpeg doesn't corrupt when reading from other threads
 	Occasionally I've noticed aac encoder complaining about NaN and will then corrupt its pts
 ****************************************************************/
-
-Ffmpeg_Actor :: Ffmpeg_Actor(Export_ffmpeg *parent)
-{
-	fParent = parent;
-	DEBUG("Ffmpeg_Actor() constructor\n");
-}
-void Ffmpeg_Actor :: Async_Start(int i)
-{
-	printf("Ffmpeg_Actor::AsyncStart(%d)\n", i);
-	while (fParent->fThread > 0)
-		snooze(1000);
-
-	fParent->fKeepAlive = true;
-	fParent->fThread = spawn_thread((status_t (*)(void *))Export_ffmpeg::WorkThread, "Export_ffmpeg::WorkThread", B_NORMAL_PRIORITY, fParent);
-	resume_thread(fParent->fThread);
-}
-void Ffmpeg_Actor :: Async_Stop(const bool complete)
+struct FfmpegSession
 {
-	printf("Ffmpeg_Actor::AsyncStop(%d)\n", complete);
-	if (!complete)
-	{
-		fParent->fKeepAlive = false;
-		int attempt = 0;
-		while ((fParent->fThread > 0) && (attempt < 2000))
-		{
-			snooze(1000);
-			attempt++;
-		}
-		if (fParent->fThread > 0)
-		{
-			if (kill_thread(fParent->fThread) != B_OK)
-			{
-				printf("Cannot kill thread(%d)\n", fParent->fThread);
-			}
-			fParent->fThread = 0;
-		}
-	}
-	DEBUG("Ffmpeg_Actor::AsyncStop()2\n");
-}
-
-/**************************************************************/
-/* media file output */
-void Export_ffmpeg :: StartEncode()
-{
-	if (!fWorkActor)
-		fWorkActor = new Ffmpeg_Actor(this);
-	fWorkActor->Async(&Ffmpeg_Actor::Async_Start, fWorkActor, 99);
-}
-
-void Export_ffmpeg :: StopEncode(const bool complete)
-{
-	DEBUG("Export_ffmpeg::StopEncode(%d)\n", complete);
-	fWorkActor->Async(&Ffmpeg_Actor::Async_Stop, fWorkActor, complete);
-}
+	int32			id;
+	AVFormatContext	*oc;
+	OutputStream	video_st;
+	OutputStream	audio_st;
+	bool			have_video;
+	bool			have_audio;
+	int				encode_video;
+	int				encode_audio;
+	double			previous_progress;
+	ExportSegmentEncoder	*segments;
+};
 
-/**************************************************************/
-/* WorkThread */
-status_t Export_ffmpeg :: WorkThread(void *arg)
+/*	FUNCTION:		Export_ffmpeg :: OpenSession
+	ARGS:			none
+	RETURN:			true if session created
+	DESCRIPTION:	Create output context, open codecs, write header
+					Called from Ffmpeg_Actor
+*/
+bool Export_ffmpeg :: OpenSession()
 {
-	assert(arg != nullptr);
-	Export_ffmpeg *instance = (Export_ffmpeg *) arg;
-	ExportMediaWindow *mParent = instance->mParent;
+	assert(fSession == nullptr);
+	printf("Export_ffmpeg::OpenSession(%s)\n", mParent->fTextOutFile->Text());
 
-	printf("Export_ffmpeg::WorkThread(%s)\n", mParent->fTextOutFile->Text());
-	sAVFormatContext = nullptr;
-
-	OutputStream video_st = { 0 }, audio_st = { 0 };
-	const char *filename;
-	AVOutputFormat *fmt;
-	AVFormatContext *oc;
 	const AVCodec *audio_codec, *video_codec;
-	int ret;
-	bool have_video = (mParent->fHasVideo && (mParent->fEnableVideo->Value() > 0));
-	bool have_audio = (mParent->fHasAudio && (mParent->fEnableAudio->Value() > 0));
-	int encode_video = 0, encode_audio = 0;
 	AVDictionary *opt = NULL;
-	int i;
+	int ret;
 
-	filename = mParent->fTextOutFile->Text();
+	const char *filename = mParent->fTextOutFile->Text();
 
 	/* allocate the output media context */
+	AVFormatContext *oc = nullptr;
 	avformat_alloc_output_context2(&oc, NULL, NULL, filename);
 	if (!oc) {
 		printf("Could not deduce output format from file extension: using MPEG.\n");
 		avformat_alloc_output_context2(&oc, NULL, "mpeg", filename);
 	}
-	sAVFormatContext = oc;
 	if (!oc)
 	{
-		BAlert *alert = new BAlert("Export_ffmpeg::WorkThread", "Cannot initialise ffmpeg context", "Dismiss");
+		BAlert *alert = new BAlert("Export_ffmpeg::OpenSession", "Cannot initialise ffmpeg context", "Dismiss");
 		alert->Go();
 		exit(1);
 	}
 
-	fmt = (AVOutputFormat*) oc->oformat;
+	FfmpegSession *session = new FfmpegSession;
+	memset(session, 0, sizeof(FfmpegSession));
+	session->id = ++fSessionId;
+	session->oc = oc;
+	session->have_video = (mParent->fHasVideo && (mParent->fEnableVideo->Value() > 0));
+	session->have_audio = (mParent->fHasAudio && (mParent->fEnableAudio->Value() > 0));
+
+	AVOutputFormat *fmt = (AVOutputFormat*) oc->oformat;
 
 	//	Video stream + codec
-	int selected_codec_idx = have_video ? mParent->fOptionVideoCodec->SelectedOption() : -1;
+	int selected_codec_idx = session->have_video ? mParent->fOptionVideoCodec->SelectedOption() : -1;
 	if (selected_codec_idx >= 0)
 	{
-		assert(selected_codec_idx < instance->fVideoCodecCookies.size());
-		fmt->video_codec = (AVCodecID) instance->fVideoCodecCookies[selected_codec_idx];
-		instance->add_stream(&video_st, oc, &video_codec, fmt->video_codec);
-		encode_video = 1;
+		assert(selected_codec_idx < fVideoCodecCookies.size());
+		fmt->video_codec = (AVCodecID) fVideoCodecCookies[selected_codec_idx];
+		add_stream(&session->video_st, oc, &video_codec, fmt->video_codec);
+		session->encode_video = 1;
 	}
 	else
 		fmt->video_codec = AV_CODEC_ID_NONE;
 
 	//	Audio stream + codec
-	selected_codec_idx = have_audio ? mParent->fOptionAudioCodec->SelectedOption() : -1;
+	selected_codec_idx = session->have_audio ? mParent->fOptionAudioCodec->SelectedOption() : -1;
 	if (selected_codec_idx >= 0)
 	{
-		assert(selected_codec_idx < instance->fAudioCodecCookies.size());
-		fmt->audio_codec = (AVCodecID) instance->fAudioCodecCookies[selected_codec_idx];
-		instance->add_stream(&audio_st, oc, &audio_codec, fmt->audio_codec);
-		encode_audio = 1;
+		assert(selected_codec_idx < fAudioCodecCookies.size());
+		fmt->audio_codec = (AVCodecID) fAudioCodecCookies[selected_codec_idx];
+		add_stream(&session->audio_st, oc, &audio_codec, fmt->audio_codec);
+		session->encode_audio = 1;
 	}
 	else
 		fmt->audio_codec = AV_CODEC_ID_NONE;
 
 	/* Now that all the parameters are set, we can open the audio and
 	* video codecs and allocate the necessary encode buffers. */
-	if (have_video)
-		instance->open_video(oc, video_codec, &video_st, opt);
+	if (session->have_video)
+	{
+		open_video(oc, video_codec, &session->video_st, opt);
+		fExportPipeline = new ExportPipeline(session->video_st.enc->time_base.num, session->video_st.enc->time_base.den, filename);
+		fExportConverter = new ExportConverter(gProject->mResolution.width, gProject->mResolution.height, session->video_st.enc->width, session->video_st.enc->height, session->video_st.enc->pix_fmt);
+
+		int32 number_encoders = 1;
+		if (fOptionVideoSegments)
+			fOptionVideoSegments->SelectedOption(nullptr, &number_encoders);
+		if (number_encoders > 1)
+			session->segments = new ExportSegmentEncoder(video_codec, session->video_st.enc, number_encoders, fExportPipeline, fExportConverter, fKeepAlive);
+	}
 
-	if (have_audio)
-		instance->open_audio(oc, audio_codec, &audio_st, opt);
+	if (session->have_audio)
+		open_audio(oc, audio_codec, &session->audio_st, opt);
 
 	av_dump_format(oc, 0, filename, 1);
 
@@ -1056,45 +1067,94 @@ status_t Export_ffmpeg :: WorkThread(void *arg)
 	if (ret < 0)
 		AlertFfmpegExit(ret, "Cannot open file");
 
-	float previous_progress = 0.0f;
-	while ((encode_video || encode_audio) && instance->fKeepAlive)
-	{
-		/* select the stream to encode */
-		if (encode_video && (!encode_audio || av_compare_ts(video_st.next_pts, video_st.enc->time_base, audio_st.next_pts, audio_st.enc->time_base) <= 0))
-		{
-			encode_video = !instance->write_video_frame(oc, &video_st);
-		} else if (have_audio)
-		{
-			encode_audio = !instance->write_audio_frame(oc, &audio_st);
-		}
+	fSession = session;
+	return true;
+}
 
-		//	Update progress bar
-		double progress;
-		if (have_video)
-		{
-			double frame_duration = (double)video_st.enc->time_base.num/(double)video_st.enc->time_base.den;
-			int64 next_frame = kFramesSecond * frame_duration * video_st.next_pts;
-			progress = 100.0 * (double)next_frame / (double)gProject->mTotalDuration;
-		}
+/*	FUNCTION:		Export_ffmpeg :: EncodeStep
+	ARGS:			none
+	RETURN:			true when encoding is finished
+	DESCRIPTION:	Encode one video frame or audio packet (interleaved by pts), update progress
+					Called from Ffmpeg_Actor
+*/
+bool Export_ffmpeg :: EncodeStep()
+{
+	FfmpegSession *session = fSession;
+	assert(session != nullptr);
+	OutputStream &video_st = session->video_st;
+	OutputStream &audio_st = session->audio_st;
+
+	/* select the stream to encode */
+	if (session->encode_video && (!session->encode_audio || av_compare_ts(video_st.next_pts, video_st.enc->time_base, audio_st.next_pts, audio_st.enc->time_base) <= 0))
+	{
+		if (session->segments)
+			session->encode_video = !write_video_segment(session->oc, &video_st, session->segments);
 		else
-		{
-			double frame_duration = (double)audio_st.enc->time_base.num/(double)audio_st.enc->time_base.den;
-			int64 next_frame = kFramesSecond * frame_duration * audio_st.next_pts;
-			progress = 100.0 * (double)next_frame / (double)gProject->mTotalDuration;
-		}
-		if ((progress - previous_progress > 0.01) && (progress < 100.0))
-		{
-			mParent->fMsgExportEngine->ReplaceFloat("progress", (float)progress);
-			mParent->PostMessage(mParent->fMsgExportEngine);
-			previous_progress = progress;
-		}
+			session->encode_video = !write_video_frame(session->oc, &video_st);
+	} else if (session->have_audio)
+	{
+		session->encode_audio = !write_audio_frame(session->oc, &audio_st);
 	}
 
+	//	Update progress bar
+	double progress;
+	if (session->have_video)
+	{
+		double frame_duration = (double)video_st.enc->time_base.num/(double)video_st.enc->time_base.den;
+		int64 next_frame = kFramesSecond * frame_duration * video_st.next_pts;
+		progress = 100.0 * (double)next_frame / (double)gProject->mTotalDuration;
+	}
+	else
+	{
+		double frame_duration = (double)audio_st.enc->time_base.num/(double)audio_st.enc->time_base.den;
+		int64 next_frame = kFramesSecond * frame_duration * audio_st.next_pts;
+		progress = 100.0 * (double)next_frame / (double)gProject->mTotalDuration;
+	}
+	if ((progress - session->previous_progress > 0.01) && (progress < 100.0))
+	{
+		mParent->fMsgExportEngine->ReplaceFloat("progress", (float)progress);
+		mParent->PostMessage(mParent->fMsgExportEngine);
+		session->previous_progress = progress;
+	}
+
+	return !(session->encode_video || session->encode_audio);
+}
+
+/*	FUNCTION:		Export_ffmpeg :: CloseSession
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Drain pipeline, write trailer, release ffmpeg context (complete or cancelled export)
+					Called from Ffmpeg_Actor
+*/
+void Export_ffmpeg :: CloseSession()
+{
+	FfmpegSession *session = fSession;
+	assert(session != nullptr);
+	AVFormatContext *oc = session->oc;
+
+	//	Segment encoders reference pipeline and converter
+	if (session->segments)
+	{
+		session->segments->PrintStatistics();
+		delete session->segments;
+	}
+
+	//	Wait for frames in flight (cancelled export)
+	if (fExportConverter)
+	{
+		fExportConverter->Wait();
+		fExportConverter->PrintStatistics();
+		delete fExportConverter;
+		fExportConverter = nullptr;
+	}
+	delete fExportPipeline;
+	fExportPipeline = nullptr;
+
 	printf("[Export_ffmpeg] Duration = %ld\n", gProject->mTotalDuration);
-	if (have_video)
-		printf("[Export_ffmpeg] Final video->next_pts=%ld (timeline=%ld)\n", video_st.next_pts, video_st.next_pts * kFramesSecond*video_st.enc->time_base.num/video_st.enc->time_base.den);
-	if (have_audio)
-		printf("[Export_ffmpeg] Final audio->next_pts=%ld (timeline=%ld)\n", audio_st.next_pts, audio_st.next_pts * kFramesSecond*audio_st.enc->time_base.num/audio_st.enc->time_base.den);
+	if (session->have_video)
+		printf("[Export_ffmpeg] Final video->next_pts=%ld (timeline=%ld)\n", session->video_st.next_pts, session->video_st.next_pts * kFramesSecond*session->video_st.enc->time_base.num/session->video_st.enc->time_base.den);
+	if (session->have_audio)
+		printf("[Export_ffmpeg] Final audio->next_pts=%ld (timeline=%ld)\n", session->audio_st.next_pts, session->audio_st.next_pts * kFramesSecond*session->audio_st.enc->time_base.num/session->audio_st.enc->time_base.den);
 
 	/* Write the trailer, if any. The trailer must be written before you
 	* close the CodecContexts open when you wrote the header; otherwise
@@ -1103,25 +1163,101 @@ status_t Export_ffmpeg :: WorkThread(void *arg)
 	av_write_trailer(oc);
 
 	/* Close each codec. */
-	if (have_video)
-		instance->close_stream(oc, &video_st);
-	if (have_audio)
-		instance->close_stream(oc, &audio_st);
+	if (session->have_video)
+		close_stream(oc, &session->video_st);
+	if (session->have_audio)
+		close_stream(oc, &session->audio_st);
 
-	if (!(fmt->flags & AVFMT_NOFILE))
+	if (!(oc->oformat->flags & AVFMT_NOFILE))
 		/* Close the output file. */
 		avio_closep(&oc->pb);
 
 	/* free the stream */
 	avformat_free_context(oc);
 
-	mParent->fMsgExportEngine->ReplaceFloat("progress", 100.0f);
-	mParent->PostMessage(mParent->fMsgExportEngine);
+	delete session;
+	fSession = nullptr;
+	printf("Export_ffmpeg::CloseSession()\n");
+}
 
-	instance->fThread = 0;
+/**************************************************************/
+/* Ffmpeg_Actor */
+Ffmpeg_Actor :: Ffmpeg_Actor(Export_ffmpeg *parent)
+{
+	fParent = parent;
+	DEBUG("Ffmpeg_Actor() constructor\n");
+}
+
+/*	FUNCTION:		Ffmpeg_Actor :: Async_Start
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Open encode session and schedule first step
+*/
+void Ffmpeg_Actor :: Async_Start()
+{
+	printf("Ffmpeg_Actor::Async_Start()\n");
+
+	//	Restarted before previous (cancelled) session processed its next step
+	if (fParent->fSession)
+		fParent->CloseSession();
+
+	if (fParent->OpenSession())
+		Async<&Ffmpeg_Actor::Async_EncodeStep>(fParent->fSession->id);
+}
+
+/*	FUNCTION:		Ffmpeg_Actor :: Async_EncodeStep
+	ARGS:			session_id
+	RETURN:			n/a
+	DESCRIPTION:	Encode one step, then reschedule (other messages are processed between steps)
+*/
+void Ffmpeg_Actor :: Async_EncodeStep(const int32 session_id)
+{
+	if (!fParent->fSession || (fParent->fSession->id != session_id))
+		return;		//	stale step from closed session
+
+	if (!fParent->fKeepAlive)
+	{
+		fParent->CloseSession();
+		return;
+	}
+
+	if (fParent->EncodeStep())
+	{
+		fParent->CloseSession();
+		fParent->mParent->fMsgExportEngine->ReplaceFloat("progress", 100.0f);
+		fParent->mParent->PostMessage(fParent->mParent->fMsgExportEngine);
+		return;
+	}
 
-	printf("Export_ffmpeg::ExitWorkThread\n");
-	return B_OK;
+	Async<&Ffmpeg_Actor::Async_EncodeStep>(session_id);
+}
+
+/*	FUNCTION:		Ffmpeg_Actor :: Async_Quit
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Close session (if any), signal Export_ffmpeg destructor
+*/
+void Ffmpeg_Actor :: Async_Quit()
+{
+	if (fParent->fSession)
+		fParent->CloseSession();
+	release_sem(fParent->fQuitSemaphore);		//	last access, Export_ffmpeg destructor waits for this
 }
 
+/**************************************************************/
+/* media file output */
+void Export_ffmpeg :: StartEncode()
+{
+	if (!fWorkActor)
+		fWorkActor = new Ffmpeg_Actor(this);
+	fKeepAlive = true;
+	fWorkActor->Async<&Ffmpeg_Actor::Async_Start>();
+}
 
+void Export_ffmpeg :: StopEncode(const bool complete)
+{
+	DEBUG("Export_ffmpeg::StopEncode(%d)\n", complete);
+	//	Complete export already closed by Ffmpeg_Actor, cancelled export is closed on next step
+	if (!complete)
+		fKeepAlive = false;
+}
@@ -11,6 +11,10 @@
 #include <vector>
 #endif
 
+#ifndef _GLIBCXX_ATOMIC
+#include <atomic>
+#endif
+
 #ifndef _EXPORT_MEDIA_WINDOW_H_
 #include "ExportMediaWindow.h"
 #endif
@@ -25,11 +29,14 @@ struct AVStream;
 struct AVFrame;
 struct AVChannelLayout;
 
-struct SwsContext;
 struct OutputStream;
 struct AVDictionary;
+struct FfmpegSession;
 
 class Ffmpeg_Actor;
+class ExportPipeline;
+class ExportConverter;
+class ExportSegmentEncoder;
 
 class Export_ffmpeg : public ExportEngine
 {
@@ -50,17 +57,23 @@ public:
 private:
 	BOptionPopUp		*fOptionVideoCodecCompliance;
 	BOptionPopUp		*fOptionAudioCodecCompliance;
+	BOptionPopUp		*fOptionVideoSegments;
 	std::vector<const AVOutputFormat *>	fFileFormatCookies;
 	std::vector<int>	fVideoCodecCookies;
 	std::vector<int>	fAudioCodecCookies;
 
-	static status_t		WorkThread(void *arg);
-	int32				fThread;
-	bool				fKeepAlive;		// to be removed when transition to actor model
-	sem_id				fRenderSemaphore;
 	friend class Ffmpeg_Actor;
 	Ffmpeg_Actor		*fWorkActor;
+	std::atomic<bool>	fKeepAlive;			//	cleared by StopEncode(), polled by Ffmpeg_Actor between steps
+	sem_id				fQuitSemaphore;
+	FfmpegSession		*fSession;			//	owned by Ffmpeg_Actor
+	int32				fSessionId;
+	ExportPipeline		*fExportPipeline;
+	ExportConverter		*fExportConverter;
 
+	bool		OpenSession();
+	bool		EncodeStep();
+	void		CloseSession();
 
 	void		add_stream(OutputStream *ost, AVFormatContext *oc, const AVCodec **codec, int codec_id);
     AVFrame		*alloc_audio_frame(int sample_fmt, const AVChannelLayout *channel_layout, int sample_rate, int nb_samples);
@@ -70,6 +83,7 @@ private:
 	void		open_video(AVFormatContext *oc, const AVCodec *codec, OutputStream *ost, AVDictionary *opt_arg);
 	AVFrame		*get_video_frame(OutputStream *ost);
 	int			write_video_frame(AVFormatContext *oc, OutputStream *ost);
+	int			write_video_segment(AVFormatContext *oc, OutputStream *ost, ExportSegmentEncoder *segments);
 	void		close_stream(AVFormatContext *oc, OutputStream *ost);
 };
 
@@ -0,0 +1,147 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Export pipeline (multiple frames in flight)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+
+#include <kernel/OS.h>
+#include <interface/Bitmap.h>
+
+#include "ExportPipeline.h"
+#include "Project.h"
+#include "RenderActor.h"
+#include "RenderStatistics.h"
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+/*	FUNCTION:		ExportPipeline :: ExportPipeline
+	ARGS:			time_base_num, time_base_den (encoder frame duration)
+					filename (export file, timing statistics written to <filename>.timing.csv)
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+ExportPipeline :: ExportPipeline(const int64 time_base_num, const int64 time_base_den, const char *filename)
+	: fTimeBaseNum(time_base_num), fTimeBaseDen(time_base_den), fNextRequest(0), fNextFrame(0), fFlushed(false)
+{
+	assert(time_base_den > 0);
+	BRect frame(0, 0, gProject->mResolution.width - 1, gProject->mResolution.height - 1);
+	for (int i=0; i < kPipelineDepth; i++)
+	{
+		fSlots[i].bitmap = new BBitmap(frame, B_RGB32);
+		if ((fSlots[i].semaphore = create_sem(0, "ExportPipeline Semaphore")) < B_OK)
+		{
+			printf("ExportPipeline() Cannot create semaphore\n");
+			exit(1);
+		}
+		fSlots[i].frame_number = -1;
+		fSlots[i].pending = false;
+	}
+
+	if (filename && *filename)
+		fStatisticsFilename.assign(filename).append(".timing.csv");
+	//	Not posted to RenderActor (PrepareFrame() clears pending messages), RenderStatistics is thread safe
+	gRenderActor->GetStatistics()->Reset();
+}
+
+/*	FUNCTION:		ExportPipeline :: ~ExportPipeline
+	ARGS:			n/a
+	RETURN:			n/a
+	DESCRIPTION:	Destructor, wait for frames in flight (export may be cancelled)
+*/
+ExportPipeline :: ~ExportPipeline()
+{
+	Flush();
+	for (int i=0; i < kPipelineDepth; i++)
+	{
+		if (fSlots[i].pending)
+		{
+			while (acquire_sem(fSlots[i].semaphore) == B_INTERRUPTED) ;
+		}
+		delete_sem(fSlots[i].semaphore);
+		delete fSlots[i].bitmap;
+	}
+
+	if (!fStatisticsFilename.empty())
+		gRenderActor->GetStatistics()->WriteCsv(fStatisticsFilename.c_str());
+}
+
+/*	FUNCTION:		ExportPipeline :: GetFrameIndex
+	ARGS:			frame_number (encoder pts)
+	RETURN:			timeline frame_idx
+	DESCRIPTION:	Convert encoder frame number to timeline frame
+*/
+const int64 ExportPipeline :: GetFrameIndex(const int64 frame_number) const
+{
+	return frame_number*kFramesSecond*fTimeBaseNum/fTimeBaseDen;
+}
+
+/*	FUNCTION:		ExportPipeline :: Request
+	ARGS:			frame_number
+	RETURN:			n/a
+	DESCRIPTION:	Schedule frame on RenderActor
+*/
+void ExportPipeline :: Request(const int64 frame_number)
+{
+	SLOT &slot = fSlots[frame_number % kPipelineDepth];
+	assert(!slot.pending);
+	slot.frame_number = frame_number;
+	slot.pending = true;
+
+	int64 preload_idx = GetFrameIndex(frame_number + kPreloadDistance);
+	if (preload_idx >= gProject->mTotalDuration)
+		preload_idx = -1;
+	DEBUG("ExportPipeline::Request(%ld) frame_idx=%ld, preload_idx=%ld\n", frame_number, GetFrameIndex(frame_number), preload_idx);
+	gRenderActor->Async(&RenderActor::AsyncExportFrame, gRenderActor, GetFrameIndex(frame_number), preload_idx, slot.bitmap, slot.semaphore);
+}
+
+/*	FUNCTION:		ExportPipeline :: Flush
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	No further requests, RenderActor completes pending readback
+*/
+void ExportPipeline :: Flush()
+{
+	if (fFlushed)
+		return;
+	gRenderActor->Async(&RenderActor::AsyncFlushExportFrame, gRenderActor);
+	fFlushed = true;
+}
+
+/*	FUNCTION:		ExportPipeline :: GetFrame
+	ARGS:			frame_number (sequential encoder pts)
+	RETURN:			output frame (nullptr if beyond project duration)
+	DESCRIPTION:	Refill pipeline, then block until frame available.
+					The previous frame slot is reused (caller finished with previous bitmap).
+*/
+BBitmap * ExportPipeline :: GetFrame(const int64 frame_number)
+{
+	assert(frame_number == fNextFrame);
+	if (GetFrameIndex(frame_number) >= gProject->mTotalDuration)
+		return nullptr;
+
+	while ((fNextRequest < frame_number + kPipelineDepth) && (GetFrameIndex(fNextRequest) < gProject->mTotalDuration))
+		Request(fNextRequest++);
+	if (GetFrameIndex(fNextRequest) >= gProject->mTotalDuration)
+		Flush();
+
+	SLOT &slot = fSlots[frame_number % kPipelineDepth];
+	assert(slot.pending && (slot.frame_number == frame_number));
+	status_t err;
+	while ((err = acquire_sem(slot.semaphore)) == B_INTERRUPTED) ;
+	slot.pending = false;
+	fNextFrame = frame_number + 1;
+	if (err != B_OK)
+	{
+		printf("ExportPipeline::GetFrame(%ld) - error acquiring semaphore(%d)\n", frame_number, err);
+		return nullptr;
+	}
+	return slot.bitmap;
+}
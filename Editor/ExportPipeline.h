@@ -0,0 +1,66 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Export pipeline (multiple frames in flight)
+ */
+
+#ifndef _EXPORT_PIPELINE_H_
+#define _EXPORT_PIPELINE_H_
+
+#ifndef _OS_H
+#include <kernel/OS.h>
+#endif
+
+#ifndef _GLIBCXX_STRING
+#include <string>
+#endif
+
+class BBitmap;
+
+/*****************************
+	ExportPipeline keeps several export frames in flight, so the stages overlap:
+		decode N+2 (VideoManager preload actor)
+		composite N+1 (RenderActor, asynchronous pixel buffer readback)
+		readback N (completed when N+1 is composited)
+		colour conversion N-1 (ExportConverter actor, ffmpeg)
+		encode + mux N-2 (encoder actor)
+	Frames are requested in advance (bounded by kPipelineDepth), each slot owns an output bitmap.
+	Frame numbers are consumed sequentially, the bitmap returned by GetFrame() is valid until
+	the next GetFrame() call.  Throughput approaches the slowest stage.
+	Render statistics are reset when the pipeline is created, and written to
+	"<filename>.timing.csv" when the pipeline is destroyed (see RenderStatistics).
+	Accessed only from the encoder actor (Ffmpeg_Actor, MediaKit_Actor).
+******************************/
+class ExportPipeline
+{
+public:
+	static const int	kPipelineDepth = 4;
+	static const int	kPreloadDistance = 2;
+
+						ExportPipeline(const int64 time_base_num, const int64 time_base_den, const char *filename = nullptr);
+						~ExportPipeline();
+
+	BBitmap				*GetFrame(const int64 frame_number);
+	const int64			GetFrameIndex(const int64 frame_number) const;
+
+private:
+	void				Request(const int64 frame_number);
+	void				Flush();
+
+	struct SLOT
+	{
+		BBitmap			*bitmap;
+		sem_id			semaphore;
+		int64			frame_number;
+		bool			pending;
+	};
+	SLOT				fSlots[kPipelineDepth];
+	int64				fTimeBaseNum;
+	int64				fTimeBaseDen;
+	int64				fNextRequest;
+	int64				fNextFrame;
+	bool				fFlushed;
+	std::string			fStatisticsFilename;
+};
+
+#endif	//#ifndef _EXPORT_PIPELINE_H_
@@ -0,0 +1,520 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Segmented parallel video encoder (ffmpeg export)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+}
+
+#include <kernel/OS.h>
+#include <interface/Bitmap.h>
+
+#include "Actor/Actor.h"
+
+#include "ExportSegments.h"
+#include "ExportPipeline.h"
+#include "ExportConverter.h"
+#include "ParallelFor.h"
+#include "Project.h"
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+/*************************************
+	SegmentEncoderActor
+	Frames arrive in presentation order, a codec context is created for the first frame of
+	a segment and drained/freed by AsyncEndSegment().  Pool frames are reused in
+	round robin order, fFreeSemaphore counts pool frames the dispatcher may overwrite.
+	Quit() sets fQuit, frames still queued at that point are released without encoding.
+**************************************/
+class SegmentEncoderActor : public yarra::Actor
+{
+public:
+						SegmentEncoderActor(const AVCodec *codec, const AVCodecContext *config, const int pool_size, const int thread_count);
+						~SegmentEncoderActor();
+
+	void				AsyncEncodeFrame(AVFrame *frame);
+	void				AsyncEndSegment();
+	void				AsyncQuit();
+
+	AVFrame				*AcquireFrame();
+	bool				WaitSegment(const bigtime_t timeout);
+	void				PopSegment(std::vector<AVPacket *> &packets);
+	void				Quit();
+
+	bigtime_t			fEncodeTime;				//	written by actor, read after final segment
+
+private:
+	void				OpenContext();
+	void				ReceivePackets();
+
+	const AVCodec		*fCodec;
+	const AVCodecContext	*fConfig;
+	int					fThreadCount;
+	AVCodecContext		*fContext;
+	std::vector<AVFrame *>	fPool;
+	int					fPoolWrite;
+	sem_id				fFreeSemaphore;
+	sem_id				fSegmentSemaphore;
+	sem_id				fQuitSemaphore;
+	std::atomic<bool>	fQuit;
+
+	std::vector<AVPacket *>		fPackets;			//	current segment
+	std::deque<std::vector<AVPacket *>>	fCompleted;
+	std::mutex			fCompletedMutex;
+};
+
+/*	FUNCTION:		SegmentEncoderActor :: SegmentEncoderActor
+	ARGS:			codec, config (configured context, not modified)
+					pool_size (frames), thread_count (per codec context)
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+SegmentEncoderActor :: SegmentEncoderActor(const AVCodec *codec, const AVCodecContext *config, const int pool_size, const int thread_count)
+	: fEncodeTime(0), fCodec(codec), fConfig(config), fThreadCount(thread_count), fContext(nullptr), fPoolWrite(0), fQuit(false)
+{
+	assert(pool_size > 0);
+	for (int i=0; i < pool_size; i++)
+	{
+		AVFrame *frame = av_frame_alloc();
+		if (frame)
+		{
+			frame->format = config->pix_fmt;
+			frame->width = config->width;
+			frame->height = config->height;
+		}
+		if (!frame || (av_frame_get_buffer(frame, 32) < 0))
+		{
+			printf("SegmentEncoderActor() Could not allocate frame pool\n");
+			exit(1);
+		}
+		fPool.push_back(frame);
+	}
+
+	fFreeSemaphore = create_sem(pool_size, "SegmentEncoder Free Semaphore");
+	fSegmentSemaphore = create_sem(0, "SegmentEncoder Segment Semaphore");
+	fQuitSemaphore = create_sem(0, "SegmentEncoder Quit Semaphore");
+	if ((fFreeSemaphore < B_OK) || (fSegmentSemaphore < B_OK) || (fQuitSemaphore < B_OK))
+	{
+		printf("SegmentEncoderActor() Cannot create semaphore\n");
+		exit(1);
+	}
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: ~SegmentEncoderActor
+	ARGS:			n/a
+	RETURN:			n/a
+	DESCRIPTION:	Destructor, call Quit() first
+*/
+SegmentEncoderActor :: ~SegmentEncoderActor()
+{
+	for (auto &packets : fCompleted)
+	{
+		for (auto &pkt : packets)
+			av_packet_free(&pkt);
+	}
+	for (auto &frame : fPool)
+		av_frame_free(&frame);
+	delete_sem(fFreeSemaphore);
+	delete_sem(fSegmentSemaphore);
+	delete_sem(fQuitSemaphore);
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: OpenContext
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create codec context with the same configuration as fConfig
+*/
+void SegmentEncoderActor :: OpenContext()
+{
+	assert(fContext == nullptr);
+	fContext = avcodec_alloc_context3(fCodec);
+	if (!fContext)
+	{
+		printf("SegmentEncoderActor::OpenContext() Could not alloc an encoding context\n");
+		exit(1);
+	}
+	fContext->codec_id = fConfig->codec_id;
+	fContext->bit_rate = fConfig->bit_rate;
+	fContext->width = fConfig->width;
+	fContext->height = fConfig->height;
+	fContext->sample_aspect_ratio = fConfig->sample_aspect_ratio;
+	fContext->time_base = fConfig->time_base;
+	fContext->framerate = fConfig->framerate;
+	fContext->gop_size = fConfig->gop_size;
+	fContext->max_b_frames = fConfig->max_b_frames;
+	fContext->mb_decision = fConfig->mb_decision;
+	fContext->pix_fmt = fConfig->pix_fmt;
+	fContext->flags = fConfig->flags;
+	fContext->flags2 = fConfig->flags2;
+	fContext->strict_std_compliance = fConfig->strict_std_compliance;
+	fContext->thread_count = fThreadCount;
+
+	int ret = avcodec_open2(fContext, fCodec, nullptr);
+	if (ret < 0)
+	{
+		printf("SegmentEncoderActor::OpenContext() Could not open codec (%d)\n", ret);
+		exit(1);
+	}
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: ReceivePackets
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Move encoded packets to current segment
+*/
+void SegmentEncoderActor :: ReceivePackets()
+{
+	for (;;)
+	{
+		AVPacket *pkt = av_packet_alloc();
+		int ret = avcodec_receive_packet(fContext, pkt);
+		if (ret < 0)
+		{
+			av_packet_free(&pkt);
+			if ((ret != AVERROR(EAGAIN)) && (ret != AVERROR_EOF))
+				printf("SegmentEncoderActor::ReceivePackets() avcodec_receive_packet returned %d\n", ret);
+			return;
+		}
+		fPackets.push_back(pkt);
+	}
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: AsyncEncodeFrame
+	ARGS:			frame (pool frame, pts set)
+	RETURN:			n/a
+	DESCRIPTION:	Encode frame, pool frame can then be reused
+*/
+void SegmentEncoderActor :: AsyncEncodeFrame(AVFrame *frame)
+{
+	if (fQuit)
+	{
+		release_sem(fFreeSemaphore);
+		return;
+	}
+
+	const bigtime_t start_time = system_time();
+	if (!fContext)
+		OpenContext();
+
+	int ret = avcodec_send_frame(fContext, frame);
+	if (ret < 0)
+		printf("SegmentEncoderActor::AsyncEncodeFrame() avcodec_send_frame returned %d\n", ret);
+	release_sem(fFreeSemaphore);
+	ReceivePackets();
+
+	fEncodeTime += system_time() - start_time;
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: AsyncEndSegment
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Drain encoder, publish segment packets
+*/
+void SegmentEncoderActor :: AsyncEndSegment()
+{
+	if (fQuit)
+		return;		//	AsyncQuit() releases context and packets
+
+	const bigtime_t start_time = system_time();
+	if (fContext)
+	{
+		avcodec_send_frame(fContext, nullptr);
+		ReceivePackets();
+		avcodec_free_context(&fContext);
+	}
+
+	fCompletedMutex.lock();
+	fCompleted.emplace_back(std::move(fPackets));
+	fCompletedMutex.unlock();
+	fPackets.clear();
+	fEncodeTime += system_time() - start_time;
+	release_sem(fSegmentSemaphore);
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: AsyncQuit
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Release codec context of incomplete segment (cancelled export)
+*/
+void SegmentEncoderActor :: AsyncQuit()
+{
+	avcodec_free_context(&fContext);
+	for (auto &pkt : fPackets)
+		av_packet_free(&pkt);
+	fPackets.clear();
+	release_sem(fQuitSemaphore);		//	last access, Quit() waits for this
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: Quit
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Discard queued frames, wait until actor idle, safe to delete actor
+*/
+void SegmentEncoderActor :: Quit()
+{
+	fQuit = true;
+	Async<&SegmentEncoderActor::AsyncQuit>();
+	while (acquire_sem(fQuitSemaphore) == B_INTERRUPTED) ;
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: AcquireFrame
+	ARGS:			none
+	RETURN:			writable pool frame
+	DESCRIPTION:	Block until pool frame available (back-pressure)
+*/
+AVFrame * SegmentEncoderActor :: AcquireFrame()
+{
+	while (acquire_sem(fFreeSemaphore) == B_INTERRUPTED) ;
+	AVFrame *frame = fPool[fPoolWrite];
+	fPoolWrite = (fPoolWrite + 1) % fPool.size();
+
+	/* the encoder may keep a reference to the frame internally, make sure we do not overwrite it here */
+	if (av_frame_make_writable(frame) < 0)
+	{
+		printf("SegmentEncoderActor::AcquireFrame() av_frame_make_writable failed\n");
+		exit(1);
+	}
+	return frame;
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: WaitSegment
+	ARGS:			timeout (microseconds, 0 = poll)
+	RETURN:			true if segment complete (call PopSegment())
+	DESCRIPTION:	Segments complete in order
+*/
+bool SegmentEncoderActor :: WaitSegment(const bigtime_t timeout)
+{
+	status_t err;
+	while ((err = acquire_sem_etc(fSegmentSemaphore, 1, B_RELATIVE_TIMEOUT, timeout)) == B_INTERRUPTED) ;
+	return (err == B_OK);
+}
+
+/*	FUNCTION:		SegmentEncoderActor :: PopSegment
+	ARGS:			packets (caller takes ownership)
+	RETURN:			n/a
+	DESCRIPTION:	Oldest completed segment
+*/
+void SegmentEncoderActor :: PopSegment(std::vector<AVPacket *> &packets)
+{
+	fCompletedMutex.lock();
+	assert(!fCompleted.empty());
+	packets = std::move(fCompleted.front());
+	fCompleted.pop_front();
+	fCompletedMutex.unlock();
+}
+
+/*************************************
+	ExportSegmentEncoder
+**************************************/
+
+/*	FUNCTION:		ExportSegmentEncoder :: ExportSegmentEncoder
+	ARGS:			codec, config (opened stream context, provides configuration and time base)
+					number_encoders (requested concurrent segments)
+					pipeline (frame source), converter (to config pix_fmt)
+					keep_alive (cleared when export cancelled, must outlive encoder)
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+ExportSegmentEncoder :: ExportSegmentEncoder(const AVCodec *codec, const AVCodecContext *config, const int number_encoders,
+											 ExportPipeline *pipeline, ExportConverter *converter, const std::atomic<bool> &keep_alive)
+	: fPipeline(pipeline), fConverter(converter), fKeepAlive(keep_alive), fNextDispatch(0), fDispatchSegment(0), fNextReceive(0)
+{
+	assert((codec != nullptr) && (config != nullptr) && (pipeline != nullptr) && (converter != nullptr));
+
+	//	Frames encoded by the sequential path (see Export_ffmpeg::get_video_frame())
+	fNumberFrames = 0;
+	while (pipeline->GetFrameIndex(fNumberFrames) < gProject->mTotalDuration)
+		fNumberFrames++;
+
+	const int gop_size = (config->gop_size > 0) ? config->gop_size : 12;
+	const int segment_frames = kGopsPerSegment * gop_size;
+	PlanSegments(segment_frames);
+
+	//	Each encoder holds a pool of one segment of frames, pools limited to 25% of free memory
+	system_info info;
+	get_system_info(&info);
+	int64 pool_budget = (int64)(info.free_memory/4);
+	if (pool_budget > kMaxFramePoolBytes)
+		pool_budget = kMaxFramePoolBytes;
+	const int frame_bytes = av_image_get_buffer_size(config->pix_fmt, config->width, config->height, 32);
+	int count_encoders = std::max(1, std::min(number_encoders, (int)(fSegmentStart.size() - 1)));
+	if (frame_bytes > 0)
+		count_encoders = std::max(1, std::min<int>(count_encoders, pool_budget/((int64)segment_frames*frame_bytes)));
+	const int thread_count = std::max(1, ParallelForConcurrency()/count_encoders);
+
+	for (int i=0; i < count_encoders; i++)
+		fEncoders.push_back(new SegmentEncoderActor(codec, config, segment_frames, thread_count));
+
+	printf("[ExportSegmentEncoder] %ld frames, %ld segments (%d frames), %d encoders x %d threads (pool budget %ld MiB)\n",
+		   fNumberFrames, (int64)fSegmentStart.size() - 1, segment_frames, count_encoders, thread_count, pool_budget/(1024*1024));
+	fStartTime = system_time();
+}
+
+/*	FUNCTION:		ExportSegmentEncoder :: ~ExportSegmentEncoder
+	ARGS:			n/a
+	RETURN:			n/a
+	DESCRIPTION:	Destructor, discards frames in flight (export may be cancelled)
+*/
+ExportSegmentEncoder :: ~ExportSegmentEncoder()
+{
+	for (auto &encoder : fEncoders)
+	{
+		encoder->Quit();
+		delete encoder;
+	}
+}
+
+/*	FUNCTION:		ExportSegmentEncoder :: PlanSegments
+	ARGS:			segment_frames (maximum segment length, multiple of the GOP size)
+	RETURN:			n/a
+	DESCRIPTION:	Populate fSegmentStart, GOP aligned unless snapped to a clip cut
+*/
+void ExportSegmentEncoder :: PlanSegments(const int64 segment_frames)
+{
+	//	First frame number at or after timeline frame_idx
+	auto frame_number_at = [this](const bigtime_t frame_idx) -> int64
+	{
+		int64 lo = 0, hi = fNumberFrames;
+		while (lo < hi)
+		{
+			const int64 mid = (lo + hi)/2;
+			if (fPipeline->GetFrameIndex(mid) < frame_idx)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	};
+
+	//	Clip cuts (scene changes)
+	std::vector<int64> cuts;
+	for (auto &track : gProject->mTimelineTracks)
+	{
+		if (!track->mVideoEnabled)
+			continue;
+		for (auto &clip : track->mClips)
+		{
+			for (const bigtime_t cut : {clip.mTimelineFrameStart, clip.GetTimelineEndFrame()})
+			{
+				const int64 frame_number = frame_number_at(cut);
+				if ((frame_number > 0) && (frame_number < fNumberFrames))
+					cuts.push_back(frame_number);
+			}
+		}
+	}
+	std::sort(cuts.begin(), cuts.end());
+
+	fSegmentStart.clear();
+	int64 start = 0;
+	while (start < fNumberFrames)
+	{
+		fSegmentStart.push_back(start);
+		int64 end = start + segment_frames;
+
+		//	Latest cut in second half of segment
+		auto it = std::upper_bound(cuts.begin(), cuts.end(), end);
+		if (it != cuts.begin())
+		{
+			--it;
+			if (*it >= start + segment_frames/2)
+				end = *it;
+		}
+		start = std::min(end, fNumberFrames);
+	}
+	fSegmentStart.push_back(fNumberFrames);
+}
+
+/*	FUNCTION:		ExportSegmentEncoder :: DispatchFrame
+	ARGS:			none
+	RETURN:			false if all frames dispatched
+	DESCRIPTION:	Render next frame, convert to pool frame of segment encoder
+					Blocks when the encoder pool is full
+*/
+bool ExportSegmentEncoder :: DispatchFrame()
+{
+	if (fNextDispatch >= fNumberFrames)
+		return false;
+
+	SegmentEncoderActor *encoder = fEncoders[fDispatchSegment % fEncoders.size()];
+	BBitmap *bitmap = fPipeline->GetFrame(fNextDispatch);
+	AVFrame *frame = encoder->AcquireFrame();
+	if (bitmap)
+		fConverter->Convert(bitmap, frame);
+	else
+		printf("ExportSegmentEncoder::DispatchFrame(), warning output = nullptr\n");
+	frame->pts = fNextDispatch;
+	encoder->Async<&SegmentEncoderActor::AsyncEncodeFrame>(frame);
+	DEBUG("[ExportSegmentEncoder] frame %ld -> segment %ld\n", fNextDispatch, fDispatchSegment);
+
+	fNextDispatch++;
+	if (fNextDispatch == fSegmentStart[fDispatchSegment + 1])
+	{
+		encoder->Async<&SegmentEncoderActor::AsyncEndSegment>();
+		fDispatchSegment++;
+	}
+	return true;
+}
+
+/*	FUNCTION:		ExportSegmentEncoder :: ReceiveSegment
+	ARGS:			packets (caller takes ownership, presentation order of segments)
+					end_frame (first frame number after segment)
+					cancelled (set when keep_alive cleared)
+	RETURN:			false when all segments received or export cancelled
+	DESCRIPTION:	Dispatch frames until the next segment is encoded.  Cancellation is checked per frame.
+*/
+bool ExportSegmentEncoder :: ReceiveSegment(std::vector<AVPacket *> &packets, int64 *end_frame, bool *cancelled)
+{
+	*cancelled = false;
+	if (fNextReceive + 1 >= (int64)fSegmentStart.size())
+		return false;
+
+	SegmentEncoderActor *encoder = fEncoders[fNextReceive % fEncoders.size()];
+	bool dispatching = true;
+	while (!encoder->WaitSegment(dispatching ? 0 : kCancelPollTime))
+	{
+		if (!fKeepAlive)
+		{
+			*cancelled = true;
+			return false;
+		}
+		if (dispatching)
+			dispatching = DispatchFrame();
+	}
+	encoder->PopSegment(packets);
+
+	fNextReceive++;
+	if (end_frame)
+		*end_frame = fSegmentStart[fNextReceive];
+	return true;
+}
+
+/*	FUNCTION:		ExportSegmentEncoder :: PrintStatistics
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Encoder throughput, call after all segments received
+*/
+void ExportSegmentEncoder :: PrintStatistics() const
+{
+	const bigtime_t elapsed = system_time() - fStartTime;
+	bigtime_t encode_time = 0;
+	for (auto &encoder : fEncoders)
+		encode_time += encoder->fEncodeTime;
+	printf("[ExportSegmentEncoder] %ld frames in %0.2f s (%0.1f fps), encoders busy %0.1f%%\n",
+		   fNextDispatch, 0.000001*elapsed, elapsed > 0 ? 1000000.0*fNextDispatch/elapsed : 0.0,
+		   elapsed > 0 ? 100.0*encode_time/(elapsed*(double)fEncoders.size()) : 0.0);
+}
@@ -0,0 +1,78 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Segmented parallel video encoder (ffmpeg export)
+ */
+
+#ifndef _EXPORT_SEGMENTS_H_
+#define _EXPORT_SEGMENTS_H_
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _GLIBCXX_ATOMIC
+#include <atomic>
+#endif
+
+#ifndef _OS_H
+#include <kernel/OS.h>
+#endif
+
+struct AVCodec;
+struct AVCodecContext;
+struct AVPacket;
+class ExportPipeline;
+class ExportConverter;
+class SegmentEncoderActor;
+
+/*****************************
+	ExportSegmentEncoder splits the video into closed GOP segments, which are encoded
+	concurrently by several encoder instances (each segment starts with a fresh codec
+	context, so every segment starts with a key frame).  Segment i is encoded by encoder
+	actor (i % number_encoders).
+	Segment boundaries are GOP aligned (kGopsPerSegment), and snap to a clip cut (scene
+	change) when one falls in the second half of the segment.
+	Rendering and decoding remain sequential (single RenderActor, serialised media decoding),
+	frames are taken from the ExportPipeline in order, converted to the encoder pixel format
+	and queued to the segment encoder.  Each encoder owns a frame pool of one segment,
+	which bounds memory and provides back-pressure.  The pools of all encoders are limited
+	to a quarter of free memory (at most kMaxFramePoolBytes), which caps the encoder count.
+	ReceiveSegment() returns the packets of the next segment in presentation order, the caller
+	concatenates them into the output container (no re-encoding).  Audio is not handled here.
+	keep_alive is polled for every frame, so a cancelled export stops within a frame (queued
+	frames are discarded, not encoded).
+	Encoder instances must produce identical stream parameters (same configuration).
+	Accessed only from the encoder actor (Ffmpeg_Actor).
+******************************/
+class ExportSegmentEncoder
+{
+public:
+	static const int	kGopsPerSegment = 2;
+	static const int64	kMaxFramePoolBytes = 1536LL*1024*1024;
+	static const bigtime_t	kCancelPollTime = 50000;	//	waiting for final segment
+
+						ExportSegmentEncoder(const AVCodec *codec, const AVCodecContext *config, const int number_encoders,
+											 ExportPipeline *pipeline, ExportConverter *converter, const std::atomic<bool> &keep_alive);
+						~ExportSegmentEncoder();
+
+	bool				ReceiveSegment(std::vector<AVPacket *> &packets, int64 *end_frame, bool *cancelled);
+	void				PrintStatistics() const;
+
+private:
+	void				PlanSegments(const int64 segment_frames);
+	bool				DispatchFrame();
+
+	ExportPipeline		*fPipeline;
+	ExportConverter		*fConverter;
+	const std::atomic<bool>	&fKeepAlive;
+	std::vector<SegmentEncoderActor *>	fEncoders;
+	std::vector<int64>	fSegmentStart;			//	segment i = [fSegmentStart[i], fSegmentStart[i+1])
+	int64				fNumberFrames;
+	int64				fNextDispatch;			//	frame number
+	int64				fDispatchSegment;
+	int64				fNextReceive;			//	segment index
+	bigtime_t			fStartTime;
+};
+
+#endif	//#ifndef _EXPORT_SEGMENTS_H_
@@ -0,0 +1,219 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Rendered output frame cache
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+#include <kernel/OS.h>
+#include <interface/Bitmap.h>
+
+#include "FrameCache.h"
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+static const size_t kMinMemoryBudget = 256*1024*1024;
+static const size_t kMaxMemoryBudget = 2048UL*1024*1024;
+static const size_t kRecentBitmaps = 2;		//	OutputView may display previous frame while next is prepared
+
+/*	FUNCTION:		FrameCache :: FrameCache
+	ARGS:			memory_budget (0 = derive from system memory)
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+FrameCache :: FrameCache(const size_t memory_budget)
+	: fMemoryUsed(0), fUseCounter(0), fEditGeneration(gProject->mEditGeneration)
+{
+	SetMemoryBudget(memory_budget);
+}
+
+/*	FUNCTION:		FrameCache :: ~FrameCache
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Destructor
+*/
+FrameCache :: ~FrameCache()
+{
+	for (auto &i : fFrames)
+		delete i.second.bitmap;
+	for (auto i : fRetiredBitmaps)
+		delete i;
+}
+
+/*	FUNCTION:		FrameCache :: SetMemoryBudget
+	ARGS:			bytes (0 = 1/8 of system memory)
+	RETURN:			n/a
+	DESCRIPTION:	Set memory budget, evict frames if exceeded
+*/
+void FrameCache :: SetMemoryBudget(const size_t bytes)
+{
+	if (bytes > 0)
+		fMemoryBudget = bytes;
+	else
+	{
+		system_info info;
+		get_system_info(&info);
+		fMemoryBudget = std::clamp((size_t)info.max_pages*B_PAGE_SIZE/8, kMinMemoryBudget, kMaxMemoryBudget);
+	}
+	while (!fFrames.empty() && (fMemoryUsed > fMemoryBudget))
+		EvictLeastRecentlyUsed();
+}
+
+/*	FUNCTION:		FrameCache :: Clear
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Evict all frames
+*/
+void FrameCache :: Clear()
+{
+	while (!fFrames.empty())
+		Evict(fFrames.begin());
+	fEditGeneration = gProject->mEditGeneration;
+}
+
+/*	FUNCTION:		FrameCache :: Evict
+	ARGS:			it
+	RETURN:			n/a
+	DESCRIPTION:	Remove frame, recently returned bitmaps are retired instead of deleted
+*/
+void FrameCache :: Evict(std::map<int64, FRAME>::iterator it)
+{
+	BBitmap *bitmap = it->second.bitmap;
+	fMemoryUsed -= bitmap->BitsLength();
+	fFrames.erase(it);
+
+	if (std::find(fRecentBitmaps.begin(), fRecentBitmaps.end(), bitmap) != fRecentBitmaps.end())
+		fRetiredBitmaps.push_back(bitmap);
+	else
+		delete bitmap;
+}
+
+/*	FUNCTION:		FrameCache :: EvictLeastRecentlyUsed
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Remove least recently used frame
+*/
+void FrameCache :: EvictLeastRecentlyUsed()
+{
+	assert(!fFrames.empty());
+	auto lru = fFrames.begin();
+	for (auto it = fFrames.begin(); it != fFrames.end(); ++it)
+	{
+		if (it->second.last_used < lru->second.last_used)
+			lru = it;
+	}
+	DEBUG("FrameCache::EvictLeastRecentlyUsed(%ld)\n", lru->first);
+	Evict(lru);
+}
+
+/*	FUNCTION:		FrameCache :: Returned
+	ARGS:			bitmap
+	RETURN:			bitmap
+	DESCRIPTION:	Track recently returned bitmaps, delete retired bitmaps which are no longer recent
+*/
+BBitmap * FrameCache :: Returned(BBitmap *bitmap)
+{
+	fRecentBitmaps.push_back(bitmap);
+	if (fRecentBitmaps.size() > kRecentBitmaps)
+		fRecentBitmaps.pop_front();
+
+	for (auto it = fRetiredBitmaps.begin(); it != fRetiredBitmaps.end();)
+	{
+		if (std::find(fRecentBitmaps.begin(), fRecentBitmaps.end(), *it) == fRecentBitmaps.end())
+		{
+			delete *it;
+			it = fRetiredBitmaps.erase(it);
+		}
+		else
+			++it;
+	}
+	return bitmap;
+}
+
+/*	FUNCTION:		FrameCache :: Validate
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Evict frames which intersect timeline ranges edited since last validation
+*/
+void FrameCache :: Validate()
+{
+	const uint32 generation = gProject->mEditGeneration;
+	if (generation == fEditGeneration)
+		return;
+
+	if (!gProject->GetEditRanges(fEditGeneration, fEditRanges))
+	{
+		DEBUG("FrameCache::Validate() edit history exhausted, clear all\n");
+		Clear();
+		return;
+	}
+
+	for (auto &r : fEditRanges)
+	{
+		auto it = fFrames.lower_bound(r.start);
+		while ((it != fFrames.end()) && (it->first < r.end))
+		{
+			auto next = std::next(it);
+			Evict(it);
+			it = next;
+		}
+		//	Edit generation uses the most recent range
+		fEditGeneration = r.generation;
+	}
+	DEBUG("FrameCache::Validate() generation=%u, ranges=%lu, cached=%lu\n", fEditGeneration, fEditRanges.size(), fFrames.size());
+	if (fEditRanges.empty())
+		fEditGeneration = generation;
+}
+
+/*	FUNCTION:		FrameCache :: Find
+	ARGS:			frame_idx
+	RETURN:			cached output frame (nullptr if not cached)
+	DESCRIPTION:	Lookup rendered frame
+*/
+BBitmap * FrameCache :: Find(const int64 frame_idx)
+{
+	Validate();
+
+	auto it = fFrames.find(frame_idx);
+	if (it == fFrames.end())
+		return nullptr;
+
+	it->second.last_used = ++fUseCounter;
+	return Returned(it->second.bitmap);
+}
+
+/*	FUNCTION:		FrameCache :: Add
+	ARGS:			frame_idx
+					source
+	RETURN:			cached copy of source
+	DESCRIPTION:	Cache rendered frame (Find() must be called prior to rendering frame)
+*/
+BBitmap * FrameCache :: Add(const int64 frame_idx, BBitmap *source)
+{
+	assert(source);
+	const size_t frame_size = source->BitsLength();
+	if (frame_size > fMemoryBudget)
+		return source;
+
+	auto existing = fFrames.find(frame_idx);
+	if (existing != fFrames.end())
+		Evict(existing);
+
+	while (!fFrames.empty() && (fMemoryUsed + frame_size > fMemoryBudget))
+		EvictLeastRecentlyUsed();
+
+	BBitmap *bitmap = new BBitmap(source->Bounds(), source->ColorSpace());
+	memcpy(bitmap->Bits(), source->Bits(), frame_size);
+	fFrames[frame_idx] = {bitmap, ++fUseCounter};
+	fMemoryUsed += frame_size;
+	DEBUG("FrameCache::Add(%ld) cached=%lu, memory=%luMB\n", frame_idx, fFrames.size(), fMemoryUsed/(1024*1024));
+	return Returned(bitmap);
+}
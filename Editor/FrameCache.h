@@ -0,0 +1,71 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Rendered output frame cache
+ */
+
+#ifndef _FRAME_CACHE_H_
+#define _FRAME_CACHE_H_
+
+#ifndef _GLIBCXX_MAP
+#include <map>
+#endif
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _GLIBCXX_DEQUE
+#include <deque>
+#endif
+
+#ifndef _PROJECT_H_
+#include "Project.h"
+#endif
+
+class BBitmap;
+
+/*****************************
+	FrameCache holds copies of composited output frames (keyed by frame_idx), so looped playback
+	and scrubbing over previously rendered frames do not recomposite.
+	Entries are validated against Project::mEditGeneration, only frames inside edited
+	ranges (Project::GetEditRanges()) are evicted.  Least recently used frames are evicted
+	when the memory budget is exceeded.
+	The most recently returned bitmaps are never deleted on eviction (the preview window may
+	still be displaying them), they are retired until no longer recent.
+	Accessed only from the RenderActor thread.
+******************************/
+class FrameCache
+{
+public:
+						FrameCache(const size_t memory_budget = 0);
+						~FrameCache();
+
+	BBitmap				*Find(const int64 frame_idx);
+	BBitmap				*Add(const int64 frame_idx, BBitmap *source);
+	void				Clear();
+	void				SetMemoryBudget(const size_t bytes);
+	const size_t		GetMemoryUsed() const	{return fMemoryUsed;}
+
+private:
+	struct FRAME
+	{
+		BBitmap			*bitmap;
+		uint64			last_used;
+	};
+	void				Validate();
+	void				Evict(std::map<int64, FRAME>::iterator it);
+	void				EvictLeastRecentlyUsed();
+	BBitmap				*Returned(BBitmap *bitmap);
+
+	std::map<int64, FRAME>			fFrames;
+	std::deque<BBitmap *>			fRecentBitmaps;
+	std::vector<BBitmap *>			fRetiredBitmaps;
+	std::vector<Project::EDIT_RANGE>	fEditRanges;
+	size_t							fMemoryBudget;
+	size_t							fMemoryUsed;
+	uint64							fUseCounter;
+	uint32							fEditGeneration;		//	all cached frames are valid for this generation
+};
+
+#endif	//#ifndef _FRAME_CACHE_H_
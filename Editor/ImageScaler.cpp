@@ -0,0 +1,453 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Image scaler (box / bilinear, 32 bit pixels)
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include <interface/Bitmap.h>
+
+#include "ImageScaler.h"
+#include "ParallelFor.h"
+
+#if defined (__GNUC__)
+	#if defined(__amd64__)
+		#define Y_CPU_X86
+		#define Y_SCALER_AVX2
+	#endif
+#elif defined (_MSC_VER)
+	#define Y_CPU_X86
+#endif
+
+#ifdef Y_CPU_X86
+#include <emmintrin.h>
+#endif
+#ifdef Y_SCALER_AVX2
+#include <immintrin.h>
+#endif
+
+/*	Box reductions above this ratio are point sampled down to it first */
+static const int kMaxBoxRatio = 2;
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+/*	Contiguous source taps for every destination pixel (one axis) */
+struct FILTER_TAPS
+{
+	int					max_taps;
+	std::vector<int>	start;
+	std::vector<int>	count;
+	std::vector<float>	weights;		//	max_taps per destination pixel, normalised
+};
+
+/*	FUNCTION:		BuildFilter
+	ARGS:			filter
+					source_size
+					dest_size
+					taps
+	RETURN:			n/a
+	DESCRIPTION:	Box: fractional coverage of [i*scale, (i+1)*scale)
+					Bilinear: 2 taps around pixel centre (i + 0.5)*scale - 0.5
+*/
+static void BuildFilter(const SCALE_FILTER filter, const int source_size, const int dest_size, FILTER_TAPS &taps)
+{
+	const double scale = double(source_size)/double(dest_size);
+	taps.max_taps = (filter == SCALE_FILTER_BOX) ? (int)ceil(scale) + 1 : 2;
+	taps.start.resize(dest_size);
+	taps.count.resize(dest_size);
+	taps.weights.assign((size_t)dest_size*taps.max_taps, 0.0f);
+
+	for (int i=0; i < dest_size; i++)
+	{
+		float *w = taps.weights.data() + (size_t)i*taps.max_taps;
+		if (filter == SCALE_FILTER_BOX)
+		{
+			const double left = i*scale;
+			const double right = std::min((i + 1)*scale, (double)source_size);
+			int first = (int)floor(left);
+			int last = std::min((int)ceil(right), source_size) - 1;
+			//	Drop slivers caused by rounding
+			if ((last > first) && (first + 1 - left < 1e-6))
+				first++;
+			if ((last > first) && (right - last < 1e-6))
+				last--;
+			assert(last - first + 1 <= taps.max_taps);
+
+			double sum = 0.0;
+			for (int s=first; s <= last; s++)
+				sum += std::min(right, s + 1.0) - std::max(left, (double)s);
+			for (int s=first; s <= last; s++)
+				w[s - first] = float((std::min(right, s + 1.0) - std::max(left, (double)s))/sum);
+			taps.start[i] = first;
+			taps.count[i] = last - first + 1;
+		}
+		else
+		{
+			const double centre = (i + 0.5)*scale - 0.5;
+			int s0 = (int)floor(centre);
+			float f = float(centre - s0);
+			if (s0 < 0)
+			{
+				s0 = 0;
+				f = 0.0f;
+			}
+			if (s0 >= source_size - 1)
+			{
+				s0 = source_size - 1;
+				f = 0.0f;
+			}
+			taps.start[i] = s0;
+			taps.count[i] = (f > 0.0f) ? 2 : 1;
+			w[0] = 1.0f - f;
+			w[1] = f;
+		}
+	}
+}
+
+/*	FUNCTION:		AccumulateRow
+	ARGS:			source (4*count bytes)
+					count (pixels)
+					weight
+					row (4*count floats)
+					first (first tap, row contents ignored)
+	RETURN:			n/a
+	DESCRIPTION:	row = (first ? 0 : row) + weight*source
+*/
+static void AccumulateRow_Scalar(const uint8 *source, const int count, const float weight, float *row, const bool first)
+{
+	if (first)
+	{
+		for (int i=0; i < 4*count; i++)
+			row[i] = weight*source[i];
+	}
+	else
+	{
+		for (int i=0; i < 4*count; i++)
+			row[i] += weight*source[i];
+	}
+}
+
+#ifdef Y_CPU_X86
+template <bool kFirst>
+static void AccumulateRowT_SSE2(const uint8 *source, const int count, const float weight, float *row)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 w = _mm_set1_ps(weight);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128((const __m128i *)(source + 4*i));
+		const __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+		const __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+		const __m128 p0 = _mm_mul_ps(w, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+		const __m128 p1 = _mm_mul_ps(w, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+		const __m128 p2 = _mm_mul_ps(w, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+		const __m128 p3 = _mm_mul_ps(w, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+		float *r = row + 4*i;
+		if (kFirst)
+		{
+			_mm_storeu_ps(r + 0, p0);
+			_mm_storeu_ps(r + 4, p1);
+			_mm_storeu_ps(r + 8, p2);
+			_mm_storeu_ps(r + 12, p3);
+		}
+		else
+		{
+			_mm_storeu_ps(r + 0, _mm_add_ps(_mm_loadu_ps(r + 0), p0));
+			_mm_storeu_ps(r + 4, _mm_add_ps(_mm_loadu_ps(r + 4), p1));
+			_mm_storeu_ps(r + 8, _mm_add_ps(_mm_loadu_ps(r + 8), p2));
+			_mm_storeu_ps(r + 12, _mm_add_ps(_mm_loadu_ps(r + 12), p3));
+		}
+	}
+	AccumulateRow_Scalar(source + 4*i, count - i, weight, row + 4*i, kFirst);
+}
+static void AccumulateRow_SSE2(const uint8 *source, const int count, const float weight, float *row, const bool first)
+{
+	if (first)
+		AccumulateRowT_SSE2<true>(source, count, weight, row);
+	else
+		AccumulateRowT_SSE2<false>(source, count, weight, row);
+}
+#endif
+
+#ifdef Y_SCALER_AVX2
+//	No FMA (output must match SSE2 / scalar paths)
+template <bool kFirst>
+__attribute__((target("avx2")))
+static void AccumulateRowT_AVX2(const uint8 *source, const int count, const float weight, float *row)
+{
+	const __m256 w = _mm256_set1_ps(weight);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128((const __m128i *)(source + 4*i));
+		const __m256 p0 = _mm256_mul_ps(w, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(pixels)));
+		const __m256 p1 = _mm256_mul_ps(w, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(pixels, 8))));
+		float *r = row + 4*i;
+		if (kFirst)
+		{
+			_mm256_storeu_ps(r + 0, p0);
+			_mm256_storeu_ps(r + 8, p1);
+		}
+		else
+		{
+			_mm256_storeu_ps(r + 0, _mm256_add_ps(_mm256_loadu_ps(r + 0), p0));
+			_mm256_storeu_ps(r + 8, _mm256_add_ps(_mm256_loadu_ps(r + 8), p1));
+		}
+	}
+	AccumulateRow_Scalar(source + 4*i, count - i, weight, row + 4*i, kFirst);
+}
+__attribute__((target("avx2")))
+static void AccumulateRow_AVX2(const uint8 *source, const int count, const float weight, float *row, const bool first)
+{
+	if (first)
+		AccumulateRowT_AVX2<true>(source, count, weight, row);
+	else
+		AccumulateRowT_AVX2<false>(source, count, weight, row);
+}
+#endif
+
+typedef void (*ACCUMULATE_ROW)(const uint8 *, const int, const float, float *, const bool);
+
+/*	FUNCTION:		GetAccumulateRow
+	ARGS:			none
+	RETURN:			vertical kernel for this cpu
+	DESCRIPTION:	Selected once
+*/
+static ACCUMULATE_ROW GetAccumulateRow()
+{
+	static const ACCUMULATE_ROW sKernel = []()
+	{
+#if defined (Y_SCALER_AVX2)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+		{
+			DEBUG("[ImageScaler] AVX2\n");
+			return &AccumulateRow_AVX2;
+		}
+#endif
+#if defined (Y_CPU_X86)
+		return &AccumulateRow_SSE2;
+#else
+		return &AccumulateRow_Scalar;
+#endif
+	}();
+	return sKernel;
+}
+
+/*	FUNCTION:		FilterRow
+	ARGS:			row (4 floats per source pixel)
+					taps (horizontal)
+					dest_width
+					dest
+	RETURN:			n/a
+	DESCRIPTION:	Horizontal pass, round and saturate to 8 bit
+*/
+static void FilterRow(const float *row, const FILTER_TAPS &taps, const int dest_width, uint8 *dest)
+{
+	const int *start = taps.start.data();
+	const int *count = taps.count.data();
+	const float *weights = taps.weights.data();
+	const int max_taps = taps.max_taps;
+#ifdef Y_CPU_X86
+	const __m128 half = _mm_set1_ps(0.5f);
+	uint32 *d = (uint32 *)dest;
+	for (int x=0; x < dest_width; x++)
+	{
+		const float *s = row + 4*start[x];
+		const float *w = weights + (size_t)x*max_taps;
+		__m128 sum = _mm_mul_ps(_mm_set1_ps(w[0]), _mm_loadu_ps(s));
+		for (int t=1; t < count[x]; t++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[t]), _mm_loadu_ps(s + 4*t)));
+		__m128i v = _mm_cvttps_epi32(_mm_add_ps(sum, half));
+		v = _mm_packs_epi32(v, v);
+		d[x] = (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+	}
+#else
+	for (int x=0; x < dest_width; x++)
+	{
+		const float *s = row + 4*start[x];
+		const float *w = weights + (size_t)x*max_taps;
+		for (int c=0; c < 4; c++)
+		{
+			float sum = w[0]*s[c];
+			for (int t=1; t < count[x]; t++)
+				sum = sum + w[t]*s[4*t + c];
+			dest[4*x + c] = (uint8)std::min((int)(sum + 0.5f), 255);
+		}
+	}
+#endif
+}
+
+/*	FUNCTION:		HalveRows
+	ARGS:			source, source_bytes_per_row
+					dest, dest_width, dest_bytes_per_row
+					row_start, row_end
+	RETURN:			n/a
+	DESCRIPTION:	Exact 2:1 box, (a + b + c + d + 2)/4 per channel in integer arithmetic.
+					Same result as the float path (every intermediate is exact in float).
+*/
+static void HalveRows(const uint8 *source, const int32 source_bytes_per_row,
+					  uint8 *dest, const int dest_width, const int32 dest_bytes_per_row,
+					  const int row_start, const int row_end)
+{
+	for (int y=row_start; y < row_end; y++)
+	{
+		const uint8 *a = source + (size_t)(2*y)*source_bytes_per_row;
+		const uint8 *b = a + source_bytes_per_row;
+		uint8 *d = dest + (size_t)y*dest_bytes_per_row;
+		int x = 0;
+#ifdef Y_CPU_X86
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two = _mm_set1_epi16(2);
+		for (; x + 4 <= dest_width; x += 4)
+		{
+			const __m128i a0 = _mm_loadu_si128((const __m128i *)(a + 8*x));
+			const __m128i a1 = _mm_loadu_si128((const __m128i *)(a + 8*x + 16));
+			const __m128i b0 = _mm_loadu_si128((const __m128i *)(b + 8*x));
+			const __m128i b1 = _mm_loadu_si128((const __m128i *)(b + 8*x + 16));
+			//	vertical sums, 2 source pixels per register
+			const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+			const __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+			const __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+			const __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+			//	horizontal pairs
+			__m128i p01 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+			__m128i p23 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+			p01 = _mm_srli_epi16(_mm_add_epi16(p01, two), 2);
+			p23 = _mm_srli_epi16(_mm_add_epi16(p23, two), 2);
+			_mm_storeu_si128((__m128i *)(d + 4*x), _mm_packus_epi16(p01, p23));
+		}
+#endif
+		for (; x < dest_width; x++)
+		{
+			for (int c=0; c < 4; c++)
+				d[4*x + c] = (uint8)((a[8*x + c] + a[8*x + 4 + c] + b[8*x + c] + b[8*x + 4 + c] + 2) >> 2);
+		}
+	}
+}
+
+/*	FUNCTION:		ScaleImage
+	ARGS:			source, source_width, source_height, source_bytes_per_row
+					dest, dest_width, dest_height, dest_bytes_per_row
+					filter
+	RETURN:			n/a
+	DESCRIPTION:	Resample 4 byte pixels.  Destination rows processed in parallel.
+					Box fast paths: exact 2:1 in integer arithmetic, reductions above kMaxBoxRatio are
+					point sampled down to kMaxBoxRatio first (see ImageScaler.h).
+*/
+void ScaleImage(const uint8 *source, const int source_width, const int source_height, const int32 source_bytes_per_row,
+				uint8 *dest, const int dest_width, const int dest_height, const int32 dest_bytes_per_row,
+				const SCALE_FILTER filter)
+{
+	assert(source && dest);
+	assert((source_width > 0) && (source_height > 0) && (dest_width > 0) && (dest_height > 0));
+	assert((source_bytes_per_row >= 4*source_width) && (dest_bytes_per_row >= 4*dest_width));
+
+	if (filter == SCALE_FILTER_BOX)
+	{
+		if ((source_width == 2*dest_width) && (source_height == 2*dest_height))
+		{
+			const int chunk_size = std::max(4, dest_height/(4*ParallelForConcurrency()));
+			ParallelFor(dest_height, chunk_size, [&](const int row_start, const int row_end)
+			{
+				HalveRows(source, source_bytes_per_row, dest, dest_width, dest_bytes_per_row, row_start, row_end);
+			});
+			return;
+		}
+
+		//	Large reduction (thumbnails): averaging every source pixel costs ~300x nearest neighbour (4K -> 96x54),
+		//	so point sample a kMaxBoxRatio x kMaxBoxRatio grid per destination pixel, then box filter the grid.
+		const int grid_width = std::min(source_width, kMaxBoxRatio*dest_width);
+		const int grid_height = std::min(source_height, kMaxBoxRatio*dest_height);
+		if ((grid_width < source_width) || (grid_height < source_height))
+		{
+			DEBUG("ScaleImage() %dx%d decimated to %dx%d\n", source_width, source_height, grid_width, grid_height);
+			std::vector<uint32> grid((size_t)grid_width*grid_height);
+			for (int y=0; y < grid_height; y++)
+			{
+				//	sample centre of each grid cell
+				const int sy = (int)(((2*(int64)y + 1)*source_height)/(2*grid_height));
+				const uint32 *s = (const uint32 *)(source + (size_t)sy*source_bytes_per_row);
+				uint32 *d = grid.data() + (size_t)y*grid_width;
+				for (int x=0; x < grid_width; x++)
+					d[x] = s[((2*(int64)x + 1)*source_width)/(2*grid_width)];
+			}
+			ScaleImage((const uint8 *)grid.data(), grid_width, grid_height, 4*grid_width,
+					   dest, dest_width, dest_height, dest_bytes_per_row, filter);
+			return;
+		}
+	}
+
+	FILTER_TAPS taps_x, taps_y;
+	BuildFilter(filter, source_width, dest_width, taps_x);
+	BuildFilter(filter, source_height, dest_height, taps_y);
+	const ACCUMULATE_ROW accumulate_row = GetAccumulateRow();
+
+	//	Only source columns referenced by horizontal taps
+	const int col_start = taps_x.start[0];
+	const int col_end = taps_x.start[dest_width - 1] + taps_x.count[dest_width - 1];
+
+	const int chunk_size = std::max(4, dest_height/(4*ParallelForConcurrency()));
+	ParallelFor(dest_height, chunk_size, [&](const int row_start, const int row_end)
+	{
+		std::vector<float> row_buffer(4*(size_t)source_width);
+		float *row = row_buffer.data();
+		for (int y=row_start; y < row_end; y++)
+		{
+			const float *w = taps_y.weights.data() + (size_t)y*taps_y.max_taps;
+			for (int t=0; t < taps_y.count[y]; t++)
+			{
+				const uint8 *s = source + (size_t)(taps_y.start[y] + t)*source_bytes_per_row;
+				accumulate_row(s + 4*col_start, col_end - col_start, w[t], row + 4*col_start, t == 0);
+			}
+			FilterRow(row, taps_x, dest_width, dest + (size_t)y*dest_bytes_per_row);
+		}
+	});
+}
+
+/*	FUNCTION:		ScaleBitmap
+	ARGS:			source
+					dest
+					filter
+	RETURN:			n/a
+	DESCRIPTION:	Resample source to fill dest.
+					Other colour spaces than B_RGBA32 / B_RGB32 are converted with BBitmap::ImportBits() (slow path)
+*/
+void ScaleBitmap(const BBitmap *source, BBitmap *dest, const SCALE_FILTER filter)
+{
+	assert((source != nullptr) && (dest != nullptr));
+
+	auto is_32bit = [](const color_space cs) {return (cs == B_RGBA32) || (cs == B_RGB32);};
+	if (!is_32bit(source->ColorSpace()))
+	{
+		BBitmap converted(source->Bounds(), B_RGBA32);
+		if (converted.ImportBits(source) != B_OK)
+		{
+			printf("ScaleBitmap() - unsupported source colour space(%d)\n", source->ColorSpace());
+			return;
+		}
+		ScaleBitmap(&converted, dest, filter);
+		return;
+	}
+	if (!is_32bit(dest->ColorSpace()))
+	{
+		BBitmap scaled(dest->Bounds(), B_RGBA32);
+		ScaleBitmap(source, &scaled, filter);
+		if (dest->ImportBits(&scaled) != B_OK)
+			printf("ScaleBitmap() - unsupported destination colour space(%d)\n", dest->ColorSpace());
+		return;
+	}
+	ScaleImage((const uint8 *)source->Bits(), source->Bounds().IntegerWidth() + 1, source->Bounds().IntegerHeight() + 1, source->BytesPerRow(),
+			   (uint8 *)dest->Bits(), dest->Bounds().IntegerWidth() + 1, dest->Bounds().IntegerHeight() + 1, dest->BytesPerRow(),
+			   filter);
+}
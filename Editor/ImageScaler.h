@@ -0,0 +1,41 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Image scaler (box / bilinear, 32 bit pixels)
+ */
+
+#ifndef _IMAGE_SCALER_H_
+#define _IMAGE_SCALER_H_
+
+#ifndef _SUPPORT_DEFS_H
+#include <support/SupportDefs.h>
+#endif
+
+class BBitmap;
+
+/*****************************
+	Separable resampler for 4 byte pixels (B_RGBA32 / B_RGB32, every channel filtered).
+	SCALE_FILTER_BOX averages the source area covered by each destination pixel (fractional
+	coverage at the edges), which is alias free up to 2:1 - use for thumbnails and downscaling.
+	Exact 2:1 uses integer arithmetic.  Above 2:1 the source is first point sampled to 2x the
+	destination size, so each destination pixel averages 2x2 samples instead of its whole area:
+	a speed / quality tradeoff for thumbnails (4K -> 96x54 ~0.06 ms vs ~3 ms for the full area,
+	nearest neighbour ~0.01 ms), much less aliased than nearest neighbour but not alias free.
+	SCALE_FILTER_BILINEAR samples 2x2 pixels, use for enlarging or reductions below 2:1.
+	The vertical pass accumulates into a float row (SSE2, AVX2 when the cpu supports it),
+	the horizontal pass filters that row (SSE2).  Destination rows are sliced across
+	ParallelFor.  SIMD and scalar paths produce identical output.
+	ScaleBitmap() converts other colour spaces via B_RGBA32 (extra copy, not a fast path).
+******************************/
+enum SCALE_FILTER
+{
+	SCALE_FILTER_BOX,
+	SCALE_FILTER_BILINEAR,
+};
+
+void	ScaleImage(const uint8 *source, const int source_width, const int source_height, const int32 source_bytes_per_row,
+				   uint8 *dest, const int dest_width, const int dest_height, const int32 dest_bytes_per_row,
+				   const SCALE_FILTER filter = SCALE_FILTER_BOX);
+void	ScaleBitmap(const BBitmap *source, BBitmap *dest, const SCALE_FILTER filter = SCALE_FILTER_BOX);
+
+#endif	//#ifndef _IMAGE_SCALER_H_
@@ -11,13 +11,14 @@
 #include <support/Errors.h>
 
 #include "ImageUtility.h"
+#include "ImageScaler.h"
 
 /*	FUNCTION:		CreateThumbnail
 	ARGS:			source
 					width, height
 					dest
 	RETURN:			thumbnail, caller acquires ownership
-	DESCRIPTION:	Create thumnail (RGBA32) from source image
+	DESCRIPTION:	Create thumnail (RGBA32) from source image (box filter, see ImageScaler.h for large reductions)
 */
 BBitmap *CreateThumbnail(const BBitmap *source, const float width, const float height, BBitmap *dest)
 {
@@ -28,26 +29,7 @@ BBitmap *CreateThumbnail(const BBitmap *source, const float width, const float h
 	BBitmap *image = dest ? dest : new BBitmap(BRect(0, 0, width-1, height-1), B_RGBA32);
 	
 	image->Lock();
-	uint8 *s = (uint8 *)source->Bits();
-	int32 bytes_per_row = source->BytesPerRow();
-	int32 sw = bytes_per_row / 4;
-	int32 sh = source->BitsLength() / bytes_per_row;
-	
-	float dx = sw/width;
-	float dy = sh/height;
-	
-	uint8 *d = (uint8 *)image->Bits();
-	for (int32 row=0; row < height; row++)
-	{
-		int32 y = dy*row;
-
-		for (int32 col=0; col < width; col++)
-		{
-			int32 x= dx*col;
-			*((uint32 *)d) = *((uint32 *)(s + y*bytes_per_row + x*4));
-			d += 4;
-		}	
-	}
+	ScaleBitmap(source, image, SCALE_FILTER_BOX);
 	image->Unlock();
 
 	return image;
@@ -0,0 +1,135 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Interval index (augmented interval tree over sorted array)
+ */
+
+#include <algorithm>
+
+#include "IntervalIndex.h"
+
+/*	FUNCTION:		IntervalIndex :: IntervalIndex
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+IntervalIndex :: IntervalIndex()
+{
+}
+
+/*	FUNCTION:		IntervalIndex :: ~IntervalIndex
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Destructor
+*/
+IntervalIndex :: ~IntervalIndex()
+{
+}
+
+/*	FUNCTION:		IntervalIndex :: Clear
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Remove all intervals
+*/
+void IntervalIndex :: Clear()
+{
+	fIntervals.clear();
+	fMaxEnd.clear();
+}
+
+/*	FUNCTION:		IntervalIndex :: Add
+	ARGS:			start, end
+					index
+	RETURN:			n/a
+	DESCRIPTION:	Add interval, Build() must be called before query
+*/
+void IntervalIndex :: Add(const int64_t start, const int64_t end, const int32_t index)
+{
+	if (end <= start)
+		return;
+	fIntervals.push_back({start, end, index});
+}
+
+/*	FUNCTION:		IntervalIndex :: Build
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Sort intervals and calculate subtree max end
+*/
+void IntervalIndex :: Build()
+{
+	std::sort(fIntervals.begin(), fIntervals.end(), [](const INTERVAL &a, const INTERVAL &b)
+		{return (a.start < b.start) || ((a.start == b.start) && (a.index < b.index));});
+	fMaxEnd.resize(fIntervals.size());
+	if (!fIntervals.empty())
+		BuildNode(0, fIntervals.size());
+}
+
+/*	FUNCTION:		IntervalIndex :: BuildNode
+	ARGS:			lo, hi
+	RETURN:			max end of subtree
+	DESCRIPTION:	Recursively calculate max end for node [lo, hi)
+*/
+int64_t IntervalIndex :: BuildNode(const size_t lo, const size_t hi)
+{
+	const size_t mid = lo + (hi - lo)/2;
+	int64_t max_end = fIntervals[mid].end;
+	if (lo < mid)
+		max_end = std::max(max_end, BuildNode(lo, mid));
+	if (mid + 1 < hi)
+		max_end = std::max(max_end, BuildNode(mid + 1, hi));
+	fMaxEnd[mid] = max_end;
+	return max_end;
+}
+
+/*	FUNCTION:		IntervalIndex :: QueryNode
+	ARGS:			lo, hi
+					start, end
+					results
+	RETURN:			n/a
+	DESCRIPTION:	Find intervals in [lo, hi) which overlap [start, end)
+*/
+void IntervalIndex :: QueryNode(const size_t lo, const size_t hi, const int64_t start, const int64_t end, std::vector<int32_t> &results) const
+{
+	if (lo >= hi)
+		return;
+	const size_t mid = lo + (hi - lo)/2;
+
+	//	Nothing in subtree ends after start
+	if (fMaxEnd[mid] <= start)
+		return;
+
+	QueryNode(lo, mid, start, end, results);
+
+	//	Right subtree (and mid) begin at or after mid.start
+	if (fIntervals[mid].start >= end)
+		return;
+	if (fIntervals[mid].end > start)
+		results.push_back(fIntervals[mid].index);
+	QueryNode(mid + 1, hi, start, end, results);
+}
+
+/*	FUNCTION:		IntervalIndex :: Stab
+	ARGS:			frame
+					results
+	RETURN:			n/a
+	DESCRIPTION:	Find intervals which contain frame
+*/
+void IntervalIndex :: Stab(const int64_t frame, std::vector<int32_t> &results) const
+{
+	Range(frame, frame + 1, results);
+}
+
+/*	FUNCTION:		IntervalIndex :: Range
+	ARGS:			start, end
+					results
+	RETURN:			n/a
+	DESCRIPTION:	Find intervals which overlap [start, end)
+*/
+void IntervalIndex :: Range(const int64_t start, const int64_t end, std::vector<int32_t> &results) const
+{
+	results.clear();
+	if (fIntervals.empty() || (end <= start))
+		return;
+	QueryNode(0, fIntervals.size(), start, end, results);
+	std::sort(results.begin(), results.end());
+}
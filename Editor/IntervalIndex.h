@@ -0,0 +1,58 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Interval index (augmented interval tree over sorted array)
+ */
+
+#ifndef _INTERVAL_INDEX_H_
+#define _INTERVAL_INDEX_H_
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _GLIBCXX_CSTDINT
+#include <cstdint>
+#endif
+
+#ifndef _GLIBCXX_CSTDDEF
+#include <cstddef>
+#endif
+
+/*****************************
+	Intervals are half open [start, end), payload is an index into the owner container.
+	The tree is implicit (sorted by start, node = midpoint of range), each node stores
+	the maximum end of its subtree so queries are O(log n + k).
+	Overlapping intervals are supported.
+******************************/
+class IntervalIndex
+{
+public:
+	struct INTERVAL
+	{
+		int64_t		start;
+		int64_t		end;
+		int32_t		index;
+	};
+
+				IntervalIndex();
+				~IntervalIndex();
+
+	void		Clear();
+	void		Add(const int64_t start, const int64_t end, const int32_t index);
+	void		Build();
+	const size_t	Size() const	{return fIntervals.size();}
+
+	//	Results are sorted by index (ie. container order)
+	void		Stab(const int64_t frame, std::vector<int32_t> &results) const;
+	void		Range(const int64_t start, const int64_t end, std::vector<int32_t> &results) const;
+
+private:
+	int64_t		BuildNode(const size_t lo, const size_t hi);
+	void		QueryNode(const size_t lo, const size_t hi, const int64_t start, const int64_t end, std::vector<int32_t> &results) const;
+
+	std::vector<INTERVAL>	fIntervals;
+	std::vector<int64_t>	fMaxEnd;
+};
+
+#endif	//#ifndef _INTERVAL_INDEX_H_
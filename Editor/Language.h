@@ -56,6 +56,7 @@ enum LANGUAGE_TEXT
 	TXT_MENU_TOOLS_COLOUR_SCOPE,
 	TXT_MENU_TOOLS_AUDIO_MIXER,
 	TXT_MENU_TOOLS_SOUND_RECORDER,
+	TXT_MENU_TOOLS_PERFORMANCE_OVERLAY,
 	
 	//	Tab labels
 	TXT_TAB_MEDIA_SOURCES,
@@ -110,6 +111,7 @@ enum LANGUAGE_TEXT
 	TXT_EXPORT_COMPLIANCE_NORMAL,
 	TXT_EXPORT_COMPLIANCE_UNOFFICIAL,
 	TXT_EXPORT_COMPLIANCE_EXPERIMENTAL,
+	TXT_EXPORT_PARALLEL_SEGMENTS,
 
 	//	Project settings
 	TXT_PROJECT_SETTINGS_WINDOW,
@@ -206,6 +208,10 @@ enum LANGUAGE_TEXT
 	//	Colour scope
 	TXT_COLOUR_SCOPE_SEPARATE_COLOURS,
 	TXT_COLOUR_SCOPE_UNIFIED_COLOURS,
+	TXT_COLOUR_SCOPE_WAVEFORM_LUMA,
+	TXT_COLOUR_SCOPE_RGB_PARADE,
+	TXT_COLOUR_SCOPE_VECTORSCOPE,
+	TXT_COLOUR_SCOPE_SAMPLING,
 
 	//	Effects/Common
 	TXT_EFFECTS_COMMON_POSITION,
@@ -314,6 +320,7 @@ enum LANGUAGE_TEXT
 	TXT_EFFECTS_COLOUR_LUT_LOAD,
 	TXT_EFFECTS_COLOUR_LUT_NO_FILE,
 	TXT_EFFECTS_COLOUR_LUT_INSTRUCTIONS,
+	TXT_EFFECTS_COLOUR_LUT_TETRAHEDRAL,
 
 	//	Effects/Image/Blur
 	TXT_EFFECTS_IMAGE_BLUR,
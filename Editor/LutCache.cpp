@@ -0,0 +1,404 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Colour LUT cache (shared 3D textures / CPU tables)
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <mutex>
+
+#include <sys/stat.h>
+
+#include <storage/Directory.h>
+#include <storage/FindDirectory.h>
+#include <storage/Path.h>
+
+#include "Yarra/Platform.h"
+#include "Yarra/Render/RenderState.h"
+#include "3rdParty/LutCube.h"
+
+#include "LutCache.h"
+
+#if defined (__GNUC__)
+	#if defined(__amd64__)
+		#define Y_CPU_X86
+	#endif
+#elif defined (_MSC_VER)
+	#define Y_CPU_X86
+#endif
+
+#ifdef Y_CPU_X86
+#include <emmintrin.h>
+#endif
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+//	2x2x2 identity (exact with both linear and tetrahedral interpolation)
+static const float kIdentityTable[4*8] =
+{
+	0, 0, 0, 1,		1, 0, 0, 1,		0, 1, 0, 1,		1, 1, 0, 1,
+	0, 0, 1, 1,		1, 0, 1, 1,		0, 1, 1, 1,		1, 1, 1, 1,
+};
+
+/*	FUNCTION:		LutCache :: GetInstance
+	ARGS:			none
+	RETURN:			global cache
+	DESCRIPTION:	Shared by every clip
+*/
+LutCache * LutCache :: GetInstance()
+{
+	static LutCache sLutCache;
+	return &sLutCache;
+}
+
+/*	FUNCTION:		LutCache :: LutCache
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+LutCache :: LutCache()
+	: fPurgePending(false), fIdentityTexture(0)
+{ }
+
+/*	FUNCTION:		LutCache :: ~LutCache
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Destructor (GL context already destroyed, textures not deleted)
+*/
+LutCache :: ~LutCache()
+{
+	for (auto &i : fLuts)
+		delete i.second;
+}
+
+/*	FUNCTION:		LutCache :: Acquire
+	ARGS:			path
+	RETURN:			shared LUT (caller must Release)
+	DESCRIPTION:	Find LUT with same path and modification time, otherwise create entry (parsed on first use)
+*/
+LutCache::LUT * LutCache :: Acquire(const char *path)
+{
+	assert(path);
+	struct stat st;
+	const time_t mtime = (stat(path, &st) == 0) ? st.st_mtime : 0;
+	const KEY key(path, mtime);
+
+	std::lock_guard<std::mutex> lock(fLock);
+	auto it = fLuts.find(key);
+	if (it != fLuts.end())
+	{
+		it->second->count++;
+		return it->second;
+	}
+
+	LUT *lut = new LUT;
+	lut->path = path;
+	lut->mtime = mtime;
+	lut->count = 1;
+	lut->valid = false;
+	lut->size = 0;
+	lut->texture_id = 0;
+	fLuts[key] = lut;
+	DEBUG("LutCache::Acquire(%s) new entry, count=%lu\n", path, fLuts.size());
+	return lut;
+}
+
+/*	FUNCTION:		LutCache :: Release
+	ARGS:			lut
+	RETURN:			n/a
+	DESCRIPTION:	Drop reference, unused entries are deleted by next GetTexture()
+*/
+void LutCache :: Release(LUT *lut)
+{
+	assert(lut);
+	std::lock_guard<std::mutex> lock(fLock);
+	assert(lut->count > 0);
+	if (--lut->count == 0)
+		fPurgePending = true;
+}
+
+/*	FUNCTION:		LutCache :: PurgeUnused
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Delete unreferenced entries (called from RenderActor thread)
+*/
+void LutCache :: PurgeUnused()
+{
+	std::lock_guard<std::mutex> lock(fLock);
+	if (!fPurgePending)
+		return;
+	for (auto it = fLuts.begin(); it != fLuts.end(); )
+	{
+		if (it->second->count == 0)
+		{
+			DEBUG("LutCache::PurgeUnused(%s)\n", it->second->path.c_str());
+			if (it->second->texture_id > 0)
+				yrender::yRenderState.DeleteTextures(1, &it->second->texture_id);
+			delete it->second;
+			it = fLuts.erase(it);
+		}
+		else
+			++it;
+	}
+	fPurgePending = false;
+}
+
+/*	FUNCTION:		GetBinaryCacheDirectory
+	ARGS:			none
+	RETURN:			B_USER_CACHE_DIRECTORY/Medo/luts (empty if unavailable)
+	DESCRIPTION:	Parsed cube files are cached here, never next to the user's .cube file (read only media, clutter)
+*/
+static const std::string &GetBinaryCacheDirectory()
+{
+	static const std::string sCacheDirectory = []()
+	{
+		BPath cache_path;
+		if ((find_directory(B_USER_CACHE_DIRECTORY, &cache_path) == B_OK) &&
+			(cache_path.Append("Medo/luts") == B_OK) &&
+			(create_directory(cache_path.Path(), 0755) == B_OK))
+			return std::string(cache_path.Path());
+		return std::string();
+	}();
+	return sCacheDirectory;
+}
+
+/*	FUNCTION:		LutCache :: Load
+	ARGS:			lut
+	RETURN:			n/a
+	DESCRIPTION:	Parse cube file (binary cache if available), reorder into GPU lookup layout (called once per entry)
+*/
+void LutCache :: Load(LUT *lut)
+{
+	timecube::Cube cube;
+	try {
+		const std::string &cache_directory = GetBinaryCacheDirectory();
+		if (cache_directory.empty())
+			cube = timecube::read_cube_from_file(lut->path.c_str());
+		else
+			cube = timecube::read_cube_cached(lut->path.c_str(), cache_directory.c_str());
+	}
+	catch (const std::exception &e)
+	{
+		printf("LutCache::Load() - failed to parse CUBE file(%s).  Error(%s)\n", lut->path.c_str(), e.what());
+		return;
+	}
+	if (!cube.is_3d || (cube.n < 2) || (cube.lut.size() != 3*(size_t)cube.n*cube.n*cube.n))
+	{
+		printf("LutCache::Load() - unsupported CUBE file(%s), 3D LUT required\n", lut->path.c_str());
+		return;
+	}
+
+	//	Cube order is R fastest with RGB entries, lookup is by memory component order (BGR).
+	const size_t n = cube.n;
+	lut->size = (int)n;
+	lut->table.resize(4*n*n*n);
+	float *p = lut->table.data();
+	for (size_t z=0; z < n; z++)				//	red
+	{
+		for (size_t y=0; y < n; y++)			//	green
+		{
+			for (size_t x=0; x < n; x++)		//	blue
+			{
+				const float *rgb = cube.lut.data() + 3*(x*n*n + y*n + z);
+				*p++ = rgb[2];
+				*p++ = rgb[1];
+				*p++ = rgb[0];
+				*p++ = 1.0f;
+			}
+		}
+	}
+	assert(p == lut->table.data() + lut->table.size());
+	lut->valid = true;
+}
+
+/*	FUNCTION:		LutCache :: IsValid
+	ARGS:			lut (may be nullptr)
+	RETURN:			true if table available
+	DESCRIPTION:	Parse on first use
+*/
+bool LutCache :: IsValid(LUT *lut)
+{
+	if (!lut)
+		return false;
+	std::call_once(lut->load_once, Load, lut);
+	return lut->valid;
+}
+
+/*	FUNCTION:		CreateLutTexture
+	ARGS:			size
+					table (4*size^3, BGRA)
+	RETURN:			3D texture
+	DESCRIPTION:	Half float texture (8 bit quantisation bands smooth gradients)
+*/
+static GLuint CreateLutTexture(const int size, const float *table)
+{
+	GLuint texture_id;
+	glGenTextures(1, &texture_id);
+	yrender::yRenderState.BindTexture(GL_TEXTURE_3D, texture_id);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+#if !defined (GL_ES_VERSION_2_0)
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, size, size, size, 0, GL_RGBA, GL_FLOAT, table);
+#else
+	//	10 bit per component (half float textures are not always filterable)
+	const size_t count = (size_t)size*size*size;
+	std::vector<uint32_t> packed(count);
+	for (size_t i=0; i < count; i++)
+	{
+		const float *c = table + 4*i;
+		uint32_t v = 3U << 30;
+		for (int k=0; k < 3; k++)
+			v |= (uint32_t)(std::clamp(c[k], 0.0f, 1.0f)*1023.0f + 0.5f) << (10*k);
+		packed[i] = v;
+	}
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB10_A2, size, size, size, 0, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, packed.data());
+#endif
+	return texture_id;
+}
+
+/*	FUNCTION:		LutCache :: GetTexture
+	ARGS:			lut (may be nullptr)
+	RETURN:			3D texture (identity LUT if invalid)
+	DESCRIPTION:	Called from RenderActor thread (GL context locked)
+*/
+GLuint LutCache :: GetTexture(LUT *lut)
+{
+	PurgeUnused();
+
+	if (!IsValid(lut))
+	{
+		if (fIdentityTexture == 0)
+			fIdentityTexture = CreateLutTexture(2, kIdentityTable);
+		return fIdentityTexture;
+	}
+	if (lut->texture_id == 0)
+	{
+		lut->texture_id = CreateLutTexture(lut->size, lut->table.data());
+		DEBUG("LutCache::GetTexture(%s) upload %dx%dx%d\n", lut->path.c_str(), lut->size, lut->size, lut->size);
+	}
+	return lut->texture_id;
+}
+
+/*	FUNCTION:		LutCache :: DestroyTextures
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Delete all textures (eg. GL context destroyed), tables are kept
+*/
+void LutCache :: DestroyTextures()
+{
+	std::lock_guard<std::mutex> lock(fLock);
+	for (auto &i : fLuts)
+	{
+		if (i.second->texture_id > 0)
+		{
+			yrender::yRenderState.DeleteTextures(1, &i.second->texture_id);
+			i.second->texture_id = 0;
+		}
+	}
+	if (fIdentityTexture > 0)
+	{
+		yrender::yRenderState.DeleteTextures(1, &fIdentityTexture);
+		fIdentityTexture = 0;
+	}
+}
+
+/*	FUNCTION:		LutCache :: Apply
+	ARGS:			lut (IsValid() must be true)
+					colour (BGRA, in/out, alpha unchanged)
+					tetrahedral (otherwise trilinear)
+	RETURN:			n/a
+	DESCRIPTION:	CPU equivalent of GPU lookup (see Effect_ColourLut shaders)
+*/
+void LutCache :: Apply(const LUT *lut, float colour[4], const bool tetrahedral)
+{
+	assert(lut && lut->valid);
+	const int n = lut->size;
+	const float scale = float(n - 1);
+	int offset = 0;
+	float f[3];
+	const int stride[3] = {4, 4*n, 4*n*n};
+	for (int c=0; c < 3; c++)
+	{
+		const float p = std::clamp(colour[c], 0.0f, 1.0f)*scale;
+		const int i = std::min((int)p, n - 2);
+		f[c] = p - i;
+		offset += i*stride[c];
+	}
+	const float *base = lut->table.data() + offset;
+	const int d111 = stride[0] + stride[1] + stride[2];
+
+	if (tetrahedral)
+	{
+		//	Walk lattice from c000 to c111 along axes in order of decreasing fraction
+		int a0, a1, a2;
+		if (f[0] >= f[1])
+		{
+			if (f[1] >= f[2])		{a0 = 0; a1 = 1; a2 = 2;}
+			else if (f[0] >= f[2])	{a0 = 0; a1 = 2; a2 = 1;}
+			else					{a0 = 2; a1 = 0; a2 = 1;}
+		}
+		else
+		{
+			if (f[2] >= f[1])		{a0 = 2; a1 = 1; a2 = 0;}
+			else if (f[2] >= f[0])	{a0 = 1; a1 = 2; a2 = 0;}
+			else					{a0 = 1; a1 = 0; a2 = 2;}
+		}
+		const int d1 = stride[a0];
+		const int d2 = d1 + stride[a1];
+#ifdef Y_CPU_X86
+		const __m128 c0 = _mm_loadu_ps(base);
+		const __m128 c1 = _mm_loadu_ps(base + d1);
+		const __m128 c2 = _mm_loadu_ps(base + d2);
+		const __m128 c3 = _mm_loadu_ps(base + d111);
+		__m128 r = _mm_add_ps(c0, _mm_mul_ps(_mm_set1_ps(f[a0]), _mm_sub_ps(c1, c0)));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(f[a1]), _mm_sub_ps(c2, c1)));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(f[a2]), _mm_sub_ps(c3, c2)));
+		const float alpha = colour[3];
+		_mm_storeu_ps(colour, r);
+		colour[3] = alpha;
+#else
+		for (int c=0; c < 3; c++)
+			colour[c] = base[c] + f[a0]*(base[d1 + c] - base[c]) + f[a1]*(base[d2 + c] - base[d1 + c]) + f[a2]*(base[d111 + c] - base[d2 + c]);
+#endif
+	}
+	else
+	{
+		const int dx = stride[0], dy = stride[1], dz = stride[2];
+#ifdef Y_CPU_X86
+		const __m128 fx = _mm_set1_ps(f[0]);
+		const __m128 fy = _mm_set1_ps(f[1]);
+		const __m128 fz = _mm_set1_ps(f[2]);
+		auto lerp = [](const __m128 a, const __m128 b, const __m128 t) {return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));};
+		const __m128 c00 = lerp(_mm_loadu_ps(base), _mm_loadu_ps(base + dx), fx);
+		const __m128 c10 = lerp(_mm_loadu_ps(base + dy), _mm_loadu_ps(base + dy + dx), fx);
+		const __m128 c01 = lerp(_mm_loadu_ps(base + dz), _mm_loadu_ps(base + dz + dx), fx);
+		const __m128 c11 = lerp(_mm_loadu_ps(base + dz + dy), _mm_loadu_ps(base + d111), fx);
+		const __m128 r = lerp(lerp(c00, c10, fy), lerp(c01, c11, fy), fz);
+		const float alpha = colour[3];
+		_mm_storeu_ps(colour, r);
+		colour[3] = alpha;
+#else
+		for (int c=0; c < 3; c++)
+		{
+			const float c00 = base[c] + f[0]*(base[dx + c] - base[c]);
+			const float c10 = base[dy + c] + f[0]*(base[dy + dx + c] - base[dy + c]);
+			const float c01 = base[dz + c] + f[0]*(base[dz + dx + c] - base[dz + c]);
+			const float c11 = base[dz + dy + c] + f[0]*(base[d111 + c] - base[dz + dy + c]);
+			const float c0 = c00 + f[1]*(c10 - c00);
+			const float c1 = c01 + f[1]*(c11 - c01);
+			colour[c] = c0 + f[2]*(c1 - c0);
+		}
+#endif
+	}
+}
@@ -0,0 +1,79 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Colour LUT cache (shared 3D textures / CPU tables)
+ */
+
+#ifndef _LUT_CACHE_H_
+#define _LUT_CACHE_H_
+
+#ifndef _GLIBCXX_MAP
+#include <map>
+#endif
+
+#ifndef _GLIBCXX_MUTEX
+#include <mutex>
+#endif
+
+#ifndef _GLIBCXX_STRING
+#include <string>
+#endif
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _YARRA_PLATFORM_H_
+#include "Yarra/Platform.h"
+#endif
+
+/*****************************
+	LutCache shares parsed .cube files between every clip using the same LUT.
+	Entries are keyed by file path and modification time (an edited file is a new entry,
+	clips using the old content are unaffected) and reference counted by EffectLutData.
+	Acquire/Release may be called from any thread.  The table is parsed once on first use
+	(by either renderer), the 3D texture (RGBA16F, one per LUT) is created from the RenderActor
+	thread.  Unreferenced entries are deleted by the next GetTexture() call.
+	Table layout matches the GPU lookup: axis x/y/z is colour component 0/1/2 in memory
+	order (BGR), entries are BGRA.  Missing or invalid files behave as an identity LUT.
+******************************/
+class LutCache
+{
+public:
+	struct LUT
+	{
+		std::string			path;
+		time_t				mtime;
+		int					count;			//	references (protected by fLock)
+		std::once_flag		load_once;
+		bool				valid;
+		int					size;			//	entries per axis
+		std::vector<float>	table;			//	4*size^3 (BGRA)
+		GLuint				texture_id;		//	RenderActor thread
+	};
+
+	static LutCache		*GetInstance();
+
+	LUT					*Acquire(const char *path);
+	void				Release(LUT *lut);
+
+	GLuint				GetTexture(LUT *lut);
+	void				DestroyTextures();
+
+	static bool			IsValid(LUT *lut);
+	static void			Apply(const LUT *lut, float colour[4], const bool tetrahedral);
+
+private:
+						LutCache();
+						~LutCache();
+	static void			Load(LUT *lut);
+	void				PurgeUnused();
+
+	typedef std::pair<std::string, time_t>	KEY;
+	std::map<KEY, LUT *>		fLuts;
+	std::mutex			fLock;
+	bool				fPurgePending;		//	protected by fLock
+	GLuint				fIdentityTexture;
+};
+
+#endif	//#ifndef _LUT_CACHE_H_
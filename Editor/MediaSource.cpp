@@ -5,6 +5,7 @@
  */
 
 #include <cassert>
+#include <atomic>
 
 #if 0
 extern "C" {
@@ -25,6 +26,8 @@ extern "C" {
 #include "MediaSource.h"
 #include "MediaUtility.h"
 
+static std::atomic<uint64>	sInstanceCounter(0);
+
 /*	FUNCTION:		MediaSource :: MediaSource
 	ARGS:			filename
 	RETURN:			n/a
@@ -36,6 +39,7 @@ MediaSource :: MediaSource(const char *filename)
 	  fSecondaryMediaFile(nullptr), fSecondaryVideoTrack(nullptr)
 {
 	assert(filename != nullptr);
+	fInstanceId = ++sInstanceCounter;
 		
 	fFilename.SetTo(filename);
 	
@@ -36,6 +36,7 @@ private:
 	MEDIA_TYPE		fMediaType;
 	BString			fFilename;
 	BString			fLabel;
+	uint64			fInstanceId;
 	
 	BBitmap			*fBitmap;
 	BMediaFile		*fMediaFile;
@@ -72,6 +73,7 @@ public:
 	const BString		&GetFilename() const			{return fFilename;}
 	const BString		&GetLabel() const				{return fLabel;}
 	const MEDIA_TYPE	GetMediaType() const			{return fMediaType;}
+	const uint64		GetInstanceId() const			{return fInstanceId;}		//	unique for application lifetime (address may be reused)
 	const bigtime_t		GetTotalDuration() const;
 
 	BBitmap				*GetBitmap()					{return fBitmap;}
@@ -12,6 +12,7 @@
 
 #include "MedoApplication.h"
 #include "MedoWindow.h"
+#include "RenderActor.h"
 
 static const int32	kMaxRefsReceived = 32;
 
@@ -19,13 +20,24 @@ static const int32	kMaxRefsReceived = 32;
 MedoApplication :: MedoApplication(int argc, char **argv)
 	: BApplication("application/x-vnd.ZenYes.Medo")
 {
+	const bigtime_t start_time = system_time();
+	const char *project = nullptr;
+	for (int i=1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--software-render") == 0)
+			gSoftwareRender = true;		//	composite on CPU (no OpenGL context)
+		else if (!project && strstr(argv[i], ".medo"))
+			project = argv[i];
+	}
+
 	fWindow = new MedoWindow;
 	fWindow->Show();
+	printf("MedoApplication() first window %0.1f ms\n", 0.001f*(system_time() - start_time));
 	
-	if ((argc > 1) && (strstr(argv[1], ".medo")))
+	if (project)
 	{
 		fWindow->LockLooper();
-		fWindow->LoadProject(argv[1]);
+		fWindow->LoadProject(project);
 		fWindow->UnlockLooper();
 	}
 }
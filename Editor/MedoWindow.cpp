@@ -147,6 +147,8 @@ MedoWindow :: MedoWindow()
 	menu_tools->AddItem(new BMenuItem(GetText(TXT_MENU_TOOLS_COLOUR_SCOPE), new BMessage(eMsgMenuToolsColourScope)));
 	menu_tools->AddItem(new BMenuItem(GetText(TXT_MENU_TOOLS_AUDIO_MIXER), new BMessage(eMsgMenuToolsAudioMixer)));
 	menu_tools->AddItem(new BMenuItem(GetText(TXT_MENU_TOOLS_SOUND_RECORDER), new BMessage(eMsgMenuToolsSoundRecorder)));
+	fMenuItemToolsPerformanceOverlay = new BMenuItem(GetText(TXT_MENU_TOOLS_PERFORMANCE_OVERLAY), new BMessage(eMsgMenuToolsPerformanceOverlay));
+	menu_tools->AddItem(fMenuItemToolsPerformanceOverlay);
 	
     const float kFontFactor = be_plain_font->Size()/20.0f;
     BRect control_rect(kTabViewWidth*kFontFactor, menu_height, kTabViewWidth*kFontFactor + kControlViewWidth, kControlViewHeight+menu_height);
@@ -550,6 +552,12 @@ void MedoWindow :: MessageReceived(BMessage *msg)
 			}
 			break;
 		}
+		case eMsgMenuToolsPerformanceOverlay:
+		{
+			fMenuItemToolsPerformanceOverlay->SetMarked(!fMenuItemToolsPerformanceOverlay->IsMarked());
+			((OutputView *)fControlViews[CONTROL_OUTPUT])->SetPerformanceOverlay(fMenuItemToolsPerformanceOverlay->IsMarked());
+			break;
+		}
 
 		//	Timeline messages
 		case TimelineEdit::eMsgDragDropClip:	//	ControlSource message not delivered to TimelineEdit
@@ -633,6 +641,7 @@ void MedoWindow :: SetActiveControl(CONTROL_MODE mode)
 */
 void MedoWindow :: InvalidatePreview()
 {
+	gProject->IncrementEditGeneration();
 	if (fControlMode != CONTROL_OUTPUT)
 		SetActiveControl(CONTROL_OUTPUT);
 
@@ -84,6 +84,7 @@ private:
 	BMenuItem		*fMenuItemViewShowClipTags;
 	BMenuItem		*fMenuItemViewShowNotes;
 	BMenuItem		*fMenuItemViewShowThumbnails;
+	BMenuItem		*fMenuItemToolsPerformanceOverlay;
 	BMenuItem		*fMenuItemExportMediaKit;
 
 	//	Project IO
@@ -139,6 +140,7 @@ public:
 		eMsgMenuToolsColourScope,
 		eMsgMenuToolsAudioMixer,
 		eMsgMenuToolsSoundRecorder,
+		eMsgMenuToolsPerformanceOverlay,
 
 		eMsgActionProjectSaveFilename,
 		eMsgActionFilePanelCancel,
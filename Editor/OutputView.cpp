@@ -15,9 +15,12 @@
 #include "TimelineView.h"
 #include "MedoWindow.h"
 #include "Project.h"
+#include "RenderActor.h"
+#include "RenderStatistics.h"
 
 static const float kMinZoomFactor = 0.5f;
 static const float kMaxZoomFactor = 50.0f;
+static const size_t kPerformanceOverlayLines = 12;
 
 /*	FUNCTION:		OutputView :: OutputView
 	ARGS:			frame
@@ -32,6 +35,7 @@ OutputView :: OutputView(BRect frame)
 
 	fZoomFactor = 1.0f;
 	fZoomOffset.Set(0.0f, 0.0f);
+	fPerformanceOverlay = false;
 }
 
 /*	FUNCTION:		OutputView :: ~OutputView
@@ -145,11 +149,68 @@ void OutputView :: Draw(BRect frame)
 			DrawString(buffer);
 			SetFont(be_plain_font);
 		}
+
+		if (fPerformanceOverlay)
+			DrawPerformanceOverlay(frame);
 	}
 	else
 		FillRect(frame);
 }
 
+/*	FUNCTION:		OutputView :: DrawPerformanceOverlay
+	ARGS:			frame
+	RETURN:			n/a
+	DESCRIPTION:	Display render timing (most expensive entries per stage, rolling window)
+*/
+void OutputView :: DrawPerformanceOverlay(BRect frame)
+{
+	std::vector<RenderStatistics::SUMMARY> summary;
+	gRenderActor->GetStatistics()->GetSummary(summary);
+	if (summary.empty())
+		return;
+	if (summary.size() > kPerformanceOverlayLines)
+		summary.resize(kPerformanceOverlayLines);
+	int gl_calls, gl_skipped;
+	gRenderActor->GetStatistics()->GetGlCalls(gl_calls, gl_skipped);
+
+	font_height fh;
+	be_plain_font->GetHeight(&fh);
+	const float line_height = 1.2f*(fh.ascent + fh.descent);
+
+	SetDrawingMode(B_OP_ALPHA);
+	SetHighColor({0, 0, 0, 160});
+	FillRect(BRect(0, 0, 32*fh.ascent, (summary.size() + 1)*line_height + 0.5f*line_height));
+	SetDrawingMode(B_OP_COPY);
+
+	SetHighColor({255, 255, 255, 255});
+	char buffer[128];
+	float y = fh.ascent + 0.25f*line_height;
+	for (auto &i : summary)
+	{
+		if (i.gpu_ms >= 0.0f)
+			snprintf(buffer, sizeof(buffer), "%s %s %0.1f ms (max %0.1f, GPU %0.1f)", RenderStatistics::GetStageName(i.stage), i.label.c_str(), i.average_ms, i.max_ms, i.gpu_ms);
+		else
+			snprintf(buffer, sizeof(buffer), "%s %s %0.1f ms (max %0.1f)", RenderStatistics::GetStageName(i.stage), i.label.c_str(), i.average_ms, i.max_ms);
+		MovePenTo(0.25f*line_height, y);
+		DrawString(buffer);
+		y += line_height;
+	}
+	snprintf(buffer, sizeof(buffer), "GL calls %d (skipped %d)", gl_calls, gl_skipped);
+	MovePenTo(0.25f*line_height, y);
+	DrawString(buffer);
+}
+
+/*	FUNCTION:		OutputView :: SetPerformanceOverlay
+	ARGS:			enable
+	RETURN:			n/a
+	DESCRIPTION:	Show / hide render timing overlay
+*/
+void OutputView :: SetPerformanceOverlay(const bool enable)
+{
+	fPerformanceOverlay = enable;
+	Invalidate();
+}
+
 /*	FUNCTION:		OutputView :: SetBitmap
 	ARGS:			bitmap
 	RETURN:			n/a
@@ -31,6 +31,7 @@ public:
 	void		SetBitmap(BBitmap *bitmap);
 	void		SetTimelineView(TimelineView *view);
 	void		Zoom(bool in);
+	void		SetPerformanceOverlay(const bool enable);
 	BBitmap		*GetBitmap()	{return fBitmap;}
 
 	float			GetZoomFactor() const {return fZoomFactor;}
@@ -45,6 +46,9 @@ private:
 	float			fZoomFactor;
 	BPoint			fZoomOffset;
 	BPoint			fMouseDownPoint;
+
+	bool			fPerformanceOverlay;
+	void			DrawPerformanceOverlay(BRect frame);
 };
 
 #endif	//#ifndef _OUTPUT_VIEW_H_
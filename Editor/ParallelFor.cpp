@@ -0,0 +1,162 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Parallel for (shared pool of worker actors)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <kernel/OS.h>
+
+#include "Actor/Actor.h"
+
+#include "ParallelFor.h"
+
+struct PARALLEL_FOR_JOB
+{
+	const std::function<void(const int, const int)>	*kernel;
+	std::atomic<int>	next_chunk;
+	int					count_chunks;
+	int					count;
+	int					chunk_size;
+	sem_id				semaphore;
+};
+
+/*****************************
+	Completion semaphores are persistent (created on first use, deleted on thread exit).
+	A thread has one semaphore per ParallelFor nesting depth, since a kernel may call
+	ParallelFor and the outer job is still being completed by other workers.
+******************************/
+class ParallelForSemaphores
+{
+public:
+	ParallelForSemaphores() : fDepth(0) { }
+	~ParallelForSemaphores()
+	{
+		for (auto i : fSemaphores)
+			delete_sem(i);
+	}
+	sem_id Acquire()
+	{
+		if (fDepth == fSemaphores.size())
+		{
+			sem_id sem = create_sem(0, "ParallelFor Semaphore");
+			if (sem < B_OK)
+			{
+				printf("ParallelFor() Cannot create semaphore\n");
+				exit(1);
+			}
+			fSemaphores.push_back(sem);
+		}
+		return fSemaphores[fDepth++];
+	}
+	void Release()
+	{
+		assert(fDepth > 0);
+		fDepth--;
+	}
+private:
+	std::vector<sem_id>	fSemaphores;
+	size_t				fDepth;
+};
+static thread_local ParallelForSemaphores sSemaphores;
+
+/*	FUNCTION:		RunChunks
+	ARGS:			job
+	RETURN:			n/a
+	DESCRIPTION:	Process chunks until none remain (worker actors and caller thread).
+					Late actors find no remaining chunks and never touch the kernel / semaphore.
+*/
+static void RunChunks(PARALLEL_FOR_JOB *job)
+{
+	int chunk;
+	while ((chunk = job->next_chunk++) < job->count_chunks)
+	{
+		const int start = chunk*job->chunk_size;
+		const int end = std::min(start + job->chunk_size, job->count);
+		(*job->kernel)(start, end);
+		release_sem_etc(job->semaphore, 1, B_DO_NOT_RESCHEDULE);
+	}
+}
+
+class ParallelForActor : public yarra::Actor
+{
+public:
+	void	AsyncRunChunks(std::shared_ptr<PARALLEL_FOR_JOB> job)
+	{
+		RunChunks(job.get());
+	}
+};
+
+/*	FUNCTION:		GetWorkers
+	ARGS:			none
+	RETURN:			worker actor pool (created on first use, never destroyed)
+	DESCRIPTION:	Caller thread also processes chunks, hence cpu_count - 1 workers
+*/
+static std::vector<ParallelForActor *> &GetWorkers()
+{
+	static std::vector<ParallelForActor *> *sWorkers = []()
+	{
+		std::vector<ParallelForActor *> *workers = new std::vector<ParallelForActor *>;
+		system_info info;
+		get_system_info(&info);
+		for (uint32 i=1; i < info.cpu_count; i++)
+			workers->push_back(new ParallelForActor);
+		return workers;
+	}();
+	return *sWorkers;
+}
+
+/*	FUNCTION:		ParallelForConcurrency
+	ARGS:			none
+	RETURN:			number of threads which process chunks (workers + caller)
+	DESCRIPTION:	Used to size chunks / per thread scratch buffers
+*/
+int ParallelForConcurrency()
+{
+	return (int)GetWorkers().size() + 1;
+}
+
+/*	FUNCTION:		ParallelFor
+	ARGS:			count
+					chunk_size
+					kernel
+	RETURN:			n/a
+	DESCRIPTION:	Execute kernel(start, end) for every chunk in [0, count).  Blocks until complete.
+*/
+void ParallelFor(const int count, const int chunk_size, const std::function<void(const int start, const int end)> &kernel)
+{
+	assert(chunk_size > 0);
+	if (count <= 0)
+		return;
+
+	std::vector<ParallelForActor *> &workers = GetWorkers();
+	const int count_chunks = (count + chunk_size - 1)/chunk_size;
+	if ((count_chunks <= 1) || workers.empty())
+	{
+		kernel(0, count);
+		return;
+	}
+
+	std::shared_ptr<PARALLEL_FOR_JOB> job = std::make_shared<PARALLEL_FOR_JOB>();
+	job->kernel = &kernel;
+	job->next_chunk = 0;
+	job->count_chunks = count_chunks;
+	job->count = count;
+	job->chunk_size = chunk_size;
+	job->semaphore = sSemaphores.Acquire();
+
+	const size_t count_workers = std::min(workers.size(), (size_t)count_chunks - 1);
+	for (size_t i=0; i < count_workers; i++)
+		workers[i]->Async(&ParallelForActor::AsyncRunChunks, workers[i], job);
+	RunChunks(job.get());
+
+	while (acquire_sem_etc(job->semaphore, count_chunks, 0, 0) == B_INTERRUPTED) ;
+	sSemaphores.Release();
+}
@@ -0,0 +1,25 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Parallel for (shared pool of worker actors)
+ */
+
+#ifndef _PARALLEL_FOR_H_
+#define _PARALLEL_FOR_H_
+
+#ifndef _GLIBCXX_FUNCTIONAL
+#include <functional>
+#endif
+
+/*****************************
+	ParallelFor splits [0, count) into chunks of chunk_size, which are processed by a shared
+	pool of worker actors (cpu_count - 1) and the caller thread.  Blocks until every chunk is
+	processed, the kernel must be thread safe.
+	Chunks are claimed with an atomic counter, so the caller never waits for a busy worker
+	to start (safe to call from any thread, including a worker or nested ParallelFor).
+	This is the only worker pool for data parallel work (SoftwareRender tiles, scalers, converters).
+******************************/
+void	ParallelFor(const int count, const int chunk_size, const std::function<void(const int start, const int end)> &kernel);
+int		ParallelForConcurrency();
+
+#endif	//#ifndef _PARALLEL_FOR_H_
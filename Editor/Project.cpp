@@ -6,12 +6,15 @@
 
 #include <cassert>
 #include <cstring>
+#include <mutex>
 
 #include <support/SupportDefs.h>
 #include <interface/Window.h>
 #include <storage/FilePanel.h>
 #include <interface/Bitmap.h>
 
+#include "Actor/Platform.h"
+
 #include "MediaSource.h"
 #include "EffectNode.h"
 #include "VideoManager.h"
@@ -37,6 +40,8 @@ Project :: Project()
 	assert(gProject == nullptr);
 	gProject = this;
 	fMemento = nullptr;
+	mEditGeneration = 0;
+	fEditLock = new yarra::yplatform::SpinLock;
 	
 	//	Defaults
 #if 1
@@ -78,6 +83,8 @@ Project :: ~Project()
 		
 	for (auto i : mTimelineTracks)
 		delete i;
+
+	delete fEditLock;
 		
 	gProject = nullptr;
 }
@@ -89,9 +96,61 @@ Project :: ~Project()
 */
 void Project :: InvalidatePreview()
 {
+	IncrementEditGeneration();
 	gRenderActor->Async<&RenderActor::AsyncPrepareFrame>(MedoWindow::GetInstance()->fTimelineView->GetCurrrentFrame());
 }
 
+/*	FUNCTION:		Project :: InvalidatePreview
+	ARGS:			start, end
+	RETURN:			n/a
+	DESCRIPTION:	Message to invalidate preview, only timeline range [start, end) modified
+*/
+void Project :: InvalidatePreview(const int64 start, const int64 end)
+{
+	IncrementEditGeneration(start, end);
+	gRenderActor->Async<&RenderActor::AsyncPrepareFrame>(MedoWindow::GetInstance()->fTimelineView->GetCurrrentFrame());
+}
+
+/*	FUNCTION:		Project :: IncrementEditGeneration
+	ARGS:			start, end
+	RETURN:			n/a
+	DESCRIPTION:	Timeline range [start, end) was modified.
+					Recent ranges are kept so that caches can perform partial invalidation.
+*/
+void Project :: IncrementEditGeneration(const int64 start, const int64 end)
+{
+	static const size_t kMaxEditRanges = 64;
+
+	std::lock_guard<yarra::yplatform::SpinLock> lock(*fEditLock);
+	const uint32 generation = ++mEditGeneration;
+	fEditRanges.push_back({generation, start, end});
+	if (fEditRanges.size() > kMaxEditRanges)
+		fEditRanges.pop_front();
+}
+
+/*	FUNCTION:		Project :: GetEditRanges
+	ARGS:			since_generation
+					ranges
+	RETURN:			false if history insufficient (caller must assume entire timeline modified)
+	DESCRIPTION:	Get timeline ranges modified after since_generation
+*/
+const bool Project :: GetEditRanges(const uint32 since_generation, std::vector<EDIT_RANGE> &ranges)
+{
+	ranges.clear();
+	std::lock_guard<yarra::yplatform::SpinLock> lock(*fEditLock);
+	if (since_generation == mEditGeneration)
+		return true;
+	if (fEditRanges.empty() || (fEditRanges.front().generation > since_generation + 1))
+		return false;
+
+	for (auto &r : fEditRanges)
+	{
+		if (r.generation > since_generation)
+			ranges.push_back(r);
+	}
+	return true;
+}
+
 /*	FUNCTION:		Project :: AddMediaSource
 	ARGS:			source_file
 					is_new
@@ -144,7 +203,13 @@ void Project :: RemoveMediaSource(MediaSource *source)
 			{
 				if (c->mMediaSource == source)
 				{
-					t->mClips.erase(c);
+					const int64 invalid_start = c->mTimelineFrameStart;
+					const int64 invalid_end = c->GetTimelineEndFrame();
+					{
+						TimelineTrack::ContainerLock lock(t);
+						t->mClips.erase(c);
+					}
+					t->InvalidateIndex(invalid_start, invalid_end);
 					repeat = true;
 					break;
 				}
@@ -158,6 +223,7 @@ void Project :: RemoveMediaSource(MediaSource *source)
 		if (source == *i)
 		{
 			mMediaSources.erase(i);
+			gRenderActor->Async(&RenderActor::AsyncInvalidateMediaSource, gRenderActor, source->GetInstanceId());
 			delete source;
 			found = true;
 			break;	
@@ -199,6 +265,7 @@ void Project :: AddTimelineTrack(TimelineTrack *track, int index)
 		mTimelineTracks.insert(mTimelineTracks.begin() + index, track);
 	else
 		mTimelineTracks.push_back(track);
+	IncrementEditGeneration();
 
 	AudioMixer *audio_mixer = MedoWindow::GetInstance()->GetAudioMixer();
 	if (audio_mixer)
@@ -223,6 +290,7 @@ void Project :: RemoveTimelineTrack(TimelineTrack *track)
 			break;	
 		}	
 	}
+	IncrementEditGeneration();
 	if (!found)
 		printf("Project::RemoveTimelineTrack() - not found\n");
 }
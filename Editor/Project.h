@@ -11,6 +11,18 @@
 #include <vector>
 #endif
 
+#ifndef _GLIBCXX_ATOMIC
+#include <atomic>
+#endif
+
+#ifndef _GLIBCXX_DEQUE
+#include <deque>
+#endif
+
+#ifndef _GLIBCXX_CSTDINT
+#include <cstdint>
+#endif
+
 #ifndef _B_STRING_H
 #include <support/String.h>
 #endif
@@ -28,6 +40,15 @@ class Memento;
 class BBitmap;
 class BMessage;
 
+class IntervalIndex;
+namespace yarra
+{
+	namespace yplatform
+	{
+		class SpinLock;
+	};
+};
+
 /*****************************
 	Timeline clip data
 	- media source
@@ -76,9 +97,10 @@ class MediaEffect
 public:
 	enum MEDIA_EFFECT {MEDIA_EFFECT_IMAGE, MEDIA_EFFECT_AUDIO};
 	
-							MediaEffect() : mEffectNode(nullptr), mEffectData(nullptr), mPriority(0), mEnabled(true) {}
+							MediaEffect() : mEffectNode(nullptr), mEffectData(nullptr), mPriority(0), mEnabled(true), fInstanceId(++sInstanceCounter) {}
 	virtual					~MediaEffect() {}
 	virtual MEDIA_EFFECT	Type() const = 0;
+	const uint64			GetInstanceId() const	{return fInstanceId;}		//	unique for application lifetime (address may be reused)
 	
 	EffectNode				*mEffectNode;
 	void					*mEffectData;	//	Each Derived effect must delete effect data
@@ -87,6 +109,10 @@ public:
 	bigtime_t				mTimelineFrameEnd;
 	bool					mEnabled;
 	inline const bigtime_t	Duration() const	{return mTimelineFrameEnd - mTimelineFrameStart;}
+
+private:
+	uint64					fInstanceId;
+	static inline std::atomic<uint64>	sInstanceCounter = 0;
 };
 
 //	Image Media Effect
@@ -148,8 +174,35 @@ public:
 	const int32		GetEffectIndex(MediaEffect *effect);
 	void			SetEffectPriority(MediaEffect *effect, const int32 priority);
 
+	//	Interval index queries, overlap [start, end), results in container order.  Safe from any thread
+	//	(RenderActor, audio callback): results are copied under the container lock, clips by value.
+	//	Returned MediaEffect pointers remain owned by the track (objects are not reallocated, but are
+	//	deleted by RemoveEffect/RemoveClip on the window thread).
+	void			FindClips(const int64 start, const int64 end, std::vector<MediaClip> &clips);
+	void			FindEffects(const int64 start, const int64 end, std::vector<MediaEffect *> &effects);
+	void			InvalidateIndex(const int64 start = 0, const int64 end = INT64_MAX);
+
+	//	Writers hold ContainerLock while mClips/mEffects are resized or reordered (vector reallocation), it
+	//	also invalidates the index.  Not recursive.  In place edits of clip/effect positions are not locked
+	//	(scalar fields), call InvalidateIndex() after every modification (edit generation / render graph).
+	class ContainerLock
+	{
+	public:
+						ContainerLock(TimelineTrack *track);
+						~ContainerLock();
+	private:
+		TimelineTrack	*fTrack;
+	};
+
 private:
 	const bool		DoEffectsIntersect(const MediaEffect *a, const MediaEffect *b);
+
+	void			ValidateIndexLocked();
+	IntervalIndex				*fClipIndex;
+	IntervalIndex				*fEffectIndex;
+	std::vector<int32_t>		fIndexResults;
+	yarra::yplatform::SpinLock	*fIndexLock;			//	index and container structure
+	bool						fIndexValid;
 };
 	
 
@@ -185,6 +238,20 @@ public:
 	RESOLUTION	mResolution;
 	
 	void			InvalidatePreview();
+	void			InvalidatePreview(const int64 start, const int64 end);
+
+//	Edit generation, incremented on every timeline/effect modification (RenderGraph, frame cache)
+//	Each generation records the modified timeline range, default is entire timeline
+	struct EDIT_RANGE
+	{
+		uint32		generation;
+		int64		start;
+		int64		end;
+	};
+	static const int64	kEditRangeAll = INT64_MAX;
+	void			IncrementEditGeneration(const int64 start = 0, const int64 end = kEditRangeAll);
+	const bool		GetEditRanges(const uint32 since_generation, std::vector<EDIT_RANGE> &ranges);
+	std::atomic<uint32>	mEditGeneration;
 
 //	Undo support
 	void			Snapshot();
@@ -202,6 +269,10 @@ public:
 	
 //	Diagnostic
 	void		DebugClips(const size_t track_index);
+
+private:
+	std::deque<EDIT_RANGE>		fEditRanges;
+	yarra::yplatform::SpinLock	*fEditLock;
 };
 
 //	Global project instance
@@ -602,6 +602,7 @@ const bool Project :: LoadProject(const char *data, const bool clear_media)
 			const EFFECT &effect = inEffects[e];	//	TODO index
 			if (effect.media_effect->mPriority > highest_priority)
 				highest_priority = effect.media_effect->mPriority;
+			TimelineTrack::ContainerLock lock(mTimelineTracks[t.id]);
 			mTimelineTracks[t.id]->mEffects.push_back(effect.media_effect);	//	TODO index
 		}
 		mTimelineTracks[t.id]->mNumberEffectLayers = (t.effects.empty() ? 0 : highest_priority + 1);
@@ -616,6 +617,7 @@ const bool Project :: LoadProject(const char *data, const bool clear_media)
 			mTimelineTracks[t.id]->mNotes.push_back(media_note);
 		}
 	}
+	IncrementEditGeneration();
 	
 	//	Session
 	MedoWindow::GetInstance()->fTimelineView->SetSession(inSession);
@@ -6,10 +6,15 @@
 
 #include <cstdio>
 #include <cstring>
+#include <cassert>
+#include <algorithm>
 
 #include <opengl/GLView.h>
 #include <interface/Bitmap.h>
 #include <interface/Window.h>
+#include <storage/Directory.h>
+#include <storage/FindDirectory.h>
+#include <storage/Path.h>
 #include <translation/TranslationUtils.h>
 
 #include "Actor/Actor.h"
@@ -17,8 +22,11 @@
 #include "Yarra/FileManager.h"
 #include "Yarra/Math/Math.h"
 #include "Yarra/Render/Camera.h"
+#include "Yarra/Render/Font.h"
 #include "Yarra/Render/RenderTarget.h"
 #include "Yarra/Render/Picture.h"
+#include "Yarra/Render/RenderState.h"
+#include "Yarra/Render/Shader.h"
 #include "Yarra/Render/Texture.h"
 
 #include "EffectsManager.h"
@@ -27,7 +35,14 @@
 #include "Effects/Effect_Speed.h"
 
 #include "RenderActor.h"
+#include "RenderGraph.h"
+#include "RenderStatistics.h"
+#include "ColourFusion.h"
+#include "FrameCache.h"
+#include "TextureCache.h"
+#include "SoftwareRender.h"
 #include "MedoWindow.h"
+#include "ParallelFor.h"
 #include "Project.h"
 #include "VideoManager.h"
 
@@ -40,6 +55,11 @@
 using namespace yrender;
 
 RenderActor *gRenderActor = nullptr;
+bool gSoftwareRender = false;
+
+//	RenderStatistics readback keys (sources and effects are keyed by instance id)
+static const uint64 kStatisticReadback = 0;
+static const uint64 kStatisticExportReadback = 1;
 
 /**************************************
 	RenderView
@@ -52,21 +72,58 @@ public:
 	void		ErrorCallback(unsigned long errorCode);
 	void		ResetViewport();
 
-	enum FRAME_BUFFER {PRIMARY_FRAME_BUFFER, SECONDARY_FRAME_BUFFER};
+	enum FRAME_BUFFER {PRIMARY_FRAME_BUFFER, SECONDARY_FRAME_BUFFER, NUMBER_FRAME_BUFFERS};
 	void		ActivateFrameBuffer(FRAME_BUFFER target, const bool clear, const bool is_alpha_clear = false);
 	void		DeactivateFrameBuffer(FRAME_BUFFER target);
+	void		ClearFrameBuffer(FRAME_BUFFER target);
 	BBitmap		*GetFrameBufferBitmap(FRAME_BUFFER target, GLenum format = GL_RGBA);
+	yrender::YTexture	*GetFrameBufferTexture(FRAME_BUFFER target);
+	BBitmap		*GetTextureBitmap(yrender::YTexture *texture, GLenum format = GL_RGBA);
+
+	//	Asynchronous readback (pixel pack buffers), export pipeline
+	int			ReadbackBegin(FRAME_BUFFER target);
+	void		ReadbackEnd(const int buffer, BBitmap *destination);
+
+	//	Reduced resolution preview (playback), 0 = project resolution, 1 = 1/2, 2 = 1/4
+	enum {kNumberPreviewScales = 3};
+	void		SetPreviewScale(const int scale);
+	const int	GetPreviewScale() const		{return fPreviewScale;}
 
 private:
+	void		CreateFrameBuffers();
+	void		DestroyFrameBuffers();
+	void		CreateFrameBufferSet(const int scale);
+
 	yrender::YCamera 		*fCamera;
 	enum {kNumberBitmapBuffers = 2};
-	yrender::YRenderTarget	*fRenderTarget[2];
-	BBitmap 				*fOpenGlBitmap[kNumberBitmapBuffers];
 	int						fBitmapIndex;
+	enum {kNumberReadbackBuffers = 2};
+	GLuint					fReadbackBuffer[kNumberReadbackBuffers];
+	int						fReadbackIndex;
+	size_t					fReadbackSize;
+
+	//	Each frame buffer is a ping-pong pair.  Activate() switches to the other target, so effects
+	//	can sample the previous target texture while rendering (no CPU readback required).
+	//	A set exists per preview scale, created on first use and retained (no reallocation when
+	//	playback switches resolution).  Camera is unchanged, only the viewport is scaled.
+	struct FRAME_BUFFER_SET
+	{
+		BBitmap					*bitmap[kNumberBitmapBuffers];
+		BBitmap					*texture_bitmap;		//	readback for legacy effects, independant of bitmap
+		yrender::YRenderTarget	*render_target[NUMBER_FRAME_BUFFERS][2];
+	};
+	FRAME_BUFFER_SET		*fFrameBufferSet[kNumberPreviewScales];
+	int						fPreviewScale;
+	int						fRenderTargetIndex[NUMBER_FRAME_BUFFERS];
+	int						fRenderTargetDepth[NUMBER_FRAME_BUFFERS];
 };
 
 /**********************************
 	PictureCache
+	Picture per dimension, upload is skipped when the same bitmap is requested again.
+	Bitmap content can change (readback buffers, recycled frame bitmaps), so Invalidate()
+	at start of frame and after readback.
+	Resident textures (TextureCache) are rendered with the same picture, without upload.
 ***********************************/
 class PictureCache
 {
@@ -76,39 +133,102 @@ class PictureCache
 		unsigned int		height;
 		BBitmap				*source;
 		yrender::YPicture	*picture;
+		yrender::YTexture	*texture;		//	owned, picture->mTexture may be a resident texture
 	};
 	std::vector<PICTURE_ITEM>		fPictures;
 
+	PICTURE_ITEM	*Find(const unsigned int width, const unsigned int height)
+	{
+		for (auto &i : fPictures)
+		{
+			if ((width == i.width) && (height == i.height))
+				return &i;
+		}
+		PICTURE_ITEM aItem;
+		aItem.width = width;
+		aItem.height = height;
+		aItem.source = nullptr;
+		aItem.picture = new yrender::YPicture(width, height, true, true);
+		aItem.texture = aItem.picture->mTexture;
+		fPictures.push_back(aItem);
+		return &fPictures.back();
+	}
+
 public:
 	~PictureCache()
 	{
-		for (auto i : fPictures)
+		for (auto &i : fPictures)
+		{
+			i.picture->mTexture = i.texture;
 			delete i.picture;
+		}
 	}
 
 	yrender::YPicture	*GetPicture(const unsigned int width, const unsigned int height, BBitmap *source)
 	{
-		for (auto i : fPictures)
+		PICTURE_ITEM *item = Find(width, height);
+		item->picture->mTexture = item->texture;
+		if (item->source != source)
 		{
-			if ((width == i.width) && (height == i.height))
-			{
-				if (i.source != source)
-					i.picture->mTexture->Upload(source);
-				return i.picture;
-			}
+			item->texture->Upload(source);
+			item->source = source;
 		}
+		return item->picture;
+	}
 
-		PICTURE_ITEM aItem;
-		aItem.width = width;
-		aItem.height = height;
-		aItem.picture = new yrender::YPicture(width, height, true, true);
-		aItem.source - source;
-		fPictures.push_back(aItem);
-		aItem.picture->mTexture->Upload(source);
-		return aItem.picture;
+	yrender::YPicture	*GetPicture(const unsigned int width, const unsigned int height, yrender::YTexture *resident)
+	{
+		PICTURE_ITEM *item = Find(width, height);
+		item->picture->mTexture = resident;
+		return item->picture;
+	}
+
+	void	Invalidate(BBitmap *source = nullptr)
+	{
+		for (auto &i : fPictures)
+		{
+			if (!source || (i.source == source))
+				i.source = nullptr;
+		}
 	}
 };
 
+/*	FUNCTION:		PrintShaderStatistics
+	ARGS:			description
+					previous (statistics before shaders created)
+	RETURN:			n/a
+	DESCRIPTION:	Report shader creation time (program binary cache)
+*/
+static void PrintShaderStatistics(const char *description, const YShader::CACHE_STATISTICS &previous)
+{
+	const YShader::CACHE_STATISTICS &current = YShader::GetCacheStatistics();
+	const int compiled = current.compiled - previous.compiled;
+	const int loaded = current.loaded - previous.loaded;
+	if (compiled + loaded == 0)
+		return;
+	printf("%s: shaders %0.2f ms (%d compiled, %d from cache)\n", description,
+		1000.0*(current.compile_time - previous.compile_time + current.load_time - previous.load_time), compiled, loaded);
+}
+
+/*	FUNCTION:		GetTextureGeneration
+	ARGS:			clip
+					frame_idx (as requested from VideoManager)
+	RETURN:			content generation (see TextureCache)
+	DESCRIPTION:	Decoded video frame index (repeated when source frame rate is lower than project frame rate),
+					0 for still pictures
+*/
+static int64 GetTextureGeneration(const MediaClip &clip, const int64 frame_idx)
+{
+	if ((clip.mMediaSourceType != MediaSource::MEDIA_VIDEO) && (clip.mMediaSourceType != MediaSource::MEDIA_VIDEO_AND_AUDIO))
+		return 0;
+
+	MediaSource *source = clip.mMediaSource;
+	int64 video_frame = frame_idx / float(kFramesSecond / source->GetVideoFrameRate());
+	if (video_frame >= source->GetVideoNumberFrames())
+		video_frame = source->GetVideoNumberFrames() - 1;
+	return video_frame < 0 ? 0 : video_frame;
+}
+
 /**************************************
 	RenderActor
 ***************************************/
@@ -127,6 +247,14 @@ RenderActor :: RenderActor(BRect frame)
 	fRenderView = nullptr;
 	fBackgroundBitmap = BTranslationUtils::GetBitmap("Resources/black.png");
 	fPictureCache = new PictureCache;
+	fTexturePicture = nullptr;
+	fRenderGraph = new RenderGraph;
+	fColourFusion = nullptr;
+	fFrameCache = new FrameCache;
+	fTextureCache = new TextureCache;
+	fResidentSource.bitmap = nullptr;
+	fStatistics = new RenderStatistics;
+	fExportReadback.bitmap = nullptr;
 
 	fPreviewMessage = new BMessage(MedoWindow::eMsgActionAsyncPreviewReady);
 	fPreviewMessage->AddPointer("BBitmap", nullptr);
@@ -134,7 +262,24 @@ RenderActor :: RenderActor(BRect frame)
 
 	fMsgInvalidateTimelineEdit = new BMessage(MedoWindow::eMsgActionAsyncThumbnailReady);
 
-	Async(&RenderActor::AsyncInitOpenGlView, this, frame);
+	if (gSoftwareRender)
+		fSoftwareRender = new SoftwareRender;
+	else
+	{
+		fSoftwareRender = nullptr;
+
+		//	Program binary cache (avoid recompiling effect shaders every launch)
+		BPath cache_path;
+		if (find_directory(B_USER_CACHE_DIRECTORY, &cache_path) == B_OK)
+		{
+			cache_path.Append("Medo/shaders");
+			if (create_directory(cache_path.Path(), 0755) == B_OK)
+				YShader::SetProgramBinaryCache(cache_path.Path());
+		}
+		//	3D text glyph tessellation uses the shared worker pool
+		yrender::YFontFreetype::sParallelFor = ParallelFor;
+		Async(&RenderActor::AsyncInitOpenGlView, this, frame);
+	}
 
 }
 
@@ -145,9 +290,31 @@ RenderActor :: RenderActor(BRect frame)
 */
 RenderActor :: ~RenderActor()
 {
+	if (fTexturePicture)
+		fTexturePicture->mTexture = nullptr;
+	delete fTexturePicture;
+	delete fColourFusion;
+	if (fRenderView)
+	{
+		fRenderView->LockGL();
+		fStatistics->DestroyGpuTimers();
+		delete fTextureCache;
+		fRenderView->UnlockGL();
+	}
+	else
+		delete fTextureCache;
+	delete fStatistics;
 	delete fRenderView;		//	TODO destructor must be run from same thread
+	delete fSoftwareRender;
 	delete fBackgroundBitmap;
 	delete fPictureCache;
+	delete fRenderGraph;
+	delete fFrameCache;
+	for (auto &frames : fClipFrames)
+	{
+		for (auto i : frames)
+			gVideoManager->ReleaseFrameBitmap(i);
+	}
 	delete fPreviewMessage;
 	delete fMsgInvalidateTimelineEdit;
 }
@@ -160,6 +327,9 @@ RenderActor :: ~RenderActor()
 void RenderActor :: AsyncInitOpenGlView(BRect frame)
 {
 	fRenderView = new RenderView(frame);
+	fRenderView->LockGL();
+	fStatistics->InitGpuTimers();
+	fRenderView->UnlockGL();
 }
 
 /*	FUNCTION:		RenderActor ::AsyncCreateEffectNode
@@ -169,23 +339,51 @@ void RenderActor :: AsyncInitOpenGlView(BRect frame)
 */
 void RenderActor :: AsyncCreateEffectNode(EffectNode *node)
 {
+	if (!fRenderView)
+		return;		//	software render
+	const YShader::CACHE_STATISTICS shader_statistics = YShader::GetCacheStatistics();
 	fRenderView->LockGL();
 	node->InitRenderObjects();
 	fRenderView->UnlockGL();
+	PrintShaderStatistics(node->GetEffectName(), shader_statistics);
 }
 
 /*	FUNCTION:		RenderActor ::AsyncPrepareFrame
 	ARGS:			frame_idx
 	RETURN:			n/a
-	DESCRIPTION:	Prepare rendered frame  (actor thread)
-					Note - Filter older messages
+	DESCRIPTION:	Prepare rendered frame at project resolution (actor thread)
 */
 void RenderActor :: AsyncPrepareFrame(bigtime_t frame_idx)
+{
+	PrepareFrame(frame_idx, 0);
+}
+
+/*	FUNCTION:		RenderActor :: PrepareFrame
+	ARGS:			frame_idx
+					preview_scale (0 = project resolution, 1 = 1/2, 2 = 1/4)
+					preload_idx (decode ahead, -1 if none)
+	RETURN:			n/a
+	DESCRIPTION:	Prepare rendered frame, post to MedoWindow  (actor thread)
+					Note - Filter older messages.  Decoding of preload_idx is scheduled on the
+					VideoManager preload actor, which is not affected by ClearAllMessages().
+*/
+void RenderActor :: PrepareFrame(bigtime_t frame_idx, const int preview_scale, const bigtime_t preload_idx)
 {
 	//	TODO ExportMedia will deadlock if AsyncPrepareExportFrame() messages destroyed
 	ClearAllMessages();
+	if (preload_idx >= 0)
+		PreloadFrame(preload_idx, true);
 
-	BBitmap *bitmap = GetOutputFrame(frame_idx);
+	//	Composited frames are cached (looped playback / scrubbing), reduced resolution frames are not
+	BBitmap *bitmap = fFrameCache->Find(frame_idx);
+	if (!bitmap)
+	{
+		SetPreviewScale(preview_scale);
+		bool composited = false;
+		bitmap = GetOutputFrame(frame_idx, &composited);
+		if (composited && (preview_scale == 0))
+			bitmap = fFrameCache->Add(frame_idx, bitmap);
+	}
 	fPreviewMessage->ReplacePointer("BBitmap", bitmap);
 	fPreviewMessage->ReplaceInt64("frame", frame_idx);
 	MedoWindow::GetInstance()->PostMessage(fPreviewMessage);
@@ -193,16 +391,33 @@ void RenderActor :: AsyncPrepareFrame(bigtime_t frame_idx)
 
 /*	FUNCTION:		RenderActor ::AsyncPlayFrame
 	ARGS:			frame_idx
+					preload_idx (decode ahead, -1 if none)
+					preview_scale (see TimelinePlayer, adaptive playback resolution)
 					completion
 					behaviour
 	RETURN:			n/a
 	DESCRIPTION:	Called by TimelinePlayer, prepare frame, display it, send completion message
 */
-void RenderActor :: AsyncPlayFrame(bigtime_t frame_idx, Actor *completion, std::function<void()> behaviour)
+void RenderActor :: AsyncPlayFrame(bigtime_t frame_idx, bigtime_t preload_idx, int preview_scale, Actor *completion, std::function<void()> behaviour)
 {
-	AsyncPrepareFrame(frame_idx);	//	Sync call
+	PrepareFrame(frame_idx, preview_scale, preload_idx);
 	completion->Async(behaviour);
 }
+
+/*	FUNCTION:		RenderActor :: SetPreviewScale
+	ARGS:			preview_scale (0 = project resolution, 1 = 1/2, 2 = 1/4)
+	RETURN:			n/a
+	DESCRIPTION:	Select reduced resolution render targets (OpenGL only, software render ignores scale)
+*/
+void RenderActor :: SetPreviewScale(const int preview_scale)
+{
+	if (!fRenderView || (fRenderView->GetPreviewScale() == preview_scale))
+		return;
+	fRenderView->LockGL();
+	fRenderView->SetPreviewScale(preview_scale);
+	fRenderView->UnlockGL();
+}
+
 /*	FUNCTION:		RenderActor ::AsyncPrepareExportFrame
 	ARGS:			frame_idx
 	RETURN:			n/a
@@ -211,106 +426,158 @@ void RenderActor :: AsyncPlayFrame(bigtime_t frame_idx, Actor *completion, std::
 */
 void RenderActor :: AsyncPrepareExportFrame(bigtime_t frame_idx, sem_id sem_signal, BBitmap **pbitmap)
 {
+	SetPreviewScale(0);
 	*pbitmap = GetOutputFrame(frame_idx);
 	release_sem(sem_signal);
 }
 
+/*	FUNCTION:		RenderActor ::AsyncExportFrame
+	ARGS:			frame_idx
+					preload_idx (decode ahead, -1 if none)
+					bitmap (owned by caller, receives output frame)
+					sem_signal
+	RETURN:			n/a
+	DESCRIPTION:	Pipelined export frame (actor thread), see ExportPipeline.
+					Decoding of preload_idx is scheduled on the VideoManager preload actor, frame_idx is
+					composited and an asynchronous readback is started.  The readback of the previous
+					frame is then completed (bitmap copied, sem_signal released).
+					Caller must call AsyncFlushExportFrame() after the final request.
+*/
+void RenderActor :: AsyncExportFrame(bigtime_t frame_idx, bigtime_t preload_idx, BBitmap *bitmap, sem_id sem_signal)
+{
+	assert(bitmap != nullptr);
+	if (preload_idx >= 0)
+		PreloadFrame(preload_idx, true);
+
+	BBitmap *output = fFrameCache->Find(frame_idx);
+	bool composited = false;
+	int readback_buffer = -1;
+	if (!output)
+	{
+		SetPreviewScale(0);
+		output = GetOutputFrame(frame_idx, &composited, &readback_buffer);
+	}
+
+	if (fRenderView)
+	{
+		fRenderView->LockGL();
+		CompleteExportReadback();
+		fRenderView->UnlockGL();
+	}
+
+	if (composited && (readback_buffer >= 0))
+	{
+		fExportReadback.bitmap = bitmap;
+		fExportReadback.semaphore = sem_signal;
+		fExportReadback.buffer = readback_buffer;
+		return;
+	}
+
+	//	Passthrough frame (cached, single full screen clip or background)
+	if (output && (output != fBackgroundBitmap) && (output->BitsLength() == bitmap->BitsLength()))
+		memcpy(bitmap->Bits(), output->Bits(), bitmap->BitsLength());
+	else
+		memset(bitmap->Bits(), 0, bitmap->BitsLength());
+	release_sem(sem_signal);
+}
+
+/*	FUNCTION:		RenderActor ::AsyncFlushExportFrame
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Complete pending export readback (final frame)
+*/
+void RenderActor :: AsyncFlushExportFrame()
+{
+	if (!fRenderView)
+		return;
+	fRenderView->LockGL();
+	CompleteExportReadback();
+	fRenderView->UnlockGL();
+}
+
+/*	FUNCTION:		RenderActor :: CompleteExportReadback
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Copy pending export readback to caller bitmap and signal caller (GL context locked)
+*/
+void RenderActor :: CompleteExportReadback()
+{
+	if (!fExportReadback.bitmap)
+		return;
+
+	fStatistics->Begin(RenderStatistics::STAGE_READBACK, kStatisticExportReadback, "Export readback");
+	fRenderView->ReadbackEnd(fExportReadback.buffer, fExportReadback.bitmap);
+	fStatistics->End();
+	release_sem(fExportReadback.semaphore);
+	fExportReadback.bitmap = nullptr;
+}
+
 /*	FUNCTION:		RenderActor :: GetPicture
 	ARGS:			width
 					height
+					source
 	RETURN:			YPicture
-	DESCRIPTION:	Get Picture from cache, maintain ownership
+	DESCRIPTION:	Get Picture from cache, maintain ownership.
+					The clip bitmap being composited uses a resident texture (no upload if content unchanged).
 */
 yrender::YPicture * RenderActor :: GetPicture(const unsigned int width, unsigned int height, BBitmap *source)
 {
 	AsyncValidityCheck();
+	if (source && (source == fResidentSource.bitmap))
+		return fPictureCache->GetPicture(width, height, fTextureCache->GetTexture(source, fResidentSource.owner, fResidentSource.generation));
 	return fPictureCache->GetPicture(width, height, source);
 }
 
+/*	FUNCTION:		RenderActor :: GetPicture
+	ARGS:			source
+	RETURN:			YPicture
+	DESCRIPTION:	Get Picture which renders source texture (no upload), maintain ownership
+*/
+yrender::YPicture * RenderActor :: GetPicture(yrender::YTexture *source)
+{
+	AsyncValidityCheck();
+	assert(source);
+
+	//	Geometry is unit sized (caller sets scale), only the texture is replaced
+	if (!fTexturePicture)
+	{
+		fTexturePicture = new yrender::YPicture(source->GetWidth(), source->GetHeight(), true, true);
+		delete fTexturePicture->mTexture;
+	}
+	fTexturePicture->mTexture = source;
+	return fTexturePicture;
+}
+
 /*	FUNCTION:		RenderActor :: GetOutputFrame
 	ARGS:			frame_idx
-	RETURN:			Output frame
+					composited (optional, set if output is a composited frame buffer)
+					readback_buffer (optional, asynchronous readback of composited frame buffer)
+	RETURN:			Output frame (nullptr if composited frame buffer readback is asynchronous)
 	DESCRIPTION:	Create output frame
 */
-BBitmap * RenderActor :: GetOutputFrame(int64 frame_idx)
+BBitmap * RenderActor :: GetOutputFrame(int64 frame_idx, bool *composited, int *readback_buffer)
 {
 	DEBUG("RenderActor::GetOutputFrame(%ld)\n", frame_idx);
+	if (composited)
+		*composited = false;
+	ReleaseClipFrames();
 
-	std::deque<FRAME_ITEM>		frame_items;
-	std::deque<int64>			track_timelines;
-
-	//	Reverse iterate each track, find clips and effects
-	for (std::vector<TimelineTrack *>::const_reverse_iterator t = gProject->mTimelineTracks.rbegin(); t < gProject->mTimelineTracks.rend(); ++t)
-	{
-		if (!(*t)->mVideoEnabled)
-			continue;
-
-		//	Find clips (TODO binary search)
-		for (auto &clip : (*t)->mClips)
-		{
-			if ((frame_idx >= clip.mTimelineFrameStart) && (frame_idx < clip.GetTimelineEndFrame()) && clip.mVideoEnabled &&
-				((clip.mMediaSourceType == MediaSource::MEDIA_VIDEO) || (clip.mMediaSourceType == MediaSource::MEDIA_VIDEO_AND_AUDIO) || (clip.mMediaSourceType == MediaSource::MEDIA_PICTURE)))
-			{
-				frame_items.emplace_back(FRAME_ITEM(*t, &clip, nullptr, false));
-				break;
-			}
-			else if (clip.mTimelineFrameStart > frame_idx)
-				break;
-		}
-
-		//	Find effects (TODO binary search, TODO early exit)
-		std::vector<FRAME_ITEM> effects;
-		bool use_secondary_buffer = false;
-		int64 timeline_frame_idx = frame_idx;
-		for (auto e : (*t)->mEffects)
-		{
-			if ((frame_idx >= e->mTimelineFrameStart) && (frame_idx < e->mTimelineFrameEnd) && e->mEnabled)
-			{
-				if (e->Type() == MediaEffect::MEDIA_EFFECT_IMAGE)
-				{
-					effects.emplace_back(FRAME_ITEM(*t, nullptr, e, e->mEffectNode->UseSecondaryFrameBuffer()));
-					if (e->mEffectNode->UseSecondaryFrameBuffer())
-						use_secondary_buffer = true;
-				}
-
-				//	timeline - warning not cumulative
-				if (e->mEffectNode->IsSpeedEffect())
-				{
-					timeline_frame_idx = ((Effect_Speed *)e->mEffectNode)->GetSpeedTime(frame_idx, e);
-					track_timelines.push_back(timeline_frame_idx);
-				}
-			}
-		}
-		if (!effects.empty())
-		{
-			if (effects.size() > 1)
-			{
-				std::sort(effects.begin(), effects.end(), [](const FRAME_ITEM &a, const FRAME_ITEM &b){return a.effect->mPriority < b.effect->mPriority;});
-
-				//	If one effect requires secondary buffer, all effects + clip render to secondary frame buffer
-				if (use_secondary_buffer && !frame_items.empty() && frame_items[frame_items.size()-1].clip)
-				{
-					frame_items[frame_items.size() - 1].secondary_framebuffer = true;
-					for (auto &e : effects)
-						e.secondary_framebuffer = true;
-				}
-			}
-			for (auto &e : effects)
-				frame_items.emplace_back(e);
-		}
-		effects.clear();
-	}
+	//	Render schedule is precompiled (only recompiled when project edited)
+	const RenderGraph::SPAN *span = fRenderGraph->GetSpan(frame_idx);
+	if (!span)
+		return fBackgroundBitmap;
 
-	if (frame_items.empty())
+	if (span->items.empty())
 		return fBackgroundBitmap;
 
 	//	Add 25% grace to frame time to avoid touching clips (end/begin)
 	const int64 kFrameReadGrace = kFramesSecond / (4.0*gProject->mResolution.frame_rate);
 
 	BBitmap *bitmap = fBackgroundBitmap;
+	fStatistics->BeginFrame();
 
 	//	Early exit if single (or final) full screen frame
-	const FRAME_ITEM &last = frame_items[frame_items.size() - 1];
+	const FRAME_ITEM &last = span->items.back();
 	if (last.clip)
 	{
 		const MediaClip &clip = *last.clip;
@@ -319,16 +586,19 @@ BBitmap * RenderActor :: GetOutputFrame(int64 frame_idx)
 		if (last_fullscreen)
 		{
 			int64 requested_frame = (frame_idx - clip.mTimelineFrameStart) + clip.mSourceFrameStart;
+			fStatistics->Begin(RenderStatistics::STAGE_DECODE, clip.mMediaSource->GetInstanceId(), clip.mMediaSource->GetFilename().String());
 			if ((clip.mMediaSourceType == MediaSource::MEDIA_VIDEO) || (clip.mMediaSourceType == MediaSource::MEDIA_VIDEO_AND_AUDIO))
-				bitmap = gVideoManager->GetFrameBitmap(clip.mMediaSource, requested_frame + kFrameReadGrace);
+				bitmap = GetClipFrameBitmap(clip.mMediaSource, requested_frame + kFrameReadGrace);
 			else
 				bitmap = clip.mMediaSource->GetBitmap();
+			fStatistics->End();
+			fStatistics->EndFrame();
 			return bitmap;
 		}
 	}
 
 	DEBUG("*** Output ***\n");
-	for (auto i : frame_items)
+	for (auto &i : span->items)
 	{
 		if (i.clip)
 		{
@@ -340,25 +610,45 @@ BBitmap * RenderActor :: GetOutputFrame(int64 frame_idx)
 		}
 	}
 
+	if (fSoftwareRender)
+	{
+		bitmap = fSoftwareRender->Composite(fRenderGraph, span, frame_idx);
+		fStatistics->EndFrame();
+		if (!bitmap)
+			return fBackgroundBitmap;
+		if (composited)
+			*composited = true;
+		return bitmap;
+	}
+
+	//	Compositing is GPU resident, effects sample the previous render target texture.
+	//	Only legacy effects (BBitmap RenderEffect) and the final output require a readback.
 	BBitmap *frame_bitmap = bitmap;
 	bool initial_primary = true;
 	bool initial_secondary = true;
-	BBitmap *secondary_bitmap = nullptr;
+	bool primary_valid = false;
+	bool secondary_valid = false;
 	bool secondary_transfer_pending = false;
 	double ts = yplatform::GetElapsedTime();
 	fRenderView->LockGL();
+	yrender::yRenderState.Invalidate();
+	fStatistics->ResolveGpuTimers();
+	fTextureCache->BeginFrame();
+	fPictureCache->Invalidate();
+	if (!fColourFusion)
+		fColourFusion = new ColourFusion;
+	std::deque<FRAME_ITEM> &frame_items = fRenderGraph->GetFrameItems(span);
 	TimelineTrack *timeline_track = nullptr;
 	int64 timeline_frame_idx = frame_idx;
 	while (!frame_items.empty())
 	{
-		const FRAME_ITEM &item = frame_items.front();
+		const FRAME_ITEM item = frame_items.front();
 		frame_items.pop_front();
 
-		if ((track_timelines.size() > 0) && (item.track != timeline_track))
+		if (!span->timelines.empty() && (item.track != timeline_track))
 		{
-			timeline_frame_idx = track_timelines.front();
+			timeline_frame_idx = fRenderGraph->GetTrackFrame(span, item.track, frame_idx);
 			timeline_track = item.track;
-			track_timelines.pop_front();
 		}
 
 		DEBUG("   >>> %s\n", item.clip ? item.clip->mMediaSource->GetFilename().String() : item.effect->mEffectNode->GetEffectName());
@@ -367,40 +657,46 @@ BBitmap * RenderActor :: GetOutputFrame(int64 frame_idx)
 		{
 			const MediaClip &clip = *item.clip;
 			int64 requested_frame = (timeline_frame_idx - clip.mTimelineFrameStart) + clip.mSourceFrameStart;
+			const char *clip_label = clip.mMediaSource->GetFilename().String();
+			fStatistics->Begin(RenderStatistics::STAGE_DECODE, clip.mMediaSource->GetInstanceId(), clip_label);
 			if ((clip.mMediaSourceType == MediaSource::MEDIA_VIDEO) || (clip.mMediaSourceType == MediaSource::MEDIA_VIDEO_AND_AUDIO))
-				frame_bitmap = gVideoManager->GetFrameBitmap(clip.mMediaSource, requested_frame + kFrameReadGrace);
+				frame_bitmap = GetClipFrameBitmap(clip.mMediaSource, requested_frame + kFrameReadGrace);
 			else
 				frame_bitmap = clip.mMediaSource->GetBitmap();
+			fStatistics->End();
 
 			if (secondary_transfer_pending)
 			{
 				fRenderView->ActivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER, initial_primary, false);
-				gEffectsManager->GetEffectNone()->RenderEffect(secondary_bitmap, nullptr, frame_idx, frame_items);
+				gEffectsManager->GetEffectNone()->RenderEffect(fRenderView->GetFrameBufferTexture(RenderView::SECONDARY_FRAME_BUFFER), nullptr, frame_idx, frame_items);
 				fRenderView->DeactivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER);
-				bitmap = fRenderView->GetFrameBufferBitmap(RenderView::PRIMARY_FRAME_BUFFER, GL_RGBA);
+				primary_valid = true;
 				secondary_transfer_pending = false;
 			}
 
 			if (frame_bitmap)
 			{
+				fStatistics->Begin(RenderStatistics::STAGE_UPLOAD, clip.mMediaSource->GetInstanceId(), clip_label, true);
+				fResidentSource = {frame_bitmap, clip.mMediaSource->GetInstanceId(), GetTextureGeneration(clip, requested_frame + kFrameReadGrace)};
 				if (!item.secondary_framebuffer)
 				{
 					fRenderView->ActivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER, initial_primary, false);
 					gEffectsManager->GetEffectNone()->RenderEffect(frame_bitmap, nullptr, frame_idx, frame_items);
 					fRenderView->DeactivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER);
-					bitmap = fRenderView->GetFrameBufferBitmap(RenderView::PRIMARY_FRAME_BUFFER, GL_RGBA);
 					initial_primary = false;
+					primary_valid = true;
 				}
 				else
 				{
 					fRenderView->ActivateFrameBuffer(RenderView::SECONDARY_FRAME_BUFFER, initial_secondary, true);
 					gEffectsManager->GetEffectNone()->RenderEffect(frame_bitmap, nullptr, frame_idx, frame_items);
 					fRenderView->DeactivateFrameBuffer(RenderView::SECONDARY_FRAME_BUFFER);
-					secondary_bitmap = fRenderView->GetFrameBufferBitmap(RenderView::SECONDARY_FRAME_BUFFER, GL_RGBA);
 					initial_secondary = false;
+					secondary_valid = true;
 					secondary_transfer_pending = true;
 				}
-
+				fResidentSource.bitmap = nullptr;
+				fStatistics->End();
 			}
 			else
 				printf("RenderActor::GetOutputFrame(%ld) - cannot retrieve frame File: %s\n", frame_idx, item.clip->mMediaSource->GetFilename().String());
@@ -416,23 +712,44 @@ BBitmap * RenderActor :: GetOutputFrame(int64 frame_idx)
 					initial_primary = true;
 				}
 
+				fStatistics->Begin(RenderStatistics::STAGE_EFFECT, item.effect->GetInstanceId(), item.effect->mEffectNode->GetEffectName(), true);
 				if (!item.secondary_framebuffer)
 				{
+					//	Source texture must be acquired before activation (ping-pong)
+					yrender::YTexture *source = primary_valid ? fRenderView->GetFrameBufferTexture(RenderView::PRIMARY_FRAME_BUFFER) : nullptr;
 					fRenderView->ActivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER, initial_primary, false);
-					item.effect->mEffectNode->RenderEffect(bitmap, item.effect, frame_idx, frame_items);
+					if (source)
+					{
+						if (!RenderColourFusion(source, item, frame_items, frame_idx))
+							item.effect->mEffectNode->RenderEffect(source, item.effect, frame_idx, frame_items);
+					}
+					else
+						item.effect->mEffectNode->RenderEffect(fBackgroundBitmap, item.effect, frame_idx, frame_items);
 					fRenderView->DeactivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER);
-					bitmap = fRenderView->GetFrameBufferBitmap(RenderView::PRIMARY_FRAME_BUFFER, GL_RGBA);
 					initial_primary = false;
+					primary_valid = true;
 				}
 				else
 				{
+					yrender::YTexture *source = nullptr;
+					if (secondary_valid)
+						source = fRenderView->GetFrameBufferTexture(RenderView::SECONDARY_FRAME_BUFFER);
+					else if (primary_valid)
+						source = fRenderView->GetFrameBufferTexture(RenderView::PRIMARY_FRAME_BUFFER);
 					fRenderView->ActivateFrameBuffer(RenderView::SECONDARY_FRAME_BUFFER, initial_secondary, false);
-					item.effect->mEffectNode->RenderEffect(secondary_bitmap == nullptr ? bitmap : secondary_bitmap, item.effect, frame_idx, frame_items);
+					if (source)
+					{
+						if (!RenderColourFusion(source, item, frame_items, frame_idx))
+							item.effect->mEffectNode->RenderEffect(source, item.effect, frame_idx, frame_items);
+					}
+					else
+						item.effect->mEffectNode->RenderEffect(fBackgroundBitmap, item.effect, frame_idx, frame_items);
 					fRenderView->DeactivateFrameBuffer(RenderView::SECONDARY_FRAME_BUFFER);
-					secondary_bitmap = fRenderView->GetFrameBufferBitmap(RenderView::SECONDARY_FRAME_BUFFER, GL_RGBA);
 					initial_secondary = false;
+					secondary_valid = true;
 					secondary_transfer_pending = true;
 				}
+				fStatistics->End();
 			}
 		}
 	}
@@ -440,20 +757,95 @@ BBitmap * RenderActor :: GetOutputFrame(int64 frame_idx)
 	if (secondary_transfer_pending)
 	{
 		fRenderView->ActivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER, initial_primary, false);
-		gEffectsManager->GetEffectNone()->RenderEffect(secondary_bitmap, nullptr, frame_idx, frame_items);
+		gEffectsManager->GetEffectNone()->RenderEffect(fRenderView->GetFrameBufferTexture(RenderView::SECONDARY_FRAME_BUFFER), nullptr, frame_idx, frame_items);
 		fRenderView->DeactivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER);
-		bitmap = fRenderView->GetFrameBufferBitmap(RenderView::PRIMARY_FRAME_BUFFER, GL_RGBA);
+		primary_valid = true;
 		secondary_transfer_pending = false;
 	}
 
+	//	Single readback for display / export
+	if (primary_valid)
+	{
+		fStatistics->Begin(RenderStatistics::STAGE_READBACK, kStatisticReadback, "Readback", true);
+		if (readback_buffer)
+		{
+			*readback_buffer = fRenderView->ReadbackBegin(RenderView::PRIMARY_FRAME_BUFFER);
+			bitmap = nullptr;
+		}
+		else
+			bitmap = fRenderView->GetFrameBufferBitmap(RenderView::PRIMARY_FRAME_BUFFER, GL_RGBA);
+		fStatistics->End();
+		if (composited)
+			*composited = true;
+	}
+
 	fRenderView->UnlockGL();
+	fStatistics->EndFrame();
 	DEBUG("RenderTime[3] = %fms\n", 1000.0 * (yplatform::GetElapsedTime() - ts));
 	return bitmap;
 }
 
+/*	FUNCTION:		RenderActor :: GetClipFrameBitmap
+	ARGS:			source
+					frame_idx
+	RETURN:			decoded video frame
+	DESCRIPTION:	Frame remains pinned in VideoManager (not evicted by preload actor) until the
+					output frame after next, since the output frame may reference it (passthrough).
+*/
+BBitmap * RenderActor :: GetClipFrameBitmap(MediaSource *source, const int64 frame_idx)
+{
+	BBitmap *bitmap = gVideoManager->GetFrameBitmap(source, frame_idx);
+	if (bitmap)
+		fClipFrames[0].push_back(bitmap);
+	return bitmap;
+}
+
+/*	FUNCTION:		RenderActor :: ReleaseClipFrames
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Unpin clip frames of previous output frame, current frames become previous
+*/
+void RenderActor :: ReleaseClipFrames()
+{
+	for (auto i : fClipFrames[1])
+		gVideoManager->ReleaseFrameBitmap(i);
+	fClipFrames[1].swap(fClipFrames[0]);
+	fClipFrames[0].clear();
+}
+
+/*	FUNCTION:		RenderActor :: RenderColourFusion
+	ARGS:			source
+					item
+					frame_items
+					frame_idx
+	RETURN:			true if item (and fused pending items) rendered
+	DESCRIPTION:	Render run of consecutive colour effects in a single shader pass.
+					Fused items are removed from frame_items.
+*/
+bool RenderActor :: RenderColourFusion(yrender::YTexture *source, const FRAME_ITEM &item, std::deque<FRAME_ITEM> &frame_items, int64 frame_idx)
+{
+	const size_t run_length = fColourFusion->GetRunLength(item, frame_items);
+	if (run_length == 0)
+		return false;
+
+	fFusionEffects.clear();
+	fFusionEffects.push_back(item.effect);
+	for (size_t i=0; i < run_length; i++)
+		fFusionEffects.push_back(frame_items[i].effect);
+
+	if (!fColourFusion->Render(source, fFusionEffects, frame_idx))
+		return false;
+
+	DEBUG("   >>> fused %lu colour effects\n", fFusionEffects.size());
+	frame_items.erase(frame_items.begin(), frame_items.begin() + run_length);
+	return true;
+}
+
 BBitmap * RenderActor :: GetCurrentFrameBufferTexture(GLenum format)
 {
-	return fRenderView->GetFrameBufferBitmap(RenderView::PRIMARY_FRAME_BUFFER, format);
+	BBitmap *bitmap = fRenderView->GetFrameBufferBitmap(RenderView::PRIMARY_FRAME_BUFFER, format);
+	fPictureCache->Invalidate(bitmap);
+	return bitmap;
 }
 
 void RenderActor :: ActivateSecondaryRenderBuffer(const bool is_alpha_clear)
@@ -468,13 +860,27 @@ void RenderActor :: DeactivateSecondaryRenderBuffer()
 
 BBitmap *RenderActor :: GetSecondaryFrameBufferTexture(GLenum format)
 {
-	return fRenderView->GetFrameBufferBitmap(RenderView::SECONDARY_FRAME_BUFFER, format);
+	BBitmap *bitmap = fRenderView->GetFrameBufferBitmap(RenderView::SECONDARY_FRAME_BUFFER, format);
+	fPictureCache->Invalidate(bitmap);
+	return bitmap;
 }
 
 void RenderActor :: EffectResetPrimaryRenderBuffer()
 {
-	fRenderView->DeactivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER);
-	fRenderView->ActivateFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER, true, false);
+	//	Clear in place, switching ping-pong targets would clear the effect source texture
+	fRenderView->ClearFrameBuffer(RenderView::PRIMARY_FRAME_BUFFER);
+}
+
+yrender::YTexture * RenderActor :: GetCurrentFrameBufferTextureGPU()
+{
+	return fRenderView->GetFrameBufferTexture(RenderView::PRIMARY_FRAME_BUFFER);
+}
+
+BBitmap * RenderActor :: GetTextureBitmap(yrender::YTexture *texture, GLenum format)
+{
+	BBitmap *bitmap = fRenderView->GetTextureBitmap(texture, format);
+	fPictureCache->Invalidate(bitmap);
+	return bitmap;
 }
 
 /*	FUNCTION:		RenderView :: AsyncPreloadFrame
@@ -484,20 +890,36 @@ void RenderActor :: EffectResetPrimaryRenderBuffer()
 */
 void RenderActor :: AsyncPreloadFrame(bigtime_t frame_idx)
 {
-	//	Reverse iterate each track, find clips
-	for (std::vector<TimelineTrack *>::const_reverse_iterator t = gProject->mTimelineTracks.rbegin(); t < gProject->mTimelineTracks.rend(); ++t)
+	PreloadFrame(frame_idx, false);
+}
+
+/*	FUNCTION:		RenderView :: PreloadFrame
+	ARGUMENTS:		frame_idx
+					async (decode on VideoManager preload actor)
+	RETURN:			n/a
+	DESCRIPTION:	Decode video clip frames required to composite frame_idx
+*/
+void RenderActor :: PreloadFrame(bigtime_t frame_idx, const bool async)
+{
+	const RenderGraph::SPAN *span = fRenderGraph->GetSpan(frame_idx);
+	if (!span)
+		return;
+
+	for (auto &item : span->items)
 	{
-		//	Find clips (TODO binary search)
-		for (auto &clip : (*t)->mClips)
+		if (item.clip &&
+			((item.clip->mMediaSourceType == MediaSource::MEDIA_VIDEO) || (item.clip->mMediaSourceType == MediaSource::MEDIA_VIDEO_AND_AUDIO)))
 		{
-			if ((frame_idx >= clip.mTimelineFrameStart) && (frame_idx < clip.GetTimelineEndFrame()) &&
-				((clip.mMediaSourceType == MediaSource::MEDIA_VIDEO) || (clip.mMediaSourceType == MediaSource::MEDIA_VIDEO_AND_AUDIO)))
+			const MediaClip &clip = *item.clip;
+			int64 requested_frame = (fRenderGraph->GetTrackFrame(span, item.track, frame_idx) - clip.mTimelineFrameStart) + clip.mSourceFrameStart;
+			if (async)
 			{
-				int64 requested_frame = (frame_idx - clip.mTimelineFrameStart) + clip.mSourceFrameStart;
-				gVideoManager->GetFrameBitmap(clip.mMediaSource, requested_frame);
+				//	Same grace as GetOutputFrame(), so the decoded frame is found in cache
+				const int64 kFrameReadGrace = kFramesSecond / (4.0*gProject->mResolution.frame_rate);
+				gVideoManager->PreloadFrameAsync(clip.mMediaSource, requested_frame + kFrameReadGrace);
 			}
-			else if (clip.mTimelineFrameStart > frame_idx)
-				break;
+			else
+				gVideoManager->ReleaseFrameBitmap(gVideoManager->GetFrameBitmap(clip.mMediaSource, requested_frame));
 		}
 	}
 }
@@ -526,11 +948,47 @@ void RenderActor :: AsyncInvalidateProjectSettings(int32 sem_id)
 	gEffectsManager->ProjectSettingsChanged();
 	fRenderView->UnlockGL();
 #else
+	if (fSoftwareRender)
+	{
+		fSoftwareRender->Invalidate();
+		fFrameCache->Clear();
+		if (sem_id > 0)
+			release_sem(sem_id);
+		else
+			gProject->InvalidatePreview();
+		return;
+	}
+	if (fTexturePicture)
+	{
+		fRenderView->LockGL();
+		fTexturePicture->mTexture = nullptr;
+		delete fTexturePicture;
+		fTexturePicture = nullptr;
+		fRenderView->UnlockGL();
+	}
+	if (fColourFusion)
+	{
+		//	GL objects belong to RenderView context
+		fRenderView->LockGL();
+		delete fColourFusion;
+		fColourFusion = nullptr;
+		fRenderView->UnlockGL();
+	}
+	fRenderView->LockGL();
+	CompleteExportReadback();
+	fStatistics->DestroyGpuTimers();
+	fTextureCache->Clear();
+	fPictureCache->Invalidate();
+	fRenderView->UnlockGL();
 	delete fRenderView;
 	fRenderView = new RenderView(BRect(0, 0, gProject->mResolution.width, gProject->mResolution.height));
+	fFrameCache->Clear();
 	fRenderView->LockGL();
+	fStatistics->InitGpuTimers();
+	const YShader::CACHE_STATISTICS shader_statistics = YShader::GetCacheStatistics();
 	gEffectsManager->ProjectSettingsChanged();
 	fRenderView->UnlockGL();
+	PrintShaderStatistics("RenderActor::AsyncInvalidateProjectSettings()", shader_statistics);
 #endif
 
 	if (sem_id > 0)
@@ -539,6 +997,22 @@ void RenderActor :: AsyncInvalidateProjectSettings(int32 sem_id)
 		gProject->InvalidatePreview();
 }
 
+/*	FUNCTION:		RenderActor :: AsyncInvalidateMediaSource
+	ARGUMENTS:		source_id (MediaSource::GetInstanceId())
+	RETURN:			n/a
+	DESCRIPTION:	MediaSource removed from project, release resident textures.
+					Textures are keyed by instance id (never reused), so if this message is cleared by
+					PrepareFrame() the textures are only held until evicted, never shown for another source.
+*/
+void RenderActor :: AsyncInvalidateMediaSource(uint64 source_id)
+{
+	if (!fRenderView)
+		return;
+	fRenderView->LockGL();
+	fTextureCache->Invalidate(source_id);
+	fRenderView->UnlockGL();
+}
+
 /*	FUNCTION:		RenderView :: Reset
 	ARGUMENTS:		none
 	RETURN:			n/a
@@ -584,8 +1058,9 @@ RenderView :: RenderView(BRect frame)
 	//glDepthMask(GL_TRUE);
 	//glDepthFunc(GL_LEQUAL);
 	
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	yrender::yRenderState.Reset();
+	yrender::yRenderState.SetBlend(true);
+	yrender::yRenderState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	
 	const float width = gProject->mResolution.width;
 	const float height = gProject->mResolution.height;
@@ -593,13 +1068,7 @@ RenderView :: RenderView(BRect frame)
 	fCamera->mSpatial.SetPosition(ymath::YVector3(0.5f*width, 0.5f*height, width));
 	fCamera->SetDirection(ymath::YVector3(0, 0, -1));
 
-	BRect glFrame(0, 0, width-1, height-1);
-	for (int i=0; i < kNumberBitmapBuffers; i++)
-		fOpenGlBitmap[i] = new BBitmap(glFrame, B_RGB32);
-	fBitmapIndex = 0;
-	
-	fRenderTarget[PRIMARY_FRAME_BUFFER] = new YRenderTarget(GL_RGBA, width, height);
-	fRenderTarget[SECONDARY_FRAME_BUFFER] = new YRenderTarget(GL_RGBA, width, height);
+	CreateFrameBuffers();
 	
 	UnlockGL();
 }
@@ -613,10 +1082,7 @@ RenderView :: ~RenderView()
 {
 	LockGL();
 	delete fCamera;
-	for (int i=0; i < kNumberBitmapBuffers; i++)
-		delete fOpenGlBitmap[i];
-	delete fRenderTarget[PRIMARY_FRAME_BUFFER];
-	delete fRenderTarget[SECONDARY_FRAME_BUFFER];
+	DestroyFrameBuffers();
 	UnlockGL();
 	YDestroyFileManager();	
 }
@@ -629,10 +1095,7 @@ RenderView :: ~RenderView()
 void RenderView :: ResetViewport()
 {
 	delete fCamera;
-	for (int i=0; i < kNumberBitmapBuffers; i++)
-		delete fOpenGlBitmap[i];
-	delete fRenderTarget[PRIMARY_FRAME_BUFFER];
-	delete fRenderTarget[SECONDARY_FRAME_BUFFER];
+	DestroyFrameBuffers();
 
 	const float width = gProject->mResolution.width;
 	const float height = gProject->mResolution.height;
@@ -641,13 +1104,107 @@ void RenderView :: ResetViewport()
 	fCamera->mSpatial.SetPosition(ymath::YVector3(0.5f*width, 0.5f*height, width));
 	fCamera->SetDirection(ymath::YVector3(0, 0, -1));
 
+	CreateFrameBuffers();
+}
+
+/*	FUNCTION:		RenderView :: CreateFrameBuffers
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	Create readback buffers and project resolution frame buffer set
+*/
+void RenderView :: CreateFrameBuffers()
+{
+	for (int i=0; i < kNumberPreviewScales; i++)
+		fFrameBufferSet[i] = nullptr;
+	fPreviewScale = 0;
+	fBitmapIndex = 0;
+	for (int fb=0; fb < NUMBER_FRAME_BUFFERS; fb++)
+	{
+		fRenderTargetIndex[fb] = 0;
+		fRenderTargetDepth[fb] = 0;
+	}
+	CreateFrameBufferSet(0);
+
+	fReadbackSize = fFrameBufferSet[0]->texture_bitmap->BitsLength();
+	glGenBuffers(kNumberReadbackBuffers, fReadbackBuffer);
+	for (int i=0; i < kNumberReadbackBuffers; i++)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, fReadbackBuffer[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, fReadbackSize, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	fReadbackIndex = 0;
+}
+
+/*	FUNCTION:		RenderView :: CreateFrameBufferSet
+	ARGUMENTS:		scale (0 = project resolution, 1 = 1/2, 2 = 1/4)
+	RETURN:			n/a
+	DESCRIPTION:	Create ping-pong render targets and readback bitmaps for preview scale
+*/
+void RenderView :: CreateFrameBufferSet(const int scale)
+{
+	assert((scale >= 0) && (scale < kNumberPreviewScales));
+	assert(fFrameBufferSet[scale] == nullptr);
+
+	const int width = std::max(int(gProject->mResolution.width >> scale), 1);
+	const int height = std::max(int(gProject->mResolution.height >> scale), 1);
+
+	FRAME_BUFFER_SET *set = new FRAME_BUFFER_SET;
 	BRect glFrame(0, 0, width-1, height-1);
 	for (int i=0; i < kNumberBitmapBuffers; i++)
-		fOpenGlBitmap[i] = new BBitmap(glFrame, B_RGB32);
-	fBitmapIndex = 0;
+		set->bitmap[i] = new BBitmap(glFrame, B_RGB32);
+	set->texture_bitmap = new BBitmap(glFrame, B_RGB32);
 
-	fRenderTarget[PRIMARY_FRAME_BUFFER] = new YRenderTarget(GL_RGBA, width, height);
-	fRenderTarget[SECONDARY_FRAME_BUFFER] = new YRenderTarget(GL_RGBA, width, height);
+	for (int fb=0; fb < NUMBER_FRAME_BUFFERS; fb++)
+	{
+		for (int i=0; i < 2; i++)
+			set->render_target[fb][i] = new YRenderTarget(GL_RGBA, width, height);
+	}
+	fFrameBufferSet[scale] = set;
+	DEBUG("RenderView::CreateFrameBufferSet(%d) %dx%d\n", scale, width, height);
+}
+
+/*	FUNCTION:		RenderView :: DestroyFrameBuffers
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	Destroy render targets and readback bitmaps
+*/
+void RenderView :: DestroyFrameBuffers()
+{
+	glDeleteBuffers(kNumberReadbackBuffers, fReadbackBuffer);
+
+	for (int s=0; s < kNumberPreviewScales; s++)
+	{
+		FRAME_BUFFER_SET *set = fFrameBufferSet[s];
+		if (!set)
+			continue;
+		for (int i=0; i < kNumberBitmapBuffers; i++)
+			delete set->bitmap[i];
+		delete set->texture_bitmap;
+		for (int fb=0; fb < NUMBER_FRAME_BUFFERS; fb++)
+		{
+			for (int i=0; i < 2; i++)
+				delete set->render_target[fb][i];
+		}
+		delete set;
+		fFrameBufferSet[s] = nullptr;
+	}
+}
+
+/*	FUNCTION:		RenderView :: SetPreviewScale
+	ARGUMENTS:		scale (0 = project resolution, 1 = 1/2, 2 = 1/4)
+	RETURN:			n/a
+	DESCRIPTION:	Select frame buffer set (only between frames, no frame buffer active)
+*/
+void RenderView :: SetPreviewScale(const int scale)
+{
+	assert((scale >= 0) && (scale < kNumberPreviewScales));
+	assert((fRenderTargetDepth[PRIMARY_FRAME_BUFFER] == 0) && (fRenderTargetDepth[SECONDARY_FRAME_BUFFER] == 0));
+	if (scale == fPreviewScale)
+		return;
+	if (!fFrameBufferSet[scale])
+		CreateFrameBufferSet(scale);
+	fPreviewScale = scale;
 }
 
 /*	FUNCTION:		MedoOpenGlView :: ErrorCallback
@@ -673,18 +1230,34 @@ void RenderView :: ErrorCallback(unsigned long errorCode)
 /*	FUNCTION:		RenderView :: ActivateFrameBuffer
 	ARGUMENTS:		target
 					clear
+					is_alpha_clear
 	RETURN:			n/a
-	DESCRIPTION:	Activate frame buffer
+	DESCRIPTION:	Activate frame buffer.
+					The outermost activation switches to the other ping-pong target, so the previous
+					target texture remains a valid effect source.  When not clearing, the previous
+					content is copied (GPU side) to preserve compositing.
+					Nested activation (eg. effect using its own passes) reuses the active target.
 */
 void RenderView :: ActivateFrameBuffer(FRAME_BUFFER target, const bool clear, const bool is_alpha_clear)
 {
 	if (++fBitmapIndex > 1)
 		fBitmapIndex = 0;
 
+	FRAME_BUFFER_SET *set = fFrameBufferSet[fPreviewScale];
+	if (fRenderTargetDepth[target]++ == 0)
+	{
+		YRenderTarget *previous = set->render_target[target][fRenderTargetIndex[target]];
+		fRenderTargetIndex[target] ^= 1;
+		if (!clear && !is_alpha_clear)
+			previous->CopyTo(set->render_target[target][fRenderTargetIndex[target]]);
+	}
+
+	YRenderTarget *render_target = set->render_target[target][fRenderTargetIndex[target]];
+	glViewport(0, 0, render_target->GetWidth(), render_target->GetHeight());
 	if (is_alpha_clear)
-		fRenderTarget[target]->ActivateTransparentBuffer();
+		render_target->ActivateTransparentBuffer();
 	else
-		fRenderTarget[target]->Activate(clear);
+		render_target->Activate(clear);
 	if (target == PRIMARY_FRAME_BUFFER)
 		fCamera->Render(0.0f);
 }
@@ -696,7 +1269,22 @@ void RenderView :: ActivateFrameBuffer(FRAME_BUFFER target, const bool clear, co
 */
 void RenderView :: DeactivateFrameBuffer(FRAME_BUFFER target)
 {
-	fRenderTarget[target]->Deactivate();	
+	assert(fRenderTargetDepth[target] > 0);
+	--fRenderTargetDepth[target];
+	fFrameBufferSet[fPreviewScale]->render_target[target][fRenderTargetIndex[target]]->Deactivate();
+}
+
+/*	FUNCTION:		RenderView :: ClearFrameBuffer
+	ARGUMENTS:		target
+	RETURN:			n/a
+	DESCRIPTION:	Clear active frame buffer in place
+*/
+void RenderView :: ClearFrameBuffer(FRAME_BUFFER target)
+{
+	assert(fRenderTargetDepth[target] > 0);
+	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+	if (target == PRIMARY_FRAME_BUFFER)
+		fCamera->Render(0.0f);
 }
 
 /*	FUNCTION:		RenderView :: GetFrameBufferBitmap
@@ -706,7 +1294,76 @@ void RenderView :: DeactivateFrameBuffer(FRAME_BUFFER target)
 */
 BBitmap * RenderView :: GetFrameBufferBitmap(FRAME_BUFFER target, GLenum format)
 {
-	fRenderTarget[target]->BindTexture();
-	glGetTexImage(GL_TEXTURE_2D, 0, format, GL_UNSIGNED_BYTE, fOpenGlBitmap[fBitmapIndex]->Bits());
-	return fOpenGlBitmap[fBitmapIndex];
+	FRAME_BUFFER_SET *set = fFrameBufferSet[fPreviewScale];
+	set->render_target[target][fRenderTargetIndex[target]]->BindTexture();
+	glGetTexImage(GL_TEXTURE_2D, 0, format, GL_UNSIGNED_BYTE, set->bitmap[fBitmapIndex]->Bits());
+	return set->bitmap[fBitmapIndex];
+}
+
+/*	FUNCTION:		RenderView :: GetFrameBufferTexture
+	ARGUMENTS:		target
+	RETURN:			YTexture (owned by render target)
+	DESCRIPTION:	Get frame buffer texture which is safe to sample (GPU resident).
+					When target is active, this is the previous ping-pong target (content before current pass).
+*/
+yrender::YTexture * RenderView :: GetFrameBufferTexture(FRAME_BUFFER target)
+{
+	const int index = (fRenderTargetDepth[target] > 0) ? fRenderTargetIndex[target] ^ 1 : fRenderTargetIndex[target];
+	return fFrameBufferSet[fPreviewScale]->render_target[target][index]->GetTexture();
+}
+
+/*	FUNCTION:		RenderView :: GetTextureBitmap
+	ARGUMENTS:		texture
+					format
+	RETURN:			BBitmap
+	DESCRIPTION:	Readback texture (legacy effect fallback)
+*/
+BBitmap * RenderView :: GetTextureBitmap(yrender::YTexture *texture, GLenum format)
+{
+	yrender::yRenderState.BindTexture(GL_TEXTURE_2D, texture->GetTextureId(), GL_TEXTURE0);
+	BBitmap *bitmap = fFrameBufferSet[fPreviewScale]->texture_bitmap;
+	glGetTexImage(GL_TEXTURE_2D, 0, format, GL_UNSIGNED_BYTE, bitmap->Bits());
+	return bitmap;
+}
+
+/*	FUNCTION:		RenderView :: ReadbackBegin
+	ARGUMENTS:		target
+	RETURN:			pixel buffer index
+	DESCRIPTION:	Start asynchronous readback of frame buffer into next pixel pack buffer.
+					The GPU copy overlaps with CPU work until ReadbackEnd().
+*/
+int RenderView :: ReadbackBegin(FRAME_BUFFER target)
+{
+	if (++fReadbackIndex >= kNumberReadbackBuffers)
+		fReadbackIndex = 0;
+
+	assert(fPreviewScale == 0);
+	fFrameBufferSet[0]->render_target[target][fRenderTargetIndex[target]]->BindTexture();
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, fReadbackBuffer[fReadbackIndex]);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return fReadbackIndex;
+}
+
+/*	FUNCTION:		RenderView :: ReadbackEnd
+	ARGUMENTS:		buffer
+					destination
+	RETURN:			n/a
+	DESCRIPTION:	Complete asynchronous readback, copy pixel pack buffer to destination
+*/
+void RenderView :: ReadbackEnd(const int buffer, BBitmap *destination)
+{
+	assert((buffer >= 0) && (buffer < kNumberReadbackBuffers));
+	assert(destination != nullptr);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, fReadbackBuffer[buffer]);
+	const void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, fReadbackSize, GL_MAP_READ_BIT);
+	if (data)
+	{
+		memcpy(destination->Bits(), data, std::min(fReadbackSize, (size_t)destination->BitsLength()));
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else
+		printf("RenderView::ReadbackEnd() - cannot map pixel buffer\n");
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 }
@@ -11,6 +11,10 @@
 #include <GL/gl.h>
 #endif
 
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
 #ifndef _YARRA_ACTOR_H_
 #include "Actor/Actor.h"
 #endif
@@ -20,10 +24,20 @@ class BMessage;
 
 class EffectNode;
 class RenderView;
+class RenderGraph;
+class ColourFusion;
+class FrameCache;
+class TextureCache;
+class MediaSource;
+class SoftwareRender;
+class RenderStatistics;
+class MediaEffect;
+struct FRAME_ITEM;
 
 namespace yrender
 {
 	class YPicture;
+	class YTexture;
 };
 class PictureCache;
 
@@ -36,35 +50,78 @@ public:
 	void		AsyncInitOpenGlView(BRect frame);
 	void		AsyncCreateEffectNode(EffectNode *node);
 	void		AsyncPrepareFrame(bigtime_t frame_idx);
-	void		AsyncPlayFrame(bigtime_t frame_idx, Actor *completion, std::function<void()> behaviour);
+	void		AsyncPlayFrame(bigtime_t frame_idx, bigtime_t preload_idx, int preview_scale, Actor *completion, std::function<void()> behaviour);
 	void		AsyncPreloadFrame(bigtime_t frame_idx);
 	void		AsyncPrepareExportFrame(bigtime_t frame_idx, sem_id sem_signal, BBitmap **bitmap);
+	void		AsyncExportFrame(bigtime_t frame_idx, bigtime_t preload_idx, BBitmap *bitmap, sem_id sem_signal);
+	void		AsyncFlushExportFrame();
 	void		AsyncInvalidateTimelineEdit();
 	void		AsyncInvalidateProjectSettings(int32 sem_id);
+	void		AsyncInvalidateMediaSource(uint64 source_id);
 	void		WaitIdle();
 
 	yrender::YPicture	*GetPicture(const unsigned width, unsigned int height, BBitmap *source);
+	yrender::YPicture	*GetPicture(yrender::YTexture *source);
 
 	//	RenderTargets for EffectNodes (eg. Blur)
 	void		ActivateSecondaryRenderBuffer(const bool is_alpha_clear = false);
 	void		DeactivateSecondaryRenderBuffer();
 	BBitmap		*GetSecondaryFrameBufferTexture(GLenum format = GL_RGBA);
 	BBitmap		*GetBackgroundBitmap() {return fBackgroundBitmap;}
+	BBitmap		*GetClipFrameBitmap(MediaSource *source, const int64 frame_idx);
+	RenderStatistics	*GetStatistics() {return fStatistics;}		//	see RenderStatistics::GetSummary() (thread safe)
 	BBitmap		*GetCurrentFrameBufferTexture(GLenum format = GL_RGBA);
 	void		EffectResetPrimaryRenderBuffer();		//	caution, will reset compositing
 
+	//	GPU resident compositing (see EffectNode::RenderEffect(YTexture *))
+	yrender::YTexture	*GetCurrentFrameBufferTextureGPU();
+	BBitmap				*GetTextureBitmap(yrender::YTexture *texture, GLenum format = GL_RGBA);
+
 private:
-	BBitmap			*GetOutputFrame(int64 frame_idx);
+	BBitmap			*GetOutputFrame(int64 frame_idx, bool *composited = nullptr, int *readback_buffer = nullptr);
+	void			PrepareFrame(bigtime_t frame_idx, const int preview_scale, const bigtime_t preload_idx = -1);
+	void			SetPreviewScale(const int preview_scale);
+	void			PreloadFrame(bigtime_t frame_idx, const bool async);
+	void			CompleteExportReadback();
+	void			ReleaseClipFrames();
+	bool			RenderColourFusion(yrender::YTexture *source, const FRAME_ITEM &item, std::deque<FRAME_ITEM> &frame_items, int64 frame_idx);
 
 	RenderView		*fRenderView;
 	BBitmap			*fBackgroundBitmap;
 	PictureCache	*fPictureCache;
+	yrender::YPicture	*fTexturePicture;
+	RenderGraph		*fRenderGraph;
+	FrameCache		*fFrameCache;
+	TextureCache	*fTextureCache;
+
+	//	Clip bitmap being composited, GetPicture() returns resident texture (see TextureCache)
+	struct RESIDENT_SOURCE
+	{
+		BBitmap		*bitmap;
+		uint64		owner;			//	MediaSource::GetInstanceId()
+		int64		generation;
+	} fResidentSource;
+	//	Decoded clip frames (pinned in VideoManager) used by current and previous output frame (displayed by OutputView)
+	std::vector<BBitmap *>	fClipFrames[2];
+	ColourFusion	*fColourFusion;
+	std::vector<MediaEffect *>	fFusionEffects;
+	SoftwareRender	*fSoftwareRender;		//	--software-render (no OpenGL context)
+	RenderStatistics	*fStatistics;
+
+	//	Pipelined export, readback pending until next frame composited
+	struct EXPORT_READBACK
+	{
+		BBitmap		*bitmap;
+		sem_id		semaphore;
+		int			buffer;
+	} fExportReadback;
 
 	//	Messaging support
 	BMessage		*fPreviewMessage;
 	BMessage		*fMsgInvalidateTimelineEdit;
 };
 extern RenderActor	*gRenderActor;
+extern bool			gSoftwareRender;
 
 
 
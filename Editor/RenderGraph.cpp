@@ -0,0 +1,245 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Render graph (timeline compiled into render schedule)
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <algorithm>
+
+#include "Yarra/Platform.h"
+
+#include "Effects/Effect_Speed.h"
+
+#include "RenderGraph.h"
+#include "Project.h"
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+/*	FUNCTION:		RenderGraph :: RenderGraph
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+RenderGraph :: RenderGraph()
+	: fEditGeneration(0), fValid(false), fLastSpanIndex(0)
+{
+}
+
+/*	FUNCTION:		RenderGraph :: ~RenderGraph
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Destructor
+*/
+RenderGraph :: ~RenderGraph()
+{
+}
+
+/*	FUNCTION:		RenderGraph :: Invalidate
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Force compile on next GetSpan()
+*/
+void RenderGraph :: Invalidate()
+{
+	fValid = false;
+}
+
+/*	FUNCTION:		RenderGraph :: GetSpan
+	ARGS:			frame_idx
+	RETURN:			span containing frame_idx (nullptr if nothing to render)
+	DESCRIPTION:	Lookup render schedule for frame, compile if project was edited
+*/
+const RenderGraph::SPAN * RenderGraph :: GetSpan(const bigtime_t frame_idx)
+{
+	if (!fValid || (fEditGeneration != gProject->mEditGeneration))
+		Compile();
+
+	if (fSpans.empty())
+		return nullptr;
+
+	//	Playback is sequential, check previous span first
+	if (fLastSpanIndex < fSpans.size())
+	{
+		const SPAN &span = fSpans[fLastSpanIndex];
+		if ((frame_idx >= span.start) && (frame_idx < span.end))
+			return &span;
+	}
+
+	auto it = std::upper_bound(fSpans.begin(), fSpans.end(), frame_idx, [](const bigtime_t f, const SPAN &s) {return f < s.start;});
+	if (it == fSpans.begin())
+		return nullptr;
+	--it;
+	if (frame_idx >= it->end)
+		return nullptr;
+
+	fLastSpanIndex = it - fSpans.begin();
+	return &(*it);
+}
+
+/*	FUNCTION:		RenderGraph :: GetTrackFrame
+	ARGS:			span
+					track
+					frame_idx
+	RETURN:			track timeline frame
+	DESCRIPTION:	Apply track speed mapping (warning - not cumulative)
+*/
+const bigtime_t RenderGraph :: GetTrackFrame(const SPAN *span, TimelineTrack *track, const bigtime_t frame_idx) const
+{
+	for (auto &t : span->timelines)
+	{
+		if (t.track == track)
+			return ((Effect_Speed *)t.speed_effect->mEffectNode)->GetSpeedTime(frame_idx, t.speed_effect);
+	}
+	return frame_idx;
+}
+
+/*	FUNCTION:		RenderGraph :: GetFrameItems
+	ARGS:			span
+	RETURN:			work queue with span items (render order)
+	DESCRIPTION:	Effects consume chained items from the queue (EffectNode::RenderEffect),
+					so the queue is refilled for every frame.  The deque is a member to retain
+					its storage, valid until next GetFrameItems() or Compile().
+*/
+std::deque<FRAME_ITEM> & RenderGraph :: GetFrameItems(const SPAN *span)
+{
+	fFrameItems.assign(span->items.begin(), span->items.end());
+	return fFrameItems;
+}
+
+/*	FUNCTION:		RenderGraph :: Compile
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Compile timeline into spans.
+					Span boundaries are clip/effect start/end frames, span content is found with
+					the TimelineTrack interval index.
+*/
+void RenderGraph :: Compile()
+{
+	double ts = yplatform::GetElapsedTime();
+
+	fEditGeneration = gProject->mEditGeneration;
+	fValid = true;
+	fLastSpanIndex = 0;
+	fFrameItems.clear();
+	fSpans.clear();
+
+	auto is_video_clip = [](const MediaClip &clip) -> bool
+	{
+		return clip.mVideoEnabled &&
+			((clip.mMediaSourceType == MediaSource::MEDIA_VIDEO) || (clip.mMediaSourceType == MediaSource::MEDIA_VIDEO_AND_AUDIO) || (clip.mMediaSourceType == MediaSource::MEDIA_PICTURE));
+	};
+
+	std::vector<TimelineTrack *> tracks;
+	std::vector<bigtime_t> boundaries;
+	std::vector<MediaClip> clips;
+	std::vector<MediaEffect *> active_effects;
+
+	//	Reverse iterate tracks (render order)
+	for (std::vector<TimelineTrack *>::const_reverse_iterator t = gProject->mTimelineTracks.rbegin(); t < gProject->mTimelineTracks.rend(); ++t)
+	{
+		if (!(*t)->mVideoEnabled)
+			continue;
+
+		tracks.push_back(*t);
+		(*t)->FindClips(0, INT64_MAX, clips);		//	copies (mClips may be reallocated by the window thread)
+		for (auto &clip : clips)
+		{
+			if (is_video_clip(clip))
+			{
+				boundaries.push_back(clip.mTimelineFrameStart);
+				boundaries.push_back(clip.GetTimelineEndFrame());
+			}
+		}
+		(*t)->FindEffects(0, INT64_MAX, active_effects);
+		for (auto e : active_effects)
+		{
+			if (e->mEnabled)
+			{
+				boundaries.push_back(e->mTimelineFrameStart);
+				boundaries.push_back(e->mTimelineFrameEnd);
+			}
+		}
+	}
+
+	std::sort(boundaries.begin(), boundaries.end());
+	boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+	std::vector<FRAME_ITEM> effects;
+	for (size_t b=0; b + 1 < boundaries.size(); b++)
+	{
+		const bigtime_t frame_idx = boundaries[b];
+		SPAN span;
+		span.start = frame_idx;
+		span.end = boundaries[b + 1];
+		span.clips.reserve(tracks.size());		//	max one clip per track, items point into span.clips
+
+		for (auto track : tracks)
+		{
+			//	Clips (first valid clip in track order)
+			track->FindClips(frame_idx, frame_idx + 1, clips);
+			for (auto &clip : clips)
+			{
+				if (is_video_clip(clip))
+				{
+					span.clips.push_back(clip);
+					span.items.emplace_back(FRAME_ITEM(track, &span.clips.back(), nullptr, false));
+					break;
+				}
+			}
+
+			//	Effects (track order)
+			track->FindEffects(frame_idx, frame_idx + 1, active_effects);
+			bool use_secondary_buffer = false;
+			for (auto e : active_effects)
+			{
+				if (!e->mEnabled)
+					continue;
+
+				if (e->Type() == MediaEffect::MEDIA_EFFECT_IMAGE)
+				{
+					effects.emplace_back(FRAME_ITEM(track, nullptr, e, e->mEffectNode->UseSecondaryFrameBuffer()));
+					if (e->mEffectNode->UseSecondaryFrameBuffer())
+						use_secondary_buffer = true;
+				}
+
+				//	timeline - warning not cumulative
+				if (e->mEffectNode->IsSpeedEffect())
+				{
+					if (!span.timelines.empty() && (span.timelines.back().track == track))
+						span.timelines.back().speed_effect = e;
+					else
+						span.timelines.push_back({track, e});
+				}
+			}
+			if (!effects.empty())
+			{
+				if (effects.size() > 1)
+				{
+					std::stable_sort(effects.begin(), effects.end(), [](const FRAME_ITEM &a, const FRAME_ITEM &b){return a.effect->mPriority < b.effect->mPriority;});
+
+					//	If one effect requires secondary buffer, all effects + clip render to secondary frame buffer
+					if (use_secondary_buffer && !span.items.empty() && span.items.back().clip && (span.items.back().track == track))
+					{
+						span.items.back().secondary_framebuffer = true;
+						for (auto &e : effects)
+							e.secondary_framebuffer = true;
+					}
+				}
+				for (auto &e : effects)
+					span.items.emplace_back(e);
+			}
+			effects.clear();
+		}
+
+		if (!span.items.empty())
+			fSpans.emplace_back(std::move(span));
+	}
+
+	DEBUG("RenderGraph::Compile() generation=%u, spans=%lu, %fms\n", fEditGeneration, fSpans.size(), 1000.0*(yplatform::GetElapsedTime() - ts));
+}
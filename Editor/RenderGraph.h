@@ -0,0 +1,73 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Render graph (timeline compiled into render schedule)
+ */
+
+#ifndef _RENDER_GRAPH_H_
+#define _RENDER_GRAPH_H_
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _GLIBCXX_DEQUE
+#include <deque>
+#endif
+
+#ifndef EFFECT_NODE_H
+#include "EffectNode.h"
+#endif
+
+#ifndef _PROJECT_H_
+#include "Project.h"
+#endif
+
+class TimelineTrack;
+class MediaEffect;
+
+/*****************************
+	The timeline is compiled into a list of spans (time between clip/effect boundaries).
+	Each span holds the precomputed render schedule (clips, effects, frame buffer assignment
+	and speed mapping), so per frame work is a lookup.
+	Compile only occurs when the Project edit generation changes.
+	Clips are copied into the span at compile time (the window thread reallocates
+	TimelineTrack::mClips on insert/erase), FRAME_ITEM::clip points to the span copy.
+	Accessed only from the RenderActor thread.
+******************************/
+class RenderGraph
+{
+public:
+	struct TRACK_TIMELINE
+	{
+		TimelineTrack		*track;
+		MediaEffect			*speed_effect;
+	};
+	struct SPAN
+	{
+		bigtime_t					start;
+		bigtime_t					end;
+		std::vector<FRAME_ITEM>		items;			//	render order
+		std::vector<MediaClip>		clips;			//	snapshot, referenced by items
+		std::vector<TRACK_TIMELINE>	timelines;		//	tracks with speed effect
+	};
+
+					RenderGraph();
+					~RenderGraph();
+
+	void			Invalidate();
+	const SPAN		*GetSpan(const bigtime_t frame_idx);
+	const bigtime_t	GetTrackFrame(const SPAN *span, TimelineTrack *track, const bigtime_t frame_idx) const;
+	std::deque<FRAME_ITEM>	&GetFrameItems(const SPAN *span);
+
+private:
+	void			Compile();
+
+	std::vector<SPAN>	fSpans;
+	std::deque<FRAME_ITEM>	fFrameItems;		//	compositing work queue, storage reused between frames
+	uint32				fEditGeneration;
+	bool				fValid;
+	size_t				fLastSpanIndex;
+};
+
+#endif	//#ifndef _RENDER_GRAPH_H_
@@ -0,0 +1,386 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Render timing statistics (decode / upload / effects / readback)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+
+#include "Yarra/Platform.h"
+#include "Yarra/Render/RenderState.h"
+
+#include "RenderStatistics.h"
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+/*	FUNCTION:		RenderStatistics :: RenderStatistics
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+RenderStatistics :: RenderStatistics()
+	: fGeneration(0), fFrameCount(0), fFrameStart(0.0), fGlCalls(0), fGlSkipped(0),
+	  fActiveIndex(0), fActiveGeneration(0), fActiveStart(0.0), fActive(false), fActiveGpu(false),
+	  fGpuFrameIndex(0), fGpuTimers(false)
+{
+	if ((fLock = create_sem(1, "RenderStatistics")) < B_OK)
+	{
+		printf("RenderStatistics() Cannot create semaphore\n");
+		exit(1);
+	}
+	for (int i=0; i < kGpuFrames; i++)
+	{
+		fGpuFrames[i].used = 0;
+		fGpuFrames[i].generation = 0;
+	}
+}
+
+/*	FUNCTION:		RenderStatistics :: ~RenderStatistics
+	ARGS:			n/a
+	RETURN:			n/a
+	DESCRIPTION:	Destructor (DestroyGpuTimers() must be called while GL context valid)
+*/
+RenderStatistics :: ~RenderStatistics()
+{
+	delete_sem(fLock);
+}
+
+/*	FUNCTION:		RenderStatistics :: InitGpuTimers
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Enable GPU timing if GL timestamp queries available (GL 3.3 / ARB_timer_query)
+*/
+void RenderStatistics :: InitGpuTimers()
+{
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	fGpuTimers = false;
+	if ((major > 3) || ((major == 3) && (minor >= 3)))
+	{
+		GLint bits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+		fGpuTimers = (bits > 0);
+	}
+	for (int i=0; i < kGpuFrames; i++)
+		fGpuFrames[i].used = 0;
+	fGpuFrameIndex = 0;
+	printf("[RenderStatistics]         GPU timers %s\n", fGpuTimers ? "enabled" : "not available");
+}
+
+/*	FUNCTION:		RenderStatistics :: DestroyGpuTimers
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Delete GL query objects
+*/
+void RenderStatistics :: DestroyGpuTimers()
+{
+	for (int i=0; i < kGpuFrames; i++)
+	{
+		GPU_FRAME &frame = fGpuFrames[i];
+		if (!frame.queries.empty())
+			glDeleteQueries(frame.queries.size(), frame.queries.data());
+		frame.queries.clear();
+		frame.statistics.clear();
+		frame.used = 0;
+	}
+	fGpuTimers = false;
+}
+
+/*	FUNCTION:		RenderStatistics :: ResolveGpuTimers
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Start GPU frame.  The query slot is reused from kGpuFrames ago, results are collected
+					if available (otherwise discarded, never wait for GPU).
+*/
+void RenderStatistics :: ResolveGpuTimers()
+{
+	if (!fGpuTimers)
+		return;
+
+	if (++fGpuFrameIndex >= kGpuFrames)
+		fGpuFrameIndex = 0;
+	GPU_FRAME &frame = fGpuFrames[fGpuFrameIndex];
+	if (frame.used > 0)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(frame.queries[2*frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			while (acquire_sem(fLock) == B_INTERRUPTED) ;
+			for (size_t i=0; (i < frame.used) && (frame.generation == fGeneration); i++)
+			{
+				GLuint64 start, end;
+				glGetQueryObjectui64v(frame.queries[2*i], GL_QUERY_RESULT, &start);
+				glGetQueryObjectui64v(frame.queries[2*i + 1], GL_QUERY_RESULT, &end);
+				STATISTIC &statistic = fStatistics[frame.statistics[i]];
+				const float ms = (end > start) ? float(end - start)*1e-6f : 0.0f;
+				statistic.gpu_ms = (statistic.gpu_ms < 0.0f) ? ms : 0.9f*statistic.gpu_ms + 0.1f*ms;
+				statistic.total_gpu_ms += ms;
+			}
+			release_sem(fLock);
+		}
+		else
+			DEBUG("RenderStatistics::ResolveGpuTimers() results not available, discarded\n");
+	}
+	frame.used = 0;
+}
+
+/*	FUNCTION:		RenderStatistics :: GetStatistic
+	ARGS:			stage
+					key (stable id, unique per stage)
+					label
+	RETURN:			index into fStatistics
+	DESCRIPTION:	Find or create statistic (lock held)
+*/
+size_t RenderStatistics :: GetStatistic(const STAGE stage, const uint64 key, const char *label)
+{
+	auto it = fStatisticIndex.find(std::make_pair((int)stage, key));
+	if (it != fStatisticIndex.end())
+		return it->second;
+
+	STATISTIC statistic;
+	statistic.stage = stage;
+	statistic.label = label ? label : "";
+	statistic.number_samples = 0;
+	statistic.sample_index = 0;
+	statistic.gpu_ms = -1.0f;
+	statistic.last_frame = fFrameCount;
+	statistic.count = 0;
+	statistic.total_ms = 0.0;
+	statistic.total_gpu_ms = 0.0;
+	fStatistics.push_back(statistic);
+	fStatisticIndex[std::make_pair((int)stage, key)] = fStatistics.size() - 1;
+	return fStatistics.size() - 1;
+}
+
+/*	FUNCTION:		RenderStatistics :: AddSample
+	ARGS:			statistic
+					ms
+	RETURN:			n/a
+	DESCRIPTION:	Add sample to rolling window and totals (lock held)
+*/
+void RenderStatistics :: AddSample(STATISTIC &statistic, const float ms)
+{
+	statistic.samples[statistic.sample_index] = ms;
+	if (++statistic.sample_index >= kWindowSamples)
+		statistic.sample_index = 0;
+	if (statistic.number_samples < kWindowSamples)
+		statistic.number_samples++;
+	statistic.last_frame = fFrameCount;
+	statistic.count++;
+	statistic.total_ms += ms;
+}
+
+/*	FUNCTION:		RenderStatistics :: BeginFrame
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Start frame measurement
+*/
+void RenderStatistics :: BeginFrame()
+{
+	fFrameCount++;
+	fFrameStart = yplatform::GetElapsedTime();
+	yrender::yRenderState.ResetCounters();
+}
+
+/*	FUNCTION:		RenderStatistics :: EndFrame
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Record total frame time and GL call count
+*/
+void RenderStatistics :: EndFrame()
+{
+	const float ms = 1000.0f*float(yplatform::GetElapsedTime() - fFrameStart);
+	while (acquire_sem(fLock) == B_INTERRUPTED) ;
+	AddSample(fStatistics[GetStatistic(STAGE_FRAME, 0, "Frame")], ms);
+	fGlCalls = yrender::yRenderState.GetCallCount();
+	fGlSkipped = yrender::yRenderState.GetSkippedCount();
+	release_sem(fLock);
+}
+
+/*	FUNCTION:		RenderStatistics :: GetGlCalls
+	ARGS:			calls
+					skipped
+	RETURN:			via calls / skipped
+	DESCRIPTION:	GL state changes sent / skipped (redundant) during last frame
+*/
+void RenderStatistics :: GetGlCalls(int &calls, int &skipped)
+{
+	while (acquire_sem(fLock) == B_INTERRUPTED) ;
+	calls = fGlCalls;
+	skipped = fGlSkipped;
+	release_sem(fLock);
+}
+
+/*	FUNCTION:		RenderStatistics :: Begin
+	ARGS:			stage
+					key (stable id, eg. MediaSource or MediaEffect instance id)
+					label
+					gpu (issue GPU timestamp, GL context locked)
+	RETURN:			n/a
+	DESCRIPTION:	Start measurement (measurements are not nested)
+*/
+void RenderStatistics :: Begin(const STAGE stage, const uint64 key, const char *label, const bool gpu)
+{
+	assert(!fActive);
+	while (acquire_sem(fLock) == B_INTERRUPTED) ;
+	fActiveIndex = GetStatistic(stage, key, label);
+	fActiveGeneration = fGeneration;
+	release_sem(fLock);
+	fActive = true;
+	fActiveGpu = gpu && fGpuTimers;
+
+	if (fActiveGpu)
+	{
+		GPU_FRAME &frame = fGpuFrames[fGpuFrameIndex];
+		if (frame.generation != fActiveGeneration)
+		{
+			//	Reset() since frame started, earlier query pairs refer to discarded statistics
+			frame.used = 0;
+			frame.generation = fActiveGeneration;
+		}
+		if (2*frame.used + 2 > frame.queries.size())
+		{
+			const size_t previous = frame.queries.size();
+			frame.queries.resize(previous + 32);
+			glGenQueries(32, frame.queries.data() + previous);
+			frame.statistics.resize(frame.queries.size()/2);
+		}
+		frame.statistics[frame.used] = fActiveIndex;
+		glQueryCounter(frame.queries[2*frame.used], GL_TIMESTAMP);
+	}
+	fActiveStart = yplatform::GetElapsedTime();
+}
+
+/*	FUNCTION:		RenderStatistics :: End
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Complete measurement
+*/
+void RenderStatistics :: End()
+{
+	assert(fActive);
+	const float ms = 1000.0f*float(yplatform::GetElapsedTime() - fActiveStart);
+	if (fActiveGpu)
+	{
+		GPU_FRAME &frame = fGpuFrames[fGpuFrameIndex];
+		glQueryCounter(frame.queries[2*frame.used + 1], GL_TIMESTAMP);
+		frame.used++;
+	}
+	fActive = false;
+
+	while (acquire_sem(fLock) == B_INTERRUPTED) ;
+	if (fActiveGeneration == fGeneration)
+		AddSample(fStatistics[fActiveIndex], ms);
+	release_sem(fLock);
+}
+
+/*	FUNCTION:		RenderStatistics :: GetSummary
+	ARGS:			summary (output, sorted by stage, then average time)
+					recent_only (skip entries not sampled within kWindowSamples frames)
+	RETURN:			n/a
+	DESCRIPTION:	Thread safe snapshot
+*/
+void RenderStatistics :: GetSummary(std::vector<SUMMARY> &summary, const bool recent_only)
+{
+	summary.clear();
+	while (acquire_sem(fLock) == B_INTERRUPTED) ;
+	for (auto &i : fStatistics)
+	{
+		if ((i.number_samples == 0) || (recent_only && (fFrameCount - i.last_frame > kWindowSamples)))
+			continue;
+
+		SUMMARY s;
+		s.stage = i.stage;
+		s.label = i.label;
+		float total = 0.0f;
+		s.max_ms = 0.0f;
+		for (int k=0; k < i.number_samples; k++)
+		{
+			total += i.samples[k];
+			s.max_ms = std::max(s.max_ms, i.samples[k]);
+		}
+		s.average_ms = total/i.number_samples;
+		s.gpu_ms = i.gpu_ms;
+		s.count = i.count;
+		s.total_ms = i.total_ms;
+		s.gpu_total_ms = (i.gpu_ms >= 0.0f) ? i.total_gpu_ms : -1.0;
+		summary.push_back(s);
+	}
+	release_sem(fLock);
+
+	std::sort(summary.begin(), summary.end(), [](const SUMMARY &a, const SUMMARY &b)
+	{
+		if (a.stage != b.stage)
+			return a.stage < b.stage;
+		return a.average_ms > b.average_ms;
+	});
+}
+
+/*	FUNCTION:		RenderStatistics :: Reset
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Clear all statistics (eg. start of export), any thread.
+					Active measurement and GPU queries in flight are discarded (generation).
+*/
+void RenderStatistics :: Reset()
+{
+	while (acquire_sem(fLock) == B_INTERRUPTED) ;
+	fStatistics.clear();
+	fStatisticIndex.clear();
+	fGeneration++;
+	release_sem(fLock);
+}
+
+/*	FUNCTION:		RenderStatistics :: GetStageName
+	ARGS:			stage
+	RETURN:			name
+	DESCRIPTION:	Stage description (CSV / overlay)
+*/
+const char * RenderStatistics :: GetStageName(const STAGE stage)
+{
+	static const char *kStageNames[NUMBER_STAGES] = {"Frame", "Decode", "Upload", "Effect", "Readback"};
+	assert((stage >= 0) && (stage < NUMBER_STAGES));
+	return kStageNames[stage];
+}
+
+/*	FUNCTION:		RenderStatistics :: WriteCsv
+	ARGS:			filename
+	RETURN:			true if successful
+	DESCRIPTION:	Write totals since Reset() (export timing summary)
+*/
+bool RenderStatistics :: WriteCsv(const char *filename)
+{
+	FILE *file = fopen(filename, "w");
+	if (!file)
+	{
+		printf("RenderStatistics::WriteCsv(%s) - cannot create file\n", filename);
+		return false;
+	}
+
+	std::vector<SUMMARY> summary;
+	GetSummary(summary, false);
+
+	fprintf(file, "stage,label,count,total_ms,average_ms,gpu_total_ms,gpu_average_ms\n");
+	for (auto &s : summary)
+	{
+		std::string label = s.label;
+		std::replace(label.begin(), label.end(), '"', '\'');
+		fprintf(file, "%s,\"%s\",%ld,%.3f,%.3f,", GetStageName(s.stage), label.c_str(), s.count, s.total_ms, s.count > 0 ? s.total_ms/s.count : 0.0);
+		if (s.gpu_total_ms >= 0.0)
+			fprintf(file, "%.3f,%.3f\n", s.gpu_total_ms, s.count > 0 ? s.gpu_total_ms/s.count : 0.0);
+		else
+			fprintf(file, ",\n");
+	}
+	fclose(file);
+	printf("[RenderStatistics] Timing summary: %s\n", filename);
+	return true;
+}
@@ -0,0 +1,130 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Render timing statistics (decode / upload / effects / readback)
+ */
+
+#ifndef _RENDER_STATISTICS_H_
+#define _RENDER_STATISTICS_H_
+
+#ifndef __gl_h_
+#include <GL/gl.h>
+#endif
+
+#ifndef _GLIBCXX_MAP
+#include <map>
+#endif
+
+#ifndef _GLIBCXX_STRING
+#include <string>
+#endif
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _OS_H
+#include <kernel/OS.h>
+#endif
+
+/*****************************
+	RenderStatistics records the time spent in each stage of GetOutputFrame():
+		- decode (per media source, includes waiting for preload actor)
+		- upload (per media source, texture upload and draw)
+		- effect (per MediaEffect instance)
+		- readback (composited frame buffer)
+	Entries are keyed by stage and a stable id (MediaSource/MediaEffect::GetInstanceId(), never reused),
+	since addresses of deleted sources and effects are reused.
+	CPU time is always measured.  When GL timestamp queries are available, GPU time is measured
+	with query pairs which are resolved several frames later (never stalls the pipeline).
+	Each entry keeps a rolling window of recent samples (average / max), plus totals since Reset()
+	for the export summary (WriteCsv()).
+	The number of GL state changes sent / skipped by yrender::yRenderState is sampled per frame.
+	Samples are recorded on the RenderActor thread, GetSummary(), Reset() and WriteCsv() may be called
+	from any thread (not posted to RenderActor, since RenderActor::PrepareFrame() clears pending messages).
+	Measurements in progress during Reset() are discarded (generation).
+******************************/
+class RenderStatistics
+{
+public:
+	enum STAGE {STAGE_FRAME, STAGE_DECODE, STAGE_UPLOAD, STAGE_EFFECT, STAGE_READBACK, NUMBER_STAGES};
+	static const int	kWindowSamples = 60;
+
+						RenderStatistics();
+						~RenderStatistics();
+
+	//	GL context must be locked
+	void				InitGpuTimers();
+	void				DestroyGpuTimers();
+	void				ResolveGpuTimers();
+
+	void				BeginFrame();
+	void				EndFrame();
+	void				Begin(const STAGE stage, const uint64 key, const char *label, const bool gpu = false);
+	void				End();
+
+	struct SUMMARY
+	{
+		STAGE			stage;
+		std::string		label;
+		float			average_ms;			//	rolling window
+		float			max_ms;				//	rolling window
+		float			gpu_ms;				//	rolling average, < 0 if not available
+		int64			count;				//	since Reset()
+		double			total_ms;			//	since Reset()
+		double			gpu_total_ms;		//	since Reset(), < 0 if not available
+	};
+	void				GetSummary(std::vector<SUMMARY> &summary, const bool recent_only = true);
+	void				Reset();
+	bool				WriteCsv(const char *filename);
+	void				GetGlCalls(int &calls, int &skipped);
+	static const char	*GetStageName(const STAGE stage);
+
+private:
+	struct STATISTIC
+	{
+		STAGE			stage;
+		std::string		label;
+		float			samples[kWindowSamples];
+		int				number_samples;
+		int				sample_index;
+		float			gpu_ms;
+		int64			last_frame;
+		int64			count;
+		double			total_ms;
+		double			total_gpu_ms;
+	};
+	std::vector<STATISTIC>		fStatistics;
+	std::map<std::pair<int, uint64>, size_t>	fStatisticIndex;
+	uint32				fGeneration;		//	incremented by Reset()
+	size_t				GetStatistic(const STAGE stage, const uint64 key, const char *label);
+	void				AddSample(STATISTIC &statistic, const float ms);
+
+	sem_id				fLock;
+	int64				fFrameCount;
+	double				fFrameStart;
+	int					fGlCalls;			//	last frame, see YRenderState
+	int					fGlSkipped;
+
+	//	Active measurement
+	size_t				fActiveIndex;
+	uint32				fActiveGeneration;
+	double				fActiveStart;
+	bool				fActive;
+	bool				fActiveGpu;
+
+	//	GPU timestamp query pairs, ring of frames in flight
+	enum {kGpuFrames = 4};
+	struct GPU_FRAME
+	{
+		std::vector<GLuint>		queries;
+		std::vector<size_t>		statistics;		//	index per query pair
+		size_t					used;			//	query pairs issued
+		uint32					generation;		//	statistics indices valid while equal to fGeneration
+	};
+	GPU_FRAME			fGpuFrames[kGpuFrames];
+	int					fGpuFrameIndex;
+	bool				fGpuTimers;
+};
+
+#endif	//#ifndef _RENDER_STATISTICS_H_
@@ -0,0 +1,624 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Software (CPU) render backend
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include <kernel/OS.h>
+#include <interface/Bitmap.h>
+
+#include "Yarra/Platform.h"
+#include "Yarra/Math/Math.h"
+#include "Yarra/Render/Camera.h"
+#include "Yarra/Render/MatrixStack.h"
+
+#include "SoftwareRender.h"
+#include "EffectNode.h"
+#include "Project.h"
+#include "RenderActor.h"
+#include "ParallelFor.h"
+
+#if defined (__GNUC__)
+	#if defined(__amd64__)
+		#define Y_CPU_X86
+	#endif
+#elif defined (_MSC_VER)
+	#define Y_CPU_X86
+#endif
+
+#ifdef Y_CPU_X86
+#include <emmintrin.h>
+#endif
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+using namespace yrender;
+
+/**************************************
+	SoftwareRender
+***************************************/
+
+/*	FUNCTION:		SoftwareRender::TEXTURE :: TEXTURE
+	ARGS:			bitmap (32 bit colour space)
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+SoftwareRender::TEXTURE :: TEXTURE(BBitmap *bitmap)
+{
+	assert((bitmap->ColorSpace() == B_RGBA32) || (bitmap->ColorSpace() == B_RGB32));
+	bits = (const uint8 *)bitmap->Bits();
+	bytes_per_row = bitmap->BytesPerRow();
+	width = bitmap->Bounds().IntegerWidth() + 1;
+	height = bitmap->Bounds().IntegerHeight() + 1;
+}
+
+/*	FUNCTION:		SoftwareRender :: SoftwareRender
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Constructor (RenderActor thread)
+*/
+SoftwareRender :: SoftwareRender()
+	: fCamera(nullptr), fSourceBitmap(nullptr), fScratchBitmap(nullptr)
+{
+	for (int i=0; i < NUMBER_FRAME_BUFFERS; i++)
+		fFrameBuffer[i] = nullptr;
+	for (int i=0; i <= kMaxPyramidLevels; i++)
+		fPyramidLevels[i] = nullptr;
+
+	CreateBuffers();
+}
+
+/*	FUNCTION:		SoftwareRender :: ~SoftwareRender
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Destructor
+*/
+SoftwareRender :: ~SoftwareRender()
+{
+	DestroyBuffers();
+}
+
+/*	FUNCTION:		SoftwareRender :: CreateBuffers
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create frame buffers and camera (project resolution)
+*/
+void SoftwareRender :: CreateBuffers()
+{
+	const float width = gProject->mResolution.width;
+	const float height = gProject->mResolution.height;
+	BRect frame(0, 0, width - 1, height - 1);
+	for (int i=0; i < NUMBER_FRAME_BUFFERS; i++)
+		fFrameBuffer[i] = new BBitmap(frame, B_RGBA32);
+	fSourceBitmap = new BBitmap(frame, B_RGBA32);
+	fScratchBitmap = new BBitmap(frame, B_RGBA32);
+
+	//	Same camera as RenderView
+	fCamera = new YCamera(YCamera::CAMERA_PERSPECTIVE, width, height);
+	fCamera->mSpatial.SetPosition(ymath::YVector3(0.5f*width, 0.5f*height, width));
+	fCamera->SetDirection(ymath::YVector3(0, 0, -1));
+}
+
+/*	FUNCTION:		SoftwareRender :: DestroyBuffers
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Destroy frame buffers and camera
+*/
+void SoftwareRender :: DestroyBuffers()
+{
+	for (int i=0; i < NUMBER_FRAME_BUFFERS; i++)
+	{
+		delete fFrameBuffer[i];
+		fFrameBuffer[i] = nullptr;
+	}
+	delete fSourceBitmap;
+	fSourceBitmap = nullptr;
+	delete fScratchBitmap;
+	fScratchBitmap = nullptr;
+	DestroyPyramid();
+	delete fCamera;
+	fCamera = nullptr;
+}
+
+/*	FUNCTION:		SoftwareRender :: Invalidate
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Project settings changed (resolution)
+*/
+void SoftwareRender :: Invalidate()
+{
+	DestroyBuffers();
+	CreateBuffers();
+}
+
+/*	FUNCTION:		SoftwareRender :: ParallelFor
+	ARGS:			count_rows
+					kernel
+	RETURN:			n/a
+	DESCRIPTION:	Split rows into tiles, process tiles on the shared worker pool (see ParallelFor.h).
+					Blocks until all tiles processed.
+*/
+void SoftwareRender :: ParallelFor(const int count_rows, const std::function<void(const int row_start, const int row_end)> &kernel)
+{
+	::ParallelFor(count_rows, kRowsPerTile, kernel);
+}
+
+/*	FUNCTION:		SoftwareRender :: BlendRow
+	ARGS:			destination (BGRA)
+					source (float BGRA)
+					count pixels
+	RETURN:			n/a
+	DESCRIPTION:	destination = source*source.a + destination*(1 - source.a)  (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+*/
+void SoftwareRender :: BlendRow(uint8 *destination, const float *source, const int count)
+{
+#ifdef Y_CPU_X86
+	const __m128 kZero = _mm_setzero_ps();
+	const __m128 kOne = _mm_set1_ps(1.0f);
+	const __m128 k255 = _mm_set1_ps(255.0f);
+	const __m128 kInv255 = _mm_set1_ps(1.0f/255.0f);
+	const __m128i kZeroInt = _mm_setzero_si128();
+	for (int i=0; i < count; i++, source += 4, destination += 4)
+	{
+		const __m128 src = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source), kZero), kOne);
+		const __m128 alpha = _mm_shuffle_ps(src, src, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i d = _mm_cvtsi32_si128(*(const int *)destination);
+		d = _mm_unpacklo_epi16(_mm_unpacklo_epi8(d, kZeroInt), kZeroInt);
+		const __m128 dst = _mm_mul_ps(_mm_cvtepi32_ps(d), kInv255);
+		const __m128 blend = _mm_add_ps(_mm_mul_ps(src, alpha), _mm_mul_ps(dst, _mm_sub_ps(kOne, alpha)));
+		__m128i out = _mm_cvtps_epi32(_mm_mul_ps(blend, k255));
+		out = _mm_packs_epi32(out, out);
+		out = _mm_packus_epi16(out, out);
+		*(int *)destination = _mm_cvtsi128_si32(out);
+	}
+#else
+	for (int i=0; i < count; i++, source += 4, destination += 4)
+	{
+		const float alpha = std::clamp(source[3], 0.0f, 1.0f);
+		for (int c=0; c < 4; c++)
+		{
+			const float value = std::clamp(source[c], 0.0f, 1.0f)*alpha + destination[c]*(1.0f/255.0f)*(1.0f - alpha);
+			destination[c] = (uint8)std::clamp(lrintf(value*255.0f), 0L, 255L);
+		}
+	}
+#endif
+}
+
+/*	FUNCTION:		SoftwareRender :: WriteRow
+	ARGS:			destination (BGRA)
+					source (float BGRA)
+					count pixels
+	RETURN:			n/a
+	DESCRIPTION:	destination = source (clamped and rounded, same as GL_RGBA8 render target)
+*/
+void SoftwareRender :: WriteRow(uint8 *destination, const float *source, const int count)
+{
+#ifdef Y_CPU_X86
+	const __m128 kZero = _mm_setzero_ps();
+	const __m128 k255 = _mm_set1_ps(255.0f);
+	for (int i=0; i < count; i++, source += 4, destination += 4)
+	{
+		const __m128 src = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(source), k255), kZero), k255);
+		__m128i out = _mm_cvtps_epi32(src);
+		out = _mm_packs_epi32(out, out);
+		out = _mm_packus_epi16(out, out);
+		*(int *)destination = _mm_cvtsi128_si32(out);
+	}
+#else
+	for (int i=0; i < 4*count; i++)
+		destination[i] = (uint8)std::clamp(lrintf(source[i]*255.0f), 0L, 255L);
+#endif
+}
+
+/*	FUNCTION:		SoftwareRender :: Clear
+	ARGS:			destination
+	RETURN:			n/a
+	DESCRIPTION:	Clear to transparent black (same as RenderView clear colour)
+*/
+void SoftwareRender :: Clear(BBitmap *destination)
+{
+	memset(destination->Bits(), 0, destination->BitsLength());
+}
+
+/*	FUNCTION:		SoftwareRender :: GetScratchBitmap
+	ARGS:			none
+	RETURN:			cleared project size bitmap
+	DESCRIPTION:	Intermediate render target for multi pass effects (valid until next call)
+*/
+BBitmap * SoftwareRender :: GetScratchBitmap()
+{
+	Clear(fScratchBitmap);
+	return fScratchBitmap;
+}
+
+/*	FUNCTION:		SoftwareRender :: GetPyramidLevel
+	ARGS:			level
+					width, height (level 0 size)
+	RETURN:			pyramid bitmap (width >> level, height >> level)
+	DESCRIPTION:	Create level bitmap on first use
+*/
+BBitmap * SoftwareRender :: GetPyramidLevel(const int level, const int width, const int height)
+{
+	assert((level >= 0) && (level <= kMaxPyramidLevels));
+	if (!fPyramidLevels[level])
+		fPyramidLevels[level] = new BBitmap(BRect(0, 0, std::max(width >> level, 1) - 1, std::max(height >> level, 1) - 1), B_RGBA32);
+	return fPyramidLevels[level];
+}
+
+/*	FUNCTION:		SoftwareRender :: DestroyPyramid
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Delete pyramid levels
+*/
+void SoftwareRender :: DestroyPyramid()
+{
+	for (int i=0; i <= kMaxPyramidLevels; i++)
+	{
+		delete fPyramidLevels[i];
+		fPyramidLevels[i] = nullptr;
+	}
+}
+
+/*	FUNCTION:		SoftwareRender :: PyramidPass
+	ARGS:			source
+					destination
+					offset
+					upsample
+	RETURN:			n/a
+	DESCRIPTION:	Equivalent of YBlurPyramid::RenderPass() (downsample / upsample shader taps).
+					Offsets are in units of uHalfPixel (0.5*offset/source size).
+*/
+void SoftwareRender :: PyramidPass(BBitmap *source, BBitmap *destination, const float offset, const bool upsample)
+{
+	struct TAP
+	{
+		float	x, y;
+		float	weight;
+	};
+	static const TAP kDownsample[] = {{0, 0, 4.0f/8.0f}, {-1, -1, 1.0f/8.0f}, {1, 1, 1.0f/8.0f}, {1, -1, 1.0f/8.0f}, {-1, 1, 1.0f/8.0f}};
+	static const TAP kUpsample[] = {{-2, 0, 1.0f/12.0f}, {-1, 1, 2.0f/12.0f}, {0, 2, 1.0f/12.0f}, {1, 1, 2.0f/12.0f},
+									{2, 0, 1.0f/12.0f}, {1, -1, 2.0f/12.0f}, {0, -2, 1.0f/12.0f}, {-1, -1, 2.0f/12.0f}};
+	const TAP *taps = upsample ? kUpsample : kDownsample;
+	const int count_taps = upsample ? sizeof(kUpsample)/sizeof(TAP) : sizeof(kDownsample)/sizeof(TAP);
+
+	const TEXTURE texture(source);
+	const float half_pixel_s = 0.5f*offset/texture.width;
+	const float half_pixel_t = 0.5f*offset/texture.height;
+	WriteFragments(destination, [&](const float s, const float t, float colour[4])
+	{
+		float sample[4];
+		colour[0] = colour[1] = colour[2] = colour[3] = 0.0f;
+		for (int i=0; i < count_taps; i++)
+		{
+			Sample(texture, s + taps[i].x*half_pixel_s, t + taps[i].y*half_pixel_t, sample);
+			for (int c=0; c < 4; c++)
+				colour[c] += taps[i].weight*sample[c];
+		}
+	});
+}
+
+/*	FUNCTION:		SoftwareRender :: BlurPyramid
+	ARGS:			source
+					radius (approximate gaussian sigma, source pixels)
+	RETURN:			blurred bitmap (owned by SoftwareRender, valid until next BlurPyramid()), or source if radius too small
+	DESCRIPTION:	CPU equivalent of YBlurPyramid::Render()
+*/
+BBitmap * SoftwareRender :: BlurPyramid(BBitmap *source, const float radius)
+{
+	const float kMinRadius = 0.5f;
+	const int kMinLevelSize = 2;
+	if (radius < kMinRadius)
+		return source;
+
+	if (fPyramidLevels[0] && (fPyramidLevels[0]->Bounds() != source->Bounds()))
+		DestroyPyramid();
+	const int width = source->Bounds().IntegerWidth() + 1;
+	const int height = source->Bounds().IntegerHeight() + 1;
+
+	//	Each level doubles the blur, offset (1.0 - 2.0) covers the remainder
+	int number_levels = std::clamp((int)ceilf(log2f(radius)), 1, kMaxPyramidLevels);
+	while ((number_levels > 1) && ((std::min(width, height) >> number_levels) < kMinLevelSize))
+		number_levels--;
+	const float offset = radius/float(1 << (number_levels - 1));
+
+	BBitmap *bitmap = source;
+	for (int level=1; level <= number_levels; level++)
+	{
+		BBitmap *target = GetPyramidLevel(level, width, height);
+		PyramidPass(bitmap, target, offset, false);
+		bitmap = target;
+	}
+	for (int level=number_levels - 1; level >= 0; level--)
+	{
+		BBitmap *target = GetPyramidLevel(level, width, height);
+		PyramidPass(bitmap, target, offset, true);
+		bitmap = target;
+	}
+	return bitmap;
+}
+
+/*	FUNCTION:		SoftwareRender :: Blend
+	ARGS:			destination
+					source (same dimensions)
+	RETURN:			n/a
+	DESCRIPTION:	Blend full screen source over destination (frame buffer transfer)
+*/
+void SoftwareRender :: Blend(BBitmap *destination, BBitmap *source)
+{
+	assert(destination->Bounds() == source->Bounds());
+	const int width = destination->Bounds().IntegerWidth() + 1;
+	const int height = destination->Bounds().IntegerHeight() + 1;
+	const TEXTURE texture(source);
+	uint8 *bits = (uint8 *)destination->Bits();
+	const int32 bytes_per_row = destination->BytesPerRow();
+
+	ParallelFor(height, [&](const int row_start, const int row_end)
+	{
+		std::vector<float> row(4*width);
+		for (int y=row_start; y < row_end; y++)
+		{
+			const uint8 *s = texture.bits + y*texture.bytes_per_row;
+			for (int x=0; x < 4*width; x++)
+				row[x] = s[x]*(1.0f/255.0f);
+			BlendRow(bits + y*bytes_per_row, row.data(), width);
+		}
+	});
+}
+
+/*	FUNCTION:		SoftwareRender :: DrawPicture
+	ARGS:			destination
+					source
+					mvp (transform of quad [-1, 1], texture coordinates [0, 1])
+	RETURN:			n/a
+	DESCRIPTION:	Equivalent of YPicture::Render().
+					The quad lies on the z=0 plane, so MVP columns 0, 1 and 3 form a homography
+					from quad to clip space.  The inverse homography maps pixels back to the quad.
+*/
+void SoftwareRender :: DrawPicture(BBitmap *destination, BBitmap *source, const ymath::YMatrix4 &mvp)
+{
+	const float *m = mvp.m;
+	const float h[9] = {m[0], m[4], m[12],
+						m[1], m[5], m[13],
+						m[3], m[7], m[15]};
+	const float det = h[0]*(h[4]*h[8] - h[5]*h[7]) - h[1]*(h[3]*h[8] - h[5]*h[6]) + h[2]*(h[3]*h[7] - h[4]*h[6]);
+	if (fabsf(det) < 1e-12f)
+		return;		//	edge on
+	const float inv_det = 1.0f/det;
+	const float inv[9] = {(h[4]*h[8] - h[5]*h[7])*inv_det, (h[2]*h[7] - h[1]*h[8])*inv_det, (h[1]*h[5] - h[2]*h[4])*inv_det,
+						  (h[5]*h[6] - h[3]*h[8])*inv_det, (h[0]*h[8] - h[2]*h[6])*inv_det, (h[2]*h[3] - h[0]*h[5])*inv_det,
+						  (h[3]*h[7] - h[4]*h[6])*inv_det, (h[1]*h[6] - h[0]*h[7])*inv_det, (h[0]*h[4] - h[1]*h[3])*inv_det};
+	const TEXTURE texture(source);
+
+	RenderFragments(destination, [&inv, &h, &texture](const float s, const float t, float colour[4])
+	{
+		const float nx = 2.0f*s - 1.0f;
+		const float ny = 2.0f*t - 1.0f;
+		const float w = inv[6]*nx + inv[7]*ny + inv[8];
+		const float qx = (inv[0]*nx + inv[1]*ny + inv[2])/w;
+		const float qy = (inv[3]*nx + inv[4]*ny + inv[5])/w;
+		if ((qx < -1.0f) || (qx > 1.0f) || (qy < -1.0f) || (qy > 1.0f) || (h[6]*qx + h[7]*qy + h[8] <= 0.0f))
+		{
+			colour[0] = colour[1] = colour[2] = colour[3] = 0.0f;	//	no contribution
+			return;
+		}
+		Sample(texture, 0.5f*(qx + 1.0f), 0.5f*(qy + 1.0f), colour);
+	});
+}
+
+/*	FUNCTION:		SoftwareRender :: GetSource
+	ARGS:			destination
+					source
+	RETURN:			source safe to sample while rendering into destination
+	DESCRIPTION:	Render in place requires a copy of the frame buffer (GPU ping-pong equivalent)
+*/
+BBitmap * SoftwareRender :: GetSource(BBitmap *destination, BBitmap *source)
+{
+	if (source != destination)
+		return source;
+	memcpy(fSourceBitmap->Bits(), source->Bits(), source->BitsLength());
+	return fSourceBitmap;
+}
+
+/*	FUNCTION:		SoftwareRender :: RenderClip
+	ARGS:			destination
+					source (clip frame)
+					frame_idx
+					frame_items
+	RETURN:			n/a
+	DESCRIPTION:	Equivalent of Effect_None::RenderPicture(), applies chained spatial transform or chained effect
+*/
+void SoftwareRender :: RenderClip(BBitmap *destination, BBitmap *source, const int64 frame_idx, std::deque<FRAME_ITEM> &frame_items)
+{
+	yMatrixStack.Push();
+	bool chained_spatial = false;
+	if (!frame_items.empty() && frame_items.front().effect)
+	{
+		MediaEffect *effect = frame_items.front().effect;
+		const EffectNode::EFFECT_GROUP group = effect->mEffectNode->GetEffectGroup();
+		if (effect->mEffectNode->IsSpatialTransform())
+		{
+			effect->mEffectNode->ChainedSpatialTransform(effect, frame_idx);
+			frame_items.pop_front();
+			chained_spatial = true;
+		}
+		else if ((group == EffectNode::EFFECT_COLOUR) || (group == EffectNode::EFFECT_IMAGE) ||
+				 (group == EffectNode::EFFECT_TRANSITION) || (group == EffectNode::EFFECT_SPECIAL))
+		{
+			frame_items.pop_front();
+			RenderEffect(destination, source, effect, frame_idx);
+			yMatrixStack.Pop();
+			return;
+		}
+	}
+
+	if (!chained_spatial)
+		yMatrixStack.Translate(0.5f*gProject->mResolution.width, 0.5f*gProject->mResolution.height, 0);
+	yMatrixStack.Scale(0.5f*(source->Bounds().IntegerWidth() + 1), 0.5f*(source->Bounds().IntegerHeight() + 1), 1);
+	DrawPicture(destination, source, yMatrixStack.GetMVPMatrix());
+	yMatrixStack.Pop();
+}
+
+/*	FUNCTION:		SoftwareRender :: RenderEffect
+	ARGS:			destination
+					source
+					effect
+					frame_idx
+	RETURN:			n/a
+	DESCRIPTION:	Spatial effects are generic (chained transform), other effects implement RenderEffectSoftware()
+*/
+void SoftwareRender :: RenderEffect(BBitmap *destination, BBitmap *source, MediaEffect *effect, const int64 frame_idx)
+{
+	EffectNode *node = effect->mEffectNode;
+	if (node->IsSpatialTransform())
+	{
+		yMatrixStack.Push();
+		node->ChainedSpatialTransform(effect, frame_idx);
+		yMatrixStack.Scale(0.5f*(source->Bounds().IntegerWidth() + 1), 0.5f*(source->Bounds().IntegerHeight() + 1), 1);
+		DrawPicture(destination, source, yMatrixStack.GetMVPMatrix());
+		yMatrixStack.Pop();
+		return;
+	}
+
+	if (!node->RenderEffectSoftware(this, destination, source, effect, frame_idx))
+	{
+		std::string key(node->GetVendorName());
+		key.append("/").append(node->GetEffectName());
+		if (fUnsupportedEffects.insert(key).second)
+			printf("SoftwareRender::RenderEffect(%s) - not supported, effect skipped\n", key.c_str());
+	}
+}
+
+/*	FUNCTION:		SoftwareRender :: Composite
+	ARGS:			render_graph
+					span
+					frame_idx
+	RETURN:			composited frame (nullptr if no frame buffer rendered)
+	DESCRIPTION:	CPU equivalent of RenderActor::GetOutputFrame()
+*/
+BBitmap * SoftwareRender :: Composite(RenderGraph *render_graph, const RenderGraph::SPAN *span, const int64 frame_idx)
+{
+	std::deque<FRAME_ITEM> &frame_items = render_graph->GetFrameItems(span);
+	const int64 kFrameReadGrace = kFramesSecond / (4.0*gProject->mResolution.frame_rate);
+
+	BBitmap *primary = fFrameBuffer[PRIMARY_FRAME_BUFFER];
+	BBitmap *secondary = fFrameBuffer[SECONDARY_FRAME_BUFFER];
+	bool initial_primary = true;
+	bool initial_secondary = true;
+	bool primary_valid = false;
+	bool secondary_valid = false;
+	bool secondary_transfer_pending = false;
+	double ts = yplatform::GetElapsedTime();
+
+	fCamera->Render(0.0f);
+	TimelineTrack *timeline_track = nullptr;
+	int64 timeline_frame_idx = frame_idx;
+	while (!frame_items.empty())
+	{
+		const FRAME_ITEM item = frame_items.front();
+		frame_items.pop_front();
+
+		if (!span->timelines.empty() && (item.track != timeline_track))
+		{
+			timeline_frame_idx = render_graph->GetTrackFrame(span, item.track, frame_idx);
+			timeline_track = item.track;
+		}
+
+		if (item.clip)
+		{
+			const MediaClip &clip = *item.clip;
+			int64 requested_frame = (timeline_frame_idx - clip.mTimelineFrameStart) + clip.mSourceFrameStart;
+			BBitmap *frame_bitmap;
+			if ((clip.mMediaSourceType == MediaSource::MEDIA_VIDEO) || (clip.mMediaSourceType == MediaSource::MEDIA_VIDEO_AND_AUDIO))
+				frame_bitmap = gRenderActor->GetClipFrameBitmap(clip.mMediaSource, requested_frame + kFrameReadGrace);
+			else
+				frame_bitmap = clip.mMediaSource->GetBitmap();
+
+			if (secondary_transfer_pending)
+			{
+				if (initial_primary)
+					Clear(primary);
+				Blend(primary, secondary);
+				initial_primary = false;
+				primary_valid = true;
+				secondary_transfer_pending = false;
+			}
+
+			if (!frame_bitmap)
+			{
+				printf("SoftwareRender::Composite(%ld) - cannot retrieve frame File: %s\n", frame_idx, clip.mMediaSource->GetFilename().String());
+				continue;
+			}
+
+			if (!item.secondary_framebuffer)
+			{
+				if (initial_primary)
+					Clear(primary);
+				RenderClip(primary, frame_bitmap, frame_idx, frame_items);
+				initial_primary = false;
+				primary_valid = true;
+			}
+			else
+			{
+				Clear(secondary);
+				RenderClip(secondary, frame_bitmap, frame_idx, frame_items);
+				initial_secondary = false;
+				secondary_valid = true;
+				secondary_transfer_pending = true;
+			}
+		}
+		else if (item.effect->Type() == MediaEffect::MEDIA_EFFECT_IMAGE)
+		{
+			if (item.effect->mEffectNode->IsSpatialTransform())
+				initial_primary = true;
+
+			BBitmap *source = gRenderActor->GetBackgroundBitmap();
+			BBitmap *destination;
+			if (!item.secondary_framebuffer)
+			{
+				if (primary_valid)
+					source = GetSource(primary, primary);
+				if (initial_primary)
+					Clear(primary);
+				destination = primary;
+				initial_primary = false;
+				primary_valid = true;
+			}
+			else
+			{
+				if (secondary_valid)
+					source = GetSource(secondary, secondary);
+				else if (primary_valid)
+					source = primary;
+				if (initial_secondary)
+					Clear(secondary);
+				destination = secondary;
+				initial_secondary = false;
+				secondary_valid = true;
+				secondary_transfer_pending = true;
+			}
+			RenderEffect(destination, source, item.effect, frame_idx);
+		}
+	}
+
+	if (secondary_transfer_pending)
+	{
+		if (initial_primary)
+			Clear(primary);
+		Blend(primary, secondary);
+		primary_valid = true;
+	}
+
+	DEBUG("SoftwareRender::Composite(%ld) %fms\n", frame_idx, 1000.0 * (yplatform::GetElapsedTime() - ts));
+	return primary_valid ? primary : nullptr;
+}
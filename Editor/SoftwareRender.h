@@ -0,0 +1,219 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	Software (CPU) render backend
+ */
+
+#ifndef _SOFTWARE_RENDER_H_
+#define _SOFTWARE_RENDER_H_
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _GLIBCXX_DEQUE
+#include <deque>
+#endif
+
+#ifndef _GLIBCXX_FUNCTIONAL
+#include <functional>
+#endif
+
+#ifndef _GLIBCXX_STRING
+#include <string>
+#endif
+
+#ifndef _GLIBCXX_UNORDERED_SET
+#include <unordered_set>
+#endif
+
+#ifndef _OS_H
+#include <kernel/OS.h>
+#endif
+
+#ifndef _BITMAP_H
+#include <interface/Bitmap.h>
+#endif
+
+#ifndef _RENDER_GRAPH_H_
+#include "RenderGraph.h"
+#endif
+
+class MediaEffect;
+
+namespace ymath
+{
+	class YMatrix4;
+};
+namespace yrender
+{
+	class YCamera;
+};
+
+/*****************************
+	SoftwareRender composites frames without an OpenGL context (see --software-render).
+	Output matches the GPU path within rounding tolerance:
+		- same camera / matrix stack (projection of picture quads is an exact homography)
+		- bilinear sampling with texel centres at 0.5, clamp to edge
+		- blending is (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) for all channels
+	Colour components are in memory order (BGRA), same as the effect shaders.
+	Kernels are split into row tiles and executed by the shared ParallelFor worker pool (the
+	caller also processes tiles).  Effects implement EffectNode::RenderEffectSoftware(),
+	unsupported effects are skipped (reported once per effect type).
+	BlurPyramid() is the CPU equivalent of YBlurPyramid (same levels, taps and RGBA8 intermediates).
+	Accessed only from the RenderActor thread.
+******************************/
+class SoftwareRender
+{
+public:
+	static const int	kRowsPerTile = 32;
+	static const int	kMaxPyramidLevels = 7;		//	same as YBlurPyramid::kMaxLevels
+
+	//	Sampler for fragment kernels (source must remain valid)
+	struct TEXTURE
+	{
+		const uint8		*bits;
+		int32			bytes_per_row;
+		int				width;
+		int				height;
+		TEXTURE(BBitmap *bitmap);
+	};
+
+						SoftwareRender();
+						~SoftwareRender();
+
+	BBitmap				*Composite(RenderGraph *render_graph, const RenderGraph::SPAN *span, const int64 frame_idx);
+	void				Invalidate();
+
+	//	Kernels for EffectNode::RenderEffectSoftware()
+	void				ParallelFor(const int count_rows, const std::function<void(const int row_start, const int row_end)> &kernel);
+	template <class F>
+	void				RenderFragments(BBitmap *destination, F fragment);
+	template <class F>
+	void				WriteFragments(BBitmap *destination, F fragment);
+	void				DrawPicture(BBitmap *destination, BBitmap *source, const ymath::YMatrix4 &mvp);
+	void				Blend(BBitmap *destination, BBitmap *source);
+	void				Clear(BBitmap *destination);
+	BBitmap				*GetScratchBitmap();
+	BBitmap				*BlurPyramid(BBitmap *source, const float radius);
+
+	static void			Sample(const TEXTURE &texture, const float s, const float t, float colour[4]);
+	static void			BlendRow(uint8 *destination, const float *source, const int count);
+	static void			WriteRow(uint8 *destination, const float *source, const int count);
+
+private:
+	enum FRAME_BUFFER {PRIMARY_FRAME_BUFFER, SECONDARY_FRAME_BUFFER, NUMBER_FRAME_BUFFERS};
+	void				CreateBuffers();
+	void				DestroyBuffers();
+	void				RenderClip(BBitmap *destination, BBitmap *source, const int64 frame_idx, std::deque<FRAME_ITEM> &frame_items);
+	void				RenderEffect(BBitmap *destination, BBitmap *source, MediaEffect *effect, const int64 frame_idx);
+	BBitmap				*GetSource(BBitmap *destination, BBitmap *source);
+	BBitmap				*GetPyramidLevel(const int level, const int width, const int height);
+	void				PyramidPass(BBitmap *source, BBitmap *destination, const float offset, const bool upsample);
+	void				DestroyPyramid();
+
+	yrender::YCamera	*fCamera;
+	BBitmap				*fFrameBuffer[NUMBER_FRAME_BUFFERS];
+	BBitmap				*fSourceBitmap;			//	effect source when rendering in place
+	BBitmap				*fScratchBitmap;		//	multi pass effects
+	BBitmap				*fPyramidLevels[kMaxPyramidLevels + 1];	//	[0] = full resolution result
+	std::unordered_set<std::string>		fUnsupportedEffects;	//	vendor + effect name
+};
+
+/*	FUNCTION:		SoftwareRender :: Sample
+	ARGS:			texture
+					s, t (normalised texture coordinates)
+					colour (BGRA, output)
+	RETURN:			n/a
+	DESCRIPTION:	Bilinear sample, clamp to edge (GL_LINEAR, GL_CLAMP_TO_EDGE)
+*/
+inline void SoftwareRender :: Sample(const TEXTURE &texture, const float s, const float t, float colour[4])
+{
+	const float x = s*texture.width - 0.5f;
+	const float y = t*texture.height - 0.5f;
+	int x0 = (int)x - (x < 0.0f ? 1 : 0);
+	int y0 = (int)y - (y < 0.0f ? 1 : 0);
+	const float fx = x - x0;
+	const float fy = y - y0;
+	int x1 = x0 + 1;
+	int y1 = y0 + 1;
+	x0 = x0 < 0 ? 0 : (x0 >= texture.width ? texture.width - 1 : x0);
+	x1 = x1 < 0 ? 0 : (x1 >= texture.width ? texture.width - 1 : x1);
+	y0 = y0 < 0 ? 0 : (y0 >= texture.height ? texture.height - 1 : y0);
+	y1 = y1 < 0 ? 0 : (y1 >= texture.height ? texture.height - 1 : y1);
+
+	const uint8 *p00 = texture.bits + y0*texture.bytes_per_row + 4*x0;
+	const uint8 *p10 = texture.bits + y0*texture.bytes_per_row + 4*x1;
+	const uint8 *p01 = texture.bits + y1*texture.bytes_per_row + 4*x0;
+	const uint8 *p11 = texture.bits + y1*texture.bytes_per_row + 4*x1;
+	for (int c=0; c < 4; c++)
+	{
+		const float top = p00[c] + fx*(p10[c] - p00[c]);
+		const float bottom = p01[c] + fx*(p11[c] - p01[c]);
+		colour[c] = (top + fy*(bottom - top))*(1.0f/255.0f);
+	}
+}
+
+/*	FUNCTION:		SoftwareRender :: RenderFragments
+	ARGS:			destination
+					fragment (void fn(float s, float t, float colour[4]), similar to fragment shader)
+	RETURN:			n/a
+	DESCRIPTION:	Evaluate fragment for every destination pixel (full screen quad), blend into destination.
+					Rows are processed in parallel, fragment must be thread safe.
+*/
+template <class F>
+void SoftwareRender :: RenderFragments(BBitmap *destination, F fragment)
+{
+	const int width = destination->Bounds().IntegerWidth() + 1;
+	const int height = destination->Bounds().IntegerHeight() + 1;
+	const int32 bytes_per_row = destination->BytesPerRow();
+	uint8 *bits = (uint8 *)destination->Bits();
+	const float inv_width = 1.0f/width;
+	const float inv_height = 1.0f/height;
+
+	ParallelFor(height, [&](const int row_start, const int row_end)
+	{
+		std::vector<float> row(4*width);
+		for (int y=row_start; y < row_end; y++)
+		{
+			const float t = (y + 0.5f)*inv_height;
+			float *p = row.data();
+			for (int x=0; x < width; x++, p += 4)
+				fragment((x + 0.5f)*inv_width, t, p);
+			BlendRow(bits + y*bytes_per_row, row.data(), width);
+		}
+	});
+}
+
+/*	FUNCTION:		SoftwareRender :: WriteFragments
+	ARGS:			destination
+					fragment (void fn(float s, float t, float colour[4]), similar to fragment shader)
+	RETURN:			n/a
+	DESCRIPTION:	Evaluate fragment for every destination pixel, replace destination (blending disabled).
+					Rows are processed in parallel, fragment must be thread safe.
+*/
+template <class F>
+void SoftwareRender :: WriteFragments(BBitmap *destination, F fragment)
+{
+	const int width = destination->Bounds().IntegerWidth() + 1;
+	const int height = destination->Bounds().IntegerHeight() + 1;
+	const int32 bytes_per_row = destination->BytesPerRow();
+	uint8 *bits = (uint8 *)destination->Bits();
+	const float inv_width = 1.0f/width;
+	const float inv_height = 1.0f/height;
+
+	ParallelFor(height, [&](const int row_start, const int row_end)
+	{
+		std::vector<float> row(4*width);
+		for (int y=row_start; y < row_end; y++)
+		{
+			const float t = (y + 0.5f)*inv_height;
+			float *p = row.data();
+			for (int x=0; x < width; x++, p += 4)
+				fragment((x + 0.5f)*inv_width, t, p);
+			WriteRow(bits + y*bytes_per_row, row.data(), width);
+		}
+	});
+}
+
+#endif	//#ifndef _SOFTWARE_RENDER_H_
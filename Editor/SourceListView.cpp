@@ -91,7 +91,9 @@ void SourceListItem :: CreateBitmap(MediaSource *media_source)
 			}
 			if (intensity / h > 256.0f*0.2f)
 				fBitmap = CreateThumbnail(frame, ceilf(kThumbnailWidth*kFontFactor), kThumbnailHeight*kFontFactor);
-			else
+			if (frame_idx > 0)
+				gVideoManager->ReleaseFrameBitmap(frame);
+			if (!fBitmap)
 			{
 				frame_idx += kFramesSecond;
 				if (frame_idx >= media_source->GetVideoDuration())
@@ -0,0 +1,192 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	GPU texture residency cache (source pictures / decoded frames)
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+
+#include <kernel/OS.h>
+#include <interface/Bitmap.h>
+
+#include "Yarra/Render/Texture.h"
+
+#include "TextureCache.h"
+
+#if 0
+#define DEBUG(...)	do {printf(__VA_ARGS__);} while (0)
+#else
+#define DEBUG(fmt, ...) {}
+#endif
+
+static const size_t kMinMemoryBudget = 128*1024*1024;
+static const size_t kMaxMemoryBudget = 1024UL*1024*1024;
+
+/*	FUNCTION:		TextureCache :: TextureCache
+	ARGS:			memory_budget (0 = derive from system memory)
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+TextureCache :: TextureCache(const size_t memory_budget)
+	: fMemoryUsed(0), fUseCounter(0), fFrameStart(0), fCountUploads(0), fCountHits(0)
+{
+	SetMemoryBudget(memory_budget);
+}
+
+/*	FUNCTION:		TextureCache :: ~TextureCache
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Destructor (GL context must be locked)
+*/
+TextureCache :: ~TextureCache()
+{
+	Clear();
+}
+
+/*	FUNCTION:		TextureCache :: SetMemoryBudget
+	ARGS:			bytes (0 = 1/16 of system memory)
+	RETURN:			n/a
+	DESCRIPTION:	Set VRAM budget, evict textures if exceeded
+*/
+void TextureCache :: SetMemoryBudget(const size_t bytes)
+{
+	if (bytes > 0)
+		fMemoryBudget = bytes;
+	else
+	{
+		system_info info;
+		get_system_info(&info);
+		fMemoryBudget = std::clamp((size_t)info.max_pages*B_PAGE_SIZE/16, kMinMemoryBudget, kMaxMemoryBudget);
+	}
+	while (fMemoryUsed > fMemoryBudget)
+	{
+		yrender::YTexture *texture = EvictLeastRecentlyUsed();
+		if (!texture)
+			break;
+		delete texture;
+	}
+}
+
+/*	FUNCTION:		TextureCache :: Clear
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Delete all textures (eg. GL context recreated)
+*/
+void TextureCache :: Clear()
+{
+	while (!fTextures.empty())
+		delete Evict(fTextures.begin());
+	DEBUG("TextureCache::Clear() uploads=%ld, hits=%ld\n", fCountUploads, fCountHits);
+}
+
+/*	FUNCTION:		TextureCache :: Invalidate
+	ARGS:			owner (id)
+	RETURN:			n/a
+	DESCRIPTION:	Delete all textures of owner (eg. MediaSource removed from project)
+*/
+void TextureCache :: Invalidate(const uint64 owner)
+{
+	auto it = fTextures.lower_bound(KEY(owner, INT64_MIN));
+	while ((it != fTextures.end()) && (it->first.first == owner))
+	{
+		auto next = std::next(it);
+		delete Evict(it);
+		it = next;
+	}
+}
+
+/*	FUNCTION:		TextureCache :: BeginFrame
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Textures used before this point may be evicted
+*/
+void TextureCache :: BeginFrame()
+{
+	fFrameStart = fUseCounter;
+}
+
+/*	FUNCTION:		TextureCache :: Evict
+	ARGS:			it
+	RETURN:			texture (caller deletes or recycles)
+	DESCRIPTION:	Remove entry
+*/
+yrender::YTexture * TextureCache :: Evict(std::map<KEY, TEXTURE>::iterator it)
+{
+	yrender::YTexture *texture = it->second.texture;
+	fMemoryUsed -= it->second.size;
+	fTextures.erase(it);
+	return texture;
+}
+
+/*	FUNCTION:		TextureCache :: EvictLeastRecentlyUsed
+	ARGS:			none
+	RETURN:			evicted texture (nullptr if every texture is used in current frame)
+	DESCRIPTION:	Remove least recently used entry
+*/
+yrender::YTexture * TextureCache :: EvictLeastRecentlyUsed()
+{
+	auto lru = fTextures.end();
+	for (auto it = fTextures.begin(); it != fTextures.end(); ++it)
+	{
+		if ((it->second.last_used <= fFrameStart) && ((lru == fTextures.end()) || (it->second.last_used < lru->second.last_used)))
+			lru = it;
+	}
+	if (lru == fTextures.end())
+		return nullptr;
+	DEBUG("TextureCache::EvictLeastRecentlyUsed(%p, %ld)\n", lru->first.first, lru->first.second);
+	return Evict(lru);
+}
+
+/*	FUNCTION:		TextureCache :: GetTexture
+	ARGS:			bitmap (content of owner/generation)
+					owner (id)
+					generation
+	RETURN:			resident texture (owned by cache, valid until next BeginFrame())
+	DESCRIPTION:	Upload bitmap only if content not resident
+*/
+yrender::YTexture * TextureCache :: GetTexture(BBitmap *bitmap, const uint64 owner, const int64 generation)
+{
+	assert(bitmap);
+	const unsigned int width = bitmap->Bounds().IntegerWidth() + 1;
+	const unsigned int height = bitmap->Bounds().IntegerHeight() + 1;
+
+	const KEY key(owner, generation);
+	auto it = fTextures.find(key);
+	if (it != fTextures.end())
+	{
+		yrender::YTexture *texture = it->second.texture;
+		if ((texture->GetWidth() == width) && (texture->GetHeight() == height))
+		{
+			it->second.last_used = ++fUseCounter;
+			fCountHits++;
+			return texture;
+		}
+		delete Evict(it);
+	}
+
+	//	Evict until budget satisfied, recycle texture with matching dimensions
+	const size_t size = 4*(size_t)width*height;
+	yrender::YTexture *texture = nullptr;
+	while (!fTextures.empty() && (fMemoryUsed + size > fMemoryBudget))
+	{
+		yrender::YTexture *evicted = EvictLeastRecentlyUsed();
+		if (!evicted)
+			break;
+		if (!texture && (evicted->GetWidth() == width) && (evicted->GetHeight() == height))
+			texture = evicted;
+		else
+			delete evicted;
+	}
+	if (!texture)
+		texture = new yrender::YTexture(width, height, yrender::YTexture::YTF_REPEAT);
+
+	texture->Upload(bitmap);
+	fTextures[key] = {texture, size, ++fUseCounter};
+	fMemoryUsed += size;
+	fCountUploads++;
+	DEBUG("TextureCache::GetTexture(%lu, %ld) upload, resident=%lu, memory=%luMB\n", owner, generation, fTextures.size(), fMemoryUsed/(1024*1024));
+	return texture;
+}
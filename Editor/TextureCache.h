@@ -0,0 +1,72 @@
+/*	PROJECT:		Medo
+ *	AUTHORS:		Zenja Solaja, Melbourne Australia
+ *	COPYRIGHT:		Zen Yes Pty Ltd, 2019-2021
+ *	DESCRIPTION:	GPU texture residency cache (source pictures / decoded frames)
+ */
+
+#ifndef _TEXTURE_CACHE_H_
+#define _TEXTURE_CACHE_H_
+
+#ifndef _GLIBCXX_MAP
+#include <map>
+#endif
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+#ifndef _SUPPORT_DEFS_H
+#include <support/SupportDefs.h>
+#endif
+
+class BBitmap;
+namespace yrender
+{
+	class YTexture;
+};
+
+/*****************************
+	TextureCache keeps uploaded textures resident, keyed by content identity:
+		- owner id (MediaSource::GetInstanceId(), never reused unlike addresses) and
+		  generation (eg. decoded video frame, 0 for still pictures)
+	A BBitmap pointer alone does not identify content (VideoManager recycles frame bitmaps),
+	so the caller supplies the content key.  Unchanged inputs are never re-uploaded.
+	Least recently used textures are evicted when the VRAM budget is exceeded, an evicted
+	texture with matching dimensions is recycled (no reallocation).
+	Textures used in the current frame are never evicted.
+	Accessed only from the RenderActor thread, GL context must be locked.
+******************************/
+class TextureCache
+{
+public:
+						TextureCache(const size_t memory_budget = 0);
+						~TextureCache();
+
+	void				BeginFrame();
+	yrender::YTexture	*GetTexture(BBitmap *bitmap, const uint64 owner, const int64 generation);
+	void				Invalidate(const uint64 owner);
+	void				Clear();
+	void				SetMemoryBudget(const size_t bytes);
+	const size_t		GetMemoryUsed() const	{return fMemoryUsed;}
+
+private:
+	typedef std::pair<uint64, int64>	KEY;
+	struct TEXTURE
+	{
+		yrender::YTexture	*texture;
+		size_t				size;
+		uint64				last_used;
+	};
+	std::map<KEY, TEXTURE>	fTextures;
+	yrender::YTexture		*EvictLeastRecentlyUsed();
+	yrender::YTexture		*Evict(std::map<KEY, TEXTURE>::iterator it);
+
+	size_t				fMemoryBudget;
+	size_t				fMemoryUsed;
+	uint64				fUseCounter;
+	uint64				fFrameStart;		//	fUseCounter at BeginFrame()
+	int64				fCountUploads;
+	int64				fCountHits;
+};
+
+#endif	//#ifndef _TEXTURE_CACHE_H_
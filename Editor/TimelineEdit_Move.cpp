@@ -6,6 +6,7 @@
  
 #include <cstdio>
 #include <cassert>
+#include <algorithm>
 
 #include <InterfaceKit.h>
 
@@ -441,7 +442,13 @@ void TimelineEdit :: MoveClipUpdate(BPoint point)
 		BBitmap *drag_bitmap = CreateDragDropClipBitmap(aRect);
 
 		double px = double(frame_idx - clip.mTimelineFrameStart)/(double)clip.Duration();
-		fActiveClip.track->mClips.erase(fActiveClip.track->mClips.begin() + fActiveClip.clip_idx);
+		const int64 invalid_start = clip.mTimelineFrameStart;
+		const int64 invalid_end = clip.GetTimelineEndFrame();
+		{
+			TimelineTrack::ContainerLock lock(fActiveClip.track);
+			fActiveClip.track->mClips.erase(fActiveClip.track->mClips.begin() + fActiveClip.clip_idx);
+		}
+		fActiveClip.track->InvalidateIndex(invalid_start, invalid_end);
 		fState = State::eIdle;
 
 		DragMessage(fMsgDragDropClip, drag_bitmap, BPoint(aRect.Width()*px, 20));		//	will autodestroy drag_bitmap
@@ -455,6 +462,13 @@ void TimelineEdit :: MoveClipUpdate(BPoint point)
 	if (clip.mMediaSource->GetMediaType() != MediaSource::MEDIA_AUDIO)
 		frame_index = CalculateStickyFrameIndex(frame_index, true);
 	int64 old_timeline_start = clip.mTimelineFrameStart;
+	int64 invalid_start = clip.mTimelineFrameStart;
+	int64 invalid_end = clip.GetTimelineEndFrame();
+	for (auto &i : fClipLinkedEffects)
+	{
+		invalid_start = std::min(invalid_start, i.effect->mTimelineFrameStart);
+		invalid_end = std::max(invalid_end, i.effect->mTimelineFrameEnd);
+	}
 	clip.mTimelineFrameStart = frame_index - fActiveClip.frame_idx;
 
 	//	Check for collision with neighbour clips
@@ -469,6 +483,7 @@ void TimelineEdit :: MoveClipUpdate(BPoint point)
 			if (move_delta < 0)
 			{
 				//	move left neighbours
+				invalid_start = 0;
 				for (int mi = 0; mi < fActiveClip.clip_idx; mi++)
 				{
 					fActiveClip.track->mClips[mi].mTimelineFrameStart += move_delta;
@@ -491,6 +506,7 @@ void TimelineEdit :: MoveClipUpdate(BPoint point)
 			if (move_delta > 0)
 			{
 				//	move right neighbours
+				invalid_end = Project::kEditRangeAll;
 				for (int mi = fActiveClip.track->mClips.size() - 1; mi >= fActiveClip.clip_idx + 1; mi--)
 				{
 					fActiveClip.track->mClips[mi].mTimelineFrameStart += move_delta;
@@ -507,10 +523,19 @@ void TimelineEdit :: MoveClipUpdate(BPoint point)
 	}
 
 	MoveClipLinkedEffects();
+	invalid_start = std::min(invalid_start, clip.mTimelineFrameStart);
+	invalid_end = std::max(invalid_end, clip.GetTimelineEndFrame());
+	for (auto &i : fClipLinkedEffects)
+	{
+		invalid_start = std::min(invalid_start, i.effect->mTimelineFrameStart);
+		invalid_end = std::max(invalid_end, i.effect->mTimelineFrameEnd);
+	}
+	fActiveClip.track->InvalidateIndex(invalid_start, invalid_end);
+
 	gProject->UpdateDuration();
 	fTimelineView->InvalidateItems(TimelineView::INVALIDATE_POSITION_SLIDER | TimelineView::INVALIDATE_HORIZONTAL_SLIDER);
 	Invalidate();
-	gProject->InvalidatePreview();
+	gProject->InvalidatePreview(invalid_start, invalid_end);
 }
 
 /*	FUNCTION:		TimelineEdit :: MoveEffectUpdate
@@ -559,7 +584,11 @@ void TimelineEdit :: MoveEffectUpdate(BPoint point)
 		drag_bitmap->Unlock();
 		DragMessage(fMsgDragDropEffect, drag_bitmap, BPoint(20, 20));		//	will autodestroy drag_bitmap
 
-		fActiveEffect.track->mEffects.erase(fActiveEffect.track->mEffects.begin() + fActiveEffect.effect_idx);
+		{
+			TimelineTrack::ContainerLock lock(fActiveEffect.track);
+			fActiveEffect.track->mEffects.erase(fActiveEffect.track->mEffects.begin() + fActiveEffect.effect_idx);
+		}
+		fActiveEffect.track->InvalidateIndex(effect->mTimelineFrameStart, effect->mTimelineFrameEnd);
 
 		fState = State::eIdle;
 		Invalidate();
@@ -573,6 +602,8 @@ void TimelineEdit :: MoveEffectUpdate(BPoint point)
 		frame_index = CalculateStickyFrameIndex(frame_index, true);
 
 	bigtime_t effect_duration = effect->Duration();
+	int64 invalid_start = effect->mTimelineFrameStart;
+	int64 invalid_end = effect->mTimelineFrameEnd;
 	effect->mTimelineFrameStart = frame_index - fActiveEffect.frame_idx;
 	effect->mTimelineFrameEnd = effect->mTimelineFrameStart + effect_duration;
 
@@ -629,10 +660,14 @@ void TimelineEdit :: MoveEffectUpdate(BPoint point)
 		}
 	}
 
+	invalid_start = std::min(invalid_start, effect->mTimelineFrameStart);
+	invalid_end = std::max(invalid_end, effect->mTimelineFrameEnd);
+	fActiveEffect.track->InvalidateIndex(invalid_start, invalid_end);
+
 	gProject->UpdateDuration();
 	Invalidate();
 	fTimelineView->InvalidateItems(TimelineView::INVALIDATE_POSITION_SLIDER | TimelineView::INVALIDATE_HORIZONTAL_SLIDER);
-	gProject->InvalidatePreview();
+	gProject->InvalidatePreview(invalid_start, invalid_end);
 }
 
 /*	FUNCTION:		TimelineEdit :: ResizeClipUpdate
@@ -657,6 +692,8 @@ void TimelineEdit :: ResizeClipUpdate(BPoint point)
 
 	int64 original_start = media_clip.mSourceFrameStart;
 	int64 original_end = media_clip.mSourceFrameEnd;
+	int64 invalid_start = media_clip.mTimelineFrameStart;
+	int64 invalid_end = media_clip.GetTimelineEndFrame();
 
 	if (fActiveResizeDirection == ResizeDirection::eLeft)
 	{
@@ -711,11 +748,14 @@ void TimelineEdit :: ResizeClipUpdate(BPoint point)
 			media_clip.mSourceFrameEnd = original_end;
 		}
 	}
+	invalid_start = std::min(invalid_start, media_clip.mTimelineFrameStart);
+	invalid_end = std::max(invalid_end, media_clip.GetTimelineEndFrame());
+	fActiveClip.track->InvalidateIndex(invalid_start, invalid_end);
 
 	gProject->UpdateDuration();
 	Invalidate();
 	fTimelineView->InvalidateItems(TimelineView::INVALIDATE_POSITION_SLIDER | TimelineView::INVALIDATE_HORIZONTAL_SLIDER);
-	gProject->InvalidatePreview();
+	gProject->InvalidatePreview(invalid_start, invalid_end);
 }
 
 /*	FUNCTION:		TimelineEdit :: ResizeEffectUpdate
@@ -733,6 +773,8 @@ void TimelineEdit :: ResizeEffectUpdate(BPoint point)
 	if (effect->Type() == MediaEffect::MEDIA_EFFECT_IMAGE)
 		frame_idx = CalculateStickyFrameIndex(frame_idx, fActiveResizeDirection == ResizeDirection::eLeft);
 
+	int64 invalid_start = effect->mTimelineFrameStart;
+	int64 invalid_end = effect->mTimelineFrameEnd;
 	if (fActiveResizeDirection == ResizeDirection::eLeft)
 	{
 		effect->mTimelineFrameStart = frame_idx;
@@ -789,11 +831,15 @@ void TimelineEdit :: ResizeEffectUpdate(BPoint point)
 			}
 		}
 	}
+	invalid_start = std::min(invalid_start, effect->mTimelineFrameStart);
+	invalid_end = std::max(invalid_end, effect->mTimelineFrameEnd);
+	if (fActiveEffect.track)
+		fActiveEffect.track->InvalidateIndex(invalid_start, invalid_end);
 
 	gProject->UpdateDuration();
 	Invalidate();
 	fTimelineView->InvalidateItems(TimelineView::INVALIDATE_POSITION_SLIDER | TimelineView::INVALIDATE_HORIZONTAL_SLIDER);
-	gProject->InvalidatePreview();
+	gProject->InvalidatePreview(invalid_start, invalid_end);
 }
 
 /*	FUNCTION:		TimelineEdit :: CalculateStickyFrameIndex
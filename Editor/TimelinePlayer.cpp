@@ -21,6 +21,10 @@
 #define DEBUG(...) {}
 #endif
 
+static const int	kMaxPreviewScale = 2;			//	1/4 resolution
+static const float	kHeadroomRatio = 0.25f;			//	next scale renders 4x pixels
+static const int	kHeadroomFrames = 15;			//	consecutive frames with headroom before increasing resolution
+
 /*	FUNCTION:		TimelinePlayer :: TimelinePlayer
 	ARGS:			frame
 	RETURN:			n/a
@@ -32,8 +36,19 @@ TimelinePlayer :: TimelinePlayer(MedoWindow *parent)
 	fTimelinePositionMessage = new BMessage(MedoWindow::eMsgActionAsyncTimelinePlayerUpdate);
 	fTimelinePositionMessage->AddInt64("Position", 0);
 	fTimelinePositionMessage->AddBool("Complete", false);
+	fTimelinePositionMessage->AddInt32("Dropped", 0);
+	fTimelinePositionMessage->AddInt32("Late", 0);
 
 	fPlaying = false;
+	fDroppedFrames = 0;
+	fLateFrames = 0;
+	fRenderEstimate = 0;
+	fTimerPending = false;
+	fRestartPending = false;
+	fPreviewScale = 0;
+	fRenderScale = 0;
+	fHeadroomFrames = 0;
+	fRenderPending = false;
 }
 
 /*	FUNCTION:		TimelinePlayer :: ~TimelinePlayer
@@ -69,16 +84,112 @@ void TimelinePlayer :: AsyncPlay(bigtime_t start, bigtime_t end, const bool repe
 	fEndPosition = end;
 	fRepeat = repeat;
 	fPlaying = true;
+	fHeadroomFrames = 0;
+	fDroppedFrames = 0;
+	fLateFrames = 0;
+	fRenderEstimate = 0;
+
+	yarra::ActorManager::GetInstance()->CancelTimers(this);
+	fTimerPending = false;
+	StartClock(start);
+
+	if (fRenderPending)
+		fRestartPending = true;		//	AsyncOutputComplete() will request start frame
+	else
+		PlayFrame();
+}
+
+/*	FUNCTION:		TimelinePlayer :: StartClock
+	ARGS:			position
+	RETURN:			n/a
+	DESCRIPTION:	Start master clock (audio output) at timeline position
+*/
+void TimelinePlayer :: StartClock(const bigtime_t position)
+{
+	fClockPosition = position;
+	fClockTimestamp = system_time();
+	gAudioManager->PlayPreview(position, fEndPosition);
+}
+
+/*	FUNCTION:		TimelinePlayer :: GetClockPosition
+	ARGS:			none
+	RETURN:			timeline position
+	DESCRIPTION:	Master clock is audio output position.
+					System time is used until audio output reports a position.
+*/
+const bigtime_t TimelinePlayer :: GetClockPosition() const
+{
+	int64 position;
+	if (gAudioManager->GetPreviewPosition(position))
+		return position;
+	return fClockPosition + (system_time() - fClockTimestamp)*kFramesSecond/1'000'000;
+}
 
+/*	FUNCTION:		TimelinePlayer :: PlayFrame
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Request RenderActor to display fCurrentPosition at current preview scale, and decode ahead the next frame
+*/
+void TimelinePlayer :: PlayFrame()
+{
 	fTimestamp = system_time();
+	fRenderScale = fPreviewScale;
+	fRenderPending = true;
+	const bigtime_t frame_time = kFramesSecond / gProject->mResolution.frame_rate;
+	const bigtime_t preload = (fCurrentPosition + frame_time < fEndPosition) ? fCurrentPosition + frame_time : (fRepeat ? fStartPosition : -1);
 	std::function<void()> render_complete = std::bind(&TimelinePlayer::AsyncOutputComplete, this);
-	gRenderActor->AsyncPriority<&RenderActor::AsyncPlayFrame>(fCurrentPosition, this, render_complete);
+	gRenderActor->AsyncPriority<&RenderActor::AsyncPlayFrame>(fCurrentPosition, preload, fPreviewScale, this, render_complete);
+}
+
+/*	FUNCTION:		TimelinePlayer :: UpdatePreviewScale
+	ARGS:			render_time
+					frame_time
+	RETURN:			n/a
+	DESCRIPTION:	Reduce preview resolution when deadline missed, increase when sufficient headroom
+*/
+void TimelinePlayer :: UpdatePreviewScale(const bigtime_t render_time, const bigtime_t frame_time)
+{
+	if (render_time > frame_time)
+	{
+		fHeadroomFrames = 0;
+		if (fPreviewScale < kMaxPreviewScale)
+		{
+			fPreviewScale++;
+			DEBUG("TimelinePlayer::UpdatePreviewScale() render=%ldus, scale=1/%d\n", render_time, 1 << fPreviewScale);
+		}
+	}
+	else if ((fPreviewScale > 0) && (render_time < kHeadroomRatio*frame_time))
+	{
+		if (++fHeadroomFrames >= kHeadroomFrames)
+		{
+			fHeadroomFrames = 0;
+			fPreviewScale--;
+			DEBUG("TimelinePlayer::UpdatePreviewScale() render=%ldus, scale=1/%d\n", render_time, 1 << fPreviewScale);
+		}
+	}
+	else
+		fHeadroomFrames = 0;
+}
+
+/*	FUNCTION:		TimelinePlayer :: RestorePreviewScale
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	When paused, redisplay reduced resolution frame at project resolution
+*/
+void TimelinePlayer :: RestorePreviewScale()
+{
+	if (fRenderScale > 0)
+	{
+		fRenderScale = 0;
+		gRenderActor->AsyncPriority<&RenderActor::AsyncPrepareFrame>(fCurrentPosition);
+	}
 }
 
 /*	FUNCTION:		TimelinePlayer :: AsyncSetFrame
 	ARGS:			frame_idx
 	RETURN:			n/a
-	DESCRIPTION:	Set current frame
+	DESCRIPTION:	Set current frame.
+					During playback the seeked frame is rendered next, and following frames are scheduled from it.
 */
 void TimelinePlayer :: AsyncSetFrame(bigtime_t frame_idx)
 {
@@ -89,6 +200,21 @@ void TimelinePlayer :: AsyncSetFrame(bigtime_t frame_idx)
 			fPlaying = false;
 		if ((fCurrentPosition < fStartPosition) && fRepeat)
 			fStartPosition = fCurrentPosition;
+		if (fPlaying)
+		{
+			StartClock(fCurrentPosition);
+			if (fTimerPending)
+			{
+				yarra::ActorManager::GetInstance()->CancelTimers(this);
+				fTimerPending = false;
+			}
+			if (fRenderPending)
+				fRestartPending = true;		//	AsyncOutputComplete() will request seeked frame
+			else
+				PlayFrame();
+		}
+		else
+			gAudioManager->StopPreview();
 	}
 	else
 		gRenderActor->AsyncPriority<&RenderActor::AsyncPrepareFrame>(fCurrentPosition);
@@ -103,52 +229,131 @@ void TimelinePlayer :: AsyncStop()
 {
 	DEBUG("TimelinePlayer::AsyncStop()\n");
 	fPlaying = false;
+	gAudioManager->StopPreview();
+	if (fTimerPending)
+	{
+		yarra::ActorManager::GetInstance()->CancelTimers(this);
+		fTimerPending = false;
+		PlaybackComplete();
+	}
+	//	else AsyncOutputComplete() completes playback
 }
 
 /*	FUNCTION:		TimelinePlayer :: AsyncOutputComplete
 	ARGS:			none
 	RETURN:			n/a
-	DESCRIPTION:	Called when RenderActor finished processing frame
-					Typically sleep for a couple of milliseconds
+	DESCRIPTION:	Called when RenderActor displayed frame (fCurrentPosition)
 */
 void TimelinePlayer :: AsyncOutputComplete()
 {
 	DEBUG("TimelinePlayer::AsyncOutputComplete()\n");
+	assert(fRenderPending);
+	fRenderPending = false;
 
 	const bigtime_t frame_time = kFramesSecond / gProject->mResolution.frame_rate;
-	bigtime_t ts = system_time();
-	bigtime_t duration = ts - fTimestamp;
-	if (duration > frame_time)
-		duration = frame_time;
-	if (duration < frame_time)
+	const bigtime_t render_time = system_time() - fTimestamp;
+	UpdatePreviewScale(render_time, frame_time);
+	fRenderEstimate = (fRenderEstimate > 0) ? (3*fRenderEstimate + render_time)/4 : render_time;
+
+	if (fRestartPending)
 	{
-		yarra::ActorManager::GetInstance()->AddTimer((frame_time - duration)/1000, {this, &TimelinePlayer::AsyncOutputComplete});
-		//	Preload next frame
-		gRenderActor->Async<&RenderActor::AsyncPreloadFrame>(fCurrentPosition + frame_time);
+		fRestartPending = false;
+		PlayFrame();
 		return;
 	}
 
-//	printf("%ld\n", ts - fTimestamp);
+	//	Presented after the next frame was due
+	if (GetClockPosition() - fCurrentPosition > frame_time)
+		fLateFrames++;
 
-	fCurrentPosition += frame_time;
-	if ((fCurrentPosition >= fEndPosition) && fRepeat)
-		fCurrentPosition = fStartPosition;
+	fTimelinePositionMessage->ReplaceInt64("Position", fCurrentPosition);
+	fTimelinePositionMessage->ReplaceBool("Complete", false);
+	fTimelinePositionMessage->ReplaceInt32("Dropped", fDroppedFrames);
+	fTimelinePositionMessage->ReplaceInt32("Late", fLateFrames);
+	fParentWindow->PostMessage(fTimelinePositionMessage);
 
-	int64 next_frame = fCurrentPosition + kFramesSecond/gProject->mResolution.frame_rate;
-	gAudioManager->PlayPreview(fCurrentPosition, next_frame);
+	ScheduleFrame();
+}
 
-	if (fPlaying && (fCurrentPosition < fEndPosition))
+/*	FUNCTION:		TimelinePlayer :: ScheduleFrame
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Select next frame based on master clock.
+					Frames which cannot be rendered before their presentation time are dropped.
+					A frame is requested ahead of its presentation time (estimated render time).
+*/
+void TimelinePlayer :: ScheduleFrame()
+{
+	if (!fPlaying)
 	{
-		fTimestamp = system_time();
-		std::function<void()> render_complete = std::bind(&TimelinePlayer::AsyncOutputComplete, this);
-		gRenderActor->AsyncPriority<&RenderActor::AsyncPlayFrame>(fCurrentPosition, this, render_complete);
-		fTimelinePositionMessage->ReplaceBool("Complete", false);
+		PlaybackComplete();
+		return;
 	}
-	else
+
+	const bigtime_t frame_time = kFramesSecond / gProject->mResolution.frame_rate;
+	const bigtime_t clock = GetClockPosition();
+	bigtime_t next = fCurrentPosition + frame_time;
+	const bigtime_t ready = clock + fRenderEstimate;
+	if (ready > next)
+	{
+		const int32 skip = (ready - next + frame_time - 1)/frame_time;
+		next += skip*frame_time;
+		fDroppedFrames += skip;
+		DEBUG("TimelinePlayer::ScheduleFrame() dropped %d frames (total=%d)\n", skip, int(fDroppedFrames));
+	}
+
+	if (next >= fEndPosition)
+	{
+		if (!fRepeat)
+		{
+			fPlaying = false;
+			PlaybackComplete();
+			return;
+		}
+		next = fStartPosition;
+		StartClock(next);
+	}
+	fCurrentPosition = next;
+
+	const bigtime_t wait = (fCurrentPosition - fRenderEstimate) - GetClockPosition();
+	if (wait >= 1000)
 	{
-		fPlaying = false;
-		fTimelinePositionMessage->ReplaceBool("Complete", true);
+		fTimerPending = true;
+		yarra::ActorManager::GetInstance()->AddTimer(wait/1000, {this, &TimelinePlayer::AsyncTimerComplete});
 	}
+	else
+		PlayFrame();
+}
+
+/*	FUNCTION:		TimelinePlayer :: AsyncTimerComplete
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Frame due for rendering
+*/
+void TimelinePlayer :: AsyncTimerComplete()
+{
+	if (!fTimerPending)
+		return;
+	fTimerPending = false;
+	if (fPlaying)
+		PlayFrame();
+	else
+		PlaybackComplete();
+}
+
+/*	FUNCTION:		TimelinePlayer :: PlaybackComplete
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Stop audio, restore preview resolution, notify parent
+*/
+void TimelinePlayer :: PlaybackComplete()
+{
+	DEBUG("TimelinePlayer::PlaybackComplete() dropped=%d, late=%d\n", int(fDroppedFrames), int(fLateFrames));
+	gAudioManager->StopPreview();
+	RestorePreviewScale();
 	fTimelinePositionMessage->ReplaceInt64("Position", fCurrentPosition);
+	fTimelinePositionMessage->ReplaceBool("Complete", true);
+	fTimelinePositionMessage->ReplaceInt32("Dropped", fDroppedFrames);
+	fTimelinePositionMessage->ReplaceInt32("Late", fLateFrames);
 	fParentWindow->PostMessage(fTimelinePositionMessage);
 }
@@ -27,6 +27,10 @@ public:
 	const bool	IsPlaying() const	{return fPlaying;}
 	const bool	IsRepeat() const	{return fRepeat;}
 
+	//	Playback statistics (since AsyncPlay)
+	const int32	GetDroppedFrames() const	{return fDroppedFrames;}
+	const int32	GetLateFrames() const		{return fLateFrames;}
+
 private:
 	bigtime_t		fCurrentPosition;
 	bigtime_t		fStartPosition;
@@ -35,10 +39,33 @@ private:
 	bool			fRepeat;
 	bool			fPlaying;
 
+	//	Adaptive preview resolution (0 = project resolution, 1 = 1/2, 2 = 1/4)
+	int				fPreviewScale;
+	int				fRenderScale;			//	scale of most recent AsyncPlayFrame
+	int				fHeadroomFrames;
+	bool			fRenderPending;
+
+	//	Master clock (audio output position, system time until audio reports position)
+	bigtime_t		fClockPosition;
+	bigtime_t		fClockTimestamp;
+	bigtime_t		fRenderEstimate;		//	moving average of render time
+	int32			fDroppedFrames;			//	skipped to stay in sync with clock
+	int32			fLateFrames;			//	presented after next frame was due
+	bool			fTimerPending;
+	bool			fRestartPending;
+
 	MedoWindow		*fParentWindow;
 	BMessage		*fTimelinePositionMessage;
 
 	void			AsyncOutputComplete();
+	void			AsyncTimerComplete();
+	void			ScheduleFrame();
+	void			PlaybackComplete();
+	void			StartClock(const bigtime_t position);
+	const bigtime_t	GetClockPosition() const;
+	void			PlayFrame();
+	void			UpdatePreviewScale(const bigtime_t render_time, const bigtime_t frame_time);
+	void			RestorePreviewScale();
 };
 
 
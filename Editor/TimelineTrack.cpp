@@ -6,8 +6,12 @@
 
 #include <cstring>
 #include <algorithm>
+#include <mutex>
+
+#include "Actor/Platform.h"
 
 #include "EffectNode.h"
+#include "IntervalIndex.h"
 #include "Project.h"
 #include "Language.h"
 
@@ -30,6 +34,11 @@ TimelineTrack :: TimelineTrack()
 	char buffer[32];
 	sprintf(buffer, "%s#%lu", GetText(TXT_TIMELINE_TRACK), ++kTrackCreationIndex);
 	mName.SetTo(buffer);
+
+	fClipIndex = new IntervalIndex;
+	fEffectIndex = new IntervalIndex;
+	fIndexLock = new yarra::yplatform::SpinLock;
+	fIndexValid = false;
 }
 
 /*	FUNCTION:		TimelineTrack :: ~TimelineTrack
@@ -41,6 +50,10 @@ TimelineTrack :: ~TimelineTrack()
 {
 	for (auto i : mEffects)
 		delete i;
+
+	delete fClipIndex;
+	delete fEffectIndex;
+	delete fIndexLock;
 }
 
 /*	FUNCTION:		TimelineTrack :: AddClip
@@ -55,7 +68,11 @@ const int32 TimelineTrack :: AddClip(MediaClip &clip)
 	{
 		if (clip.mTimelineFrameStart < (*i).mTimelineFrameStart)
 		{
-			mClips.insert(i, clip);
+			{
+				ContainerLock lock(this);
+				mClips.insert(i, clip);
+			}
+			InvalidateIndex(clip.mTimelineFrameStart, clip.GetTimelineEndFrame());
 			RepositionClips();
 			return clip_index;
 		}
@@ -71,17 +88,27 @@ const int32 TimelineTrack :: AddClip(MediaClip &clip)
 					//	midpoint before, insert after
 					clip.mTimelineFrameStart = end_point;
 					i++;
-					if (i != mClips.end())
-						mClips.insert(i, clip);
-					else
-						mClips.push_back(clip);
+					{
+						ContainerLock lock(this);
+						if (i != mClips.end())
+							mClips.insert(i, clip);
+						else
+							mClips.push_back(clip);
+					}
 					clip_index++;
+					InvalidateIndex(clip.mTimelineFrameStart, clip.GetTimelineEndFrame());
 				}
 				else
 				{
 					//	midpoint after, insert before
+					const int64 invalid_start = std::min((*i).mTimelineFrameStart, clip.mTimelineFrameStart);
 					(*i).mTimelineFrameStart = clip.mTimelineFrameStart + clip.Duration();
-					mClips.insert(i, clip);
+					const int64 invalid_end = (*i).GetTimelineEndFrame();
+					{
+						ContainerLock lock(this);
+						mClips.insert(i, clip);
+					}
+					InvalidateIndex(invalid_start, invalid_end);
 				}
 				RepositionClips();
 				return clip_index;
@@ -90,7 +117,11 @@ const int32 TimelineTrack :: AddClip(MediaClip &clip)
 		clip_index++;
 	}
 	//	push back, no need to reposition
-	mClips.push_back(clip);
+	{
+		ContainerLock lock(this);
+		mClips.push_back(clip);
+	}
+	InvalidateIndex(clip.mTimelineFrameStart, clip.GetTimelineEndFrame());
 	gProject->UpdateDuration();
 	return clip_index;
 }
@@ -107,7 +138,12 @@ void TimelineTrack :: RemoveClip(MediaClip &clip, const bool remove_effects)
 	{
 		if (clip == *c)
 		{
-			mClips.erase(c);
+			const int64 invalid_start = c->mTimelineFrameStart;
+			const int64 invalid_end = c->GetTimelineEndFrame();
+			{
+				ContainerLock lock(this);
+				mClips.erase(c);
+			}
 
 			if (remove_effects)
 			{
@@ -117,18 +153,23 @@ void TimelineTrack :: RemoveClip(MediaClip &clip, const bool remove_effects)
 					repeat = false;
 					for (std::vector<MediaEffect *>::iterator e = mEffects.begin(); e != mEffects.end(); e++)
 					{
-						if ((((*e)->mTimelineFrameStart >= clip.mTimelineFrameStart) && ((*e)->mTimelineFrameStart < clip.GetTimelineEndFrame()))	&&
-							((*e)->mTimelineFrameEnd <= clip.GetTimelineEndFrame()))
+						if ((((*e)->mTimelineFrameStart >= invalid_start) && ((*e)->mTimelineFrameStart < invalid_end))	&&
+							((*e)->mTimelineFrameEnd <= invalid_end))
 						{
 							(*e)->mEffectNode->MediaEffectSelectedBase(nullptr);
-							delete *e;
-							mEffects.erase(e);
+							MediaEffect *effect = *e;
+							{
+								ContainerLock lock(this);
+								mEffects.erase(e);
+							}
+							delete effect;
 							repeat = true;
 							break;
 						}
 					}
 				} while (repeat);
 			}
+			InvalidateIndex(invalid_start, invalid_end);
 			break;
 		}
 	}
@@ -145,8 +186,20 @@ void TimelineTrack :: RepositionClips(const bool compact)
 	if (mClips.empty())
 		return;
 
+	//	Modified range (old and new position of moved clips)
+	int64 invalid_start = INT64_MAX;
+	int64 invalid_end = 0;
+	auto move_clip = [&invalid_start, &invalid_end](MediaClip &clip, const int64 timeline_start)
+	{
+		if (clip.mTimelineFrameStart == timeline_start)
+			return;
+		invalid_start = std::min(invalid_start, std::min(clip.mTimelineFrameStart, timeline_start));
+		invalid_end = std::max(invalid_end, std::max(clip.mTimelineFrameStart, timeline_start) + clip.Duration());
+		clip.mTimelineFrameStart = timeline_start;
+	};
+
 	if (compact)
-		mClips[0].mTimelineFrameStart = 0;
+		move_clip(mClips[0], 0);
 	int64 end_pos = mClips[0].GetTimelineEndFrame();
 
 	for (size_t i =1; i < mClips.size(); i++)
@@ -154,16 +207,18 @@ void TimelineTrack :: RepositionClips(const bool compact)
 		int64 clip_duration = mClips[i].Duration();
 		if (compact)
 		{
-			mClips[i].mTimelineFrameStart = end_pos;
+			move_clip(mClips[i], end_pos);
 			end_pos += clip_duration;
 		}
 		else
 		{
 			if (mClips[i].mTimelineFrameStart < end_pos)
-				mClips[i].mTimelineFrameStart = end_pos;
+				move_clip(mClips[i], end_pos);
 			end_pos = mClips[i].mTimelineFrameStart + clip_duration;
 		}
 	}
+	if (invalid_start < invalid_end)
+		InvalidateIndex(invalid_start, invalid_end);
 	gProject->UpdateDuration();
 }
 
@@ -178,7 +233,7 @@ void TimelineTrack :: SplitClip(MediaClip &clip, int64 frame_idx)
 	clip.mSourceFrameEnd = clip.mSourceFrameStart + frame_idx - clip.mTimelineFrameStart;
 	second_clip.mSourceFrameStart = clip.mSourceFrameEnd;
 	second_clip.mTimelineFrameStart = frame_idx;
-	AddClip(second_clip);
+	AddClip(second_clip);		//	invalidates index
 }
 
 /*	FUNCTION:		TimelineTrack :: AddEffect
@@ -188,7 +243,10 @@ void TimelineTrack :: SplitClip(MediaClip &clip, int64 frame_idx)
 */
 void TimelineTrack :: AddEffect(MediaEffect *effect)
 {
-	mEffects.push_back(effect);
+	{
+		ContainerLock lock(this);
+		mEffects.push_back(effect);
+	}
 	SortEffects();
 
 	//	Determine if effect layer conflict - if so, increase effect priority
@@ -218,6 +276,7 @@ void TimelineTrack :: AddEffect(MediaEffect *effect)
 		if (i->mPriority > highest_priority)
 			highest_priority = i->mPriority;
 	mNumberEffectLayers = highest_priority + 1;
+	InvalidateIndex(effect->mTimelineFrameStart, effect->mTimelineFrameEnd);
 	gProject->UpdateDuration();
 }
 
@@ -240,7 +299,11 @@ void TimelineTrack :: RemoveEffect(MediaEffect *effect, const bool free_memory)
 		if (effect == *e)
 		{
 			effect->mEffectNode->MediaEffectSelectedBase(nullptr);
-			mEffects.erase(e);
+			{
+				ContainerLock lock(this);
+				mEffects.erase(e);
+			}
+			InvalidateIndex(effect->mTimelineFrameStart, effect->mTimelineFrameEnd);
 			if (free_memory)
 				delete effect;
 			break;
@@ -264,7 +327,11 @@ void TimelineTrack :: RemoveEffect(MediaEffect *effect, const bool free_memory)
 */
 void TimelineTrack :: SortClips()
 {
-	std::sort(mClips.begin(), mClips.end(), [](const MediaClip &a, const MediaClip &b){return (a.mTimelineFrameStart < b.mTimelineFrameStart);});
+	{
+		ContainerLock lock(this);
+		std::sort(mClips.begin(), mClips.end(), [](const MediaClip &a, const MediaClip &b){return (a.mTimelineFrameStart < b.mTimelineFrameStart);});
+	}
+	InvalidateIndex(0, 0);		//	container order only, rendering unchanged
 	gProject->UpdateDuration();
 }
 
@@ -275,7 +342,11 @@ void TimelineTrack :: SortClips()
 */
 void TimelineTrack :: SortEffects()
 {
-	std::sort(mEffects.begin(), mEffects.end(), [](const MediaEffect *a, const MediaEffect *b){return (a->mTimelineFrameStart < b->mTimelineFrameStart);});
+	{
+		ContainerLock lock(this);
+		std::sort(mEffects.begin(), mEffects.end(), [](const MediaEffect *a, const MediaEffect *b){return (a->mTimelineFrameStart < b->mTimelineFrameStart);});
+	}
+	InvalidateIndex(0, 0);		//	container order only, rendering unchanged
 	gProject->UpdateDuration();
 }
 
@@ -344,11 +415,16 @@ void TimelineTrack :: SetEffectPriority(MediaEffect *effect, const int32 priorit
 			});
 	}
 	int start_layer = 0;
+	int64 invalid_start = effect->mTimelineFrameStart;
+	int64 invalid_end = effect->mTimelineFrameEnd;
 	for (auto &i : layered_effects)
 	{
 		i->mPriority = start_layer;
 		++start_layer;
+		invalid_start = std::min(invalid_start, i->mTimelineFrameStart);
+		invalid_end = std::max(invalid_end, i->mTimelineFrameEnd);
 	}
+	InvalidateIndex(invalid_start, invalid_end);
 }
 
 /*	FUNCTION:		TimelineTrack :: DoEffectsIntersect
@@ -362,3 +438,105 @@ const bool TimelineTrack :: DoEffectsIntersect(const MediaEffect *a, const Media
 		return true;
 	return false;
 }
+
+/*	FUNCTION:		TimelineTrack::ContainerLock :: ContainerLock
+	ARGS:			track
+	RETURN:			n/a
+	DESCRIPTION:	Lock track containers (held while mClips/mEffects are resized or reordered)
+*/
+TimelineTrack::ContainerLock :: ContainerLock(TimelineTrack *track)
+	: fTrack(track)
+{
+	fTrack->fIndexLock->Lock();
+	fTrack->fIndexValid = false;
+}
+
+/*	FUNCTION:		TimelineTrack::ContainerLock :: ~ContainerLock
+	ARGS:			n/a
+	RETURN:			n/a
+	DESCRIPTION:	Unlock track containers
+*/
+TimelineTrack::ContainerLock :: ~ContainerLock()
+{
+	fTrack->fIndexLock->Unlock();
+}
+
+/*	FUNCTION:		TimelineTrack :: InvalidateIndex
+	ARGS:			start, end (modified timeline range, empty if only container order changed)
+	RETURN:			n/a
+	DESCRIPTION:	Clips/effects modified, rebuild interval index of this track on next query.
+					Call after the modification, so a rebuild cannot capture the previous state.
+					mClips is held by value (indices shift on insert/erase) and the timeline
+					editor modifies positions in place, so the index is rebuilt rather than patched.
+*/
+void TimelineTrack :: InvalidateIndex(const int64 start, const int64 end)
+{
+	fIndexLock->Lock();
+	fIndexValid = false;
+	fIndexLock->Unlock();
+	if (start < end)
+		gProject->IncrementEditGeneration(start, end);
+}
+
+/*	FUNCTION:		TimelineTrack :: ValidateIndexLocked
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Rebuild interval index if track modified.  Caller holds fIndexLock
+*/
+void TimelineTrack :: ValidateIndexLocked()
+{
+	if (fIndexValid)
+		return;
+
+	fClipIndex->Clear();
+	for (size_t i=0; i < mClips.size(); i++)
+		fClipIndex->Add(mClips[i].mTimelineFrameStart, mClips[i].GetTimelineEndFrame(), (int32)i);
+	fClipIndex->Build();
+
+	fEffectIndex->Clear();
+	for (size_t i=0; i < mEffects.size(); i++)
+		fEffectIndex->Add(mEffects[i]->mTimelineFrameStart, mEffects[i]->mTimelineFrameEnd, (int32)i);
+	fEffectIndex->Build();
+
+	fIndexValid = true;
+}
+
+/*	FUNCTION:		TimelineTrack :: FindClips
+	ARGS:			start, end
+					clips
+	RETURN:			n/a
+	DESCRIPTION:	Find clips which overlap [start, end).  Use FindClips(f, f+1) for a single frame
+					Clips are copied under the container lock (mClips may be reallocated by the window thread)
+*/
+void TimelineTrack :: FindClips(const int64 start, const int64 end, std::vector<MediaClip> &clips)
+{
+	clips.clear();
+	std::lock_guard<yarra::yplatform::SpinLock> lock(*fIndexLock);
+	ValidateIndexLocked();
+	fClipIndex->Range(start, end, fIndexResults);
+	for (auto i : fIndexResults)
+	{
+		if (i < (int32)mClips.size())
+			clips.push_back(mClips[i]);
+	}
+}
+
+/*	FUNCTION:		TimelineTrack :: FindEffects
+	ARGS:			start, end
+					effects
+	RETURN:			n/a
+	DESCRIPTION:	Find effects which overlap [start, end).  Use FindEffects(f, f+1) for a single frame
+					Pointers are copied under the container lock
+*/
+void TimelineTrack :: FindEffects(const int64 start, const int64 end, std::vector<MediaEffect *> &effects)
+{
+	effects.clear();
+	std::lock_guard<yarra::yplatform::SpinLock> lock(*fIndexLock);
+	ValidateIndexLocked();
+	fEffectIndex->Range(start, end, fIndexResults);
+	for (auto i : fIndexResults)
+	{
+		if (i < (int32)mEffects.size())
+			effects.push_back(mEffects[i]);
+	}
+}
@@ -39,16 +39,19 @@ static const size_t		kThumbnailHeight	= 9*6;
 ***********************************/
 class VideoBitmapLruCache
 {
-private:
+public:
 	struct FRAME
 	{
 		BBitmap				*bitmap;
 		const MediaSource	*source;
 		int64				video_frame;
+		int32				pin_count;		//	users of bitmap (not evicted while pinned)
+		bool				decoding;		//	bitmap pending decode (completed by the thread which created the slot)
 
-		FRAME() : bitmap(nullptr), source(nullptr), video_frame(0) { }
+		FRAME() : bitmap(nullptr), source(nullptr), video_frame(0), pin_count(0), decoding(false) { }
 	};
 
+private:
 	std::deque<FRAME>	fFrames;
 	size_t				fMaxFrames;
 	
@@ -74,16 +77,16 @@ public:
 			delete i.bitmap;	
 	}
 	
-/*	FUNCTION:		VideoBitmapLruCache :: GetFrame
-					source
-	ARGS:			video_frame
+/*	FUNCTION:		VideoBitmapLruCache :: GetFrameLocked
+	ARGS:			source
+					video_frame
 					bitmap_width
 					bitmap_height
 					found
-	RETURN:			iterator to next element in cache to overwrite
-	DESCRIPTION:	Get iterator to next element in cache to overwrite (or new item)
+	RETURN:			cached frame (valid until cache modified)
+	DESCRIPTION:	Get cached frame, otherwise least recently used unpinned slot is replaced with new item
 */	
-	BBitmap *GetFrameLocked(const MediaSource *source, const int64 video_frame, const float bitmap_width, const float bitmap_height, bool &found)
+	FRAME *GetFrameLocked(const MediaSource *source, const int64 video_frame, const float bitmap_width, const float bitmap_height, bool &found)
 	{
 		assert(source != nullptr);
 		BMediaTrack *track = source->GetVideoTrack();
@@ -102,42 +105,99 @@ public:
 					FRAME aFrame = *i;
 					fFrames.erase(i);
 					fFrames.push_front(aFrame);
-					return aFrame.bitmap;
+					return &fFrames.front();
 				}
 				else
-					return (*i).bitmap;
+					return &(*i);
 			}
 		}
 		found = false;
 	
-		//	Reuse or create new slot		
+		//	Reuse or create new slot (pinned slots are in use, cache may temporarily exceed fMaxFrames)
 		if (fFrames.size() >= fMaxFrames)
 		{
-			DEBUG("[%p] VideoBitmapCache::GetFrameLocked(%ld) - pop_back(%ld)\n", this, video_frame, fFrames.back().video_frame);
-			delete fFrames.back().bitmap;
-			fFrames.pop_back();
-
+			for (std::deque<FRAME>::reverse_iterator i = fFrames.rbegin(); i != fFrames.rend(); i++)
+			{
+				if ((*i).pin_count == 0)
+				{
+					DEBUG("[%p] VideoBitmapCache::GetFrameLocked(%ld) - evict(%ld)\n", this, video_frame, (*i).video_frame);
+					delete (*i).bitmap;
+					fFrames.erase(std::next(i).base());
+					break;
+				}
+			}
 		}
 		FRAME	aFrame;
 		aFrame.bitmap = new BBitmap(BRect(0, 0, bitmap_width - 1, bitmap_height - 1), B_RGBA32);
 		aFrame.source = source;
 		aFrame.video_frame = video_frame;
 		fFrames.push_front(aFrame);
-		return aFrame.bitmap;
+		return &fFrames.front();
 	}
 
+/*	FUNCTION:		VideoBitmapLruCache :: FindLocked
+	ARGS:			bitmap
+	RETURN:			cached frame (nullptr if not cached)
+	DESCRIPTION:	Find slot which owns bitmap
+*/
+	FRAME *FindLocked(const BBitmap *bitmap)
+	{
+		for (auto &i : fFrames)
+		{
+			if (i.bitmap == bitmap)
+				return &i;
+		}
+		return nullptr;
+	}
+
+/*	FUNCTION:		VideoBitmapLruCache :: InvalidateItem
+	ARGS:			source
+					video_frame
+	RETURN:			n/a
+	DESCRIPTION:	Remove frame from cache.  Pinned frames are detached (never found again),
+					bitmap deleted by final ReleaseLocked()
+*/
 	void InvalidateItem(const MediaSource *source, const int64 video_frame)
 	{
 		for (std::deque<FRAME>::iterator i = fFrames.begin(); i != fFrames.end(); i++)
 		{
 			if (((*i).source == source) && ((*i).video_frame == video_frame))
 			{
+				if ((*i).pin_count > 0)
+				{
+					(*i).source = nullptr;
+					(*i).decoding = false;
+					return;
+				}
 				delete (*i).bitmap;
 				fFrames.erase(i);
 				return;
 			}
 		}
 	}
+
+/*	FUNCTION:		VideoBitmapLruCache :: ReleaseLocked
+	ARGS:			bitmap
+	RETURN:			n/a
+	DESCRIPTION:	Unpin frame, delete if detached by InvalidateItem()
+*/
+	void ReleaseLocked(const BBitmap *bitmap)
+	{
+		for (std::deque<FRAME>::iterator i = fFrames.begin(); i != fFrames.end(); i++)
+		{
+			if ((*i).bitmap == bitmap)
+			{
+				assert((*i).pin_count > 0);
+				if ((--(*i).pin_count == 0) && ((*i).source == nullptr))
+				{
+					delete (*i).bitmap;
+					fFrames.erase(i);
+				}
+				return;
+			}
+		}
+		assert(0);
+	}
 };
 
 /**********************************
@@ -173,6 +233,19 @@ public:
 	}
 };
 
+/**********************************
+	VideoPreloadActor
+***********************************/
+
+class VideoPreloadActor : public yarra::Actor
+{
+public:
+	void AsyncPreloadFrame(MediaSource *source, const int64 frame_idx)
+	{
+		gVideoManager->ReleaseFrameBitmap(gVideoManager->GetFrameBitmap(source, frame_idx));
+	}
+};
+
 /**********************************
 	VideoManager
 ***********************************/
@@ -201,7 +274,9 @@ VideoManager :: VideoManager()
 
 	fQueueSemaphore = new yarra::yplatform::Semaphore;
 	fThumbnailActor = new VideoThumbnailActor;
+	fPreloadActor = new VideoPreloadActor;
 	fMediaKitSemaphore = new yarra::yplatform::Semaphore;
+	fScratchBitmap = nullptr;
 }
 
 /*	FUNCTION:		VideoManager :: ~VideoManager
@@ -212,18 +287,22 @@ VideoManager :: VideoManager()
 VideoManager :: ~VideoManager()
 {
 	delete fThumbnailActor;
+	delete fPreloadActor;
 	delete fFrameCache;
 	delete fThumbnailCache;
 	delete fQueueSemaphore;
 	delete fMediaKitSemaphore;
+	delete fScratchBitmap;
 }
 
 /*	FUNCTION:		VideoManager :: GetFrameBitmap
 	ARGS:			source
 					frame_idx
 					secondary_media
-	RETURN:			bitmap
-	DESCRIPTION:	Seek to bitmap (or read from cache)
+	RETURN:			bitmap (pinned, caller must ReleaseFrameBitmap())
+	DESCRIPTION:	Seek to bitmap (or read from cache).
+					The returned bitmap is pinned, so the preload actor cannot evict or recycle a frame
+					which another thread is still compositing.
 */	
 BBitmap * VideoManager :: GetFrameBitmap(MediaSource *source, const int64 frame_idx, const bool secondary_media)
 {
@@ -251,12 +330,38 @@ BBitmap * VideoManager :: GetFrameBitmap(MediaSource *source, const int64 frame_
 	if (!fQueueSemaphore->Lock())
 		return nullptr;
 
-	//	Check if frame in cache
+	//	Check if frame in cache.  New slot is marked decoding before fQueueSemaphore is released.
 	bool found;
-	BBitmap *bitmap = fFrameCache->GetFrameLocked(source, requested_video_frame, source->GetVideoWidth(), source->GetVideoHeight(), found);
+	VideoBitmapLruCache::FRAME *frame = fFrameCache->GetFrameLocked(source, requested_video_frame, source->GetVideoWidth(), source->GetVideoHeight(), found);
+	BBitmap *bitmap = frame->bitmap;
+	frame->pin_count++;
+	bool decoding = frame->decoding;
+	if (!found)
+		frame->decoding = true;
 	fQueueSemaphore->Unlock();
 	if (found)
+	{
+		//	Slot is being decoded by another thread (eg. preload actor), decoder holds fMediaKitSemaphore until complete
+		while (decoding)
+		{
+			if (LockMediaKit())
+				UnlockMediaKit();
+			if (!fQueueSemaphore->Lock())
+				return nullptr;
+			frame = fFrameCache->FindLocked(bitmap);
+			const bool valid = (frame->source != nullptr);
+			decoding = valid && frame->decoding;
+			fQueueSemaphore->Unlock();
+			if (!valid)
+			{
+				ReleaseFrameBitmap(bitmap);
+				return nullptr;
+			}
+			if (decoding)
+				snooze(500);	//	decoder has not acquired fMediaKitSemaphore yet
+		}
 		return bitmap;
+	}
 
 	//	No match, read frames
 	media_header mh;
@@ -264,8 +369,19 @@ BBitmap * VideoManager :: GetFrameBitmap(MediaSource *source, const int64 frame_
 	int attempt = 0;
 	status_t st = B_ERROR;
 
-	if (!LockMediaKit())
+	//	Decoding failed, unpin and remove requested slot (waiting threads receive nullptr)
+	auto decode_failed = [this, source, requested_video_frame, bitmap]() -> BBitmap *
+	{
+		if (!fQueueSemaphore->Lock())
+			return nullptr;
+		fFrameCache->InvalidateItem(source, requested_video_frame);
+		fFrameCache->ReleaseLocked(bitmap);
+		fQueueSemaphore->Unlock();
 		return nullptr;
+	};
+
+	if (!LockMediaKit())
+		return decode_failed();
 
 	if (video_track->CurrentFrame() != video_frame)
 	{
@@ -278,11 +394,7 @@ BBitmap * VideoManager :: GetFrameBitmap(MediaSource *source, const int64 frame_
 		{
 			printf("Cannot seek to frame %ld, file=%s\n", video_frame, source->GetFilename().String());
 			UnlockMediaKit();
-			if (!fQueueSemaphore->Lock())
-				return nullptr;
-			fFrameCache->InvalidateItem(source, video_frame);
-			fQueueSemaphore->Unlock();
-			return nullptr;
+			return decode_failed();
 		}
 	}
 	DEBUG("Seek request(%ld), actual (%ld).  status_t=%d\n", requested_video_frame, video_frame, st);
@@ -293,42 +405,58 @@ BBitmap * VideoManager :: GetFrameBitmap(MediaSource *source, const int64 frame_
 		if (!fQueueSemaphore->Lock())	//	safe to request fQueueSemaphore while holding fDecodeSemaphore
 		{
 			UnlockMediaKit();
-			return nullptr;
+			return decode_failed();
 		}
-		bitmap = fFrameCache->GetFrameLocked(source, video_frame, source->GetVideoWidth(), source->GetVideoHeight(), found);
+		frame = fFrameCache->GetFrameLocked(source, video_frame, source->GetVideoWidth(), source->GetVideoHeight(), found);
+		BBitmap *skip_bitmap = frame->bitmap;
+		frame->pin_count++;
+		if (!found)
+			frame->decoding = true;
 		fQueueSemaphore->Unlock();
 
-		bitmap->Lock();
+		//	Cached slot may be in use (or pending decode by another thread), decoder must still advance
+		BBitmap *decode_bitmap = skip_bitmap;
+		if (found)
+		{
+			if (!fScratchBitmap || (fScratchBitmap->Bounds() != skip_bitmap->Bounds()))
+			{
+				delete fScratchBitmap;
+				fScratchBitmap = new BBitmap(skip_bitmap->Bounds(), B_RGBA32);
+			}
+			decode_bitmap = fScratchBitmap;
+		}
+		decode_bitmap->Lock();
 		attempt = 0;
 		do 
 		{
-			st = video_track->ReadFrames((char *)bitmap->Bits(), &num_read, &mh);
+			st = video_track->ReadFrames((char *)decode_bitmap->Bits(), &num_read, &mh);
 		} while ((st != B_OK) && (++attempt <= kMaxReadAttempts) && (video_track->CurrentFrame() < video_track->CountFrames()));
+		decode_bitmap->Unlock();
+
+		if (!fQueueSemaphore->Lock())
+		{
+			UnlockMediaKit();
+			return decode_failed();
+		}
+		if (!found)
+		{
+			fFrameCache->FindLocked(skip_bitmap)->decoding = false;
+			if (st != B_OK)
+				fFrameCache->InvalidateItem(source, video_frame);
+		}
+		fFrameCache->ReleaseLocked(skip_bitmap);
+		fQueueSemaphore->Unlock();
 		if (st != B_OK)
 		{
 			printf("Cannot read frame %ld, file=%s\n", video_frame, source->GetFilename().String());
-			bitmap->Unlock();
 			UnlockMediaKit();
-			if (!fQueueSemaphore->Lock())
-				return nullptr;
-			fFrameCache->InvalidateItem(source, video_frame);
-			fQueueSemaphore->Unlock();
-			return nullptr;	
+			return decode_failed();
 		}
-		bitmap->Unlock();
 		DEBUG("Skip Save(%ld)  status_t=%d\n", video_frame, st);
 		
 		video_frame++;
 	}
 
-	if (!fQueueSemaphore->Lock())	//	safe to request fQueueSemaphore while holding fDecodeSemaphore
-	{
-		UnlockMediaKit();
-		return nullptr;
-	}
-	bitmap = fFrameCache->GetFrameLocked(source, video_frame, source->GetVideoWidth(), source->GetVideoHeight(), found);
-	fQueueSemaphore->Unlock();
-
 	bitmap->Lock();
 	attempt = 0;
 	do
@@ -339,16 +467,30 @@ BBitmap * VideoManager :: GetFrameBitmap(MediaSource *source, const int64 frame_
 	UnlockMediaKit();
 	DEBUG("Final Save(%ld).  status_t=%ld\n", video_frame, st);
 
-	if (st == B_OK)
-		return bitmap;
-	else
-	{
-		if (!fQueueSemaphore->Lock())
-			return nullptr;
-		fFrameCache->InvalidateItem(source, video_frame);
-		fQueueSemaphore->Unlock();
+	if (st != B_OK)
+		return decode_failed();
+
+	if (!fQueueSemaphore->Lock())
 		return nullptr;
-	}
+	frame = fFrameCache->FindLocked(bitmap);
+	frame->decoding = false;
+	fQueueSemaphore->Unlock();
+	return bitmap;
+}
+
+/*	FUNCTION:		VideoManager :: ReleaseFrameBitmap
+	ARGS:			bitmap
+	RETURN:			n/a
+	DESCRIPTION:	Unpin bitmap returned by GetFrameBitmap()
+*/
+void VideoManager :: ReleaseFrameBitmap(BBitmap *bitmap)
+{
+	if (!bitmap)
+		return;
+	if (!fQueueSemaphore->Lock())
+		return;
+	fFrameCache->ReleaseLocked(bitmap);
+	fQueueSemaphore->Unlock();
 }
 
 /*	FUNCTION:		VideoManager :: CreateThumbnailBitmap
@@ -377,7 +519,7 @@ BBitmap * VideoManager :: CreateThumbnailBitmap(MediaSource *source, const int64
 
 	//	Check if frame in cache
 	bool found;
-	BBitmap *bitmap = fThumbnailCache->GetFrameLocked(source, video_frame, kThumbnailWidth, kThumbnailHeight, found);
+	BBitmap *bitmap = fThumbnailCache->GetFrameLocked(source, video_frame, kThumbnailWidth, kThumbnailHeight, found)->bitmap;
 	fQueueSemaphore->Unlock();
 
 	if (found)
@@ -396,6 +538,7 @@ BBitmap * VideoManager :: CreateThumbnailBitmap(MediaSource *source, const int64
 	{
 		DEBUG("Found frame - generating thumbnail\n");
 		out = CreateThumbnail(frame, kThumbnailWidth, kThumbnailHeight, bitmap);
+		ReleaseFrameBitmap(frame);
 	}
 	else
 	{
@@ -429,7 +572,7 @@ BBitmap * VideoManager :: GetThumbnailAsync(MediaSource *source, const int64 fra
 
 	//	Check if frame in cache, otherwise schedule work
 	bool found;
-	BBitmap *bitmap = fThumbnailCache->GetFrameLocked(source, video_frame, kThumbnailWidth, kThumbnailHeight, found);
+	BBitmap *bitmap = fThumbnailCache->GetFrameLocked(source, video_frame, kThumbnailWidth, kThumbnailHeight, found)->bitmap;
 	fQueueSemaphore->Unlock();
 
 	if (found)
@@ -456,6 +599,18 @@ void VideoManager :: ClearPendingThumbnails()
 	fThumbnailActor->ClearPendingThumbnails();
 }
 
+/*	FUNCTION:		VideoManager :: PreloadFrameAsync
+	ARGS:			source
+					frame_idx
+	RETURN:			n/a
+	DESCRIPTION:	Decode frame into cache from preload actor (decode ahead while compositing)
+*/
+void VideoManager :: PreloadFrameAsync(MediaSource *source, const int64 frame_idx)
+{
+	assert(source != nullptr);
+	fPreloadActor->Async<&VideoPreloadActor::AsyncPreloadFrame>(source, frame_idx);
+}
+
 //	FFmpeg (via BMediaKit) is not thread safe
 //	16 May 2021 tests show that update to ffmpeg resolved race conditions.  Disable for now.
 #if 1
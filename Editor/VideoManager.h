@@ -20,6 +20,7 @@ class BBitmap;
 class MediaSource;
 class VideoBitmapLruCache;
 class VideoThumbnailActor;
+class VideoPreloadActor;
 
 //===================
 class VideoManager
@@ -29,7 +30,9 @@ private:
 	VideoBitmapLruCache			*fThumbnailCache;
 	yarra::yplatform::Semaphore	*fQueueSemaphore;
 	VideoThumbnailActor			*fThumbnailActor;
+	VideoPreloadActor			*fPreloadActor;
 	yarra::yplatform::Semaphore	*fMediaKitSemaphore;
+	BBitmap						*fScratchBitmap;		//	decode target when skipping cached frames (fMediaKitSemaphore)
 	friend class				VideoThumbnailActor;
 
 	BBitmap						*CreateThumbnailBitmap(MediaSource *source, const int64 frame_idx);
@@ -38,9 +41,12 @@ public:
 				VideoManager();
 				~VideoManager();
 			
+	//	Frame bitmaps are pinned in the cache (not evicted or recycled), caller must ReleaseFrameBitmap()
 	BBitmap		*GetFrameBitmap(MediaSource *source, const int64 frame_idx, const bool secondary_media = false);
+	void		ReleaseFrameBitmap(BBitmap *bitmap);
 	BBitmap		*GetThumbnailAsync(MediaSource *source, const int64 frame_idx, const bool notification);
 	void		ClearPendingThumbnails();
+	void		PreloadFrameAsync(MediaSource *source, const int64 frame_idx);
 
 	//	FFMpeg (via BMediaKit) doesn't like multithreaded access
 	const bool	LockMediaKit();
@@ -53,6 +53,15 @@ const char *Effect_AudioGain :: GetEffectName() const	{return "Gain";}
 */
 Effect_AudioGain :: Effect_AudioGain(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
+{
+}
+
+/*	FUNCTION:		Effect_AudioGain :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_AudioGain :: InitGui()
 {
 	fSliderStart = new DualSlider(BRect(20, 60, 120, 600), "start", GetText(TXT_EFFECTS_AUDIO_GAIN_START), new BMessage(eMsgSliderStart), 0, kMaxGain*100,
 								  GetText(TXT_EFFECTS_COMMON_L), GetText(TXT_EFFECTS_COMMON_R));
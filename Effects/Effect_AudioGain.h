@@ -20,6 +20,7 @@ public:
 					Effect_AudioGain(BRect frame, const char *filename);
 					~Effect_AudioGain()								override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 
 	EFFECT_GROUP	GetEffectGroup() const							override {return EffectNode::EFFECT_AUDIO;}
 	const char		*GetVendorName() const							override;
@@ -14,9 +14,11 @@
 #include "Yarra/Render/Texture.h"
 #include "Yarra/Render/Shader.h"
 #include "Yarra/Render/MatrixStack.h"
+#include "Yarra/Render/RenderState.h"
 
 #include "Editor/EffectNode.h"
 #include "Editor/Project.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Effect_BackgroundColour.h"
 
@@ -241,10 +243,39 @@ void Effect_BackgroundColour :: RenderEffect(BBitmap *source, MediaEffect *data,
 	if (source)
 		fSourcePicture->Render(0.0f);
 	//	TODO
-	glEnable(GL_BLEND);
+	yrender::yRenderState.SetBlend(true);
 	fRenderNode->Render(0.0f);
 }
 
+/*	FUNCTION:		Effect_BackgroundColour :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					data
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect()
+*/
+bool Effect_BackgroundColour :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)
+{
+	if (source)
+	{
+		const SoftwareRender::TEXTURE texture(source);
+		render->RenderFragments(destination, [&texture](const float s, const float t, float fragment[4])
+		{
+			SoftwareRender::Sample(texture, s, t, fragment);
+		});
+	}
+
+	const ymath::YVector4 background_colour(((EffectBackgroundColourData *)data->mEffectData)->colour);		//	BGRA
+	render->RenderFragments(destination, [&background_colour](const float, const float, float fragment[4])
+	{
+		for (int c=0; c < 4; c++)
+			fragment[c] = background_colour.v[c];
+	});
+	return true;
+}
+
 /*	FUNCTION:		Effect_BackgroundColour :: MessageReceived
 	ARGS:			msg
 	RETURN:			n/a
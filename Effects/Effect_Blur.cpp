@@ -6,6 +6,7 @@
 
 #include <cstdio>
 #include <cassert>
+#include <cmath>
 
 #include <InterfaceKit.h>
 #include <translation/TranslationUtils.h>
@@ -15,12 +16,14 @@
 #include "Yarra/Render/SceneNode.h"
 #include "Yarra/Render/Shader.h"
 #include "Yarra/Render/MatrixStack.h"
+#include "Yarra/Render/BlurPyramid.h"
 
 #include "Gui/ValueSlider.h"
 #include "Editor/EffectNode.h"
 #include "Editor/Language.h"
 #include "Editor/Project.h"
 #include "Editor/RenderActor.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Effect_Blur.h"
 
@@ -42,6 +45,7 @@ struct EffectBlurData
 	bool			interpolate;
 };
 static const float kDefaultBlur = 6.0f;
+static const float kPyramidRadiusScale = 2.0f;		//	pyramid sigma (pixels) per blur factor, matches gaussian shader
 
 using namespace yrender;
 
@@ -180,6 +184,15 @@ static const char *kFragmentShader_blur13 = "\
 		fFragColour = blur13();\
 	}";
 
+//	Pyramid blur is performed by YBlurPyramid, shader only composites the result
+static const char *kFragmentShader_Pyramid = "\
+	uniform sampler2D	uTextureUnit0;\
+	in vec2				vTexCoord0;\
+	out vec4			fFragColour;\
+	void main(void) {\
+		fFragColour = texture(uTextureUnit0, vTexCoord0);\
+	}";
+
 class BlurShader : public yrender::YShaderNode
 {
 public:
@@ -190,6 +203,7 @@ public:
 		BLUR_SHADER_9,
 		BLUR_SHADER_13,
 		BLUR_GAUSSIAN,
+		BLUR_PYRAMID,
 		NUMBER_BLUR_SHADERS
 	};
 private:
@@ -214,6 +228,7 @@ public:
 		fShader[BLUR_SHADER_9] = new YShader(&attributes, kVertexShader, kFragmentShader_blur9);
 		fShader[BLUR_SHADER_13] = new YShader(&attributes, kVertexShader, kFragmentShader_blur13);
 		fShader[BLUR_GAUSSIAN] = new YShader(&attributes, kVertexShader, kFragmentShader_GaussianBlur);
+		fShader[BLUR_PYRAMID] = new YShader(&attributes, kVertexShader, kFragmentShader_Pyramid);
 		for (int i=0; i < NUMBER_BLUR_SHADERS; i++)
 		{
 			fLocation_uTransform[i] = fShader[i]->GetUniformLocation("uTransform");
@@ -263,7 +278,16 @@ Effect_Blur :: Effect_Blur(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
 {
 	fRenderNode = nullptr;
+	fBlurPyramid = nullptr;
+}
 
+/*	FUNCTION:		Effect_Blur :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Blur :: InitGui()
+{
 	const float kFontFactor = be_plain_font->Size()/20.0f;
 
 	//	Algorithm
@@ -273,8 +297,9 @@ Effect_Blur :: Effect_Blur(BRect frame, const char *filename)
 	fMethodPopup->AddOption("Blur 9", BlurShader::BLUR_SHADER_9);
 	fMethodPopup->AddOption("Blur 13", BlurShader::BLUR_SHADER_13);
 	fMethodPopup->AddOption("Gaussian Blur", BlurShader::BLUR_GAUSSIAN);
+	fMethodPopup->AddOption("Pyramid Blur", BlurShader::BLUR_PYRAMID);
 	mEffectView->AddChild(fMethodPopup);
-	fMethodPopup->SetValue(BlurShader::BLUR_GAUSSIAN);
+	fMethodPopup->SetValue(BlurShader::BLUR_PYRAMID);
 
 	fCheckboxInterpolate = new BCheckBox(BRect(20*kFontFactor, 100, 200*kFontFactor, 140), "interpolate", GetText(TXT_EFFECTS_COMMON_INTERPOLATE), new BMessage(kMsgBlurInterpolate));
 	fCheckboxInterpolate->SetValue(0);
@@ -339,6 +364,8 @@ void Effect_Blur :: InitRenderObjects()
 	fRenderNode->mShaderNode = new BlurShader;
 	fRenderNode->mGeometryNode = new yrender::YGeometryNode(GL_TRIANGLE_STRIP, Y_GEOMETRY_P3T2, (float *)kBlurGeometry, 4);
 	fRenderNode->mTexture = new YTexture(width, height, YTexture::YTF_MIRRORED_REPEAT);
+
+	fBlurPyramid = new YBlurPyramid;
 }
 
 /*	FUNCTION:		Effect_Blur :: DestroyRenderObjects
@@ -348,6 +375,7 @@ void Effect_Blur :: InitRenderObjects()
 */
 void Effect_Blur :: DestroyRenderObjects()
 {
+	delete fBlurPyramid;
 	delete fRenderNode;
 }
 
@@ -408,7 +436,7 @@ MediaEffect * Effect_Blur :: CreateMediaEffect()
 	EffectBlurData *data = new EffectBlurData;
 	data->factor[0] = fBlurSliders[0]->Value()/10.0f;
 	data->factor[1] = fBlurSliders[1]->Value()/10.0f;
-	data->method = BlurShader::BLUR_GAUSSIAN;
+	data->method = fMethodPopup->Value();
 	data->interpolate = fCheckboxInterpolate->Value() > 0 ? true : false;
 	media_effect->mEffectData = data;
 
@@ -435,6 +463,24 @@ void Effect_Blur :: MediaEffectSelected(MediaEffect *effect)
 	fBlurSliders[1]->SetEnabled(data->interpolate);
 }
 
+/*	FUNCTION:		GetBlurFactor
+	ARGS:			blur_data
+					effect
+					frame_idx
+	RETURN:			blur factor at frame_idx
+	DESCRIPTION:	Interpolate start / end factor
+*/
+static float GetBlurFactor(const EffectBlurData *blur_data, MediaEffect *effect, int64 frame_idx)
+{
+	if (!blur_data->interpolate)
+		return blur_data->factor[0];
+
+	float t = float(frame_idx - effect->mTimelineFrameStart)/float(effect->Duration());
+	if (t > 1.0f)
+		t = 1.0f;
+	return blur_data->factor[0] + t*(blur_data->factor[1] - blur_data->factor[0]);
+}
+
 /*	FUNCTION:		Effect_Blur :: RenderEffect
 	ARGS:			source
 					data
@@ -449,22 +495,18 @@ void Effect_Blur :: RenderEffect(BBitmap *source, MediaEffect *effect, int64 fra
 		return;
 
 	EffectBlurData *blur_data = (EffectBlurData *)effect->mEffectData;
-	BlurShader *blur_shader = (BlurShader *)fRenderNode->mShaderNode;
+	if (blur_data->method == BlurShader::BLUR_PYRAMID)
+	{
+		fRenderNode->mTexture->Upload(source);
+		RenderEffect(fRenderNode->mTexture, effect, frame_idx, chained_effects);
+		return;
+	}
 
+	BlurShader *blur_shader = (BlurShader *)fRenderNode->mShaderNode;
 	blur_shader->SetShaderIndex(blur_data->method);
 	blur_shader->SetResolution(source->Bounds().Width(), source->Bounds().Height());
 
-	float blur_factor;
-	if (blur_data->interpolate)
-	{
-		float t = float(frame_idx - effect->mTimelineFrameStart)/float(effect->Duration());
-		if (t > 1.0f)
-			t = 1.0f;
-		blur_factor = blur_data->factor[0] + t*(blur_data->factor[1] - blur_data->factor[0]);
-	}
-	else
-		blur_factor = blur_data->factor[0];
-
+	const float blur_factor = GetBlurFactor(blur_data, effect, frame_idx);
 	blur_shader->SetDirection(blur_factor, 0.0f);
 	fRenderNode->mTexture->Upload(source);
 	gRenderActor->ActivateSecondaryRenderBuffer(true);
@@ -475,6 +517,155 @@ void Effect_Blur :: RenderEffect(BBitmap *source, MediaEffect *effect, int64 fra
 	fRenderNode->Render(0.0f);
 }
 
+/*	FUNCTION:		Effect_Blur :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect (GPU resident source).
+					Pyramid blur never leaves the GPU, separable shaders need the readback path.
+*/
+void Effect_Blur :: RenderEffect(yrender::YTexture *source, MediaEffect *effect, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	if ((effect == nullptr) || (effect->mEffectData == nullptr))
+		return;
+
+	EffectBlurData *blur_data = (EffectBlurData *)effect->mEffectData;
+	if (blur_data->method != BlurShader::BLUR_PYRAMID)
+	{
+		EffectNode::RenderEffect(source, effect, frame_idx, chained_effects);
+		return;
+	}
+
+	BlurShader *blur_shader = (BlurShader *)fRenderNode->mShaderNode;
+	blur_shader->SetShaderIndex(BlurShader::BLUR_PYRAMID);
+
+	YTexture *texture = fRenderNode->mTexture;
+	fRenderNode->mTexture = fBlurPyramid->Render(source, kPyramidRadiusScale*GetBlurFactor(blur_data, effect, frame_idx));
+	fRenderNode->Render(0.0f);
+	fRenderNode->mTexture = texture;
+}
+
+/************************
+	Software blur kernels (taps of blur shaders, offsets in units of uDirection)
+*************************/
+struct SoftwareBlurKernel
+{
+	int			count;
+	float		offset[7];
+	float		weight[7];
+	bool		opaque;
+};
+
+/*	FUNCTION:		GetSoftwareBlurKernel
+	ARGS:			method
+	RETURN:			kernel
+	DESCRIPTION:	Separable kernel matching blur shader
+*/
+static const SoftwareBlurKernel & GetSoftwareBlurKernel(const uint32 method)
+{
+	static SoftwareBlurKernel kernels[BlurShader::NUMBER_BLUR_SHADERS];
+	static bool initialised = false;
+	if (!initialised)
+	{
+		//	Box blur is 3x3, each pass samples along uDirection only
+		kernels[BlurShader::BLUR_BOX] = {3, {-1.0f, 0.0f, 1.0f}, {0.25f, 0.5f, 0.25f}, true};
+		kernels[BlurShader::BLUR_SHADER_5] = {3, {-1.3333333333333333f, 0.0f, 1.3333333333333333f},
+												 {0.35294117647058826f, 0.29411764705882354f, 0.35294117647058826f}, false};
+		kernels[BlurShader::BLUR_SHADER_9] = {5, {-3.2307692308f, -1.3846153846f, 0.0f, 1.3846153846f, 3.2307692308f},
+												 {0.0702702703f, 0.3162162162f, 0.2270270270f, 0.3162162162f, 0.0702702703f}, false};
+		kernels[BlurShader::BLUR_SHADER_13] = {7, {-5.176470588235294f, -3.2941176470588234f, -1.411764705882353f, 0.0f, 1.411764705882353f, 3.2941176470588234f, 5.176470588235294f},
+												  {0.010381362401148057f, 0.09447039785044732f, 0.2969069646728344f, 0.1964825501511404f, 0.2969069646728344f, 0.09447039785044732f, 0.010381362401148057f}, false};
+
+		//	Incremental gaussian, sigma = 4, 3 pixels per side
+		SoftwareBlurKernel &gaussian = kernels[BlurShader::BLUR_GAUSSIAN];
+		const float sigma = 4.0f;
+		float g[3] = {1.0f/(sqrtf(2.0f*(float)M_PI)*sigma), expf(-0.5f/(sigma*sigma)), 0.0f};
+		g[2] = g[1]*g[1];
+		gaussian.count = 7;
+		gaussian.opaque = false;
+		gaussian.offset[3] = 0.0f;
+		gaussian.weight[3] = g[0];
+		float sum = g[0];
+		for (int i=1; i <= 3; i++)
+		{
+			g[0] *= g[1];
+			g[1] *= g[2];
+			gaussian.offset[3 - i] = -i;
+			gaussian.offset[3 + i] = i;
+			gaussian.weight[3 - i] = gaussian.weight[3 + i] = g[0];
+			sum += 2.0f*g[0];
+		}
+		for (int i=0; i < gaussian.count; i++)
+			gaussian.weight[i] /= sum;
+
+		//	BLUR_PYRAMID is not separable, see SoftwareRender::BlurPyramid()
+		initialised = true;
+	}
+	return kernels[method < BlurShader::NUMBER_BLUR_SHADERS ? method : BlurShader::BLUR_GAUSSIAN];
+}
+
+/*	FUNCTION:		Effect_Blur :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					effect
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect() (horizontal pass to scratch bitmap, vertical pass to destination).
+					Pyramid blur uses the CPU equivalent of YBlurPyramid.
+*/
+bool Effect_Blur :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *effect, int64 frame_idx)
+{
+	if ((effect == nullptr) || (effect->mEffectData == nullptr))
+		return true;
+
+	EffectBlurData *blur_data = (EffectBlurData *)effect->mEffectData;
+	const float blur_factor = GetBlurFactor(blur_data, effect, frame_idx);
+
+	if (blur_data->method == BlurShader::BLUR_PYRAMID)
+	{
+		const SoftwareRender::TEXTURE texture(render->BlurPyramid(source, kPyramidRadiusScale*blur_factor));
+		render->RenderFragments(destination, [&texture](const float s, const float t, float fragment[4])
+		{
+			SoftwareRender::Sample(texture, s, t, fragment);
+		});
+		return true;
+	}
+
+	const SoftwareBlurKernel &kernel = GetSoftwareBlurKernel(blur_data->method);
+	const float ds = blur_factor/source->Bounds().Width();
+	const float dt = blur_factor/source->Bounds().Height();
+
+	auto blur_pass = [&kernel](const SoftwareRender::TEXTURE &texture, const float s, const float t, const float step_s, const float step_t, float fragment[4])
+	{
+		float sample[4];
+		fragment[0] = fragment[1] = fragment[2] = fragment[3] = 0.0f;
+		for (int i=0; i < kernel.count; i++)
+		{
+			SoftwareRender::Sample(texture, s + kernel.offset[i]*step_s, t + kernel.offset[i]*step_t, sample);
+			for (int c=0; c < 4; c++)
+				fragment[c] += kernel.weight[i]*sample[c];
+		}
+		if (kernel.opaque)
+			fragment[3] = 1.0f;
+	};
+
+	const SoftwareRender::TEXTURE texture_source(source);
+	BBitmap *horizontal = render->GetScratchBitmap();
+	render->RenderFragments(horizontal, [&](const float s, const float t, float fragment[4])
+	{
+		blur_pass(texture_source, s, t, ds, 0.0f, fragment);
+	});
+	const SoftwareRender::TEXTURE texture_horizontal(horizontal);
+	render->RenderFragments(destination, [&](const float s, const float t, float fragment[4])
+	{
+		blur_pass(texture_horizontal, s, t, 0.0f, dt, fragment);
+	});
+	return true;
+}
+
 /*	FUNCTION:		Effect_Blur :: MessageReceived
 	ARGS:			msg
 	RETURN:			n/a
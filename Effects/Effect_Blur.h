@@ -26,6 +26,7 @@ class BCheckBox;
 namespace yrender
 {
 	class YRenderNode;
+	class YBlurPyramid;
 };
 
 //=========================
@@ -36,6 +37,7 @@ public:
 					~Effect_Blur()									override;
 
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
 	
@@ -54,11 +56,14 @@ public:
 	MediaEffect		*CreateMediaEffect()							override;
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	void			RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 	
 	void			MessageReceived(BMessage *msg)					override;
 	
 private:
 	yrender::YRenderNode 	*fRenderNode;
+	yrender::YBlurPyramid	*fBlurPyramid;
 	ValueSlider				*fBlurSliders[2];
 	BOptionPopUp			*fMethodPopup;
 	BCheckBox				*fCheckboxInterpolate;
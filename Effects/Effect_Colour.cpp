@@ -20,6 +20,7 @@
 #include "Editor/Language.h"
 #include "Editor/Project.h"
 #include "Editor/RenderActor.h"
+#include "Editor/SoftwareRender.h"
 #include "Gui/AlphaColourControl.h"
 
 #include "Effect_Colour.h"
@@ -162,7 +163,15 @@ Effect_Colour :: Effect_Colour(BRect frame, const char *filename)
 {
 	fRenderNodeTexture = nullptr;
 	fRenderNodeBackground = nullptr;
+}
 
+/*	FUNCTION:		Effect_Colour :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Colour :: InitGui()
+{
 	fGuiInterpolate = new BCheckBox(BRect(10, 10, 200, 40), "interpolate", GetText(TXT_EFFECTS_COMMON_INTERPOLATE), new BMessage(kMsgInterpolate));
 	fGuiInterpolate->SetValue(0);
 	mEffectView->AddChild(fGuiInterpolate);
@@ -391,6 +400,41 @@ void Effect_Colour :: RenderEffect(BBitmap *source, MediaEffect *effect, int64 f
 	}
 }
 
+/*	FUNCTION:		Effect_Colour :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					effect
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect()
+*/
+bool Effect_Colour :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *effect, int64 frame_idx)
+{
+	const rgb_color colour = ChainedColourEffect(effect, frame_idx);
+	const float factor[4] = {colour.blue/255.0f, colour.green/255.0f, colour.red/255.0f, colour.alpha/255.0f};	//	BGRA
+
+	if (source != gRenderActor->GetBackgroundBitmap())
+	{
+		const SoftwareRender::TEXTURE texture(source);
+		render->RenderFragments(destination, [&texture, &factor](const float s, const float t, float fragment[4])
+		{
+			SoftwareRender::Sample(texture, s, t, fragment);
+			for (int c=0; c < 4; c++)
+				fragment[c] *= factor[c];
+		});
+	}
+	else
+	{
+		render->RenderFragments(destination, [&factor](const float, const float, float fragment[4])
+		{
+			for (int c=0; c < 4; c++)
+				fragment[c] = factor[c];
+		});
+	}
+	return true;
+}
+
 /*	FUNCTION:		Effect_Colour :: MessageReceived
 	ARGS:			msg
 	RETURN:			n/a
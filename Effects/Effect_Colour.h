@@ -29,6 +29,7 @@ public:
 					~Effect_Colour()								override;
 
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
 	
@@ -47,6 +48,7 @@ public:
 	MediaEffect		*CreateMediaEffect()							override;
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 	bool			IsColourEffect() const {return true;}
 	rgb_color		ChainedColourEffect(MediaEffect *data, int64 frame_idx);
 	
@@ -21,9 +21,11 @@
 #include "Gui/Magnify.h"
 #include "Gui/ValueSlider.h"
 
+#include "Editor/ColourFusion.h"
 #include "Editor/EffectNode.h"
 #include "Editor/Language.h"
 #include "Editor/Project.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Effect_ColourCorrection.h"
 
@@ -98,6 +100,22 @@ static const char *kFragmentShader = "\
 		fFragColour = vec4(r, g, b, colour.a);\
 	}";
 
+//	Fusion source (see ColourFusion.h)
+static const char *kFusionShader = "\
+	uniform vec4		uRed@;\
+	uniform vec4		uGreen@;\
+	uniform vec4		uBlue@;\
+	float CatmullRomSpline@(in float t, in vec4 v) {\
+		float c1 =                v.y;\
+		float c2 = -0.5*v.x           + 0.5*v.z;\
+		float c3 =      v.x - 2.5*v.y + 2.0*v.z - 0.5*v.a;\
+		float c4 = -0.5*v.x + 1.5*v.y - 1.5*v.z + 0.5*v.a;\
+		return ((c4*t + c3)*t + c2)*t + c1;\
+	}\
+	vec4 Fusion@(vec4 colour, vec2 uv) {\
+		return vec4(CatmullRomSpline@(colour.r, uRed@), CatmullRomSpline@(colour.g, uGreen@), CatmullRomSpline@(colour.b, uBlue@), colour.a);\
+	}";
+
 #else
 static const char *kFragmentShader = "\
 	uniform sampler2D	uTextureUnit0;\
@@ -119,6 +137,19 @@ static const char *kFragmentShader = "\
 		fFragColour = vec4(r, g, b, colour.a);\
 	}";
 
+//	Fusion source (see ColourFusion.h)
+static const char *kFusionShader = "\
+	uniform vec4		uRed@;\
+	uniform vec4		uGreen@;\
+	uniform vec4		uBlue@;\
+	float BeizerCurve@(in float t, in vec4 v) {\
+		float q = 1-t;\
+		return q*q*q*v.x + 3.0*t*q*q*v.y + 3.0*t*t*q*v.z + t*t*t*v.a;\
+	}\
+	vec4 Fusion@(vec4 colour, vec2 uv) {\
+		return vec4(BeizerCurve@(colour.r, uRed@), BeizerCurve@(colour.g, uGreen@), BeizerCurve@(colour.b, uBlue@), colour.a);\
+	}";
+
 #endif
 
 class ColourCorrectionShader : public yrender::YShaderNode
@@ -176,10 +207,20 @@ Effect_ColourCorrection :: Effect_ColourCorrection(BRect frame, const char *file
 	: EffectNode(frame, filename)
 {
 	fRenderNode = nullptr;
+	fColourPickerWindow = nullptr;
+	fColourPickerMessage = nullptr;
+}
 
+/*	FUNCTION:		Effect_ColourCorrection :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_ColourCorrection :: InitGui()
+{
 	const float kFontFactor = be_plain_font->Size()/20.0f;
 	const float kScrollBarScale = be_plain_font->Size()/12.0f;
-	const float kFrameRight = frame.right - 10 - kScrollBarScale*B_V_SCROLL_BAR_WIDTH;
+	const float kFrameRight = Bounds().right - 10 - kScrollBarScale*B_V_SCROLL_BAR_WIDTH;
 
 	//	Interpolation
 	fOptionInterpolation = new BOptionPopUp(BRect(20*kFontFactor, 20, 20+360*kFontFactor, 60), "interpolation", GetText(TXT_EFFECTS_COMMON_INTERPOLATE), new BMessage(kMsgInterpolation));
@@ -245,8 +286,6 @@ Effect_ColourCorrection :: Effect_ColourCorrection(BRect frame, const char *file
 											 new BMessage(kMsgColourPicker));
 	fColourPickerButton->SetState(false);
 	mEffectView->AddChild(fColourPickerButton);
-	fColourPickerWindow = nullptr;
-	fColourPickerMessage = nullptr;
 
 	SetViewIdealSize(840*kFontFactor, 700);
 }
@@ -405,6 +444,20 @@ void Effect_ColourCorrection :: MediaEffectSelected(MediaEffect *effect)
 	DESCRIPTION:	Apply media effect
 */
 void Effect_ColourCorrection :: RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	fRenderNode->mTexture->Upload(source);
+	RenderEffect(fRenderNode->mTexture, data, frame_idx, chained_effects);
+}
+
+/*	FUNCTION:		Effect_ColourCorrection :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect (GPU resident source)
+*/
+void Effect_ColourCorrection :: RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
 {
 	EffectColourCorrectionData *colour_data = (EffectColourCorrectionData *)data->mEffectData;
 	ColourCorrectionShader *shader = (ColourCorrectionShader *) fRenderNode->mShaderNode;
@@ -413,8 +466,65 @@ void Effect_ColourCorrection :: RenderEffect(BBitmap *source, MediaEffect *data,
 	shader->SetGreen(colour_data->green);
 	shader->SetBlue(colour_data->red);
 
-	fRenderNode->mTexture->Upload(source);
+	YTexture *texture = fRenderNode->mTexture;
+	fRenderNode->mTexture = source;
 	fRenderNode->Render(0.0f);
+	fRenderNode->mTexture = texture;
+}
+
+/*	FUNCTION:		Effect_ColourCorrection :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					data
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect() (Beizer curves)
+*/
+bool Effect_ColourCorrection :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)
+{
+	EffectColourCorrectionData *colour_data = (EffectColourCorrectionData *)data->mEffectData;
+	const float *curves[3] = {colour_data->blue, colour_data->green, colour_data->red};	//	BGRA
+	const SoftwareRender::TEXTURE texture(source);
+	render->RenderFragments(destination, [&texture, &curves](const float s, const float t, float fragment[4])
+	{
+		SoftwareRender::Sample(texture, s, t, fragment);
+		for (int c=0; c < 3; c++)
+		{
+			const float x = fragment[c];
+			const float q = 1.0f - x;
+			const float *v = curves[c];
+			fragment[c] = q*q*q*v[0] + 3.0f*x*q*q*v[1] + 3.0f*x*x*q*v[2] + x*x*x*v[3];
+		}
+	});
+	return true;
+}
+
+/*	FUNCTION:		Effect_ColourCorrection :: GetColourFusionSource
+	ARGS:			data
+	RETURN:			fusion shader source
+	DESCRIPTION:	Curves are per pixel, can be fused with neighbouring colour effects
+*/
+const char * Effect_ColourCorrection :: GetColourFusionSource(MediaEffect *data)
+{
+	return kFusionShader;
+}
+
+/*	FUNCTION:		Effect_ColourCorrection :: SetColourFusionUniforms
+	ARGS:			program
+					stage
+					data
+					frame_idx
+	RETURN:			n/a
+	DESCRIPTION:	Set fused stage uniforms (program is active)
+*/
+void Effect_ColourCorrection :: SetColourFusionUniforms(ColourFusionProgram *program, const int stage, MediaEffect *data, int64 frame_idx)
+{
+	EffectColourCorrectionData *colour_data = (EffectColourCorrectionData *)data->mEffectData;
+	//	BGRA
+	glUniform4fv(program->GetUniformLocation("uRed", stage), 1, colour_data->blue);
+	glUniform4fv(program->GetUniformLocation("uGreen", stage), 1, colour_data->green);
+	glUniform4fv(program->GetUniformLocation("uBlue", stage), 1, colour_data->red);
 }
 
 /*	FUNCTION:		Effect_ColourCorrection :: MessageReceived
@@ -14,6 +14,7 @@
 namespace yrender
 {
 	class YRenderNode;
+	class YTexture;
 };
 namespace Magnify {class TWindow;};
 
@@ -32,6 +33,7 @@ public:
 					Effect_ColourCorrection(BRect frame, const char *filename);
 					~Effect_ColourCorrection()						override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
@@ -50,6 +52,10 @@ public:
 	MediaEffect		*CreateMediaEffect()							override;
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	void			RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
+	const char		*GetColourFusionSource(MediaEffect *data)		override;
+	void			SetColourFusionUniforms(ColourFusionProgram *program, const int stage, MediaEffect *data, int64 frame_idx)	override;
 	void			MessageReceived(BMessage *msg)					override;
 	
 private:
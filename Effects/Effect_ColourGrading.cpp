@@ -6,6 +6,8 @@
 
 #include <cstdio>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 
 #include <InterfaceKit.h>
 #include <translation/TranslationUtils.h>
@@ -16,9 +18,11 @@
 #include "Yarra/Render/MatrixStack.h"
 
 #include "Gui/ValueSlider.h"
+#include "Editor/ColourFusion.h"
 #include "Editor/EffectNode.h"
 #include "Editor/Language.h"
 #include "Editor/Project.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Effect_ColourGrading.h"
 
@@ -208,6 +212,57 @@ static const char *kFragmentShader = "\
 		//vec3 res = SetLum(rgb, lum);\n\
 		fFragColour = vec4(mix(base, res, col.a), col.a);\n\
 	}";
+
+/************************
+	ColourGrading fusion source (see ColourFusion.h)
+	Same algorithm as kFragmentShader, helpers are inlined so only the uniforms are global
+*************************/
+static const char *kFusionShader = "\
+	uniform float		uSaturation@;\n\
+	uniform float		uBrightness@;\n\
+	uniform float		uExposure@;\n\
+	uniform float		uContrast@;\n\
+	uniform float		uGamma@;\n\
+	uniform float		uTemperature@;\n\
+	uniform float		uTint@;\n\
+	vec4 Fusion@(vec4 tx_colour, vec2 uv) {\n\
+		const mat3 matRGBtoXYZ = mat3(0.4124564390896922, 0.21267285140562253, 0.0193338955823293,\n\
+			0.357576077643909, 0.715152155287818, 0.11919202588130297,\n\
+			0.18043748326639894, 0.07217499330655958, 0.9503040785363679);\n\
+		const mat3 matXYZtoRGB = mat3(3.2404541621141045, -0.9692660305051868, 0.055643430959114726,\n\
+			-1.5371385127977166, 1.8760108454466942, -0.2040259135167538,\n\
+			-0.498531409556016, 0.041556017530349834, 1.0572251882231791);\n\
+		const mat3 matAdapt = mat3(0.8951, -0.7502, 0.0389,\n\
+			0.2664, 1.7135, -0.0685,\n\
+			-0.1614, 0.0367, 1.0296);\n\
+		const mat3 matAdaptInv = mat3(0.9869929054667123, 0.43230526972339456, -0.008528664575177328,\n\
+			-0.14705425642099013, 0.5183602715367776, 0.04004282165408487,\n\
+			0.15996265166373125, 0.0492912282128556, 0.9684866957875502);\n\
+		const vec3 D65 = vec3(0.95047, 1.0, 1.08883);\n\
+		const vec3 CCT4K = vec3(1.009802, 1.0, 0.644496);\n\
+		const vec3 CCT20K = vec3(0.995451, 1.0, 1.886109);\n\
+		const vec3 AvgLum = vec3(0.5, 0.5, 0.5);\n\
+		const vec3 LumCoeff = vec3(0.2125, 0.7154, 0.0721);\n\
+		vec3 brtColor = tx_colour.rgb * uBrightness@;\n\
+		vec3 intensity = vec3(dot(brtColor, LumCoeff));\n\
+		vec3 satColor = mix(intensity, brtColor, uSaturation@);\n\
+		vec3 conColor = mix(AvgLum, satColor, uContrast@);\n\
+		vec3 exposure = conColor * pow(2.0, uExposure@);\n\
+		vec3 base = vec3(pow(exposure.r, uGamma@), pow(exposure.g, uGamma@), pow(exposure.b, uGamma@));\n\
+		float alpha = tx_colour.a;\n\
+		vec3 to = (uTemperature@ < 0.0) ? CCT20K : CCT4K;\n\
+		vec3 from = D65;\n\
+		float lum = 0.299*base.r + 0.587*base.g + 0.114*base.b;\n\
+		float temp = abs(uTemperature@) * (1.0 - pow(lum, 2.72));\n\
+		vec3 refWhite = vec3(mix(from.x, to.x, temp), mix(1.0, 0.9, uTint@), mix(from.z, to.z, temp));\n\
+		refWhite = mix(from, refWhite, alpha);\n\
+		vec3 d = matAdapt * refWhite;\n\
+		vec3 s = matAdapt * from;\n\
+		vec3 xyz = matAdaptInv * ((matAdapt * (matRGBtoXYZ * base)) * d/s);\n\
+		vec3 rgb = matXYZtoRGB * (matAdaptInv * (matAdapt * xyz));\n\
+		vec3 res = rgb * (1.0 + (temp + uTint@) / 10.0);\n\
+		return vec4(mix(base, res, alpha), alpha);\n\
+	}";
 class ColourGradingShader : public yrender::YShaderNode
 {
 private:
@@ -285,7 +340,16 @@ Effect_ColourGrading :: Effect_ColourGrading(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
 {
 	fRenderNode = nullptr;
+}
 
+/*	FUNCTION:		Effect_ColourGrading :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_ColourGrading :: InitGui()
+{
+	const BRect frame = Bounds();
 	const float kFontFactor = be_plain_font->Size()/20.0f;
 	const float kScrollBarScale = be_plain_font->Size()/12.0f;
 	const float kFrameRight = frame.right - 10 - kScrollBarScale*B_V_SCROLL_BAR_WIDTH;
@@ -562,6 +626,20 @@ void Effect_ColourGrading :: MediaEffectSelected(MediaEffect *effect)
 	DESCRIPTION:	Apply media effect
 */
 void Effect_ColourGrading :: RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	fRenderNode->mTexture->Upload(source);
+	RenderEffect(fRenderNode->mTexture, data, frame_idx, chained_effects);
+}
+
+/*	FUNCTION:		Effect_ColourGrading :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect (GPU resident source)
+*/
+void Effect_ColourGrading :: RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
 {
 	float t = float(frame_idx - data->mTimelineFrameStart)/float(data->Duration());
 	if (t > 1.0f)
@@ -576,8 +654,135 @@ void Effect_ColourGrading :: RenderEffect(BBitmap *source, MediaEffect *data, in
 	shader->SetTemperature(effect_data->temperature);
 	shader->SetTint(effect_data->tint);
 
-	fRenderNode->mTexture->Upload(source);
+	YTexture *texture = fRenderNode->mTexture;
+	fRenderNode->mTexture = source;
 	fRenderNode->Render(0.0f);
+	fRenderNode->mTexture = texture;
+}
+
+/*	FUNCTION:		Effect_ColourGrading :: GetColourFusionSource
+	ARGS:			data
+	RETURN:			fusion shader source
+	DESCRIPTION:	Colour grading is per pixel, can be fused with neighbouring colour effects
+*/
+const char * Effect_ColourGrading :: GetColourFusionSource(MediaEffect *data)
+{
+	return kFusionShader;
+}
+
+/*	FUNCTION:		Effect_ColourGrading :: SetColourFusionUniforms
+	ARGS:			program
+					stage
+					data
+					frame_idx
+	RETURN:			n/a
+	DESCRIPTION:	Set fused stage uniforms (program is active)
+*/
+void Effect_ColourGrading :: SetColourFusionUniforms(ColourFusionProgram *program, const int stage, MediaEffect *data, int64 frame_idx)
+{
+	EffectColourGradingData *effect_data = (EffectColourGradingData *)data->mEffectData;
+	glUniform1f(program->GetUniformLocation("uSaturation", stage), effect_data->saturation);
+	glUniform1f(program->GetUniformLocation("uBrightness", stage), effect_data->brightness);
+	glUniform1f(program->GetUniformLocation("uContrast", stage), effect_data->contrast);
+	glUniform1f(program->GetUniformLocation("uGamma", stage), effect_data->gamma);
+	glUniform1f(program->GetUniformLocation("uExposure", stage), effect_data->exposure);
+	glUniform1f(program->GetUniformLocation("uTemperature", stage), effect_data->temperature);
+	glUniform1f(program->GetUniformLocation("uTint", stage), effect_data->tint);
+}
+
+/************************
+	ColourGrading software fragment
+	Same algorithm as kFusionShader.  Matrices are column major (GLSL mat3 constructor order),
+	colour components are in memory order (same as shader).
+*************************/
+static const float kMatRGBtoXYZ[9] = {0.4124564390896922f, 0.21267285140562253f, 0.0193338955823293f,
+									  0.357576077643909f, 0.715152155287818f, 0.11919202588130297f,
+									  0.18043748326639894f, 0.07217499330655958f, 0.9503040785363679f};
+static const float kMatXYZtoRGB[9] = {3.2404541621141045f, -0.9692660305051868f, 0.055643430959114726f,
+									  -1.5371385127977166f, 1.8760108454466942f, -0.2040259135167538f,
+									  -0.498531409556016f, 0.041556017530349834f, 1.0572251882231791f};
+static const float kMatAdapt[9] = {0.8951f, -0.7502f, 0.0389f,
+								   0.2664f, 1.7135f, -0.0685f,
+								   -0.1614f, 0.0367f, 1.0296f};
+static const float kMatAdaptInv[9] = {0.9869929054667123f, 0.43230526972339456f, -0.008528664575177328f,
+									  -0.14705425642099013f, 0.5183602715367776f, 0.04004282165408487f,
+									  0.15996265166373125f, 0.0492912282128556f, 0.9684866957875502f};
+
+static inline void MultiplyMat3(const float m[9], const float v[3], float result[3])
+{
+	for (int i=0; i < 3; i++)
+		result[i] = m[i]*v[0] + m[3 + i]*v[1] + m[6 + i]*v[2];
+}
+
+/*	FUNCTION:		ColourGradingFragment
+	ARGS:			data
+					colour (in/out)
+	RETURN:			n/a
+	DESCRIPTION:	CPU equivalent of Fusion() in kFusionShader
+*/
+static void ColourGradingFragment(const EffectColourGradingData *data, float colour[4])
+{
+	static const float kD65[3] = {0.95047f, 1.0f, 1.08883f};
+	static const float kCCT4K[3] = {1.009802f, 1.0f, 0.644496f};
+	static const float kCCT20K[3] = {0.995451f, 1.0f, 1.886109f};
+	static const float kLumCoeff[3] = {0.2125f, 0.7154f, 0.0721f};
+
+	float brt[3];
+	for (int c=0; c < 3; c++)
+		brt[c] = colour[c]*data->brightness;
+	const float intensity = brt[0]*kLumCoeff[0] + brt[1]*kLumCoeff[1] + brt[2]*kLumCoeff[2];
+	const float exposure = powf(2.0f, data->exposure);
+	float base[3];
+	for (int c=0; c < 3; c++)
+	{
+		const float sat = intensity + (brt[c] - intensity)*data->saturation;
+		const float con = 0.5f + (sat - 0.5f)*data->contrast;
+		base[c] = powf(std::max(con*exposure, 0.0f), data->gamma);		//	pow() undefined for negative base
+	}
+	const float alpha = colour[3];
+	const float *to = (data->temperature < 0.0f) ? kCCT20K : kCCT4K;
+	const float lum = 0.299f*base[0] + 0.587f*base[1] + 0.114f*base[2];
+	const float temp = fabsf(data->temperature) * (1.0f - powf(std::max(lum, 0.0f), 2.72f));
+	float ref_white[3] = {kD65[0] + (to[0] - kD65[0])*temp, 1.0f + (0.9f - 1.0f)*data->tint, kD65[2] + (to[2] - kD65[2])*temp};
+	for (int c=0; c < 3; c++)
+		ref_white[c] = kD65[c] + (ref_white[c] - kD65[c])*alpha;
+	float d[3], s[3];
+	MultiplyMat3(kMatAdapt, ref_white, d);
+	MultiplyMat3(kMatAdapt, kD65, s);
+
+	float a[3], b[3];
+	MultiplyMat3(kMatRGBtoXYZ, base, a);
+	MultiplyMat3(kMatAdapt, a, b);
+	for (int c=0; c < 3; c++)
+		b[c] *= d[c]/s[c];
+	MultiplyMat3(kMatAdaptInv, b, a);		//	xyz
+	MultiplyMat3(kMatAdapt, a, b);
+	MultiplyMat3(kMatAdaptInv, b, a);
+	MultiplyMat3(kMatXYZtoRGB, a, b);		//	rgb
+	const float compensation = 1.0f + (temp + data->tint)/10.0f;
+	for (int c=0; c < 3; c++)
+		colour[c] = base[c] + (b[c]*compensation - base[c])*alpha;
+}
+
+/*	FUNCTION:		Effect_ColourGrading :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					data
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect()
+*/
+bool Effect_ColourGrading :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)
+{
+	const EffectColourGradingData *effect_data = (EffectColourGradingData *)data->mEffectData;
+	const SoftwareRender::TEXTURE texture(source);
+	render->RenderFragments(destination, [&texture, effect_data](const float s, const float t, float fragment[4])
+	{
+		SoftwareRender::Sample(texture, s, t, fragment);
+		ColourGradingFragment(effect_data, fragment);
+	});
+	return true;
 }
 
 /*	FUNCTION:		Effect_ColourGrading :: MessageReceived
@@ -14,6 +14,7 @@
 namespace yrender
 {
 	class YRenderNode;
+	class YTexture;
 };
 
 class BBitmap;
@@ -26,6 +27,7 @@ public:
 					Effect_ColourGrading(BRect frame, const char *filename);
 					~Effect_ColourGrading()							override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 
 	void			InitRenderObjects();
 	void			DestroyRenderObjects();
@@ -45,6 +47,10 @@ public:
 	MediaEffect		*CreateMediaEffect();
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	void			RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	const char		*GetColourFusionSource(MediaEffect *data)		override;
+	void			SetColourFusionUniforms(ColourFusionProgram *program, const int stage, MediaEffect *data, int64 frame_idx)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 	
 	void			MessageReceived(BMessage *msg)					override;
 	
@@ -6,6 +6,8 @@
 
 #include <cstdio>
 #include <cassert>
+#include <algorithm>
+#include <string>
 
 #include <InterfaceKit.h>
 #include <translation/TranslationUtils.h>
@@ -14,13 +16,16 @@
 #include "Yarra/Render/SceneNode.h"
 #include "Yarra/Render/Shader.h"
 #include "Yarra/Render/MatrixStack.h"
+#include "Yarra/Render/RenderState.h"
 
+#include "Editor/ColourFusion.h"
 #include "Editor/EffectNode.h"
 #include "Editor/Language.h"
+#include "Editor/LutCache.h"
 #include "Editor/MedoWindow.h"
 #include "Editor/Project.h"
+#include "Editor/SoftwareRender.h"
 
-#include "3rdParty/LutCube.h"
 #include "Effect_ColourLut.h"
 
 const char * Effect_ColourLut :: GetVendorName() const	{return "ZenYes";}
@@ -29,6 +34,7 @@ const char * Effect_ColourLut :: GetEffectName() const	{return "Colour LUT";}
 enum kLutMessages
 {
 	kMsgLutLoad		= 'ecl0',
+	kMsgLutTetrahedral,
 };
 
 using namespace yrender;
@@ -41,32 +47,32 @@ static const YGeometry_P3T2 kLutGeometry[] =
 	{1, 1, 0,		1, 1},
 };
 
-struct LUT_CACHE
-{
-	bool		texture_load_pending;
-	GLuint		texture_id;
-	BString		filename;
-	int			count;
-};
-static std::vector<LUT_CACHE> sLutCache;
 class EffectLutData
 {
 public:
-	int		mCacheIndex;
+	LutCache::LUT	*lut;				//	nullptr if no file
+	bool			tetrahedral;
+
+	EffectLutData() : lut(nullptr), tetrahedral(true) {}
 	~EffectLutData()
 	{
-		--sLutCache[mCacheIndex].count;
-		//	TODO schedule glDeleteTextures
-		printf("~EffectLutData()\n");
-		for (auto &i : sLutCache)
-		{
-			printf("sLutCache: %s, texture_id(%d), count(%d)\n", i.filename.String(), i.texture_id, i.count);
-		}
+		if (lut)
+			LutCache::GetInstance()->Release(lut);
+	}
+	void SetLut(const char *path)
+	{
+		LutCache::LUT *previous = lut;
+		lut = (path && *path) ? LutCache::GetInstance()->Acquire(path) : nullptr;
+		if (previous)
+			LutCache::GetInstance()->Release(previous);
 	}
 };
 
 /************************
 	LUT Shader
+	Lookup is by memory component order (texture .rgb is BGR, see LutCache.h).
+	The lattice spans [0, 1] (texel centres), tetrahedral interpolation uses 4 of the 8 neighbours
+	(preserves neutral axis, matches grading applications).
 *************************/
 static const char *kVertexShader = "\
 	uniform mat4	uTransform;\
@@ -77,55 +83,103 @@ static const char *kVertexShader = "\
 		gl_Position = uTransform * vec4(aPosition, 1.0);\
 		vTexCoord0 = aTexture0;\
 	}";
-	
-static const char *kFragmentShader = "\
+
+static const char *kFragmentShaderMain = "\
 	uniform sampler2D	uTextureUnit0;\
-	uniform sampler3D	uTextureUnit1;\
 	in vec2				vTexCoord0;\
 	out vec4			fFragColour;\
 	void main(void) {\
-		vec4 initial_colour = texture(uTextureUnit0, vTexCoord0);\
-		fFragColour = texture(uTextureUnit1, initial_colour.rgb);\
-		fFragColour.a = initial_colour.a;\
+		fFragColour = Fusion(texture(uTextureUnit0, vTexCoord0), vTexCoord0);\
+	}";
+
+//	Fusion source (see ColourFusion.h), LUT bound to stage texture unit
+static const char *kFusionShaderTrilinear = "\
+	uniform sampler3D	uLut@;\
+	vec4 Fusion@(vec4 colour, vec2 uv) {\
+		vec3 n = vec3(textureSize(uLut@, 0));\
+		vec3 coord = clamp(colour.rgb, 0.0, 1.0)*((n - 1.0)/n) + 0.5/n;\
+		return vec4(texture(uLut@, coord).rgb, colour.a);\
 	}";
 
+static const char *kFusionShaderTetrahedral = "\
+	uniform sampler3D	uLut@;\
+	vec4 Fusion@(vec4 colour, vec2 uv) {\
+		ivec3 n = textureSize(uLut@, 0);\
+		vec3 p = clamp(colour.rgb, 0.0, 1.0)*vec3(n - 1);\
+		ivec3 i0 = min(ivec3(p), n - 2);\
+		vec3 f = p - vec3(i0);\
+		ivec3 d1;\
+		ivec3 d2;\
+		vec3 w;\
+		if (f.x >= f.y) {\
+			if (f.y >= f.z)			{d1 = ivec3(1, 0, 0); d2 = ivec3(1, 1, 0); w = f.xyz;}\
+			else if (f.x >= f.z)	{d1 = ivec3(1, 0, 0); d2 = ivec3(1, 0, 1); w = f.xzy;}\
+			else					{d1 = ivec3(0, 0, 1); d2 = ivec3(1, 0, 1); w = f.zxy;}\
+		} else {\
+			if (f.z >= f.y)			{d1 = ivec3(0, 0, 1); d2 = ivec3(0, 1, 1); w = f.zyx;}\
+			else if (f.z >= f.x)	{d1 = ivec3(0, 1, 0); d2 = ivec3(0, 1, 1); w = f.yzx;}\
+			else					{d1 = ivec3(0, 1, 0); d2 = ivec3(1, 1, 0); w = f.yxz;}\
+		}\
+		vec3 c0 = texelFetch(uLut@, i0, 0).rgb;\
+		vec3 c1 = texelFetch(uLut@, i0 + d1, 0).rgb;\
+		vec3 c2 = texelFetch(uLut@, i0 + d2, 0).rgb;\
+		vec3 c3 = texelFetch(uLut@, i0 + ivec3(1), 0).rgb;\
+		return vec4(c0 + w.x*(c1 - c0) + w.y*(c2 - c1) + w.z*(c3 - c2), colour.a);\
+	}";
 
 class ColourLUTShader : public yrender::YShaderNode
 {
 private:
-	yrender::YShader	*fShader;
-	GLint		fLocation_uTransform;
-	GLint		fLocation_uTextureUnit0;
-	GLint		fLocation_uTextureUnit1;
-	bool		fValidationPending;
-	
+	enum {TRILINEAR, TETRAHEDRAL, NUMBER_SHADERS};
+	yrender::YShader	*fShader[NUMBER_SHADERS];
+	GLint		fLocation_uTransform[NUMBER_SHADERS];
+	GLint		fLocation_uTextureUnit0[NUMBER_SHADERS];
+	GLint		fLocation_uLut[NUMBER_SHADERS];
+	bool		fValidationPending[NUMBER_SHADERS];
+	bool		fTetrahedral;
+
 public:
 	ColourLUTShader()
 	{
 		std::vector <std::string> attributes;
 		attributes.push_back("aPosition");
 		attributes.push_back("aTexture0");
-		fShader = new YShader(&attributes, kVertexShader, kFragmentShader);
-		fLocation_uTransform = fShader->GetUniformLocation("uTransform");
-		fLocation_uTextureUnit0 = fShader->GetUniformLocation("uTextureUnit0");
-		fLocation_uTextureUnit1 = fShader->GetUniformLocation("uTextureUnit1");
-		fValidationPending = true;
+		const char *fusion[NUMBER_SHADERS] = {kFusionShaderTrilinear, kFusionShaderTetrahedral};
+		for (int i=0; i < NUMBER_SHADERS; i++)
+		{
+			//	Standalone program is the fusion stage without suffix
+			std::string fragment(fusion[i]);
+			fragment.erase(std::remove(fragment.begin(), fragment.end(), '@'), fragment.end());
+			fragment.append(kFragmentShaderMain);
+			fShader[i] = new YShader(&attributes, kVertexShader, fragment.c_str());
+			fLocation_uTransform[i] = fShader[i]->GetUniformLocation("uTransform");
+			fLocation_uTextureUnit0[i] = fShader[i]->GetUniformLocation("uTextureUnit0");
+			fLocation_uLut[i] = fShader[i]->GetUniformLocation("uLut");
+			fValidationPending[i] = true;
+		}
+		fTetrahedral = true;
 	}
 	~ColourLUTShader()
 	{
-		delete fShader;
+		for (int i=0; i < NUMBER_SHADERS; i++)
+			delete fShader[i];
+	}
+	void SetTetrahedral(const bool tetrahedral)
+	{
+		fTetrahedral = tetrahedral;
 	}
 	void Render(float delta_time)
 	{
-		fShader->EnableProgram();
-		glUniformMatrix4fv(fLocation_uTransform, 1, GL_FALSE, yrender::yMatrixStack.GetMVPMatrix().m);
-		glUniform1i(fLocation_uTextureUnit0, 0);
-		glUniform1i(fLocation_uTextureUnit1, 1);
+		const int idx = fTetrahedral ? TETRAHEDRAL : TRILINEAR;
+		fShader[idx]->EnableProgram();
+		glUniformMatrix4fv(fLocation_uTransform[idx], 1, GL_FALSE, yrender::yMatrixStack.GetMVPMatrix().m);
+		glUniform1i(fLocation_uTextureUnit0[idx], 0);
+		glUniform1i(fLocation_uLut[idx], 1);
 
-		if (fValidationPending)
+		if (fValidationPending[idx])
 		{
-			fShader->ValidateProgram();
-			fValidationPending = false;
+			fShader[idx]->ValidateProgram();
+			fValidationPending[idx] = false;
 		}
 	}	
 };
@@ -140,7 +194,16 @@ Effect_ColourLut :: Effect_ColourLut(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
 {
 	fRenderNode = nullptr;
-	fLutCacheIndex = 0;
+}
+
+/*	FUNCTION:		Effect_ColourLut :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_ColourLut :: InitGui()
+{
+	const BRect frame = Bounds();
 
 	//	Load LUT button
 	float load_button_width = be_plain_font->StringWidth(GetText(TXT_EFFECTS_COLOUR_LUT_LOAD)) + be_plain_font->Size();
@@ -150,6 +213,10 @@ Effect_ColourLut :: Effect_ColourLut(BRect frame, const char *filename)
 	fLoadLutString = new BStringView(BRect(60 + load_button_width, 20, frame.Width()-20, 20+1.5f*be_plain_font->Size()), "load_string", GetText(TXT_EFFECTS_COLOUR_LUT_NO_FILE));
 	mEffectView->AddChild(fLoadLutString);
 
+	fTetrahedralCheckbox = new BCheckBox(BRect(20, 60, frame.Width()-20, 60 + 1.5f*be_plain_font->Size()), "tetrahedral", GetText(TXT_EFFECTS_COLOUR_LUT_TETRAHEDRAL), new BMessage(kMsgLutTetrahedral));
+	fTetrahedralCheckbox->SetValue(1);
+	mEffectView->AddChild(fTetrahedralCheckbox);
+
 	BStringView *description_text = new BStringView(BRect(20, 100, frame.Width()-20, 240), nullptr,
 													GetText(TXT_EFFECTS_COLOUR_LUT_INSTRUCTIONS));
 
@@ -173,6 +240,7 @@ void Effect_ColourLut :: AttachedToWindow()
 {
 	//	Bind GUI
 	fLoadLutButton->SetTarget(this, Window());
+	fTetrahedralCheckbox->SetTarget(this, Window());
 }
 
 /*	FUNCTION:		Effect_ColourLut :: InitRenderObjects
@@ -195,62 +263,6 @@ void Effect_ColourLut :: InitRenderObjects()
 	fRenderNode->mTexture = new YTexture(width, height);
 }
 
-/*	FUNCTION:		Effect_ColourLut :: LoadCubeFile
-	ARGS:			none
-	RETURN:			n/a
-	DESCRIPTION:	Called from RenderActor thread
-*/
-void Effect_ColourLut :: LoadCubeFile(int index)
-{
-	if (sLutCache[index].texture_id > 0)
-		glDeleteTextures(1, &sLutCache[index].texture_id);
-
-	//	Load CUBE file
-	timecube::Cube cube;
-	try {
-		cube = timecube::read_cube_from_file(sLutCache[index].filename.String());
-	}
-	catch (const std::exception &e)
-	{
-		printf("Effect_ColourLut::CreateMediaEffect() - failed to parse CUBE file(%s).  Error(%s)\n", sLutCache[index].filename.String(), e.what());
-		exit(1);
-	}
-	assert(cube.is_3d);
-
-	//	Create 3D texture
-	glGenTextures(1, &sLutCache[index].texture_id);
-	glBindTexture(GL_TEXTURE_3D, sLutCache[index].texture_id);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-	//	Uploaad CUBE data to texture
-	unsigned char *texture_buffer = new unsigned char [cube.n * cube.n * cube.n * 4];
-	unsigned char *p = texture_buffer;
-	for (uint32_t i=0; i < cube.n; i++)
-	{
-		for (uint32_t j=0; j < cube.n; j++)
-		{
-			for (uint32_t k=0; k < cube.n; k++)
-			{
-				size_t idx = 3*(i*cube.n*cube.n + j*cube.n + k);
-				assert(idx + 2 < cube.lut.size());
-				*p++ = (unsigned char) (cube.lut[idx + 0] * 255.0f);
-				*p++ = (unsigned char) (cube.lut[idx + 1] * 255.0f);
-				*p++ = (unsigned char) (cube.lut[idx + 2] * 255.0f);
-				*p++ = 255;
-				assert(p <= texture_buffer + cube.n*cube.n*cube.n*4);
-			}
-		}
-	}
-	assert(p == texture_buffer + cube.n*cube.n*cube.n*4);
-	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, cube.n, cube.n, cube.n, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture_buffer);
-	delete [] texture_buffer;
-	sLutCache[index].texture_load_pending = false;
-}
-
 /*	FUNCTION:		Effect_ColourLut :: DestroyRenderObjects
 	ARGS:			none
 	RETURN:			n/a
@@ -259,11 +271,7 @@ void Effect_ColourLut :: LoadCubeFile(int index)
 void Effect_ColourLut :: DestroyRenderObjects()
 {
 	delete fRenderNode;
-	for (auto &i : sLutCache)
-	{
-		glDeleteTextures(1, &i.texture_id);
-		i.texture_id = 0;
-	}
+	LutCache::GetInstance()->DestroyTextures();
 }
 
 /*	FUNCTION:		Effect_ColourLut :: GetIcon
@@ -318,17 +326,8 @@ MediaEffect * Effect_ColourLut :: CreateMediaEffect()
 	ImageMediaEffect *media_effect = new ImageMediaEffect;
 	media_effect->mEffectNode = this;
 	EffectLutData *data = new EffectLutData;
-	data->mCacheIndex = fLutCacheIndex;
-
-	if (sLutCache.empty())
-	{
-		LUT_CACHE item;
-		item.count = 0;
-		item.texture_id = 0;
-		item.texture_load_pending = false;
-		sLutCache.push_back(item);
-	}
-	sLutCache[fLutCacheIndex].count++;
+	data->SetLut(fLutPath);
+	data->tetrahedral = fTetrahedralCheckbox->Value() > 0;
 	media_effect->mEffectData = data;
 
 	return media_effect;
@@ -345,14 +344,26 @@ void Effect_ColourLut :: MediaEffectSelected(MediaEffect *effect)
 		return;
 
 	//	Update GUI
-	fLutCacheIndex = ((EffectLutData *)effect->mEffectData)->mCacheIndex;
+	EffectLutData *data = (EffectLutData *)effect->mEffectData;
+	fLutPath.SetTo(data->lut ? data->lut->path.c_str() : "");
 	LockLooper();
-	BString aString(sLutCache[fLutCacheIndex].filename);
+	SetLutString(fLutPath);
+	fTetrahedralCheckbox->SetValue(data->tetrahedral ? 1 : 0);
+	UnlockLooper();
+}
+
+/*	FUNCTION:		Effect_ColourLut :: SetLutString
+	ARGS:			path
+	RETURN:			n/a
+	DESCRIPTION:	Show (truncated) LUT path, looper must be locked
+*/
+void Effect_ColourLut :: SetLutString(const char *path)
+{
+	BString aString(path);
 	if (aString.Length() == 0)
 		aString.SetTo(GetText(TXT_EFFECTS_COLOUR_LUT_NO_FILE));
 	be_plain_font->TruncateString(&aString, B_TRUNCATE_BEGINNING, fLoadLutString->Frame().Width() - 40);
 	fLoadLutString->SetText(aString);
-	UnlockLooper();
 }
 
 /*	FUNCTION:		Effect_ColourLut :: RenderEffect
@@ -364,20 +375,95 @@ void Effect_ColourLut :: MediaEffectSelected(MediaEffect *effect)
 	DESCRIPTION:	Apply media effect
 */
 void Effect_ColourLut :: RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	fRenderNode->mTexture->Upload(source);
+	RenderEffect(fRenderNode->mTexture, data, frame_idx, chained_effects);
+}
+
+/*	FUNCTION:		Effect_ColourLut :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect (GPU resident source)
+*/
+void Effect_ColourLut :: RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
 {
 	float t = float(frame_idx - data->mTimelineFrameStart)/float(data->Duration());
 	if (t > 1.0f)
 		t = 1.0f;
 
 	EffectLutData *effect_data = (EffectLutData *)data->mEffectData;
-	if (sLutCache[effect_data->mCacheIndex].texture_load_pending)
-		LoadCubeFile(effect_data->mCacheIndex);
+	const GLuint lut_texture = LutCache::GetInstance()->GetTexture(effect_data->lut);
 
-	fRenderNode->mTexture->Upload(source);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_3D, sLutCache[effect_data->mCacheIndex].texture_id);
+	YTexture *texture = fRenderNode->mTexture;
+	fRenderNode->mTexture = source;
+	yrender::yRenderState.BindTexture(GL_TEXTURE_3D, lut_texture, GL_TEXTURE1);
+	((ColourLUTShader *)fRenderNode->mShaderNode)->SetTetrahedral(effect_data->tetrahedral);
 	fRenderNode->Render(0.0f);
-	glActiveTexture(GL_TEXTURE0);
+	yrender::yRenderState.ActiveTexture(GL_TEXTURE0);
+	fRenderNode->mTexture = texture;
+}
+
+/*	FUNCTION:		Effect_ColourLut :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					data
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect() (same lattice and interpolation as shaders)
+*/
+bool Effect_ColourLut :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)
+{
+	EffectLutData *effect_data = (EffectLutData *)data->mEffectData;
+	const SoftwareRender::TEXTURE texture(source);
+	if (!LutCache::IsValid(effect_data->lut))
+	{
+		render->RenderFragments(destination, [&texture](const float s, const float t, float fragment[4])
+		{
+			SoftwareRender::Sample(texture, s, t, fragment);
+		});
+		return true;
+	}
+
+	const LutCache::LUT *lut = effect_data->lut;
+	const bool tetrahedral = effect_data->tetrahedral;
+	render->RenderFragments(destination, [&texture, lut, tetrahedral](const float s, const float t, float fragment[4])
+	{
+		SoftwareRender::Sample(texture, s, t, fragment);
+		LutCache::Apply(lut, fragment, tetrahedral);
+	});
+	return true;
+}
+
+/*	FUNCTION:		Effect_ColourLut :: GetColourFusionSource
+	ARGS:			data
+	RETURN:			fusion shader source
+	DESCRIPTION:	LUT lookup is per pixel, can be fused with neighbouring colour effects
+*/
+const char * Effect_ColourLut :: GetColourFusionSource(MediaEffect *data)
+{
+	EffectLutData *effect_data = (EffectLutData *)data->mEffectData;
+	return effect_data->tetrahedral ? kFusionShaderTetrahedral : kFusionShaderTrilinear;
+}
+
+/*	FUNCTION:		Effect_ColourLut :: SetColourFusionUniforms
+	ARGS:			program
+					stage
+					data
+					frame_idx
+	RETURN:			n/a
+	DESCRIPTION:	Bind LUT to stage texture unit (program is active)
+*/
+void Effect_ColourLut :: SetColourFusionUniforms(ColourFusionProgram *program, const int stage, MediaEffect *data, int64 frame_idx)
+{
+	EffectLutData *effect_data = (EffectLutData *)data->mEffectData;
+	const GLint unit = program->GetTextureUnit(stage);
+	yrender::yRenderState.BindTexture(GL_TEXTURE_3D, LutCache::GetInstance()->GetTexture(effect_data->lut), GL_TEXTURE0 + unit);
+	glUniform1i(program->GetUniformLocation("uLut", stage), unit);
+	yrender::yRenderState.ActiveTexture(GL_TEXTURE0);
 }
 
 /*	FUNCTION:		Effect_ColourLut :: MessageReceived
@@ -393,6 +479,15 @@ void Effect_ColourLut :: MessageReceived(BMessage *msg)
 			//printf("kMsgLutLoad\n");
 			MedoWindow::GetInstance()->PostMessage(new BMessage(MedoWindow::eMsgActionEffectsFilePanelOpen));
 			break;
+
+		case kMsgLutTetrahedral:
+			if (GetCurrentMediaEffect())
+			{
+				EffectLutData *data = (EffectLutData *)GetCurrentMediaEffect()->mEffectData;
+				data->tetrahedral = fTetrahedralCheckbox->Value() > 0;
+				InvalidatePreview();
+			}
+			break;
 				
 		default:
 			EffectNode::MessageReceived(msg);
@@ -408,33 +503,16 @@ void Effect_ColourLut :: MessageReceived(BMessage *msg)
 */
 bool Effect_ColourLut :: LoadParameters(const rapidjson::Value &v, MediaEffect *media_effect)
 {
-	//	direction
+	EffectLutData *data = (EffectLutData *) media_effect->mEffectData;
+
+	//	cube
 	if (v.HasMember("cube") && v["cube"].IsString())
-	{
-		EffectLutData *data = (EffectLutData *) media_effect->mEffectData;
-		BString aString(v["cube"].GetString());
-		int ci=0;
-		for (auto &i : sLutCache)
-		{
-			if (i.filename.Compare(aString) == 0)
-			{
-				data->mCacheIndex = ci;
-				i.count++;
-				break;
-			}
-			ci++;
-		}
-		if (ci == sLutCache.size())
-		{
-			LUT_CACHE item;
-			item.filename = aString;
-			item.count = 1;
-			item.texture_id = 0;
-			item.texture_load_pending = true;
-			sLutCache.push_back(item);
-			data->mCacheIndex = sLutCache.size() - 1;
-		}
-	}
+		data->SetLut(v["cube"].GetString());
+
+	//	tetrahedral (optional, older projects use trilinear)
+	data->tetrahedral = false;
+	if (v.HasMember("tetrahedral") && v["tetrahedral"].IsBool())
+		data->tetrahedral = v["tetrahedral"].GetBool();
 	
 	return true;
 }
@@ -448,8 +526,10 @@ bool Effect_ColourLut :: LoadParameters(const rapidjson::Value &v, MediaEffect *
 bool Effect_ColourLut :: SaveParameters(FILE *file, MediaEffect *media_effect)
 {
 	EffectLutData *data = (EffectLutData *) media_effect->mEffectData;
-	char buffer[0x100];	//	256 bytes
-	sprintf(buffer, "\t\t\t\t\"cube\": \"%s\"\n", sLutCache[data->mCacheIndex].filename.String());
+	char buffer[B_PATH_NAME_LENGTH + 0x40];
+	sprintf(buffer, "\t\t\t\t\"cube\": \"%s\",\n", data->lut ? data->lut->path.c_str() : "");
+	fwrite(buffer, strlen(buffer), 1, file);
+	sprintf(buffer, "\t\t\t\t\"tetrahedral\": %s\n", data->tetrahedral ? "true" : "false");
 	fwrite(buffer, strlen(buffer), 1, file);
 	return true;
 }
@@ -507,41 +587,13 @@ void Effect_ColourLut :: FilePanelOpen(const char *path)
 	if (strstr(BString(path).ToLower(), ".cube") == 0)
 		return;
 
-	EffectLutData *effect_data = nullptr;
+	//	Reloading an edited file creates a new cache entry (modification time differs)
+	fLutPath.SetTo(path);
 	if (GetCurrentMediaEffect() && (GetCurrentMediaEffect()->mEffectNode == this))
-		effect_data = (EffectLutData *)GetCurrentMediaEffect()->mEffectData;
-
-	bool create_item = sLutCache.empty();
-
-	if (effect_data)
-	{
-		fLutCacheIndex = effect_data->mCacheIndex;
-		if (sLutCache[fLutCacheIndex].count > 1)
-		{
-			sLutCache[fLutCacheIndex].count--;
-			create_item = true;
-		}
-	}
-
-	if (create_item)
-	{
-		LUT_CACHE item;
-		item.filename = path;
-		item.texture_id = 0;
-		item.count = (effect_data ? 1 : 0);
-		sLutCache.push_back(item);
-		fLutCacheIndex = sLutCache.size() - 1;
-		if (effect_data)
-			effect_data->mCacheIndex = fLutCacheIndex;
-	}
-	assert(fLutCacheIndex >= 0);
-	sLutCache[fLutCacheIndex].texture_load_pending = true;
-	sLutCache[fLutCacheIndex].filename.SetTo(path);
+		((EffectLutData *)GetCurrentMediaEffect()->mEffectData)->SetLut(path);
 
 	LockLooper();
-	BString aString(path);
-	be_plain_font->TruncateString(&aString, B_TRUNCATE_BEGINNING, fLoadLutString->Frame().Width() - 40);
-	fLoadLutString->SetText(aString);
+	SetLutString(path);
 	UnlockLooper();
 
 	InvalidatePreview();
@@ -11,6 +11,10 @@
 #include <storage/FilePanel.h>
 #endif
 
+#ifndef _B_STRING_H
+#include <support/String.h>
+#endif
+
 #ifndef EFFECT_NODE_H
 #include "Editor/EffectNode.h"
 #endif
@@ -18,9 +22,11 @@
 namespace yrender
 {
 	class YRenderNode;
+	class YTexture;
 };
 class BBitmap;
 class BButton;
+class BCheckBox;
 class BStringView;
 
 class Effect_ColourLut : public EffectNode, BRefFilter
@@ -30,6 +36,7 @@ public:
 					~Effect_ColourLut()								override;
 
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
 	
@@ -47,6 +54,10 @@ public:
 	MediaEffect		*CreateMediaEffect()							override;
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	void			RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
+	const char		*GetColourFusionSource(MediaEffect *data)		override;
+	void			SetColourFusionUniforms(ColourFusionProgram *program, const int stage, MediaEffect *data, int64 frame_idx)	override;
 	
 	void			MessageReceived(BMessage *msg)					override;
 
@@ -55,13 +66,14 @@ public:
 	
 private:
 	yrender::YRenderNode 	*fRenderNode;
-	int						fLutCacheIndex;
+	BString					fLutPath;			//	used by CreateMediaEffect()
 
 	BButton					*fLoadLutButton;
 	BStringView				*fLoadLutString;
+	BCheckBox				*fTetrahedralCheckbox;
 
 	bool					Filter(const entry_ref* ref, BNode* node, struct stat_beos* stat, const char* mimeType)	override;
-	void					LoadCubeFile(int index);
+	void					SetLutString(const char *path);
 };
 
 #endif	//#ifndef EFFECT_COLOUR_LUT_H
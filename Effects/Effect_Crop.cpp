@@ -6,6 +6,7 @@
 
 #include <cstdio>
 #include <cassert>
+#include <cmath>
 
 #include <InterfaceKit.h>
 #include <interface/OptionPopUp.h>
@@ -23,6 +24,7 @@
 #include "Editor/OutputView.h"
 #include "Editor/Project.h"
 #include "Editor/RenderActor.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Gui/BitmapButton.h"
 #include "Gui/Spinner.h"
@@ -139,6 +141,16 @@ public:
 */
 Effect_Crop :: Effect_Crop(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
+{
+	fRenderNode = nullptr;
+}
+
+/*	FUNCTION:		Effect_Crop :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Crop :: InitGui()
 {
 	const float kFontFactor = be_plain_font->Size()/20.0f;
 
@@ -167,8 +179,6 @@ Effect_Crop :: Effect_Crop(BRect frame, const char *filename)
 	fStringView[ePixelCenter]->SetText(buffer);
 	sprintf(buffer, "%s: %d x %d", GetText(TXT_EFFECTS_COMMON_PIXELS), (unsigned int)(kSpinners[2].value*width), (unsigned int)(kSpinners[3].value*height));
 	fStringView[ePixelSize]->SetText(buffer);
-	
-	fRenderNode = nullptr;
 }
 
 /*	FUNCTION:		Effect_Crop :: ~Effect_Crop
@@ -375,6 +385,33 @@ void Effect_Crop :: RenderEffect(BBitmap *source, MediaEffect *effect, int64 fra
 	fRenderNode->Render(0.0f);
 }
 
+/*	FUNCTION:		Effect_Crop :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					effect
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect()
+*/
+bool Effect_Crop :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *effect, int64 frame_idx)
+{
+	if (effect->mEffectData == nullptr)
+		return true;
+
+	const EffectCropData data = *(EffectCropData *) effect->mEffectData;
+	const SoftwareRender::TEXTURE texture(source);
+	render->Clear(destination);
+	render->RenderFragments(destination, [&texture, &data](const float s, const float t, float fragment[4])
+	{
+		if ((fabsf(s - data.center.x) <= data.size.x) && (fabsf(t - data.center.y) <= data.size.y))
+			SoftwareRender::Sample(texture, s, t, fragment);
+		else
+			fragment[0] = fragment[1] = fragment[2] = fragment[3] = 0.0f;
+	});
+	return true;
+}
+
 /*	FUNCTION:		Effect_Crop :: MessageReceived
 	ARGS:			msg
 	RETURN:			n/a
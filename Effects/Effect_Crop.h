@@ -25,6 +25,7 @@ public:
 					Effect_Crop(BRect frame, const char *filename);
 					~Effect_Crop()									override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	
 	EFFECT_GROUP	GetEffectGroup() const							override		{return EffectNode::EFFECT_SPATIAL;}
 	const char		*GetVendorName() const							override;
@@ -42,6 +43,7 @@ public:
 	MediaEffect		*CreateMediaEffect()							override;
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			RenderEffect(BBitmap *source, MediaEffect *effect, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 	
 	void			MessageReceived(BMessage *msg)					override;
 	void			OutputViewMouseDown(MediaEffect *media_effect, const BPoint &point)		override;
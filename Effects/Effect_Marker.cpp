@@ -259,10 +259,24 @@ public:
 Effect_Marker :: Effect_Marker(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
 {
-	const float kFontFactor = be_plain_font->Size()/20.0f;
-
 	fRenderNode = nullptr;
 
+	//	defaults
+	fPreviousStartPosition.Set(0, 0);
+	fPreviousEndPosition.Set(0, 0);
+	fPreviousWidth = 0.0f;
+	fMouseTrackingIndex = -1;
+}
+
+/*	FUNCTION:		Effect_Marker :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Marker :: InitGui()
+{
+	const float kFontFactor = be_plain_font->Size()/20.0f;
+
 	//	Colour
 	BStringView *title = new BStringView(BRect(110*kFontFactor, 20, 300*kFontFactor, 50), nullptr, GetText(TXT_EFFECTS_COMMON_COLOUR));
 	title->SetHighColor(ui_color(B_PANEL_TEXT_COLOR));
@@ -342,12 +356,6 @@ Effect_Marker :: Effect_Marker(BRect frame, const char *filename)
 	fGuiSliderMaskFilter->UpdateTextValue(0.100f);
 	background_box->AddChild(fGuiSliderMaskFilter);
 
-	//	defaults
-	fPreviousStartPosition.Set(0, 0);
-	fPreviousEndPosition.Set(0, 0);
-	fPreviousWidth = 0.0f;
-	fMouseTrackingIndex = -1;
-
 	SetViewIdealSize(840*kFontFactor, 740);
 }
 
@@ -39,6 +39,7 @@ public:
 					~Effect_Marker()								override;
 
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
 	
@@ -22,6 +22,7 @@
 #include "Editor/OutputView.h"
 #include "Editor/Project.h"
 #include "Editor/RenderActor.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Gui/PathView.h"
 #include "Gui/BitmapCheckbox.h"
@@ -144,16 +145,25 @@ public:
 Effect_Mask :: Effect_Mask(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
 {
-	const float kFontFactor = be_plain_font->Size()/20.0f;
-
 	fRenderNode = nullptr;
 	fPathView = nullptr;
 	fPathViewAttachedToWindow = false;
+	fCurrentKeyframe = 0;
 
 	if (!sBitmap)
 		sBitmap = new BBitmap(BRect(0, 0, 1919, 1079), B_RGBA32, true);
 
-	fPathView = new PathView(frame);
+	fPathView = new PathView(frame);		//	used by RenderEffect()
+}
+
+/*	FUNCTION:		Effect_Mask :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Mask :: InitGui()
+{
+	const float kFontFactor = be_plain_font->Size()/20.0f;
 
 	//	Path
 	fPathCheckbox = new BitmapCheckbox(BRect(20, 20, 60, 60), "path",
@@ -194,7 +204,6 @@ Effect_Mask :: Effect_Mask(BRect frame, const char *filename)
 
 	fKeyframeSlider = new KeyframeSlider(BRect(20, 280, 600*kFontFactor, 320));
 	mEffectView->AddChild(fKeyframeSlider);
-	fCurrentKeyframe = 0;
 }
 
 /*	FUNCTION:		Effect_Mask :: ~Effect_Mask
@@ -403,22 +412,16 @@ void Effect_Mask :: MediaEffectSelected(MediaEffect *effect)
 	fPathView->AllowSizeChange(fKeyframeList->CountItems() == 1);
 }
 
-/*	FUNCTION:		Effect_Mask :: RenderEffect
-	ARGS:			source
-					data
+/*	FUNCTION:		InterpolateKeyframe
+	ARGS:			media_effect
 					frame_idx
-					chained_effects
-	RETURN:			applied effect
-	DESCRIPTION:	Apply media effect
+					keyframe (output)
+	RETURN:			n/a
+	DESCRIPTION:	Interpolate mask path between keyframes
 */
-void Effect_Mask :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+static void InterpolateKeyframe(MediaEffect *media_effect, int64 frame_idx, KeyframeData &keyframe)
 {
-	assert(media_effect);
 	EffectMaskData *data = (EffectMaskData *)media_effect->mEffectData;
-	if (!data)
-		return;
-
-	KeyframeData keyframe;
 	if (data->keyframes.size() == 1)
 		keyframe = data->keyframes[0];
 	else
@@ -444,6 +447,25 @@ void Effect_Mask :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int
 			keyframe.path.push_back(ip);
 		}
 	}
+}
+
+/*	FUNCTION:		Effect_Mask :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect
+*/
+void Effect_Mask :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	assert(media_effect);
+	EffectMaskData *data = (EffectMaskData *)media_effect->mEffectData;
+	if (!data)
+		return;
+
+	KeyframeData keyframe;
+	InterpolateKeyframe(media_effect, frame_idx, keyframe);
 
 #if 1	//	needed to display current path
 	OutputView *output_view = MedoWindow::GetInstance()->GetOutputView();
@@ -464,6 +486,40 @@ void Effect_Mask :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int
 	fRenderNode->Render(0.0f);
 }
 
+/*	FUNCTION:		Effect_Mask :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					media_effect
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect()
+*/
+bool Effect_Mask :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *media_effect, int64 frame_idx)
+{
+	assert(media_effect);
+	EffectMaskData *data = (EffectMaskData *)media_effect->mEffectData;
+	if (!data)
+		return true;
+
+	KeyframeData keyframe;
+	InterpolateKeyframe(media_effect, frame_idx, keyframe);
+	fPathView->FillBitmap(sBitmap, keyframe.path);
+
+	const SoftwareRender::TEXTURE texture(source);
+	const SoftwareRender::TEXTURE mask(sBitmap);
+	const bool inverse = data->inverse > 0;
+	render->RenderFragments(destination, [&texture, &mask, inverse](const float s, const float t, float fragment[4])
+	{
+		float m[4];
+		SoftwareRender::Sample(texture, s, t, fragment);
+		SoftwareRender::Sample(mask, s, t, m);
+		for (int c=0; c < 4; c++)
+			fragment[c] *= inverse ? 1.0f - m[c] : m[c];
+	});
+	return true;
+}
+
 /*	FUNCTION:		Effect_Mask :: MessageReceived
 	ARGS:			msg
 	RETURN:			n/a
@@ -32,6 +32,7 @@ public:
 					~Effect_Mask()									override;
 
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	void			DetachedFromWindow()							override;
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
@@ -52,6 +53,7 @@ public:
 	MediaEffect		*CreateMediaEffect()							override;
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 
 	void			MessageReceived(BMessage *msg)					override;
 	
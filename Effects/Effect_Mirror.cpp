@@ -6,6 +6,7 @@
 
 #include <cstdio>
 #include <cassert>
+#include <algorithm>
 
 #include <InterfaceKit.h>
 #include <translation/TranslationUtils.h>
@@ -20,6 +21,7 @@
 #include "Editor/Language.h"
 #include "Editor/Project.h"
 #include "Editor/RenderActor.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Effect_Mirror.h"
 
@@ -141,7 +143,15 @@ Effect_Mirror :: Effect_Mirror(BRect frame, const char *filename)
 	fRenderNode = nullptr;
 	for (int i=0; i < eNumberRadioButtons; i++)
 		fGeometryNodes[i] = nullptr;
+}
 
+/*	FUNCTION:		Effect_Mirror :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Mirror :: InitGui()
+{
 	fGuiButtons[0]= new BRadioButton(BRect(40, 40, 300, 70), "mirror_0", GetText(TXT_EFFECTS_IMAGE_MIRROR_LEFT_RIGHT), new BMessage(kMsgLeftRight));
 	fGuiButtons[1]= new BRadioButton(BRect(40, 80, 300, 110), "mirror_1", GetText(TXT_EFFECTS_IMAGE_MIRROR_RIGHT_LEFT), new BMessage(kMsgRightLeft));
 	fGuiButtons[2] = new BRadioButton(BRect(40, 120, 300, 150), "mirror_2", GetText(TXT_EFFECTS_IMAGE_MIRROR_UP_DOWN), new BMessage(kMsgUpDown));
@@ -206,6 +216,7 @@ void Effect_Mirror :: DestroyRenderObjects()
 	for (int i=0; i < eNumberRadioButtons; i++)
 		delete fGeometryNodes[i];
 	fRenderNode->mGeometryNode = nullptr;
+	fRenderNode->mTexture = nullptr;		//	not owned
 	delete fRenderNode;
 	fRenderNode = nullptr;
 }
@@ -300,6 +311,49 @@ void Effect_Mirror :: RenderEffect(BBitmap *source, MediaEffect *data, int64 fra
 	fRenderNode->Render(0.0f);
 }
 
+/*	FUNCTION:		Effect_Mirror :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect (GPU resident source)
+*/
+void Effect_Mirror :: RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	int direction = ((EffectMirrorData *)data->mEffectData)->direction;
+	fRenderNode->mGeometryNode = fGeometryNodes[direction];
+	if (source)
+		fRenderNode->mTexture = source;
+	fRenderNode->Render(0.0f);
+}
+
+/*	FUNCTION:		Effect_Mirror :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					data
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect() (texture coordinates of mirror geometry)
+*/
+bool Effect_Mirror :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)
+{
+	const int direction = ((EffectMirrorData *)data->mEffectData)->direction;
+	const SoftwareRender::TEXTURE texture(source);
+	render->RenderFragments(destination, [&texture, direction](const float s, const float t, float fragment[4])
+	{
+		switch (direction)
+		{
+			case 0:		SoftwareRender::Sample(texture, std::min(s, 1.0f - s), t, fragment);		break;
+			case 1:		SoftwareRender::Sample(texture, std::max(s, 1.0f - s), t, fragment);		break;
+			case 2:		SoftwareRender::Sample(texture, s, std::min(t, 1.0f - t), fragment);		break;
+			default:	SoftwareRender::Sample(texture, s, std::max(t, 1.0f - t), fragment);		break;
+		}
+	});
+	return true;
+}
+
 /*	FUNCTION:		Effect_Mirror :: MessageReceived
 	ARGS:			msg
 	RETURN:			n/a
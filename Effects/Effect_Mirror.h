@@ -16,6 +16,7 @@ class BRadioButton;
 namespace yrender
 {
 	class YRenderNode;
+	class YTexture;
 	class YGeometryNode;
 };
 class BBitmap;
@@ -27,6 +28,7 @@ public:
 					~Effect_Mirror()								override;
 
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
 	
@@ -44,6 +46,8 @@ public:
 	MediaEffect		*CreateMediaEffect()							override;
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	void			RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 	
 	void			MessageReceived(BMessage *msg)					override;
 	
@@ -117,7 +117,15 @@ Effect_Move :: Effect_Move(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
 {
 	SetViewColor(B_TRANSPARENT_COLOR);
-	
+}
+
+/*	FUNCTION:		Effect_Move :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Move :: InitGui()
+{
 	//	Popup direction
 	BOptionPopUp *popup_direction = new BOptionPopUp(BRect(20, 20, 600, 70), "direction", GetText(TXT_EFFECTS_MOVE_DIRECTION), new BMessage(kMsgDirection));
 	for (int i=0; i < sizeof(kMoveParameters)/sizeof(MOVE_PARAMETERS); i++)
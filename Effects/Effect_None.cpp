@@ -65,6 +65,41 @@ void Effect_None :: RenderEffect(BBitmap *source, MediaEffect *data, int64 frame
 	unsigned int h = source->Bounds().IntegerHeight() + 1;
 	yrender::YPicture *picture = gRenderActor->GetPicture(w, h, source);
 
+	RenderPicture(picture, w, h, frame_idx, chained_effects,
+		[source, frame_idx, &chained_effects](MediaEffect *effect) {effect->mEffectNode->RenderEffect(source, effect, frame_idx, chained_effects);});
+}
+
+/*	FUNCTION:		Effect_None :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect (GPU resident source, no upload)
+*/
+void Effect_None :: RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	if (!source)
+		return;
+
+	yrender::YPicture *picture = gRenderActor->GetPicture(source);
+
+	RenderPicture(picture, source->GetWidth(), source->GetHeight(), frame_idx, chained_effects,
+		[source, frame_idx, &chained_effects](MediaEffect *effect) {effect->mEffectNode->RenderEffect(source, effect, frame_idx, chained_effects);});
+}
+
+/*	FUNCTION:		Effect_None :: RenderPicture
+	ARGS:			picture
+					width, height
+					frame_idx
+					chained_effects
+					render_chained
+	RETURN:			n/a
+	DESCRIPTION:	Render picture, applying chained spatial transform or chained effect
+*/
+void Effect_None :: RenderPicture(yrender::YPicture *picture, const unsigned int w, const unsigned int h, int64 frame_idx,
+								  std::deque<FRAME_ITEM> & chained_effects, std::function<void(MediaEffect *)> render_chained)
+{
 	//	Chained spatial transform
 	yMatrixStack.Push();
 	bool chained_spatial = false;
@@ -88,7 +123,7 @@ void Effect_None :: RenderEffect(BBitmap *source, MediaEffect *data, int64 frame
 					 ((*i).effect->mEffectNode->GetEffectGroup() == EffectNode::EFFECT_TRANSITION) ||
 					 ((*i).effect->mEffectNode->GetEffectGroup() == EffectNode::EFFECT_SPECIAL))
 			{
-				((*i).effect->mEffectNode->RenderEffect(source, (*i).effect, frame_idx, chained_effects));
+				render_chained((*i).effect);
 				chained_effects.erase(i);
 				chained_effect = true;
 				break;
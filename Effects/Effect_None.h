@@ -7,12 +7,22 @@
 #ifndef EFFECT_NONE_H
 #define EFFECT_NONE_H
 
+#ifndef _GLIBCXX_FUNCTIONAL
+#include <functional>
+#endif
+
 #ifndef EFFECT_NODE_H
 #include "Editor/EffectNode.h"
 #endif
 
 class BBitmap;
 
+namespace yrender
+{
+	class YPicture;
+	class YTexture;
+};
+
 class Effect_None : public EffectNode
 {
 public:
@@ -32,6 +42,11 @@ public:
 	MediaEffect		*CreateMediaEffect()							override	{return nullptr;}
 	
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects) override;
+	void			RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects) override;
+
+private:
+	void			RenderPicture(yrender::YPicture *picture, const unsigned int width, const unsigned int height, int64 frame_idx,
+								  std::deque<FRAME_ITEM> & chained_effects, std::function<void(MediaEffect *)> render_chained);
 };
 
 #endif	//#ifndef EFFECT_NONE_H
@@ -5,8 +5,10 @@
  */
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <cassert>
-#include <random>
+#include <cmath>
 #include <algorithm>
 
 #include <InterfaceKit.h>
@@ -18,6 +20,7 @@
 #include "Yarra/Render/Texture.h"
 #include "Yarra/Math/Interpolation.h"
 #include "Yarra/Render/Picture.h"
+#include "Yarra/Render/RenderState.h"
 
 #include "Gui/ValueSlider.h"
 #include "Gui/Spinner.h"
@@ -31,6 +34,18 @@
 
 #include "Effect_ParticleTrail.h"
 
+#if defined (__GNUC__)
+	#if defined(__amd64__)
+		#define Y_CPU_X86
+	#endif
+#elif defined (_MSC_VER)
+	#define Y_CPU_X86
+#endif
+
+#ifdef Y_CPU_X86
+#include <emmintrin.h>
+#endif
+
 const char * Effect_ParticleTrail :: GetVendorName() const	{return "ZenYes";}
 const char * Effect_ParticleTrail :: GetEffectName() const	{return "Particle Trail";}
 
@@ -129,36 +144,54 @@ public:
 
 /*******************************
 	Particle Trail
+	The simulation is a pure function of (seed, time), so scrubbing, preview and
+	export are reproducible.  Particles are emitted at a fixed tick rate, every
+	particle visible at time t is regenerated from its emission tick (counter based
+	random numbers), then advanced in SoA arrays (SIMD) and uploaded once per frame.
 ********************************/
+static const float		kParticleTickRate = 60.0f;			//	simulation ticks per second (effect time)
+static const float		kParticleAlphaDecay = 0.90f;		//	per tick
+static const uint32		kParticleSeed = 0x6d65646f;
+static const int		kParticleMaxAge = 64;				//	ticks, 0.9^64 * 255 < 1
 
 class ParticleScene : public yrender::YSceneNode
 {
-	int					fFingerTrailIndex;
 	YRenderNode			*fRenderNode;
-	YGeometry_P3C4U		*fFingerTrailVertices;
-	YVector3			*fParticleVelocity;
-
-	float				fElapsedTime;
+	YGeometry_P3C4U		*fVertices;
+
+	//	SoA simulation arrays (kNumberParticlesRange[1], 16 byte aligned)
+	float				*fEmitX;
+	float				*fEmitY;
+	float				*fVelocityX;
+	float				*fVelocityY;
+	float				*fAlpha;
+	float				*fAge;
+	uint32				*fColour;				//	BGR (alpha from fAlpha)
+	int					fParticleCount;
+
+	float				fTime;					//	seconds
+	float				fDuration;				//	seconds
 	float				fVelocity;
 	float				fSpread[2];
 	float				fPointSize;
 	int					fNumberParticles;
 	float				fSpawnDuration;
 	std::vector<ymath::YVector3>	fPath;
+	std::vector<ymath::YVector3>	fPathScratch;
+	float				fDecay[kParticleMaxAge + 1];
 
 	rgb_color			fSpawnColour;
 	rgb_color			fDeltaColouur;
 
-	std::uniform_real_distribution<double>	fUniformDistribution;
-	std::mt19937							fRandomEngine;
-
-	void				UpdateVertices(float timestamp);
+	void				Simulate();
+	void				Advance(const int start, const int end);
+	ymath::YVector3		EvaluatePath(const float t);
 
 public:
 						ParticleScene();
 						~ParticleScene();
 
-	void				SetElapsedTime(float elapsed_time);
+	void				SetTime(float time, float duration)	{fTime = time; fDuration = duration;}
 	void				SetVelocity(float velocity)			{fVelocity  = velocity;}
 	void				SetSpread(float spread1, float spread2)		{fSpread[0] = spread1; fSpread[1] = spread2;}
 	void				SetSpawnColour(rgb_color colour)	{fSpawnColour = colour;}
@@ -169,9 +202,34 @@ public:
 	void				SetPath(const std::vector<ymath::YVector3> &path) {fPath = path;}
 
 	void				Render(float delta_time);
-	void				Reset();
 };
 
+/*	FUNCTION:		ParticleHash
+	ARGUMENTS:		x
+	RETURN:			hashed value
+	DESCRIPTION:	Integer hash (counter based random numbers)
+*/
+static inline uint32 ParticleHash(uint32 x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return x;
+}
+
+/*	FUNCTION:		ParticleRandom
+	ARGUMENTS:		state
+	RETURN:			uniform [0, 1)
+	DESCRIPTION:	Advance state, return uniform random number
+*/
+static inline float ParticleRandom(uint32 &state)
+{
+	state = ParticleHash(state + 0x9e3779b9);
+	return (state >> 8) * (1.0f/16777216.0f);
+}
+
 /*	FUNCTION:		ParticleScene :: ParticleScene
 	ARGUMENTS:		none
 	RETURN:			n/a
@@ -179,31 +237,38 @@ public:
 */
 ParticleScene :: ParticleScene()
 {
+	fTime = 0.0f;
+	fDuration = 1.0f;
 	fVelocity = 0.25f*kParticleVelocityRange[1];
 	fSpread[0] = 0.25f*kParticleSpreadRange[1];
 	fSpread[1] = 0.05f;
 	fPointSize = kDefaultParticlePointSize;
-	fNumberParticles = fNumberParticles/2;
+	fNumberParticles = kNumberParticlesRange[1]/2;
 	fSpawnDuration = 1.0f;
 	fSpawnColour = kParticleSpawnColour;
 	fDeltaColouur = kParticleDeltaColour;
+	fParticleCount = 0;
 
-	fFingerTrailIndex = 0;
-	fFingerTrailVertices = new YGeometry_P3C4U [kNumberParticlesRange[1]];
-	memset(fFingerTrailVertices, 0, kNumberParticlesRange[1] * sizeof(YGeometry_P3C4U));
-	fParticleVelocity = new YVector3 [kNumberParticlesRange[1]];
-	memset(fParticleVelocity, 0, kNumberParticlesRange[1] * sizeof(YVector3));
+	fVertices = new YGeometry_P3C4U [kNumberParticlesRange[1]];
+	memset(fVertices, 0, kNumberParticlesRange[1] * sizeof(YGeometry_P3C4U));
+
+	const size_t soa_size = kNumberParticlesRange[1] * sizeof(float);
+	fEmitX = (float *)aligned_alloc(16, soa_size);
+	fEmitY = (float *)aligned_alloc(16, soa_size);
+	fVelocityX = (float *)aligned_alloc(16, soa_size);
+	fVelocityY = (float *)aligned_alloc(16, soa_size);
+	fAlpha = (float *)aligned_alloc(16, soa_size);
+	fAge = (float *)aligned_alloc(16, soa_size);
+	fColour = new uint32 [kNumberParticlesRange[1]];
+
+	fDecay[0] = 1.0f;
+	for (int i=1; i <= kParticleMaxAge; i++)
+		fDecay[i] = fDecay[i-1]*kParticleAlphaDecay;
 
 	fRenderNode = new YRenderNode;
 	fRenderNode->mTexture = new YTexture("Resources/smoke.png");
-	fRenderNode->mGeometryNode = new YGeometryNode(GL_POINTS, Y_GEOMETRY_P3C4U, (float *)fFingerTrailVertices, kNumberParticlesRange[1], 0, GL_DYNAMIC_DRAW);
+	fRenderNode->mGeometryNode = new YGeometryNode(GL_POINTS, Y_GEOMETRY_P3C4U, (float *)fVertices, kNumberParticlesRange[1], 0, GL_DYNAMIC_DRAW);
 	fRenderNode->mShaderNode = new ParticleShader;
-
-	fUniformDistribution = std::uniform_real_distribution<double> (0.0, 1.0);
-	std::random_device rand_dev;
-	fRandomEngine = std::mt19937(rand_dev());
-
-	Reset();
 }
 
 /*	FUNCTION:		ParticleScene :: ~ParticleScene
@@ -214,77 +279,136 @@ ParticleScene :: ParticleScene()
 ParticleScene :: ~ParticleScene()
 {
 	delete fRenderNode;
-	delete [] fFingerTrailVertices;
-	delete [] fParticleVelocity;
+	delete [] fVertices;
+	free(fEmitX);
+	free(fEmitY);
+	free(fVelocityX);
+	free(fVelocityY);
+	free(fAlpha);
+	free(fAge);
+	delete [] fColour;
 }
 
 void ParticleScene :: SetNumberParticles(int count)
 {
 	assert(count <= kNumberParticlesRange[1]);
-	bool reset = (count != fNumberParticles);
 	fNumberParticles = count;
-	if (reset)
-		Reset();
 }
 
-void ParticleScene :: Reset()
+/*	FUNCTION:		ParticleScene :: EvaluatePath
+	ARGUMENTS:		t
+	RETURN:			normalised position
+	DESCRIPTION:	Bezier curve through fPath (no allocation)
+*/
+ymath::YVector3 ParticleScene :: EvaluatePath(const float t)
 {
-	fFingerTrailIndex = kNumberParticlesRange[1];
-	for (int i=0; i < kNumberParticlesRange[1]; i++)
+	if (fPath.empty())
+		return YVector3(-1000, -1000, 0);
+
+	fPathScratch = fPath;
+	for (size_t i = fPathScratch.size() - 1; i > 0; i--)
 	{
-		fFingerTrailVertices[i].mColour[0] = 255;
-		fFingerTrailVertices[i].mColour[1] = 255;
-		fFingerTrailVertices[i].mColour[2] = 255;
-		fFingerTrailVertices[i].mColour[3] = 0;
+		for (size_t j = 0; j < i; j++)
+			fPathScratch[j] += (fPathScratch[j + 1] - fPathScratch[j])*t;
 	}
+	return fPathScratch[0];
 }
 
-/*	FUNCTION:		ParticleScene :: UpdateVertices
-	ARGUMENTS:		mouse_down
+/*	FUNCTION:		ParticleScene :: Simulate
+	ARGUMENTS:		none
 	RETURN:			n/a
-	DESCRIPTION:	Update particle vertices
+	DESCRIPTION:	Regenerate particles visible at fTime (newest fNumberParticles emissions)
 */
-void ParticleScene :: UpdateVertices(float timestamp)
+void ParticleScene :: Simulate()
 {
-	if (++fFingerTrailIndex >= fNumberParticles)
-		fFingerTrailIndex = 0;
+	fParticleCount = 0;
+	const int tick = (int)floorf(fTime*kParticleTickRate);
+	if (tick < 0)
+		return;
 
-	float t = timestamp;
-	YVector3 pos;
-	if (!fPath.empty())
-		pos = ymath::YInterpolationBezier(fPath, t);
-	else
-		pos.Set(-1000, -1000, 0);
-	fFingerTrailVertices[fFingerTrailIndex].mPosition[0] = pos.x * gProject->mResolution.width;
-	fFingerTrailVertices[fFingerTrailIndex].mPosition[1] = pos.y * gProject->mResolution.height;
-	fFingerTrailVertices[fFingerTrailIndex].mPosition[2] = 0.0f;
+	const int emit_per_tick = (int)ceilf(20.0f + 50.0f*fSpread[1]);
+	const int number_ticks = std::min(tick + 1, kParticleMaxAge);
+	const int count = std::min(fNumberParticles, emit_per_tick*number_ticks);
+	const float tick_duration = 1.0f/(kParticleTickRate*std::max(fDuration, 0.001f));
+	const float width = gProject->mResolution.width;
+	const float height = gProject->mResolution.height;
 
-	if (t < fSpawnDuration)
+	//	Emission (oldest first), pure function of (seed, tick, index)
+	for (int q = count - 1; q >= 0; q--)
 	{
+		const int emit_tick = tick - q/emit_per_tick;
+		const int emit_idx = emit_per_tick - 1 - q%emit_per_tick;
+		const float t = emit_tick*tick_duration + emit_idx*0.001f*fSpread[1];
+		if (t >= fSpawnDuration)
+			continue;
+
+		uint32 state = ParticleHash(kParticleSeed ^ ParticleHash((uint32)emit_tick)) + (uint32)emit_idx;
+		const float r = ParticleRandom(state);
+		const float g = ParticleRandom(state);
+		const float b = ParticleRandom(state);
+		const float vx = ParticleRandom(state);
+		const float vy = ParticleRandom(state);
+
+		const YVector3 pos = EvaluatePath(t);
+		const int i = fParticleCount++;
+		fEmitX[i] = pos.x * width;
+		fEmitY[i] = pos.y * height;
+		fVelocityX[i] = fVelocity * (fSpread[0]*vx - 0.5f);
+		fVelocityY[i] = fVelocity * (fSpread[0]*vy - 0.5f);
+		fAge[i] = float(tick - emit_tick + 1);
+		fAlpha[i] = fSpawnColour.alpha * fDecay[std::min(tick - emit_tick + 1, kParticleMaxAge)];
 		//	BGRA
-		fFingerTrailVertices[fFingerTrailIndex].mColour[0] = std::clamp<unsigned char>(fSpawnColour.blue + (fDeltaColouur.blue*(float)rand()/(float)RAND_MAX), 0, 255);
-		fFingerTrailVertices[fFingerTrailIndex].mColour[1] = std::clamp<unsigned char>(fSpawnColour.green + (fDeltaColouur.green*(float)rand()/(float)RAND_MAX), 0, 255);
-		fFingerTrailVertices[fFingerTrailIndex].mColour[2] = std::clamp<unsigned char>(fSpawnColour.red	+ (fDeltaColouur.red*(float)rand()/(float)RAND_MAX), 0, 255);
-		fFingerTrailVertices[fFingerTrailIndex].mColour[3] = fSpawnColour.alpha;
-
-		fParticleVelocity[fFingerTrailIndex].x = fVelocity * (fSpread[0]*fUniformDistribution(fRandomEngine) - 0.5);
-		fParticleVelocity[fFingerTrailIndex].y = fVelocity * (fSpread[0]*fUniformDistribution(fRandomEngine) - 0.5);
-		fParticleVelocity[fFingerTrailIndex].z = 0.0f;
+		fColour[i] = std::clamp<int>(fSpawnColour.blue + int(fDeltaColouur.blue*b), 0, 255) |
+					(std::clamp<int>(fSpawnColour.green + int(fDeltaColouur.green*g), 0, 255) << 8) |
+					(std::clamp<int>(fSpawnColour.red + int(fDeltaColouur.red*r), 0, 255) << 16);
 	}
 
-	fRenderNode->mGeometryNode->UpdateVertices((float *)fFingerTrailVertices);
+	Advance(0, fParticleCount);
 }
 
-/*	FUNCTION:		ParticleScene :: SetElapsedTime
-	ARGUMENTS:		elapsed_time
+/*	FUNCTION:		ParticleScene :: Advance
+	ARGUMENTS:		start, end
 	RETURN:			n/a
-	DESCRIPTION:	Also check if reset required
+	DESCRIPTION:	position = emit + velocity*age, write vertices
 */
-void ParticleScene :: SetElapsedTime(float elapsed_time)
+void ParticleScene :: Advance(const int start, const int end)
 {
-	if ((fElapsedTime > elapsed_time) && (elapsed_time < 0.1))
-		Reset();
-	fElapsedTime = elapsed_time;
+	const float dt = 1.0f/kParticleTickRate;
+	int i = start;
+#ifdef Y_CPU_X86
+	const __m128 kDt = _mm_set1_ps(dt);
+	for (; i + 4 <= end; i += 4)
+	{
+		const __m128 age = _mm_mul_ps(_mm_load_ps(fAge + i), kDt);
+		const __m128 x = _mm_add_ps(_mm_load_ps(fEmitX + i), _mm_mul_ps(_mm_load_ps(fVelocityX + i), age));
+		const __m128 y = _mm_add_ps(_mm_load_ps(fEmitY + i), _mm_mul_ps(_mm_load_ps(fVelocityY + i), age));
+		__m128i alpha = _mm_cvttps_epi32(_mm_load_ps(fAlpha + i));
+		__m128i colour = _mm_or_si128(_mm_loadu_si128((const __m128i *)(fColour + i)), _mm_slli_epi32(alpha, 24));
+
+		alignas(16) float px[4], py[4];
+		alignas(16) uint32 pc[4];
+		_mm_store_ps(px, x);
+		_mm_store_ps(py, y);
+		_mm_store_si128((__m128i *)pc, colour);
+		for (int j=0; j < 4; j++)
+		{
+			YGeometry_P3C4U &v = fVertices[i + j];
+			v.mPosition[0] = px[j];
+			v.mPosition[1] = py[j];
+			v.mPosition[2] = 0.0f;
+			memcpy(v.mColour, &pc[j], 4);
+		}
+	}
+#endif
+	for (; i < end; i++)
+	{
+		YGeometry_P3C4U &v = fVertices[i];
+		v.mPosition[0] = fEmitX[i] + fVelocityX[i]*fAge[i]*dt;
+		v.mPosition[1] = fEmitY[i] + fVelocityY[i]*fAge[i]*dt;
+		v.mPosition[2] = 0.0f;
+		const uint32 colour = fColour[i] | ((uint32)fAlpha[i] << 24);
+		memcpy(v.mColour, &colour, 4);
+	}
 }
 
 /*	FUNCTION:		ParticleScene :: Render
@@ -294,34 +418,17 @@ void ParticleScene :: SetElapsedTime(float elapsed_time)
 */
 void ParticleScene :: Render(float delta_time)
 {
-	for (int i=0; i < 20 + fSpread[1]*50; i++)
-		UpdateVertices(fElapsedTime + i*0.001f*fSpread[1]);
+	Simulate();
+	if (fParticleCount == 0)
+		return;
 
 	glPointSize(fPointSize);
-
-	for (int i=0; i < fNumberParticles; i++)
-	{
-		int idx;
-		if (i < fFingerTrailIndex)
-			idx = fNumberParticles - (fFingerTrailIndex - i);
-		else
-			idx = i - fFingerTrailIndex;
-
-		if (fFingerTrailVertices[idx].mColour[3] > 0)
-		{
-			fFingerTrailVertices[idx].mColour[3] = (unsigned char)(0.90f*(float)fFingerTrailVertices[idx].mColour[3]);
-
-			fFingerTrailVertices[idx].mPosition[0] += fParticleVelocity[idx].x*delta_time;
-			fFingerTrailVertices[idx].mPosition[1] += fParticleVelocity[idx].y*delta_time;
-			fFingerTrailVertices[idx].mPosition[2] += fParticleVelocity[idx].z*delta_time;
-		}
-	}
-
-	glEnable(GL_BLEND);
+	yrender::yRenderState.SetBlend(true);
 
 	glEnable(GL_POINT_SPRITE);
 	glEnable(GL_PROGRAM_POINT_SIZE);
-	fRenderNode->mGeometryNode->SetVertexCount(fNumberParticles);
+	fRenderNode->mGeometryNode->SetVertexCount(fParticleCount);
+	fRenderNode->mGeometryNode->UpdateVertices((float *)fVertices);		//	single upload per frame
 	fRenderNode->Render(delta_time);
 	glDisable(GL_PROGRAM_POINT_SIZE);
 	glDisable(GL_POINT_SPRITE);
@@ -422,8 +529,19 @@ Effect_ParticleTrail :: Effect_ParticleTrail(BRect frame, const char *filename)
 	assert(sEffectParticleTrailInstance == nullptr);
 	sEffectParticleTrailInstance = this;
 
+	fPathVector.push_back(ymath::YVector3(0.0f, 0.5f, 0.0f));
+	fPathVector.push_back(ymath::YVector3(1.0f, 0.5f, 0.0f));
+}
+
+/*	FUNCTION:		Effect_ParticleTrail :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_ParticleTrail :: InitGui()
+{
 	const float kFontFactor = be_plain_font->Size()/20.0f;
-	const float width = frame.Width();
+	const float width = Bounds().Width();
 
 	//	Velocity
 	char min_label[32], max_label[32];
@@ -557,8 +675,6 @@ Effect_ParticleTrail :: Effect_ParticleTrail(BRect frame, const char *filename)
 	mEffectView->AddChild(fButtonAddPath);
 
 	//	Populate PathListView
-	fPathVector.push_back(ymath::YVector3(0.0f, 0.5f, 0.0f));
-	fPathVector.push_back(ymath::YVector3(1.0f, 0.5f, 0.0f));
 	char buffer[0x20];
 	int idx=1;
 	for (auto &i : fPathVector)
@@ -746,7 +862,7 @@ void Effect_ParticleTrail :: RenderEffect(BBitmap *source, MediaEffect *media_ef
 	if (effect_data->particle_scene == nullptr)
 		effect_data->particle_scene = new ParticleScene;
 
-	float t = float(frame_idx - media_effect->mTimelineFrameStart)/float(media_effect->Duration());
+	effect_data->particle_scene->SetTime(float(frame_idx - media_effect->mTimelineFrameStart)/float(kFramesSecond), float(media_effect->Duration())/float(kFramesSecond));
 	effect_data->particle_scene->SetVelocity(effect_data->velocity);
 	effect_data->particle_scene->SetSpread(effect_data->spread[0], effect_data->spread[1]);
 	effect_data->particle_scene->SetPointSize(effect_data->point_size);
@@ -754,7 +870,6 @@ void Effect_ParticleTrail :: RenderEffect(BBitmap *source, MediaEffect *media_ef
 	effect_data->particle_scene->SetDeltaColour(effect_data->colour_delta);
 	effect_data->particle_scene->SetNumberParticles(effect_data->number_particles);
 	effect_data->particle_scene->SetSpawnDuration(effect_data->spawn_duration);
-	effect_data->particle_scene->SetElapsedTime(t);
 	effect_data->particle_scene->SetPath(effect_data->path);
 
 	if (source)
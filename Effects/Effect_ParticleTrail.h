@@ -28,6 +28,7 @@ public:
 					Effect_ParticleTrail(BRect frame, const char *filename);
 					~Effect_ParticleTrail()							override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
@@ -14,12 +14,14 @@
 #include "Yarra/Render/Texture.h"
 #include "Yarra/Render/Shader.h"
 #include "Yarra/Render/MatrixStack.h"
+#include "Yarra/Render/RenderState.h"
 
 #include "Gui/BitmapCheckbox.h"
 #include "Gui/Magnify.h"
 #include "Gui/Spinner.h"
 #include "Gui/ValueSlider.h"
 
+#include "Editor/ColourFusion.h"
 #include "Editor/RenderActor.h"
 #include "Editor/Language.h"
 #include "Editor/LanguageJson.h"
@@ -232,26 +234,26 @@ public:
 	void Render(float delta_time)
 	{
 		fShader->EnableProgram();
-		glUniformMatrix4fv(fLocation_uTransform, 1, GL_FALSE, yrender::yMatrixStack.GetMVPMatrix().m);
+		yrender::yRenderState.UniformMatrix4fv(fLocation_uTransform, yrender::yMatrixStack.GetMVPMatrix().m);
 		for (auto &u : fUniforms)
 		{
 			switch (u.mType)
 			{
-				case PluginUniform::UniformType::eFloat:		glUniform1f(u.mLocation,	u.mFloat);			break;
-				case PluginUniform::UniformType::eInt:			glUniform1i(u.mLocation,	u.mInt);			break;
-				case PluginUniform::UniformType::eVec2:			glUniform2fv(u.mLocation, 1, u.mVec);			break;
-				case PluginUniform::UniformType::eVec3:			glUniform3fv(u.mLocation, 1, u.mVec);			break;
-				case PluginUniform::UniformType::eVec4:			glUniform4fv(u.mLocation, 1, u.mVec);			break;
-				case PluginUniform::UniformType::eColour:		glUniform4fv(u.mLocation, 1, u.mVec);			break;
-				case PluginUniform::UniformType::eTimestamp:	glUniform1f(u.mLocation,	u.mFloat);			break;
-				case PluginUniform::UniformType::eInterval:		glUniform1f(u.mLocation,	u.mFloat);			break;
-				case PluginUniform::UniformType::eRsolution:	glUniform2fv(u.mLocation, 1, u.mVec);			break;
+				case PluginUniform::UniformType::eFloat:		yrender::yRenderState.Uniform1f(u.mLocation,	u.mFloat);			break;
+				case PluginUniform::UniformType::eInt:			yrender::yRenderState.Uniform1i(u.mLocation,	u.mInt);			break;
+				case PluginUniform::UniformType::eVec2:			yrender::yRenderState.Uniform2fv(u.mLocation, u.mVec);			break;
+				case PluginUniform::UniformType::eVec3:			yrender::yRenderState.Uniform3fv(u.mLocation, u.mVec);			break;
+				case PluginUniform::UniformType::eVec4:			yrender::yRenderState.Uniform4fv(u.mLocation, u.mVec);			break;
+				case PluginUniform::UniformType::eColour:		yrender::yRenderState.Uniform4fv(u.mLocation, u.mVec);			break;
+				case PluginUniform::UniformType::eTimestamp:	yrender::yRenderState.Uniform1f(u.mLocation,	u.mFloat);			break;
+				case PluginUniform::UniformType::eInterval:		yrender::yRenderState.Uniform1f(u.mLocation,	u.mFloat);			break;
+				case PluginUniform::UniformType::eRsolution:	yrender::yRenderState.Uniform2fv(u.mLocation, u.mVec);			break;
 
 				case PluginUniform::UniformType::eSampler2D:
 					if (fSwapTextureUnits)
-						glUniform1i(u.mLocation,	fNumberTextureUnits - u.mSampler2D - 1);
+						yrender::yRenderState.Uniform1i(u.mLocation,	fNumberTextureUnits - u.mSampler2D - 1);
 					else
-						glUniform1i(u.mLocation,	u.mSampler2D);
+						yrender::yRenderState.Uniform1i(u.mLocation,	u.mSampler2D);
 					break;
 
 				default:	assert(0);
@@ -277,8 +279,6 @@ public:
 Effect_Plugin :: Effect_Plugin(EffectPlugin *plugin, BRect frame, const char *view_name)
 	: EffectNode(frame, view_name), fPlugin(plugin)
 {
-	const float kFontFactor = be_plain_font->Size()/20.0f;
-
 	if (GetEffectGroup() == EffectNode::EFFECT_TRANSITION)
 		InitSwapTexturesCheckbox();
 
@@ -289,6 +289,18 @@ Effect_Plugin :: Effect_Plugin(EffectPlugin *plugin, BRect frame, const char *vi
 	fColourPickerWindow = nullptr;
 	fColourPickerMessage = nullptr;
 
+	//printf("Effect_Plugin::Constructor::%s (%p)\n", plugin->mHeader.name.c_str(), this);
+}
+
+/*	FUNCTION:		Effect_Plugin :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Plugin :: InitGui()
+{
+	const float kFontFactor = be_plain_font->Size()/20.0f;
+	EffectPlugin *plugin = fPlugin;
 	int count_radio_buttons = 0;
 
 	//	Init Gui objects
@@ -399,7 +411,6 @@ Effect_Plugin :: Effect_Plugin(EffectPlugin *plugin, BRect frame, const char *vi
 				assert(0);
 		}
 	}
-	//printf("Effect_Plugin::Constructor::%s (%p)\n", plugin->mHeader.name.c_str(), this);
 }
 
 /*	FUNCTION:		Effect_Plugin :: ~Effect_Plugin
@@ -415,6 +426,7 @@ Effect_Plugin :: ~Effect_Plugin()
 		fColourPickerWindow = nullptr;
 	}
 	delete fPlugin->mLanguage;
+	delete fPlugin->mIcon;
 	delete fPlugin;
 }
 
@@ -425,6 +437,7 @@ Effect_Plugin :: ~Effect_Plugin()
 */
 void Effect_Plugin :: AttachedToWindow()
 {
+	CreateGui();
 	assert(fGuiWidgets.size() == fPlugin->mFragmentShader.gui_widgets.size());
 	size_t idx = 0;
 	while (idx < fPlugin->mFragmentShader.gui_widgets.size())
@@ -517,6 +530,8 @@ void Effect_Plugin :: DestroyRenderObjects()
 */
 BBitmap * Effect_Plugin :: GetIcon()
 {
+	if (fPlugin->mIcon)
+		return new BBitmap(fPlugin->mIcon);
 	BBitmap *icon = BTranslationUtils::GetBitmap(fPlugin->mHeader.icon.c_str());
 	return icon;
 }
@@ -533,6 +548,7 @@ const char * Effect_Plugin :: GetTextB(const uint32 language_idx)			{return fPlu
 */
 MediaEffect * Effect_Plugin :: CreateMediaEffect()
 {
+	CreateGui();		//	radio button state
 	ImageMediaEffect *media_effect = new ImageMediaEffect;
 	media_effect->mEffectNode = this;
 
@@ -618,16 +634,50 @@ MediaEffect * Effect_Plugin :: CreateMediaEffect()
 */
 void Effect_Plugin :: RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
 {
-	float t = float(frame_idx - data->mTimelineFrameStart)/float(data->Duration());
-	if (t > 1.0f)
-		t = 1.0f;
-		
 	if (!fRenderNode)
 	{
 		printf("Effect_Plugin(%s) - invalid render node\n", GetEffectName());
 		return;	
 	}	
 
+	if (source)
+		fRenderNode->mTexture = gRenderActor->GetPicture((unsigned int)source->Bounds().Width() + 1, (unsigned int)source->Bounds().Height() + 1, source)->mTexture;
+	if (fTextureUnit1)
+		fTextureUnit1->Upload(gRenderActor->GetCurrentFrameBufferTexture());
+	RenderPlugin(fRenderNode->mTexture, fTextureUnit1, data, frame_idx);
+}
+
+/*	FUNCTION:		Effect_Plugin :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect (GPU resident source, frame buffer sampled directly)
+*/
+void Effect_Plugin :: RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	if (!fRenderNode)
+	{
+		printf("Effect_Plugin(%s) - invalid render node\n", GetEffectName());
+		return;	
+	}	
+
+	if (source)
+		fRenderNode->mTexture = source;
+	RenderPlugin(fRenderNode->mTexture, gRenderActor->GetCurrentFrameBufferTextureGPU(), data, frame_idx);
+}
+
+/*	FUNCTION:		Effect_Plugin :: RenderPlugin
+	ARGS:			source
+					texture_unit1
+					data
+					frame_idx
+	RETURN:			n/a
+	DESCRIPTION:	Set uniforms and render
+*/
+void Effect_Plugin :: RenderPlugin(yrender::YTexture *source, yrender::YTexture *texture_unit1, MediaEffect *data, int64 frame_idx)
+{
 	PluginFragmentShader *fragment_shader = (PluginFragmentShader *)fRenderNode->mShaderNode;
 	if (!fragment_shader->IsValid())
 	{
@@ -681,16 +731,77 @@ void Effect_Plugin :: RenderEffect(BBitmap *source, MediaEffect *data, int64 fra
 	}
 
 	fragment_shader->SwapTextureUnits(effect_data->swap_texture_units);
-	if (source)
-		fRenderNode->mTexture = gRenderActor->GetPicture((unsigned int)source->Bounds().Width() + 1, (unsigned int)source->Bounds().Height() + 1, source)->mTexture;
-	if (fragment_shader->GetNumberTextureUnits() == 2)
+	if ((fragment_shader->GetNumberTextureUnits() == 2) && texture_unit1)
 	{
-		fTextureUnit1->Upload(gRenderActor->GetCurrentFrameBufferTexture());
-		fTextureUnit1->Render(0.0f);
+		yrender::yRenderState.BindTexture(GL_TEXTURE_2D, texture_unit1->GetTextureId(), GL_TEXTURE1);
 	}
+	fRenderNode->mTexture = source;
 	fRenderNode->Render(0.0f);
 }
 
+/*	FUNCTION:		Effect_Plugin :: GetColourFusionSource
+	ARGS:			data
+	RETURN:			fusion shader source (nullptr if plugin not fusable)
+	DESCRIPTION:	Plugin opts in with "fragment":"fusion" object
+*/
+const char * Effect_Plugin :: GetColourFusionSource(MediaEffect *data)
+{
+	if (fPlugin->mFragmentShader.fusion_text.empty() || !fRenderNode)
+		return nullptr;
+	if (((PluginFragmentShader *)fRenderNode->mShaderNode)->GetNumberTextureUnits() > 1)
+		return nullptr;
+	return fPlugin->mFragmentShader.fusion_text.c_str();
+}
+
+/*	FUNCTION:		Effect_Plugin :: SetColourFusionUniforms
+	ARGS:			program
+					stage
+					data
+					frame_idx
+	RETURN:			n/a
+	DESCRIPTION:	Set fused stage uniforms (program is active)
+*/
+void Effect_Plugin :: SetColourFusionUniforms(ColourFusionProgram *program, const int stage, MediaEffect *data, int64 frame_idx)
+{
+	EffectPluginData *effect_data = (EffectPluginData *)data->mEffectData;
+	assert(effect_data->uniforms.size() == fPlugin->mFragmentShader.uniforms.size());
+	for (int idx = 0; idx < effect_data->uniforms.size(); idx++)
+	{
+		const DynamicUniform &u = effect_data->uniforms[idx];
+		if (u.mType == PluginUniform::UniformType::eSampler2D)
+			continue;
+
+		const GLint location = program->GetUniformLocation(fPlugin->mFragmentShader.uniforms[idx].name.c_str(), stage);
+		switch (u.mType)
+		{
+			case PluginUniform::UniformType::eFloat:		glUniform1f(location, u.mFloat);					break;
+			case PluginUniform::UniformType::eInt:			glUniform1i(location, u.mInt);						break;
+			case PluginUniform::UniformType::eVec2:			glUniform2fv(location, 1, u.mVec);					break;
+			case PluginUniform::UniformType::eVec3:			glUniform3fv(location, 1, u.mVec);					break;
+			case PluginUniform::UniformType::eVec4:			glUniform4fv(location, 1, u.mVec);					break;
+			case PluginUniform::UniformType::eColour:
+			{
+				//	BGRA
+				const float colour[4] = {u.mVec[2], u.mVec[1], u.mVec[0], u.mVec[3]};
+				glUniform4fv(location, 1, colour);
+				break;
+			}
+			case PluginUniform::UniformType::eTimestamp:
+				glUniform1f(location, float(double(frame_idx - data->mTimelineFrameStart)/(double)kFramesSecond));
+				break;
+			case PluginUniform::UniformType::eInterval:
+				glUniform1f(location, float(double(frame_idx - data->mTimelineFrameStart)/(double)data->Duration()));
+				break;
+			case PluginUniform::UniformType::eRsolution:
+				glUniform2f(location, gProject->mResolution.width, gProject->mResolution.height);
+				break;
+
+			default:
+				assert(0);
+		}
+	}
+}
+
 /*	FUNCTION:		Effect_Plugin :: MediaEffectSelected
 	ARGS:			effect
 	RETURN:			n/a
@@ -700,6 +811,7 @@ void Effect_Plugin :: MediaEffectSelected(MediaEffect *effect)
 {
 	if (effect->mEffectData == nullptr)
 		return;
+	CreateGui();
 
 	//	Update GUI
 	EffectPluginData *effect_data = (EffectPluginData *)effect->mEffectData;
@@ -931,6 +1043,7 @@ void Effect_Plugin :: OutputViewMouseDown(MediaEffect *media_effect, const BPoin
 {
 	if (!media_effect)
 		return;
+	CreateGui();
 
 	EffectPluginData *effect_data = (EffectPluginData *)media_effect->mEffectData;
 	int gui_idx = 0;
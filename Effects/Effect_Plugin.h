@@ -66,6 +66,8 @@ struct PluginShader
 	std::vector<PluginUniform>		uniforms;
 	std::string						source_file;
 	std::string						source_text;
+	std::string						fusion_file;		//	optional, per pixel effects (see ColourFusion.h)
+	std::string						fusion_text;
 	std::vector<PluginGuiWidget>	gui_widgets;
 };
 struct EffectPlugin
@@ -73,8 +75,9 @@ struct EffectPlugin
 	PluginHeader					mHeader;
 	PluginShader					mFragmentShader;
 	LanguageJson					*mLanguage;
+	BBitmap							*mIcon;				//	decoded when descriptor loaded
 
-	EffectPlugin() : mLanguage(nullptr) { }
+	EffectPlugin() : mLanguage(nullptr), mIcon(nullptr) { }
 };
 
 /*********************************
@@ -88,6 +91,7 @@ class Effect_Plugin : public EffectNode
 	BScrollView				*fScrollView;
 	std::vector<BView *>	fGuiWidgets;
 	yrender::YTexture		*fTextureUnit1;
+	void					RenderPlugin(yrender::YTexture *source, yrender::YTexture *texture_unit1, MediaEffect *data, int64 frame_idx);
 
 	Magnify::TWindow		*fColourPickerWindow;
 	BitmapCheckbox			*fColourPickerButton;
@@ -98,6 +102,7 @@ public:
 					~Effect_Plugin()								override;
 
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
 	
@@ -114,6 +119,9 @@ public:
 	MediaEffect		*CreateMediaEffect()							override;
 	
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects) override;
+	void			RenderEffect(yrender::YTexture *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects) override;
+	const char		*GetColourFusionSource(MediaEffect *data)		override;
+	void			SetColourFusionUniforms(ColourFusionProgram *program, const int stage, MediaEffect *data, int64 frame_idx)	override;
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 	void			MessageReceived(BMessage *msg)					override;
 	void			OutputViewMouseDown(MediaEffect *media_effect, const BPoint &point)		override;
@@ -17,6 +17,7 @@
 #include "Yarra/Render/Shader.h"
 #include "Yarra/Render/MatrixStack.h"
 #include "Yarra/Render/Picture.h"
+#include "Yarra/Render/BlurPyramid.h"
 
 #include "Editor/EffectNode.h"
 #include "Editor/ImageUtility.h"
@@ -125,9 +126,10 @@ static const YGeometry_P3T2 kBlurGeometry[] =
 	{1, 1, 0,		1, 1},
 };
 static const float kDefaultBlurDirection = 4.5f;
+static const float kPyramidRadiusScale = 2.0f;		//	pyramid sigma (pixels) per blur_direction
 
 /************************
-	Blur Shader
+	Blur Shader (composites YBlurPyramid result)
 *************************/
 static const char *kVertexShader_Blur = "\
 	uniform mat4	uTransform;\
@@ -141,31 +143,10 @@ static const char *kVertexShader_Blur = "\
 
 static const char *kFragmentShader_Blur = "\
 	uniform sampler2D	uTextureUnit0;\
-	uniform vec2		uDirection;\
-	uniform vec2		uResolution;\
 	in vec2				vTexCoord0;\
 	out vec4			fFragColour;\
-	const float sigma = 4.0;\
-	const float pi = 3.14159265f;\
-	const int numBlurPixelsPerSide = 3;\
 	void main(void) {\
-		vec3 incrementalGaussian;\
-		incrementalGaussian.x = 1.0f / (sqrt(2.0f * pi) * sigma);\
-		incrementalGaussian.y = exp(-0.5f / (sigma * sigma));\
-		incrementalGaussian.z = incrementalGaussian.y * incrementalGaussian.y;\
-		vec4 avgValue = vec4(0.0f, 0.0f, 0.0f, 0.0f);\
-		float coefficientSum = 0.0f;\
-		avgValue += texture(uTextureUnit0, vTexCoord0) * incrementalGaussian.x;\
-		coefficientSum += incrementalGaussian.x;\
-		incrementalGaussian.xy *= incrementalGaussian.yz;\
-		for (int i = 1; i <= numBlurPixelsPerSide; i++)\
-		{\
-			avgValue += texture(uTextureUnit0, vTexCoord0 - i*uDirection/uResolution) * incrementalGaussian.x;\
-			avgValue += texture(uTextureUnit0, vTexCoord0 + i*uDirection/uResolution) * incrementalGaussian.x;\
-			coefficientSum += 2.0 * incrementalGaussian.x;\
-			incrementalGaussian.xy *= incrementalGaussian.yz;\
-		}\
-		fFragColour = avgValue / coefficientSum;\
+		fFragColour = texture(uTextureUnit0, vTexCoord0);\
 	}";
 
 class PortraitBlurShader : public yrender::YShaderNode
@@ -174,11 +155,6 @@ private:
 	yrender::YShader	*fShader;
 	GLint				fLocation_uTransform;
 	GLint				fLocation_uTextureUnit0;
-	GLint				fLocation_uDirection;
-	GLint				fLocation_uResolution;
-
-	ymath::YVector2		fDirection;
-	ymath::YVector2		fResolution;
 
 public:
 	PortraitBlurShader()
@@ -189,25 +165,16 @@ public:
 		fShader = new yrender::YShader(&attributes, kVertexShader_Blur, kFragmentShader_Blur);
 		fLocation_uTransform = fShader->GetUniformLocation("uTransform");
 		fLocation_uTextureUnit0 = fShader->GetUniformLocation("uTextureUnit0");
-		fLocation_uDirection = fShader->GetUniformLocation("uDirection");
-		fLocation_uResolution = fShader->GetUniformLocation("uResolution");
-
-		fDirection = ymath::YVector2(kDefaultBlurDirection, kDefaultBlurDirection);
-		fResolution.Set(gProject->mResolution.width, gProject->mResolution.height);
 	}
 	~PortraitBlurShader()
 	{
 		delete fShader;
 	}
-	void	SetDirection(const float x, const float y) {fDirection.Set(x, y);}
-	void	SetResolution(const float width, const float height) {fResolution.Set(width, height);}
 	void	Render(float delta_time)
 	{
 		fShader->EnableProgram();
 		glUniformMatrix4fv(fLocation_uTransform, 1, GL_FALSE, yrender::yMatrixStack.GetMVPMatrix().m);
 		glUniform1i(fLocation_uTextureUnit0, 0);
-		glUniform2fv(fLocation_uResolution, 1, fResolution.v);
-		glUniform2fv(fLocation_uDirection, 1, fDirection.v);
 	}
 };
 
@@ -250,7 +217,16 @@ using namespace yrender;
 	DESCRIPTION:	Constructor
 */
 Effect_PortraitBlur :: Effect_PortraitBlur(BRect frame, const char *filename)
-	: EffectNode(frame, filename), fBlurRenderNode(nullptr)
+	: EffectNode(frame, filename), fBlurRenderNode(nullptr), fBlurPyramid(nullptr)
+{
+}
+
+/*	FUNCTION:		Effect_PortraitBlur :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_PortraitBlur :: InitGui()
 {
 	const float kFontFactor = be_plain_font->Size()/20.0f;
 
@@ -372,6 +348,8 @@ void Effect_PortraitBlur :: InitRenderObjects()
 	fBlurRenderNode->mShaderNode = new PortraitBlurShader;
 	fBlurRenderNode->mGeometryNode = new yrender::YGeometryNode(GL_TRIANGLE_STRIP, Y_GEOMETRY_P3T2, (float *)kBlurGeometry, 4);
 	fBlurRenderNode->mTexture = new YTexture(width, height);//, YTexture::YTF_REPEAT);
+
+	fBlurPyramid = new YBlurPyramid;
 }
 
 /*	FUNCTION:		Effect_PortraitBlur :: DestroyRenderObjects
@@ -381,6 +359,7 @@ void Effect_PortraitBlur :: InitRenderObjects()
 */
 void Effect_PortraitBlur :: DestroyRenderObjects()
 {
+	delete fBlurPyramid;
 	delete fBlurRenderNode;
 }
 
@@ -505,36 +484,18 @@ void Effect_PortraitBlur :: RenderEffect(BBitmap *source, MediaEffect *data, int
 	yrender::YPicture *picture = gRenderActor->GetPicture(w, h, source);
 	float aspect = (float)gProject->mResolution.width / (float)gProject->mResolution.height;
 
-	fBlurRenderNode->mSpatial.SetPosition(YVector3(0.5f*gProject->mResolution.width, 0.5f*gProject->mResolution.height, 0));
-	fBlurRenderNode->mSpatial.SetRotation(YVector3(0.0f, 0.0f, 0.0f));
-	fBlurRenderNode->mSpatial.SetScale(YVector3(0.5f*gProject->mResolution.width, 0.5f*gProject->mResolution.height, 0));
-
-	PortraitBlurShader *blur_shader = (PortraitBlurShader *) fBlurRenderNode->mShaderNode;
-	blur_shader->SetResolution(gProject->mResolution.width, gProject->mResolution.height);
-
-	//	Horizontal blur
-	blur_shader->SetDirection(portrait_data->blur_direction, 0.0f);
+	//	Background blur (GPU resident pyramid, no readback)
 	fBlurRenderNode->mTexture->Upload(source);
-	gRenderActor->ActivateSecondaryRenderBuffer();
-	fBlurRenderNode->Render(0.0f);
-	gRenderActor->DeactivateSecondaryRenderBuffer();
-	fBlurRenderNode->mTexture->Upload(gRenderActor->GetSecondaryFrameBufferTexture());
-
-	//	Repeat the horizontal blur (looks nicer)
-	gRenderActor->ActivateSecondaryRenderBuffer();
-	fBlurRenderNode->Render(0.0f);
-	gRenderActor->DeactivateSecondaryRenderBuffer();
-	fBlurRenderNode->mTexture->Upload(gRenderActor->GetSecondaryFrameBufferTexture());
+	YTexture *texture = fBlurRenderNode->mTexture;
+	fBlurRenderNode->mTexture = fBlurPyramid->Render(texture, kPyramidRadiusScale*portrait_data->blur_direction);
 
-	//	Rotation blur
-	blur_shader->SetDirection(0.0f, portrait_data->blur_direction);
 	fBlurRenderNode->mSpatial.SetPosition(portrait_data->blur_position);
 	fBlurRenderNode->mSpatial.SetRotation(portrait_data->blur_rotation);
 	fBlurRenderNode->mSpatial.SetScale(YVector3(0.5f*portrait_data->blur_scale.x*gProject->mResolution.height,
 												0.5f*portrait_data->blur_scale.y*gProject->mResolution.height,
 												1));
-	//blur_shader->SetDirection(0.0f, portrait_data->blur_direction);
 	fBlurRenderNode->Render(0.0f);
+	fBlurRenderNode->mTexture = texture;
 
 	picture->mSpatial.SetPosition(portrait_data->portrait_position);
 	picture->mSpatial.SetRotation(portrait_data->portrait_rotation);
@@ -15,6 +15,7 @@ namespace yrender
 {
 	class YPicture;
 	class YRenderNode;
+	class YBlurPyramid;
 };
 
 class BBitmap;
@@ -27,6 +28,7 @@ public:
 					Effect_PortraitBlur(BRect frame, const char *filename);
 					~Effect_PortraitBlur()							override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	void			InitRenderObjects()								override;
 	void			DestroyRenderObjects()							override;
 
@@ -50,6 +52,7 @@ public:
 	
 private:
 	yrender::YRenderNode 	*fBlurRenderNode;
+	yrender::YBlurPyramid	*fBlurPyramid;
 	ValueSlider				*fBlurSlider;
 };
 
@@ -74,7 +74,15 @@ Effect_Rotate :: Effect_Rotate(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
 {
 	SetViewColor(B_TRANSPARENT_COLOR);
-	
+}
+
+/*	FUNCTION:		Effect_Rotate :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Rotate :: InitGui()
+{
 	//	Popup direction
 	BOptionPopUp *popup_direction = new BOptionPopUp(BRect(20, 20, 600, 70), "direction", GetText(TXT_EFFECTS_ROTATE_DIRECTION), new BMessage(kMsgDirection));
 	for (int i=0; i < sizeof(kRotateParameters)/sizeof(ROTATE_PARAMETERS); i++)
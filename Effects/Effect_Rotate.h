@@ -23,6 +23,7 @@ public:
 					Effect_Rotate(BRect frame, const char *filename);
 					~Effect_Rotate()									override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 	
 	EFFECT_GROUP	GetEffectGroup() const							override		{return EffectNode::EFFECT_SPATIAL;}
 	const char		*GetVendorName() const							override;
@@ -19,6 +19,7 @@ public:
 					Effect_Speed(BRect frame, const char *filename);
 					~Effect_Speed();
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 
 	EFFECT_GROUP	GetEffectGroup() const							override	{return EffectNode::EFFECT_SPATIAL;}
 	const char		*GetVendorName() const							override;
@@ -5,6 +5,13 @@
  */
 
 #include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
 
 #include <InterfaceKit.h>
 #include <translation/TranslationUtils.h>
@@ -15,10 +22,13 @@
 #include "Yarra/Render/Texture.h"
 #include "Yarra/Render/Shader.h"
 #include "Yarra/Render/MatrixStack.h"
+#include "Yarra/Render/RenderState.h"
+#include "Yarra/FreeTypeGL/FTUnicode.h"
 
 #include "Editor/EffectNode.h"
 #include "Editor/Language.h"
 #include "Editor/Project.h"
+#include "Editor/SoftwareRender.h"
 
 #include "Gui/AlphaColourControl.h"
 #include "Gui/FontPanel.h"
@@ -98,6 +108,173 @@ public:
 	}
 };
 
+/************************
+	SoftwareTextFont rasterises text lines with FreeType (software render has no GL context).
+	Layout matches FTGLTextureFont / FTTextureGlyph (unhinted glyphs, unfitted kerning,
+	glyph quads at floor(pen + corner), flipped Y), so line bitmaps are drawn with the
+	same transforms as YTextScene.
+*************************/
+class SoftwareTextFont
+{
+public:
+	struct LINE
+	{
+		int					x, y;			//	glyph bounds (geometry units, Y down, baseline at y=0)
+		int					width, height;
+		float				advance;		//	YTextScene::GetWidth()
+		std::vector<uint8>	coverage;
+	};
+
+	SoftwareTextFont(const char *font_file, const int font_size)
+		: fFontPath(font_file), fFontSize(font_size), fLibrary(nullptr), fFace(nullptr), fBitmap(nullptr)
+	{
+		if (FT_Init_FreeType(&fLibrary) != 0)
+		{
+			fLibrary = nullptr;
+			return;
+		}
+		if ((FT_New_Face(fLibrary, font_file, 0, &fFace) != 0) || (FT_Set_Char_Size(fFace, 0, font_size*64, 72, 72) != 0))
+		{
+			printf("SoftwareTextFont() Cannot load font (%s)\n", font_file);
+			if (fFace)
+				FT_Done_Face(fFace);
+			fFace = nullptr;
+		}
+	}
+	~SoftwareTextFont()
+	{
+		delete fBitmap;
+		if (fFace)
+			FT_Done_Face(fFace);
+		if (fLibrary)
+			FT_Done_FreeType(fLibrary);
+	}
+	const bool		IsValid() const							{return fFace != nullptr;}
+	const bool		Matches(const BString &font_path, const int font_size) const	{return (fFontSize == font_size) && (fFontPath == font_path);}
+	const float		GetAscent() const						{return fFace->size->metrics.ascender/64.0f;}
+	const float		GetDescent() const						{return fFace->size->metrics.descender/64.0f;}
+
+	/*	FUNCTION:		SoftwareTextFont :: Layout
+		ARGS:			text (UTF-8)
+						line (output)
+		RETURN:			n/a
+		DESCRIPTION:	Rasterise glyphs into line coverage (overlapping glyphs are blended)
+	*/
+	void Layout(const char *text, LINE &line)
+	{
+		struct GLYPH
+		{
+			int					x, y;
+			int					width, height;
+			std::vector<uint8>	pixels;
+		};
+		std::vector<GLYPH> glyphs;
+		float pen = 0.0f;
+		FTUnicodeStringItr<unsigned char> it((const unsigned char *)text);
+		while (*it)
+		{
+			const FT_UInt index = FT_Get_Char_Index(fFace, *it++);
+			if ((FT_Load_Glyph(fFace, index, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP) != 0) ||
+				(FT_Render_Glyph(fFace->glyph, FT_RENDER_MODE_NORMAL) != 0))
+				continue;
+			const FT_GlyphSlot slot = fFace->glyph;
+			const FT_Bitmap &bitmap = slot->bitmap;
+			if ((bitmap.width > 0) && (bitmap.rows > 0))
+			{
+				GLYPH glyph;
+				glyph.x = (int)floorf(pen + slot->bitmap_left);
+				glyph.y = -slot->bitmap_top;
+				glyph.width = bitmap.width;
+				glyph.height = bitmap.rows;
+				glyph.pixels.resize(glyph.width*glyph.height);
+				for (int row=0; row < glyph.height; row++)
+					memcpy(&glyph.pixels[row*glyph.width], bitmap.buffer + row*bitmap.pitch, glyph.width);
+				glyphs.push_back(std::move(glyph));
+			}
+			FT_Vector kerning = {0, 0};
+			if (*it)
+				FT_Get_Kerning(fFace, index, FT_Get_Char_Index(fFace, *it), FT_KERNING_UNFITTED, &kerning);
+			pen += (slot->advance.x + kerning.x)/64.0f;
+		}
+
+		line.advance = pen;
+		line.width = line.height = 0;
+		line.coverage.clear();
+		if (glyphs.empty())
+			return;
+		int x0 = glyphs[0].x, y0 = glyphs[0].y;
+		int x1 = x0 + glyphs[0].width, y1 = y0 + glyphs[0].height;
+		for (auto &g : glyphs)
+		{
+			x0 = std::min(x0, g.x);		x1 = std::max(x1, g.x + g.width);
+			y0 = std::min(y0, g.y);		y1 = std::max(y1, g.y + g.height);
+		}
+		line.x = x0;
+		line.y = y0;
+		line.width = x1 - x0;
+		line.height = y1 - y0;
+		line.coverage.assign(line.width*line.height, 0);
+		for (auto &g : glyphs)
+		{
+			for (int row=0; row < g.height; row++)
+			{
+				uint8 *d = &line.coverage[(g.y - y0 + row)*line.width + (g.x - x0)];
+				const uint8 *s = &g.pixels[row*g.width];
+				for (int col=0; col < g.width; col++)
+					d[col] = (uint8)(d[col] + s[col] - (d[col]*s[col] + 127)/255);
+			}
+		}
+	}
+
+	/*	FUNCTION:		SoftwareTextFont :: DrawLine
+		ARGS:			render
+						destination
+						line
+						colour (BGRA)
+		RETURN:			n/a
+		DESCRIPTION:	Draw line with current yMatrixStack (YTextScene transform, includes alignment offset)
+	*/
+	void DrawLine(SoftwareRender *render, BBitmap *destination, const LINE &line, const float colour[4])
+	{
+		if ((line.width == 0) || (line.height == 0))
+			return;
+		if (!fBitmap || (fBitmap->Bounds().IntegerWidth() + 1 != line.width) || (fBitmap->Bounds().IntegerHeight() + 1 != line.height))
+		{
+			delete fBitmap;
+			fBitmap = new BBitmap(BRect(0, 0, line.width - 1, line.height - 1), B_RGBA32);
+		}
+		uint8 bgr[3];
+		for (int c=0; c < 3; c++)
+			bgr[c] = (uint8)lrintf(std::clamp(colour[c], 0.0f, 1.0f)*255.0f);
+		const float alpha = std::clamp(colour[3], 0.0f, 1.0f);
+		for (int y=0; y < line.height; y++)
+		{
+			uint8 *d = (uint8 *)fBitmap->Bits() + y*fBitmap->BytesPerRow();
+			const uint8 *s = &line.coverage[y*line.width];
+			for (int x=0; x < line.width; x++, d += 4)
+			{
+				d[0] = bgr[0];
+				d[1] = bgr[1];
+				d[2] = bgr[2];
+				d[3] = (uint8)lrintf(alpha*s[x]);
+			}
+		}
+
+		yMatrixStack.Push();
+		yMatrixStack.Translate(line.x + 0.5f*line.width, line.y + 0.5f*line.height, 0.0f);
+		yMatrixStack.Scale(0.5f*line.width, 0.5f*line.height, 1.0f);
+		render->DrawPicture(destination, fBitmap, yMatrixStack.GetMVPMatrix());
+		yMatrixStack.Pop();
+	}
+
+private:
+	BString			fFontPath;
+	int				fFontSize;
+	FT_Library		fLibrary;
+	FT_Face			fFace;
+	BBitmap			*fBitmap;
+};
+
 static BPoint				sMouseDownPosition;
 static ymath::YVector3		sTextPositionMouseDown;
 
@@ -130,12 +307,25 @@ public:
 Effect_Text :: Effect_Text(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
 {
-	const float kFontFactor = be_plain_font->Size()/20.0f;
-
 	fRenderNode = nullptr;
 	fTextScene = nullptr;
+	fTextSceneFontSize = 0;
 	fOpenGLPendingUpdate = false;
 	fIs3dFont = false;
+	fSoftwareFont = nullptr;
+	fFontPanel = nullptr;
+	fFontMessenger = nullptr;
+}
+
+/*	FUNCTION:		Effect_Text :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Text :: InitGui()
+{
+	const BRect frame = Bounds();
+	const float kFontFactor = be_plain_font->Size()/20.0f;
 
 	//	Text view
 	float scroll_scale = be_plain_font->Size()/12.0f;
@@ -151,8 +341,6 @@ Effect_Text :: Effect_Text(BRect frame, const char *filename)
 	mEffectView->AddChild(title);
 
 	//	Font panel
-	fFontPanel = nullptr;
-	fFontMessenger = nullptr;
 	fFontButton = new BButton(BRect(20*kFontFactor, 240, 100*kFontFactor, 270), "font_button", GetText(TXT_EFFECTS_TEXT_SIMPLE_FONT), new BMessage(kMsgFontButton));
 	mEffectView->AddChild(fFontButton);
 
@@ -197,6 +385,7 @@ Effect_Text :: ~Effect_Text()
 {
 	delete fFontPanel;
 	delete fFontMessenger;
+	delete fSoftwareFont;
 }
 
 /*	FUNCTION:		Effect_Text :: InitRenderObjects
@@ -350,15 +539,28 @@ void Effect_Text :: InitMediaEffect(MediaEffect *media_effect)
 void Effect_Text :: CreateOpenGLObjects(EffectTextData *data)
 {
 	assert(data != nullptr);
-	if (fTextScene)
-		delete fTextScene;
+	//	Create new scene before deleting old, so shared font resources (glyph atlas, cached layouts) survive
+	yrender::YTextScene *old_scene = fTextScene;
 	fTextScene = new yrender::YTextScene(new yrender::YFontFreetype(data->font_size, data->font_path.String()), true);
+	delete old_scene;
+	fTextSceneFontPath = data->font_path;
+	fTextSceneFontSize = data->font_size;
 	fTextScene->SetText(data->text.String());
 	fTextScene->SetColour(YVector4(data->font_colour.red/255.0f, data->font_colour.green/255.0f, data->font_colour.blue/255.0f, data->font_colour.alpha/255.0f));
 	//fTextScene->mSpatial.SetPosition(data->position);
 	fOpenGLPendingUpdate = false;
 }
 
+/*	FUNCTION:		Effect_Text :: IsFontChanged
+	ARGS:			data
+	RETURN:			true if media effect font differs from fTextScene font
+	DESCRIPTION:	fTextScene is shared by every media effect (clips may use different fonts)
+*/
+bool Effect_Text :: IsFontChanged(EffectTextData *data) const
+{
+	return (fTextScene == nullptr) || (fTextSceneFontSize != data->font_size) || (fTextSceneFontPath != data->font_path);
+}
+
 /*	FUNCTION:		Effect_Text :: MediaEffectSelected
 	ARGS:			effect
 	RETURN:			n/a
@@ -420,7 +622,7 @@ void Effect_Text :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int
 	EffectTextData *data = (EffectTextData *) media_effect->mEffectData;
 	assert(data);
 
-	if (fTextScene == nullptr)
+	if (IsFontChanged(data))
 		CreateOpenGLObjects(data);
 
 	//	Split text into lines (use "\n" as seperator)
@@ -429,7 +631,7 @@ void Effect_Text :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int
 	if (string_list.IsEmpty())
 		return;
 
-	glEnable(GL_BLEND);
+	yrender::yRenderState.SetBlend(true);
 
 	// Text
 	if (fOpenGLPendingUpdate)
@@ -526,6 +728,109 @@ void Effect_Text :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int
 	yMatrixStack.Pop();
 }
 
+/*	FUNCTION:		Effect_Text :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					media_effect
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect()
+*/
+bool Effect_Text :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *media_effect, int64 frame_idx)
+{
+	RenderTextSoftware(render, destination, (EffectTextData *) media_effect->mEffectData, 0.5f);
+	return true;
+}
+
+/*	FUNCTION:		Effect_Text :: RenderTextSoftware
+	ARGS:			render
+					destination
+					data
+					alignment (0.0 = left, 0.5 = centre, 1.0 = right)
+	RETURN:			n/a
+	DESCRIPTION:	Software equivalent of text rendering in RenderEffect()
+*/
+void Effect_Text :: RenderTextSoftware(SoftwareRender *render, BBitmap *destination, EffectTextData *data, const float alignment)
+{
+	assert(data);
+	if (!fSoftwareFont || !fSoftwareFont->Matches(data->font_path, data->font_size))
+	{
+		delete fSoftwareFont;
+		fSoftwareFont = new SoftwareTextFont(data->font_path.String(), data->font_size);
+	}
+	if (!fSoftwareFont->IsValid())
+		return;
+
+	//	Split text into lines (use "\n" as seperator)
+	BStringList string_list;
+	data->text.Split("\n", true, string_list);
+	if (string_list.IsEmpty())
+		return;
+
+	const int count_lines = string_list.CountStrings();
+	std::vector<SoftwareTextFont::LINE> lines(count_lines);
+	float x_width = 0.0f;
+	for (int si = 0; si < count_lines; si++)
+	{
+		fSoftwareFont->Layout(string_list.StringAt(si).String(), lines[si]);
+		if (lines[si].advance > x_width)
+			x_width = lines[si].advance;
+	}
+	const float ascent = fSoftwareFont->GetAscent();
+	const float descent = fSoftwareFont->GetDescent();
+	const float background_height = (ascent - 0.5f*descent);
+
+	const float background_colour[4] = {data->background_colour.blue/255.0f, data->background_colour.green/255.0f,
+										data->background_colour.red/255.0f, data->background_colour.alpha/255.0f};		//	BGRA
+	const float shadow_colour[4] = {0.0f, 0.0f, 0.0f, data->font_colour.alpha/255.0f};
+	const float font_colour[4] = {data->font_colour.blue/255.0f, data->font_colour.green/255.0f,
+								  data->font_colour.red/255.0f, data->font_colour.alpha/255.0f};		//	BGRA
+	BBitmap *background = nullptr;
+	if (data->background)
+	{
+		background = new BBitmap(BRect(0, 0, 0, 0), B_RGBA32);
+		uint8 *p = (uint8 *)background->Bits();
+		for (int c=0; c < 4; c++)
+			p[c] = (uint8)lrintf(255.0f*background_colour[c]);
+	}
+
+	yMatrixStack.Push();
+	yMatrixStack.Translate(data->position);
+	for (int si = count_lines - 1; si >= 0; si--)	//	backward due to descend characters (yg)
+	{
+		yMatrixStack.Push();
+		float y_offset = data->font_size * (0.5f*(count_lines-1) - si) * 1.025;
+		yMatrixStack.Translate(0.0f, -y_offset, 0.0f);
+
+		//	Background (fRenderNode)
+		if (background)
+		{
+			yMatrixStack.Push();
+			yMatrixStack.Translate(0.0f, 0.0f - 0.5f*background_height + 0.4f*descent - data->background_offset, 0.0f);
+			yMatrixStack.Scale(0.52f*x_width, 0.5f*background_height, 1.0f);
+			render->DrawPicture(destination, background, yMatrixStack.GetMVPMatrix());
+			yMatrixStack.Pop();
+		}
+
+		//	YTextScene alignment (ALIGN_VCENTER)
+		const ymath::YVector3 offset(-alignment*lines[si].advance, -0.5f*(ascent + descent), 0.0f);
+		if (data->shadow)
+		{
+			yMatrixStack.Push();
+			yMatrixStack.Translate(data->shadow_offset.x, -data->shadow_offset.y, 0);
+			yMatrixStack.Translate(offset.x, offset.y, offset.z);
+			fSoftwareFont->DrawLine(render, destination, lines[si], shadow_colour);
+			yMatrixStack.Pop();
+		}
+		yMatrixStack.Translate(offset.x, offset.y, offset.z);
+		fSoftwareFont->DrawLine(render, destination, lines[si], font_colour);
+		yMatrixStack.Pop();
+	}
+	yMatrixStack.Pop();
+	delete background;
+}
+
 /*	FUNCTION:		Effect_Text :: MessageReceived
 	ARGS:			msg
 	RETURN:			true if processed
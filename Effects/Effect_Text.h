@@ -37,6 +37,7 @@ class BTextView;
 class AlphaColourControl;
 class FontPanel;
 class Spinner;
+class SoftwareTextFont;
 
 class Effect_Text : public EffectNode
 {
@@ -44,6 +45,7 @@ public:
 						Effect_Text(BRect frame, const char *filename);
 						~Effect_Text()								override;
 	virtual void		AttachedToWindow()							override;
+	virtual void		InitGui()									override;
 
 	void				InitRenderObjects();
 	void				DestroyRenderObjects();
@@ -65,6 +67,7 @@ public:
 	void				OutputViewMouseDown(MediaEffect *media_effect, const BPoint &point)		override;
 	void				OutputViewMouseMoved(MediaEffect *media_effect, const BPoint &point)	override;
 	virtual void		RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	virtual bool		RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 
 	virtual void		MessageReceived(BMessage *msg)				override;
 
@@ -90,11 +93,16 @@ protected:
 	BTextView				*fTextView;
 	yrender::YRenderNode 	*fRenderNode;
 	yrender::YTextScene		*fTextScene;
+	BString					fTextSceneFontPath;		//	fTextScene shared by all media effects
+	int						fTextSceneFontSize;
 	bool					fOpenGLPendingUpdate;
 	bool					fIs3dFont;
+	SoftwareTextFont		*fSoftwareFont;			//	software render (no GL context)
 
 	void					InitMediaEffect(MediaEffect *effect);
 	virtual void			CreateOpenGLObjects(EffectTextData *data);	//	Called from OpenGL thread
+	bool					IsFontChanged(EffectTextData *data) const;
+	void					RenderTextSoftware(SoftwareRender *render, BBitmap *destination, EffectTextData *data, const float alignment);
 	bool					SaveParametersBase(FILE *file, MediaEffect *media_effect, const bool append_comma);
 
 private:
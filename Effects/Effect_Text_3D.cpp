@@ -73,10 +73,22 @@ using namespace yrender;
 Effect_Text3D :: Effect_Text3D(BRect frame, const char *filename)
 	: Effect_Text(frame, filename)
 {
-	const float kFontFactor = be_plain_font->Size()/20.0f;
 	fIs3dFont = true;
+	fTextSceneDepth = 0;
+}
+
+/*	FUNCTION:		Effect_Text3D :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Text3D :: InitGui()
+{
+	Effect_Text::InitGui();
 
-	fTextView->ResizeTo(frame.Width()-20, 100);
+	const float kFontFactor = be_plain_font->Size()/20.0f;
+
+	fTextView->ResizeTo(Bounds().Width()-20, 100);
 
 	fSliderDepth = new ValueSlider(BRect(20*kFontFactor, 140, 360*kFontFactor, 180), "depth", GetText(TXT_EFFECTS_TEXT_3D_DEPTH), nullptr, kMinDepth, kMaxDepth);
 	fSliderDepth->SetModificationMessage(new BMessage(eMsgDepth));
@@ -196,12 +208,15 @@ MediaEffect * Effect_Text3D :: CreateMediaEffect()
 void Effect_Text3D :: CreateOpenGLObjects(EffectTextData *data)
 {
 	assert(data != nullptr);
-	if (fTextScene)
-		delete fTextScene;
-
 	EffectText3dData *text_3d_data = (EffectText3dData *)data->derived_data;
 
+	//	Create new scene before deleting old, so shared font resources survive
+	yrender::YTextScene *old_scene = fTextScene;
 	fTextScene = new yrender::YTextScene(new yrender::YFontFreetype(data->font_size, data->font_path.String(), (float)text_3d_data->depth), true);
+	delete old_scene;
+	fTextSceneFontPath = data->font_path;
+	fTextSceneFontSize = data->font_size;
+	fTextSceneDepth = text_3d_data->depth;
 	fTextScene->SetText(data->text.String());
 	fTextScene->SetColour(YVector4(data->font_colour.red/255.0f, data->font_colour.green/255.0f, data->font_colour.blue/255.0f, data->font_colour.alpha/255.0f));
 	//fTextScene->mSpatial.SetPosition(data->position);
@@ -222,9 +237,9 @@ void Effect_Text3D :: RenderEffect(BBitmap *source, MediaEffect *media_effect, i
 		return;
 
 
-	if ((fTextScene == nullptr) || fOpenGLPendingUpdate)
+	EffectTextData *data = (EffectTextData *) media_effect->mEffectData;
+	if (IsFontChanged(data) || fOpenGLPendingUpdate || (fTextSceneDepth != ((EffectText3dData *)data->derived_data)->depth))
 	{
-		EffectTextData *data = (EffectTextData *) media_effect->mEffectData;
 		CreateOpenGLObjects(data);
 	}
 
@@ -19,6 +19,7 @@ public:
 					Effect_Text3D(BRect frame, const char *filename);
 					~Effect_Text3D()								override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 
 	const char		*GetVendorName() const							override;
 	const char		*GetEffectName() const							override;
@@ -35,10 +36,12 @@ public:
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override	{return false;}		//	extruded glyphs need GL
 	void			MessageReceived(BMessage *msg)					override;
 
 private:
 	ValueSlider		*fSliderDepth;
+	int				fTextSceneDepth;
 	void			CreateOpenGLObjects(EffectTextData *data);	//	Called from OpenGL thread
 };
 
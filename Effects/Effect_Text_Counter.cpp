@@ -97,6 +97,18 @@ using namespace yrender;
 Effect_TextCounter :: Effect_TextCounter(BRect frame, const char *filename)
 	: Effect_Text(frame, filename)
 {
+	fCounterType = kCounterCurrency;
+}
+
+/*	FUNCTION:		Effect_TextCounter :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_TextCounter :: InitGui()
+{
+	Effect_Text::InitGui();
+
 	const float kFontFactor = be_plain_font->Size()/20.0f;
 
 	mEffectView->RemoveChild(fTextView);
@@ -135,7 +147,6 @@ Effect_TextCounter :: Effect_TextCounter(BRect frame, const char *filename)
 	mEffectView->AddChild(fTextFormat);
 
 	//	Default value
-	fCounterType = kCounterCurrency;
 	fTextFormat->SetText(kRadioButtons[fCounterType].format);
 	fTextFormat->SetToolTip(kRadioButtons[fCounterType].tooltip);
 	fRadioControl[fCounterType]->SetValue(1);
@@ -236,15 +247,13 @@ MediaEffect * Effect_TextCounter :: CreateMediaEffect()
 	return effect;
 }
 
-/*	FUNCTION:		Effect_TextCounter :: RenderEffect
-	ARGS:			source
-					data
+/*	FUNCTION:		Effect_TextCounter :: GenerateText
+	ARGS:			media_effect
 					frame_idx
-					chained_effects
-	RETURN:			applied effect
-	DESCRIPTION:	Apply media effect
+	RETURN:			n/a
+	DESCRIPTION:	Update media effect text for frame_idx
 */
-void Effect_TextCounter :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+void Effect_TextCounter :: GenerateText(MediaEffect *media_effect, int64 frame_idx)
 {
 	EffectTextData *effect_data = (EffectTextData *) media_effect->mEffectData;
 	EffectTextCounterData *counter_data = (EffectTextCounterData *)effect_data->derived_data;
@@ -269,10 +278,37 @@ void Effect_TextCounter :: RenderEffect(BBitmap *source, MediaEffect *media_effe
 		case kCounterDate:				GenerateText_Date(t, effect_data);				break;
 		default:	assert(0);
 	}
+}
 
+/*	FUNCTION:		Effect_TextCounter :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect
+*/
+void Effect_TextCounter :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	GenerateText(media_effect, frame_idx);
 	Effect_Text::RenderEffect(source, media_effect, frame_idx, chained_effects);
 }
 
+/*	FUNCTION:		Effect_TextCounter :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					media_effect
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect()
+*/
+bool Effect_TextCounter :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *media_effect, int64 frame_idx)
+{
+	GenerateText(media_effect, frame_idx);
+	return Effect_Text::RenderEffectSoftware(render, destination, source, media_effect, frame_idx);
+}
+
 /*	FUNCTION:		Effect_TextCounter :: MediaEffectSelected
 	ARGS:			effect
 	RETURN:			n/a
@@ -21,6 +21,7 @@ public:
 					Effect_TextCounter(BRect frame, const char *filename);
 					~Effect_TextCounter()							override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 
 	const char		*GetVendorName() const							override;
 	const char		*GetEffectName() const							override;
@@ -37,6 +38,7 @@ public:
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 	void			MessageReceived(BMessage *msg)					override;
 
 private:
@@ -58,6 +60,7 @@ private:
 	BTextControl	*fTextFormat;
 	kCounterType	fCounterType;
 
+	void			GenerateText(MediaEffect *media_effect, int64 frame_idx);
 	void			GenerateText_Currency(const float t, Effect_Text::EffectTextData *data);
 	void			GenerateText_Number(const float t, Effect_Text::EffectTextData *data);
 	void			GenerateText_TimeMinSec(const float t, Effect_Text::EffectTextData *data);
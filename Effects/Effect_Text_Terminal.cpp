@@ -88,9 +88,21 @@ using namespace yrender;
 Effect_TextTerminal :: Effect_TextTerminal(BRect frame, const char *filename)
 	: Effect_Text(frame, filename)
 {
+	fAlignment = kAlignmentCenter;
+}
+
+/*	FUNCTION:		Effect_TextTerminal :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_TextTerminal :: InitGui()
+{
+	Effect_Text::InitGui();
+
 	const float kFontFactor = be_plain_font->Size()/20.0f;
 
-	fTextView->ResizeTo(frame.Width()-20, 100);
+	fTextView->ResizeTo(Bounds().Width()-20, 100);
 
 	static_assert(sizeof(kAlignmentButtons)/sizeof(RADIO_BUTTON) == kNumberAlignmentButtons, "sizeof(kAlignmentButtons) != kNumberAlignmentButtons");
 	for (int i=0; i < kNumberAlignmentButtons; i++)
@@ -100,7 +112,6 @@ Effect_TextTerminal :: Effect_TextTerminal(BRect frame, const char *filename)
 		fAlignmentRadioButtons[i] = new BRadioButton(button_position, nullptr, GetText(kAlignmentButtons[i].text), new BMessage(kAlignmentButtons[i].message));
 		mEffectView->AddChild(fAlignmentRadioButtons[i]);
 	}
-	fAlignment = kAlignmentCenter;
 	fAlignmentRadioButtons[fAlignment]->SetValue(1);
 
 	//	Thresholds
@@ -198,19 +209,14 @@ MediaEffect * Effect_TextTerminal :: CreateMediaEffect()
 	return effect;
 }
 
-/*	FUNCTION:		Effect_TextTerminal :: RenderEffect
-	ARGS:			source
-					data
+/*	FUNCTION:		Effect_TextTerminal :: UpdateText
+	ARGS:			media_effect
 					frame_idx
-					chained_effects
-	RETURN:			applied effect
-	DESCRIPTION:	Apply media effect
+	RETURN:			n/a
+	DESCRIPTION:	Truncate terminal text for frame_idx
 */
-void Effect_TextTerminal :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+void Effect_TextTerminal :: UpdateText(MediaEffect *media_effect, int64 frame_idx)
 {
-	if (!media_effect || !media_effect->mEffectData)
-		return;
-
 	EffectTextData *data = (EffectTextData *) media_effect->mEffectData;
 	EffectTextTerminalData *terminal_data = (EffectTextTerminalData *)data->derived_data;
 
@@ -229,8 +235,26 @@ void Effect_TextTerminal :: RenderEffect(BBitmap *source, MediaEffect *media_eff
 	BString tr = terminal_data->text;
 	tr.Truncate(t * tr.Length());
 	data->text.SetTo(tr);
+}
 
-	if (fTextScene == nullptr)
+/*	FUNCTION:		Effect_TextTerminal :: RenderEffect
+	ARGS:			source
+					data
+					frame_idx
+					chained_effects
+	RETURN:			applied effect
+	DESCRIPTION:	Apply media effect
+*/
+void Effect_TextTerminal :: RenderEffect(BBitmap *source, MediaEffect *media_effect, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)
+{
+	if (!media_effect || !media_effect->mEffectData)
+		return;
+
+	UpdateText(media_effect, frame_idx);
+	EffectTextData *data = (EffectTextData *) media_effect->mEffectData;
+	EffectTextTerminalData *terminal_data = (EffectTextTerminalData *)data->derived_data;
+
+	if (IsFontChanged(data))
 		CreateOpenGLObjects(data);
 	switch (terminal_data->alignment)
 	{
@@ -245,6 +269,34 @@ void Effect_TextTerminal :: RenderEffect(BBitmap *source, MediaEffect *media_eff
 	fTextScene->SetHorizontalAlignment(YTextScene::ALIGN_HCENTER);
 }
 
+/*	FUNCTION:		Effect_TextTerminal :: RenderEffectSoftware
+	ARGS:			render
+					destination
+					source
+					media_effect
+					frame_idx
+	RETURN:			true if rendered
+	DESCRIPTION:	CPU equivalent of RenderEffect()
+*/
+bool Effect_TextTerminal :: RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *media_effect, int64 frame_idx)
+{
+	if (!media_effect || !media_effect->mEffectData)
+		return true;
+
+	UpdateText(media_effect, frame_idx);
+	EffectTextData *data = (EffectTextData *) media_effect->mEffectData;
+	float alignment = 0.5f;
+	switch (((EffectTextTerminalData *)data->derived_data)->alignment)
+	{
+		case kAlignmentLeft:		alignment = 0.0f;		break;
+		case kAlignmentCenter:		alignment = 0.5f;		break;
+		case kAlignmentRight:		alignment = 1.0f;		break;
+		default:					assert(0);
+	}
+	RenderTextSoftware(render, destination, data, alignment);
+	return true;
+}
+
 /*	FUNCTION:		Effect_TextTerminal :: MediaEffectSelected
 	ARGS:			effect
 	RETURN:			n/a
@@ -21,6 +21,7 @@ public:
 					Effect_TextTerminal(BRect frame, const char *filename);
 					~Effect_TextTerminal()							override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 
 	const char		*GetVendorName() const							override;
 	const char		*GetEffectName() const							override;
@@ -37,6 +38,7 @@ public:
 	void			MediaEffectSelected(MediaEffect *effect)		override;
 
 	void			RenderEffect(BBitmap *source, MediaEffect *data, int64 frame_idx, std::deque<FRAME_ITEM> & chained_effects)	override;
+	bool			RenderEffectSoftware(SoftwareRender *render, BBitmap *destination, BBitmap *source, MediaEffect *data, int64 frame_idx)	override;
 	void			MessageReceived(BMessage *msg)					override;
 
 	void			TextUpdated()									override;
@@ -51,6 +53,8 @@ private:
 	};
 	kAlignment		fAlignment;
 
+	void			UpdateText(MediaEffect *media_effect, int64 frame_idx);
+
 	BRadioButton	*fAlignmentRadioButtons[kNumberAlignmentButtons];
 	BChannelSlider	*fSliderThreshold[2];
 };
@@ -162,6 +162,15 @@ using namespace yrender;
 */
 Effect_Transform :: Effect_Transform(BRect frame, const char *filename)
 	: EffectNode(frame, filename)
+{
+}
+
+/*	FUNCTION:		Effect_Transform :: InitGui
+	ARGS:			none
+	RETURN:			n/a
+	DESCRIPTION:	Create Gui objects (see EffectNode::CreateGui())
+*/
+void Effect_Transform :: InitGui()
 {
 	const float kFontFactor = be_plain_font->Size()/20.0f;
 
@@ -24,6 +24,7 @@ public:
 					Effect_Transform(BRect frame, const char *filename);
 					~Effect_Transform()								override;
 	void			AttachedToWindow()								override;
+	void			InitGui()										override;
 
 	EFFECT_GROUP	GetEffectGroup() const override	{return EffectNode::EFFECT_SPATIAL;}
 	const char		*GetVendorName() const							override;
@@ -0,0 +1,11 @@
+//	Fusion source (see Editor/ColourFusion.h), must match Levels.frag
+
+uniform float			uMinInput@;
+uniform float			uGamma@;
+uniform float			uMaxInput@;
+
+vec4 Fusion@(vec4 colour, vec2 uv)
+{
+	vec3 level = min(max(colour.rgb - vec3(uMinInput@), vec3(0.0)) / (vec3(uMaxInput@) - vec3(uMinInput@)), vec3(1.0));
+	return vec4(pow(level, vec3(1.0/uGamma@)), colour.a);
+}
@@ -0,0 +1,27 @@
+//	Fusion source (see Editor/ColourFusion.h), must match NightVision.frag
+
+uniform vec2					resolution@;
+uniform float					time@;
+
+float hash@(float n)
+{
+	return fract(sin(n)*43758.5453123);
+}
+
+vec4 Fusion@(vec4 colour, vec2 uv)
+{
+	float t = time@ + 1.0;
+
+	vec2 u = uv * 2. - 1.;
+	vec2 n = u * vec2(resolution@.x / resolution@.y, 1.0);
+	vec3 c = colour.rgb;
+
+	// flicker, grain, vignette, fade in
+	c += sin(hash@(time@*0.001)) * 0.01;
+	c += hash@((hash@(n.x) + n.y) * t*0.001) * 0.5;
+	c *= smoothstep(length(n * n * n * vec2(0.0, 0.0)), 1.0, 0.4);
+	c *= smoothstep(0.01, 1.0, t) * 1.5;
+
+	c = dot(c, vec3(0.2126, 0.7152, 0.0722)) * vec3(0.2, 1.5 - hash@(t*0.001) * 0.1, 0.4);
+	return vec4(c, 1.0);
+}
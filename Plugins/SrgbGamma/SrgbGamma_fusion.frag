@@ -0,0 +1,31 @@
+//	Fusion source (see Editor/ColourFusion.h), must match SrgbGamma.frag
+
+uniform int						uDirection@;
+uniform float					uGamma@;
+
+float srgb_linear@(float c)
+{
+	if (c <= 0.04045)
+		return c/12.92;
+	else
+		return pow((c + 0.055) / (1.0 + 0.055), 2.4);
+}
+float linear_srgb@(float c)
+{
+	if (c <= 0.0031308)
+		return 12.92*c;
+	else
+		return (1.0 + 0.055) * pow(c, 1.0/2.f) - 0.055;
+}
+
+vec4 Fusion@(vec4 colour, vec2 uv)
+{
+	if (uDirection@ == 0)
+		return vec4(srgb_linear@(colour.r), srgb_linear@(colour.g), srgb_linear@(colour.b), colour.a);
+	else if (uDirection@ == 1)
+		return vec4(linear_srgb@(colour.r), linear_srgb@(colour.g), linear_srgb@(colour.b), colour.a);
+	else if (uDirection@ == 2)
+		return vec4(pow(colour.rgb, vec3(uGamma@)), colour.a);
+	else //if (uDirection@ == 3)
+		return vec4(pow(colour.rgb, vec3(1.0/uGamma@)), colour.a);
+}
@@ -0,0 +1,8 @@
+//	Fusion source (see Editor/ColourFusion.h), must match Vignette.frag
+
+uniform float			uIntensity@;
+
+vec4 Fusion@(vec4 colour, vec2 uv)
+{
+	return colour * pow(16.*uv.x*uv.y*(1.-uv.x)*(1.-uv.y), uIntensity@); // Vigneting
+}
@@ -72,6 +72,13 @@ class FTGL_EXPORT FTExtrudeGlyph : public FTGlyph
          * @return  The advance distance for this glyph.
          */
         virtual const FTPoint& Render(const FTPoint& pen, int renderMode);
+
+        /**
+         * Medo: tessellate the glyph outline.  Deferred by the constructor,
+         * Render() tessellates on demand.  Thread safe for distinct glyphs,
+         * so clients may tessellate new glyphs in parallel.
+         */
+        void Tessellate();
 };
 
 #define FTExtrdGlyph FTExtrudeGlyph
@@ -88,6 +88,13 @@ class FTGL_EXPORT FTExtrudeFont : public FTFont
 		void	SetFrontColour(float r, float g, float b, float a);
 		void	SetBackColour(float r, float g, float b, float a);
 		void	SetSideColour(float r, float g, float b, float a);
+
+		/****************************
+			Medo: glyph tessellation is deferred.  Returns glyphs created since the
+			previous call, which the client may tessellate in parallel
+			(see FTExtrudeGlyph::Tessellate()).
+		*****************************/
+		std::vector<FTExtrudeGlyph *>	TakePendingGlyphs();
 	private:
 		friend class FTExtrudeGlyphImpl;
 		static FTExtrudeFontCustomColours sCustomColours;
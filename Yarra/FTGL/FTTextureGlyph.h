@@ -46,18 +46,12 @@ class FTGL_EXPORT FTTextureGlyph : public FTGlyph
         /**
          * Constructor
          *
+         * The glyph is rasterised once, the bitmap is kept and uploaded
+         * to the shared yrender::YGlyphAtlas when rendered.
+         *
          * @param glyph     The Freetype glyph to be processed
-         * @param id        The id of the texture that this glyph will be
-         *                  drawn in
-         * @param xOffset   The x offset into the parent texture to draw
-         *                  this glyph
-         * @param yOffset   The y offset into the parent texture to draw
-         *                  this glyph
-         * @param width     The width of the parent texture
-         * @param height    The height (number of rows) of the parent texture
          */
-        FTTextureGlyph(FT_GlyphSlot glyph, int id, int xOffset, int yOffset,
-                       int width, int height);
+        FTTextureGlyph(FT_GlyphSlot glyph);
 
         /**
          * Destructor
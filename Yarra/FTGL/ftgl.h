@@ -32,6 +32,8 @@
 #include "Yarra/Render/SceneNode.h"
 #endif
 
+#include <vector>
+
 /* We need the Freetype headers */
 #include <ft2build.h>
 #include FT_FREETYPE_H
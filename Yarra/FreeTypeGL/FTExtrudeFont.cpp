@@ -60,8 +60,22 @@ FTGlyph* FTExtrudeFont::MakeGlyph(FT_GlyphSlot ftGlyph)
         return NULL;
     }
 
-    return new FTExtrudeGlyph(ftGlyph, myimpl->depth, myimpl->front,
-                              myimpl->back, myimpl->useDisplayLists);
+    FTExtrudeGlyph *glyph = new FTExtrudeGlyph(ftGlyph, myimpl->depth, myimpl->front,
+                                               myimpl->back, myimpl->useDisplayLists);
+    myimpl->pendingGlyphs.push_back(glyph);
+    return glyph;
+}
+
+
+std::vector<FTExtrudeGlyph *> FTExtrudeFont::TakePendingGlyphs()
+{
+    FTExtrudeFontImpl *myimpl = (FTExtrudeFontImpl *)(impl);
+    std::vector<FTExtrudeGlyph *> pending;
+    if(myimpl)
+    {
+        pending.swap(myimpl->pendingGlyphs);
+    }
+    return pending;
 }
 
 
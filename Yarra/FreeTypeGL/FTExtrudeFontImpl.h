@@ -29,7 +29,10 @@
 
 #include "FTFontImpl.h"
 
+#include <vector>
+
 class FTGlyph;
+class FTExtrudeGlyph;
 
 class FTExtrudeFontImpl : public FTFontImpl
 {
@@ -75,6 +78,11 @@ class FTExtrudeFontImpl : public FTFontImpl
          * The outset distance (front and back) for the font.
          */
         float front, back;
+
+        /**
+         * Medo: glyphs awaiting tessellation (see FTExtrudeFont::TakePendingGlyphs)
+         */
+        std::vector<FTExtrudeGlyph *> pendingGlyphs;
 };
 
 #endif // __FTExtrudeFontImpl__
@@ -61,6 +61,13 @@ const FTPoint& FTExtrudeGlyph::Render(const FTPoint& pen, int renderMode)
 }
 
 
+void FTExtrudeGlyph::Tessellate()
+{
+    FTExtrudeGlyphImpl *myimpl = (FTExtrudeGlyphImpl *)(impl);
+    myimpl->Tessellate();
+}
+
+
 //
 //  FTGLExtrudeGlyphImpl
 //
@@ -95,11 +102,23 @@ FTExtrudeGlyphImpl::FTExtrudeGlyphImpl(FT_GlyphSlot glyph, float _depth,
     frontOutset = _frontOutset;
     backOutset = _backOutset;
 
+    //	Medo: vectoriser owns a copy of the contours (glyph slot is reused), tessellation is deferred
+}
+
+
+//	Medo: tessellate outside of the constructor (clients may tessellate distinct glyphs in parallel)
+void FTExtrudeGlyphImpl::Tessellate()
+{
+    if(!vectoriser)
+    {
+        return;
+    }
+
     GenerateFront();
     GenerateBack();
     GenerateSide();
-    
-	delete vectoriser;
+
+    delete vectoriser;
     vectoriser = NULL;
 }
 
@@ -127,6 +146,7 @@ FTExtrudeGlyphImpl::~FTExtrudeGlyphImpl()
 //	Medo: Buffer geometry for faster rendering
 const FTPoint& FTExtrudeGlyphImpl::RenderImpl(const FTPoint& pen, int renderMode)
 {
+	Tessellate();
 	ymath::YVector3 pos(pen.Xf(), pen.Yf(), pen.Zf());
 
 	if(renderMode & FTGL::RENDER_FRONT)
@@ -56,6 +56,8 @@ class FTExtrudeGlyphImpl : public FTGlyphImpl
 
         virtual const FTPoint& RenderImpl(const FTPoint& pen, int renderMode);
 
+        void Tessellate();
+
     private:
         /**
          * Private rendering methods.
@@ -27,9 +27,6 @@
 #include "config.h"
 #include "Yarra/Render/SceneNode.h"
 
-#include <cassert>
-#include <string> // For memset
-
 #include "FTGL/ftgl.h"
 
 #include "FTInternals.h"
@@ -74,167 +71,32 @@ FTGlyph* FTTextureFont::MakeGlyph(FT_GlyphSlot ftGlyph)
 //
 
 
-static inline GLuint ClampSize(GLuint in, GLuint maxTextureSize)
-{
-    // Find next power of two
-    --in;
-    in |= in >> 16;
-    in |= in >> 8;
-    in |= in >> 4;
-    in |= in >> 2;
-    in |= in >> 1;
-    ++in;
-
-    // Clamp to max texture size
-    return in < maxTextureSize ? in : maxTextureSize;
-}
-
+//  Glyph bitmaps are packed into the shared yrender::YGlyphAtlas (see
+//  FTTextureGlyphImpl), fonts no longer own textures.
 
 FTTextureFontImpl::FTTextureFontImpl(FTFont *ftFont, const char* fontFilePath)
-:   FTFontImpl(ftFont, fontFilePath),
-    maximumGLTextureSize(0),
-    textureWidth(0),
-    textureHeight(0),
-    glyphHeight(0),
-    glyphWidth(0),
-    padding(3),
-    xOffset(0),
-    yOffset(0)
+:   FTFontImpl(ftFont, fontFilePath)
 {
     load_flags = FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP;
-    remGlyphs = numGlyphs = face.GlyphCount();
 }
 
 
 FTTextureFontImpl::FTTextureFontImpl(FTFont *ftFont,
                                      const unsigned char *pBufferBytes,
                                      size_t bufferSizeInBytes)
-:   FTFontImpl(ftFont, pBufferBytes, bufferSizeInBytes),
-    maximumGLTextureSize(0),
-    textureWidth(0),
-    textureHeight(0),
-    glyphHeight(0),
-    glyphWidth(0),
-    padding(3),
-    xOffset(0),
-    yOffset(0)
+:   FTFontImpl(ftFont, pBufferBytes, bufferSizeInBytes)
 {
     load_flags = FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP;
-    remGlyphs = numGlyphs = face.GlyphCount();
 }
 
 
 FTTextureFontImpl::~FTTextureFontImpl()
-{
-    if(textureIDList.size())
-    {
-        glDeleteTextures((GLsizei)textureIDList.size(),
-                         (const GLuint*)&textureIDList[0]);
-    }
-}
+{}
 
 
 FTGlyph* FTTextureFontImpl::MakeGlyphImpl(FT_GlyphSlot ftGlyph)
 {
-    glyphHeight = static_cast<int>(charSize.Height() + 0.5f);
-    glyphWidth = static_cast<int>(charSize.Width() + 0.5f);
-
-    if(glyphHeight < 1) glyphHeight = 1;
-    if(glyphWidth < 1) glyphWidth = 1;
-
-    if(textureIDList.empty())
-    {
-        textureIDList.push_back(CreateTexture());
-        xOffset = yOffset = padding;
-    }
-
-    if(xOffset > (textureWidth - glyphWidth))
-    {
-        xOffset = padding;
-        yOffset += glyphHeight;
-
-        if(yOffset > (textureHeight - glyphHeight))
-        {
-            textureIDList.push_back(CreateTexture());
-            yOffset = padding;
-        }
-    }
-
-    FTTextureGlyph* tempGlyph = new FTTextureGlyph(ftGlyph, textureIDList[textureIDList.size() - 1],
-                                                    xOffset, yOffset, textureWidth, textureHeight);
-    xOffset += static_cast<int>(tempGlyph->BBox().Upper().X() - tempGlyph->BBox().Lower().X() + padding + 0.5);
-
-    --remGlyphs;
-
-    return tempGlyph;
-}
-
-
-void FTTextureFontImpl::CalculateTextureSize()
-{
-    if(!maximumGLTextureSize)
-    {
-        maximumGLTextureSize = 1024;
-        glGetIntegerv(GL_MAX_TEXTURE_SIZE, (GLint*)&maximumGLTextureSize);
-        assert(maximumGLTextureSize); // Indicates an invalid OpenGL context
-    }
-
-    // Texture width required for numGlyphs glyphs. Will probably not be
-    // large enough, but we try to fit as many glyphs in one line as possible
-    textureWidth = ClampSize(glyphWidth * numGlyphs + padding * 2,
-                             maximumGLTextureSize);
-
-    // Number of lines required for that many glyphs in a line
-    int tmp = (textureWidth - (padding * 2)) / glyphWidth;
-    tmp = tmp > 0 ? tmp : 1;
-    tmp = (numGlyphs + (tmp - 1)) / tmp; // round division up
-
-    // Texture height required for tmp lines of glyphs
-    textureHeight = ClampSize(glyphHeight * tmp + padding * 2,
-                              maximumGLTextureSize);
-}
-
-
-GLuint FTTextureFontImpl::CreateTexture()
-{
-    CalculateTextureSize();
-
-    int totalMemory = textureWidth * textureHeight;
-    unsigned char* textureMemory = new unsigned char[totalMemory];
-    memset(textureMemory, 0, totalMemory);
-
-    GLuint textID;
-    glGenTextures(1, (GLuint*)&textID);
-
-    glBindTexture(GL_TEXTURE_2D, textID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-	//	The shader will take the RED component and map it to ALPHA
-#if !defined (GL_ES_VERSION_2_0)
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, textureWidth, textureHeight, 0, GL_RED, GL_UNSIGNED_BYTE, textureMemory);
-#else
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, textureWidth, textureHeight, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, textureMemory);
-#endif
-
-    delete [] textureMemory;
-
-    return textID;
-}
-
-
-bool FTTextureFontImpl::FaceSize(const unsigned int size, const unsigned int res)
-{
-    if(!textureIDList.empty())
-    {
-        glDeleteTextures((GLsizei)textureIDList.size(), (const GLuint*)&textureIDList[0]);
-        textureIDList.clear();
-        remGlyphs = numGlyphs = face.GlyphCount();
-    }
-
-    return FTFontImpl::FaceSize(size, res);
+    return new FTTextureGlyph(ftGlyph);
 }
 
 
@@ -243,8 +105,6 @@ inline FTPoint FTTextureFontImpl::RenderI(const T* string, const int len,
                                           FTPoint position, FTPoint spacing,
                                           int renderMode)
 {
-    FTTextureGlyphImpl::ResetActiveTexture();
-
     FTPoint tmp = FTFontImpl::Render(string, len,
                                      position, spacing, renderMode);
 
@@ -45,16 +45,6 @@ class FTTextureFontImpl : public FTFontImpl
 
         virtual ~FTTextureFontImpl();
 
-        /**
-         * Set the char size for the current face.
-         *
-         * @param size      the face size in points (1/72 inch)
-         * @param res       the resolution of the target device.
-         * @return          <code>true</code> if size was set correctly
-         */
-        virtual bool FaceSize(const unsigned int size,
-                              const unsigned int res = 72);
-
         virtual FTPoint Render(const char *s, const int len,
                                FTPoint position, FTPoint spacing,
                                int renderMode);
@@ -69,79 +59,6 @@ class FTTextureFontImpl : public FTFontImpl
          */
         FTGlyph* MakeGlyphImpl(FT_GlyphSlot ftGlyph);
 
-        /**
-         * Get the size of a block of memory required to layout the glyphs
-         *
-         * Calculates a width and height based on the glyph sizes and the
-         * number of glyphs. It over estimates.
-         */
-        inline void CalculateTextureSize();
-
-        /**
-         * Creates a 'blank' OpenGL texture object.
-         *
-         * The format is GL_ALPHA and the params are
-         * GL_TEXTURE_WRAP_S = GL_CLAMP
-         * GL_TEXTURE_WRAP_T = GL_CLAMP
-         * GL_TEXTURE_MAG_FILTER = GL_LINEAR
-         * GL_TEXTURE_MIN_FILTER = GL_LINEAR
-         * Note that mipmapping is NOT used
-         */
-        inline GLuint CreateTexture();
-
-        /**
-         * The maximum texture dimension on this OpenGL implemetation
-         */
-        GLsizei maximumGLTextureSize;
-
-        /**
-         * The minimum texture width required to hold the glyphs
-         */
-        GLsizei textureWidth;
-
-        /**
-         * The minimum texture height required to hold the glyphs
-         */
-        GLsizei textureHeight;
-
-        /**
-         *An array of texture ids
-         */
-        FTVector<GLuint> textureIDList;
-
-        /**
-         * The max height for glyphs in the current font
-         */
-        int glyphHeight;
-
-        /**
-         * The max width for glyphs in the current font
-         */
-        int glyphWidth;
-
-        /**
-         * A value to be added to the height and width to ensure that
-         * glyphs don't overlap in the texture
-         */
-        unsigned int padding;
-
-        /**
-         *
-         */
-        unsigned int numGlyphs;
-
-        /**
-         */
-        unsigned int remGlyphs;
-
-        /**
-         */
-        int xOffset;
-
-        /**
-         */
-        int yOffset;
-
         /* Internal generic Render() implementation */
         template <typename T>
         inline FTPoint RenderI(const T *s, const int len,
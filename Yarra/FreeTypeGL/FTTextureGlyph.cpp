@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include <math.h>
+#include <string.h>
 
 #include "FTGL/ftgl.h"
 
@@ -35,6 +36,7 @@
 
 #include "Yarra/Render/SceneNode.h"
 #include "Yarra/Render/Font.h"
+#include "Yarra/Render/GlyphAtlas.h"
 
 #define FTGL_ASSERTS_SHOULD_SOFT_FAIL
 
@@ -61,9 +63,8 @@
 //  FTGLTextureGlyph
 //
 
-FTTextureGlyph::FTTextureGlyph(FT_GlyphSlot glyph, int id, int xOffset,
-                               int yOffset, int width, int height) :
-    FTGlyph(new FTTextureGlyphImpl(glyph, id, xOffset, yOffset, width, height))
+FTTextureGlyph::FTTextureGlyph(FT_GlyphSlot glyph) :
+    FTGlyph(new FTTextureGlyphImpl(glyph))
 {}
 
 
@@ -82,14 +83,10 @@ const FTPoint& FTTextureGlyph::Render(const FTPoint& pen, int renderMode)
 //  FTGLTextureGlyphImpl
 //
 
-GLint FTTextureGlyphImpl::activeTextureID = 0;
-
-FTTextureGlyphImpl::FTTextureGlyphImpl(FT_GlyphSlot glyph, int id, int xOffset,
-                                       int yOffset, int width, int height)
+FTTextureGlyphImpl::FTTextureGlyphImpl(FT_GlyphSlot glyph)
 :   FTGlyphImpl(glyph),
     destWidth(0),
-    destHeight(0),
-    glTextureID(id)
+    destHeight(0)
 {
     /* FIXME: need to propagate the render mode all the way down to
      * here in order to get FT_RENDER_MODE_MONO aliased fonts.
@@ -106,62 +103,30 @@ FTTextureGlyphImpl::FTTextureGlyphImpl(FT_GlyphSlot glyph, int id, int xOffset,
     destWidth  = bitmap.width;
     destHeight = bitmap.rows;
 
-    if(destWidth && destHeight)
+    FTASSERT(destWidth >= 0);
+    FTASSERT(destHeight >= 0);
+
+    if(destWidth > 0 && destHeight > 0)
     {
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glBindTexture(GL_TEXTURE_2D, glTextureID);
-
-#if !defined(GL_ES_VERSION_2_0)
-		GLint w,h;
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
-
-        FTASSERT(xOffset >= 0);
-        FTASSERT(yOffset >= 0);
-        FTASSERT(destWidth >= 0);
-        FTASSERT(destHeight >= 0);
-        FTASSERT(xOffset + destWidth <= w);
-        FTASSERT(yOffset + destHeight <= h);
-
-        if (yOffset + destHeight > h)
-        {
-            // We'll only get here if we are soft-failing our asserts. In that
-            // case, since the data we're trying to put into our texture is
-            // too long, we'll only copy a portion of the image.
-            destHeight = h - yOffset;
-        }
-#endif
-        if (destHeight >= 0)
+        //  Keep a tightly packed copy (pitch may include row padding)
+        pixels.resize(destWidth * destHeight);
+        for(int row = 0; row < destHeight; row++)
         {
-			//	The shader will take the RED component and map it to ALPHA
-#if !defined (GL_ES_VERSION_2_0)
-			glTexSubImage2D(GL_TEXTURE_2D, 0, xOffset, yOffset, destWidth, destHeight, GL_RED, GL_UNSIGNED_BYTE, bitmap.buffer);
-#else
-            glTexSubImage2D(GL_TEXTURE_2D, 0, xOffset, yOffset, destWidth, destHeight, GL_LUMINANCE, GL_UNSIGNED_BYTE, bitmap.buffer);
-#endif
+            memcpy(&pixels[row * destWidth], bitmap.buffer + row * bitmap.pitch, destWidth);
         }
-
     }
 
-//      0
-//      +----+
-//      |    |
-//      |    |
-//      |    |
-//      +----+
-//           1
-
-    uv[0].X(static_cast<float>(xOffset) / static_cast<float>(width));
-    uv[0].Y(static_cast<float>(yOffset) / static_cast<float>(height));
-    uv[1].X(static_cast<float>(xOffset + destWidth) / static_cast<float>(width));
-    uv[1].Y(static_cast<float>(yOffset + destHeight) / static_cast<float>(height));
-
     corner = FTPoint(glyph->bitmap_left, glyph->bitmap_top);
 }
 
 
 FTTextureGlyphImpl::~FTTextureGlyphImpl()
-{}
+{
+    if(yrender::YFontFreetype::sGlyphAtlas)
+    {
+        yrender::YFontFreetype::sGlyphAtlas->Remove(this);
+    }
+}
 
 
 const FTPoint& FTTextureGlyphImpl::RenderImpl(const FTPoint& pen,
@@ -171,6 +136,17 @@ const FTPoint& FTTextureGlyphImpl::RenderImpl(const FTPoint& pen,
 	dx = floor(pen.Xf() + corner.Xf());
 	dy = floor(pen.Yf() + corner.Yf());
 
+	//	Texture co-ords in shared atlas (uploaded if not resident).  Once the atlas is full, remaining glyphs are skipped (layout is split)
+	if(yrender::YFontFreetype::sGlyphAtlasFull)
+		return advance;
+	const yrender::YGlyphAtlas::UV *atlas_uv = yrender::YFontFreetype::sGlyphAtlas->GetGlyph(this, destWidth, destHeight, pixels.data());
+	if(atlas_uv == nullptr)
+	{
+		yrender::YFontFreetype::sGlyphAtlasFull = true;
+		return advance;
+	}
+	FTPoint uv[2] = {FTPoint(atlas_uv->u0, atlas_uv->v0), FTPoint(atlas_uv->u1, atlas_uv->v1)};
+
 	float *v = (float *)yrender::YFontFreetype::sVertexBufferPointer;
 
 #if 0
@@ -196,7 +172,6 @@ const FTPoint& FTTextureGlyphImpl::RenderImpl(const FTPoint& pen,
 
 	yrender::YFontFreetype::sVertexBufferPointer += 6;
 	yrender::YFontFreetype::sVertexBufferCharacterCount++;
-	yrender::YFontFreetype::sFontTextureID = glTextureID;
 	
     return advance;
 }
@@ -27,6 +27,8 @@
 #ifndef __FTTextureGlyphImpl__
 #define __FTTextureGlyphImpl__
 
+#include <vector>
+
 #include "FTGlyphImpl.h"
 
 class FTTextureGlyphImpl : public FTGlyphImpl
@@ -35,21 +37,13 @@ class FTTextureGlyphImpl : public FTGlyphImpl
     friend class FTTextureFontImpl;
 
     protected:
-        FTTextureGlyphImpl(FT_GlyphSlot glyph, int id, int xOffset,
-                           int yOffset, int width, int height);
+        FTTextureGlyphImpl(FT_GlyphSlot glyph);
 
         virtual ~FTTextureGlyphImpl();
 
         virtual const FTPoint& RenderImpl(const FTPoint& pen, int renderMode);
 
     private:
-        /**
-         * Reset the currently active texture to zero to get into a known
-         * state before drawing a string. This is to get round possible
-         * threading issues.
-         */
-        static void ResetActiveTexture() { activeTextureID = 0; }
-
         /**
          * The width of the glyph 'image'
          */
@@ -66,22 +60,10 @@ class FTTextureGlyphImpl : public FTGlyphImpl
         FTPoint corner;
 
         /**
-         * The texture co-ords of this glyph within the texture.
-         */
-        FTPoint uv[2];
-
-        /**
-         * The texture index that this glyph is contained in.
-         */
-        int glTextureID;
-
-        /**
-         * The texture index of the currently active texture
-         *
-         * We keep track of the currently active texture to try to reduce the
-         * number of texture bind operations.
+         * Rasterised glyph (destWidth * destHeight), uploaded to the shared
+         * glyph atlas on demand (the atlas may evict it at any time).
          */
-        static GLint activeTextureID;
+        std::vector<unsigned char> pixels;
 };
 
 #endif  //  __FTTextureGlyphImpl__
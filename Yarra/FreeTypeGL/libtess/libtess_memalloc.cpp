@@ -34,22 +34,156 @@
 
 #include "memalloc.h"
 #include "string.h"
+#include <assert.h>
 
-int __gl_memInit( size_t maxFast )
+#include <vector>
+
+/*
+** Medo: arena allocator.
+** libtess allocates every vertex, edge, face and region individually, and
+** everything is released before gluDeleteTess() returns.  Allocations are
+** served from per thread blocks (bump pointer), memFree() only reclaims the
+** most recent allocation, and the arena is rewound once no allocation is
+** live.  Blocks are retained for the next tessellation on the same thread,
+** so glyphs tessellated in parallel never contend on the heap.
+**
+** Invariants (checked with assert in debug builds):
+**  - memory is freed on the thread which allocated it (the live count and
+**    bump pointer are per thread).
+**  - a GLUtesselator lives within one call on one thread (gluNewTess() to
+**    gluDeleteTess(), see FTVectoriser::MakeMesh()).  Freed blocks other than
+**    the most recent are only reclaimed on rewind, so a tessellator kept alive
+**    across tessellations would grow the arena without bound.
+*/
+static const size_t kArenaBlockSize = 64*1024;
+static const size_t kArenaAlignment = 16;
+static const size_t kArenaMaxRetainedBlocks = 16;
+
+struct Arena;
+struct ArenaHeader
 {
-#ifndef NO_MALLOPT
-/*  mallopt( M_MXFAST, maxFast );*/
-#ifdef MEMORY_DEBUG
-  mallopt( M_DEBUG, 1 );
-#endif
+  size_t	size;		/* requested size */
+  size_t	offset;		/* block offset before allocation */
+#ifndef NDEBUG
+  Arena		*owner;		/* allocating thread's arena */
+  size_t	padding;	/* keep payload kArenaAlignment aligned */
 #endif
+};
+static_assert( sizeof(ArenaHeader) % kArenaAlignment == 0, "ArenaHeader must preserve payload alignment" );
+
+struct Arena
+{
+  std::vector<char *>	blocks;
+  std::vector<size_t>	block_sizes;
+  size_t		current;
+  size_t		offset;
+  void			*last;
+  long			live;
+
+  Arena() : current(0), offset(0), last(NULL), live(0) {}
+  ~Arena()
+  {
+    for( size_t i = 0; i < blocks.size(); ++i )
+      free( blocks[i] );
+  }
+  void Rewind()
+  {
+    while( blocks.size() > kArenaMaxRetainedBlocks ) {
+      free( blocks.back() );
+      blocks.pop_back();
+      block_sizes.pop_back();
+    }
+    current = 0;
+    offset = 0;
+    last = NULL;
+  }
+};
+
+static thread_local Arena sArena;
+
+static inline size_t ArenaRound( size_t n )
+{
+  return (n + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+
+int __gl_memInit( size_t maxFast )
+{
    return 1;
 }
 
-#ifdef MEMORY_DEBUG
 void *__gl_memAlloc( size_t n )
 {
-  return memset( malloc( n ), 0xa5, n );
-}
+  Arena &arena = sArena;
+  const size_t size = sizeof(ArenaHeader) + ArenaRound( n );
+
+  while( (arena.current >= arena.blocks.size()) ||
+         (arena.offset + size > arena.block_sizes[arena.current]) ) {
+    if( arena.current < arena.blocks.size() ) {
+      ++arena.current;
+      arena.offset = 0;
+    }
+    if( arena.current == arena.blocks.size() ) {
+      const size_t block_size = (size > kArenaBlockSize) ? size : kArenaBlockSize;
+      char *block = (char *)malloc( block_size );
+      if( block == NULL ) return NULL;
+      arena.blocks.push_back( block );
+      arena.block_sizes.push_back( block_size );
+      arena.offset = 0;
+    }
+  }
+
+  ArenaHeader *header = (ArenaHeader *)(arena.blocks[arena.current] + arena.offset);
+  header->size = n;
+  header->offset = arena.offset;
+#ifndef NDEBUG
+  header->owner = &arena;
 #endif
+  arena.offset += size;
+  arena.last = header + 1;
+  ++arena.live;
+#ifdef MEMORY_DEBUG
+  memset( arena.last, 0xa5, n );
+#endif
+  return arena.last;
+}
+
+void __gl_memFree( void *p )
+{
+  if( p == NULL ) return;
+  Arena &arena = sArena;
+  assert( ((ArenaHeader *)p - 1)->owner == &arena );	/* freed on allocating thread */
+  assert( arena.live > 0 );
+  if( p == arena.last ) {
+    arena.offset = ((ArenaHeader *)p - 1)->offset;
+    arena.last = NULL;
+  }
+  if( --arena.live == 0 )
+    arena.Rewind();
+}
+
+void *__gl_memRealloc( void *p, size_t n )
+{
+  if( p == NULL ) return __gl_memAlloc( n );
+
+  Arena &arena = sArena;
+  ArenaHeader *header = (ArenaHeader *)p - 1;
+  assert( header->owner == &arena );	/* reallocated on allocating thread */
+
+  /* Grow in place when p is the most recent allocation */
+  if( p == arena.last ) {
+    const size_t size = sizeof(ArenaHeader) + ArenaRound( n );
+    if( header->offset + size <= arena.block_sizes[arena.current] ) {
+      header->size = n;
+      arena.offset = header->offset + size;
+      return p;
+    }
+  }
+
+  const size_t old_size = header->size;
+  void *q = __gl_memAlloc( n );
+  if( q == NULL ) return NULL;
+  memcpy( q, p, (old_size < n) ? old_size : n );
+  --arena.live;		/* p is not the last allocation, space reclaimed on rewind */
+  return q;
+}
 
@@ -37,18 +37,16 @@
 
 #include <stdlib.h>
 
-#define memRealloc	realloc
-#define memFree		free
+/* Medo: per thread arena allocator (see libtess_memalloc.cpp) */
+#define memAlloc	__gl_memAlloc
+#define memRealloc	__gl_memRealloc
+#define memFree		__gl_memFree
+extern void *		__gl_memAlloc( size_t );
+extern void *		__gl_memRealloc( void *, size_t );
+extern void		__gl_memFree( void * );
 
 #define memInit		__gl_memInit
 /*extern void		__gl_memInit( size_t );*/
 extern int		__gl_memInit( size_t );
 
-#ifndef MEMORY_DEBUG
-#define memAlloc	malloc
-#else
-#define memAlloc	__gl_memAlloc
-extern void *		__gl_memAlloc( size_t );
-#endif
-
 #endif
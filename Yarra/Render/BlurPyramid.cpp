@@ -0,0 +1,218 @@
+/*	PROJECT:		Yarra Engine
+	AUTHORS:		Zenja Solaja, Melbourne Australia
+	COPYRIGHT:		Yarra Engine	2008-2021, ZenYes Pty Ltd
+	DESCRIPTION:	Downsampled pyramid blur (dual Kawase)
+*/
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Yarra/Platform.h"
+
+#include "SceneNode.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "RenderTarget.h"
+#include "RenderState.h"
+
+#include "BlurPyramid.h"
+
+namespace yrender
+{
+
+//	Full screen quad in clip space (fills current viewport), preserves texture orientation
+static const YGeometry_P3T2 kPyramidGeometry[] =
+{
+	{-1, -1, 0,		0, 0},
+	{1, -1, 0,		1, 0},
+	{-1, 1, 0,		0, 1},
+	{1, 1, 0,		1, 1},
+};
+
+static const float kMinRadius = 0.5f;		//	below this, source is returned unmodified
+static const unsigned int kMinLevelSize = 2;
+
+static const char *kVertexShader_Pyramid = "\
+	in vec3			aPosition;\
+	in vec2			aTexture0;\
+	out vec2		vTexCoord0;\
+	void main(void) {\
+		gl_Position = vec4(aPosition.xy, 0.0, 1.0);\
+		vTexCoord0 = aTexture0;\
+	}";
+
+static const char *kFragmentShader_Downsample = "\
+	uniform sampler2D	uTextureUnit0;\
+	uniform vec2		uHalfPixel;\
+	in vec2				vTexCoord0;\
+	out vec4			fFragColour;\
+	void main(void) {\
+		vec4 sum = 4.0*texture(uTextureUnit0, vTexCoord0);\
+		sum += texture(uTextureUnit0, vTexCoord0 - uHalfPixel);\
+		sum += texture(uTextureUnit0, vTexCoord0 + uHalfPixel);\
+		sum += texture(uTextureUnit0, vTexCoord0 + vec2(uHalfPixel.x, -uHalfPixel.y));\
+		sum += texture(uTextureUnit0, vTexCoord0 - vec2(uHalfPixel.x, -uHalfPixel.y));\
+		fFragColour = sum/8.0;\
+	}";
+
+static const char *kFragmentShader_Upsample = "\
+	uniform sampler2D	uTextureUnit0;\
+	uniform vec2		uHalfPixel;\
+	in vec2				vTexCoord0;\
+	out vec4			fFragColour;\
+	void main(void) {\
+		vec4 sum = texture(uTextureUnit0, vTexCoord0 + vec2(-2.0*uHalfPixel.x, 0.0));\
+		sum += 2.0*texture(uTextureUnit0, vTexCoord0 + vec2(-uHalfPixel.x, uHalfPixel.y));\
+		sum += texture(uTextureUnit0, vTexCoord0 + vec2(0.0, 2.0*uHalfPixel.y));\
+		sum += 2.0*texture(uTextureUnit0, vTexCoord0 + vec2(uHalfPixel.x, uHalfPixel.y));\
+		sum += texture(uTextureUnit0, vTexCoord0 + vec2(2.0*uHalfPixel.x, 0.0));\
+		sum += 2.0*texture(uTextureUnit0, vTexCoord0 + vec2(uHalfPixel.x, -uHalfPixel.y));\
+		sum += texture(uTextureUnit0, vTexCoord0 + vec2(0.0, -2.0*uHalfPixel.y));\
+		sum += 2.0*texture(uTextureUnit0, vTexCoord0 + vec2(-uHalfPixel.x, -uHalfPixel.y));\
+		fFragColour = sum/12.0;\
+	}";
+
+/*	FUNCTION:		YBlurPyramid :: YBlurPyramid
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	Constructor (GL context must be locked)
+*/
+YBlurPyramid :: YBlurPyramid()
+	: fWidth(0), fHeight(0)
+{
+	std::vector <std::string> attributes;
+	attributes.push_back("aPosition");
+	attributes.push_back("aTexture0");
+
+	fShaderDownsample = new YShader(&attributes, kVertexShader_Pyramid, kFragmentShader_Downsample);
+	fLocationDownsample_uTextureUnit0 = fShaderDownsample->GetUniformLocation("uTextureUnit0");
+	fLocationDownsample_uHalfPixel = fShaderDownsample->GetUniformLocation("uHalfPixel");
+
+	fShaderUpsample = new YShader(&attributes, kVertexShader_Pyramid, kFragmentShader_Upsample);
+	fLocationUpsample_uTextureUnit0 = fShaderUpsample->GetUniformLocation("uTextureUnit0");
+	fLocationUpsample_uHalfPixel = fShaderUpsample->GetUniformLocation("uHalfPixel");
+
+	fGeometryNode = new YGeometryNode(GL_TRIANGLE_STRIP, Y_GEOMETRY_P3T2, (float *)kPyramidGeometry, 4);
+
+	for (int i=0; i <= kMaxLevels; i++)
+		fLevels[i] = nullptr;
+}
+
+/*	FUNCTION:		YBlurPyramid :: ~YBlurPyramid
+	ARGUMENTS:		n/a
+	RETURN:			n/a
+	DESCRIPTION:	Destructor (GL context must be locked)
+*/
+YBlurPyramid :: ~YBlurPyramid()
+{
+	DestroyLevels();
+	delete fGeometryNode;
+	delete fShaderUpsample;
+	delete fShaderDownsample;
+}
+
+/*	FUNCTION:		YBlurPyramid :: DestroyLevels
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	Delete render targets
+*/
+void YBlurPyramid :: DestroyLevels()
+{
+	for (int i=0; i <= kMaxLevels; i++)
+	{
+		delete fLevels[i];
+		fLevels[i] = nullptr;
+	}
+}
+
+/*	FUNCTION:		YBlurPyramid :: GetLevel
+	ARGUMENTS:		level
+	RETURN:			render target (width >> level, height >> level)
+	DESCRIPTION:	Create render target on first use
+*/
+YRenderTarget * YBlurPyramid :: GetLevel(const int level)
+{
+	assert((level >= 0) && (level <= kMaxLevels));
+	if (!fLevels[level])
+		fLevels[level] = new YRenderTarget(GL_RGBA, std::max(fWidth >> level, 1U), std::max(fHeight >> level, 1U));
+	return fLevels[level];
+}
+
+/*	FUNCTION:		YBlurPyramid :: RenderPass
+	ARGUMENTS:		shader
+					location_texture
+					location_half_pixel
+					source
+					destination
+					offset
+	RETURN:			n/a
+	DESCRIPTION:	Render source into destination (entire target)
+*/
+void YBlurPyramid :: RenderPass(YShader *shader, const GLint location_texture, const GLint location_half_pixel,
+								YTexture *source, YRenderTarget *destination, const float offset)
+{
+	destination->Activate(false);
+	glViewport(0, 0, (GLsizei)destination->GetWidth(), (GLsizei)destination->GetHeight());
+
+	shader->EnableProgram();
+	yRenderState.Uniform1i(location_texture, 0);
+	yRenderState.Uniform2f(location_half_pixel, 0.5f*offset/source->GetWidth(), 0.5f*offset/source->GetHeight());
+	source->Render(0.0f);
+	fGeometryNode->Render(0.0f);
+
+	destination->Deactivate();
+}
+
+/*	FUNCTION:		YBlurPyramid :: Render
+	ARGUMENTS:		source
+					radius (approximate gaussian sigma, source pixels)
+	RETURN:			blurred texture (owned by YBlurPyramid, valid until next Render()), or source if radius too small
+	DESCRIPTION:	Downsample radius dependant number of levels, then upsample back to full resolution.
+					Current render target and viewport are preserved.
+*/
+YTexture * YBlurPyramid :: Render(YTexture *source, const float radius)
+{
+	assert(source);
+	if (radius < kMinRadius)
+		return source;
+
+	if ((source->GetWidth() != fWidth) || (source->GetHeight() != fHeight))
+	{
+		DestroyLevels();
+		fWidth = source->GetWidth();
+		fHeight = source->GetHeight();
+	}
+
+	//	Each level doubles the blur, offset (1.0 - 2.0) covers the remainder
+	int number_levels = std::clamp((int)ceilf(log2f(radius)), 1, kMaxLevels);
+	while ((number_levels > 1) && ((std::min(fWidth, fHeight) >> number_levels) < kMinLevelSize))
+		number_levels--;
+	const float offset = radius/float(1 << (number_levels - 1));
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	yRenderState.SetBlend(false);
+
+	YTexture *texture = source;
+	for (int level=1; level <= number_levels; level++)
+	{
+		YRenderTarget *target = GetLevel(level);
+		RenderPass(fShaderDownsample, fLocationDownsample_uTextureUnit0, fLocationDownsample_uHalfPixel, texture, target, offset);
+		texture = target->GetTexture();
+	}
+	for (int level=number_levels - 1; level >= 0; level--)
+	{
+		YRenderTarget *target = GetLevel(level);
+		RenderPass(fShaderUpsample, fLocationUpsample_uTextureUnit0, fLocationUpsample_uHalfPixel, texture, target, offset);
+		texture = target->GetTexture();
+	}
+
+	yRenderState.SetBlend(true);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	return texture;
+}
+
+};	//	namespace yrender
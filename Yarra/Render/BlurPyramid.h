@@ -0,0 +1,67 @@
+/*	PROJECT:		Yarra Engine
+	AUTHORS:		Zenja Solaja, Melbourne Australia
+	COPYRIGHT:		Yarra Engine	2008-2021, ZenYes Pty Ltd
+	DESCRIPTION:	Downsampled pyramid blur (dual Kawase)
+*/
+
+#ifndef __YARRA_BLUR_PYRAMID_H__
+#define __YARRA_BLUR_PYRAMID_H__
+
+#ifndef _YARRA_PLATFORM_H_
+#include "Yarra/Platform.h"
+#endif
+
+namespace yrender
+{
+
+class YShader;
+class YTexture;
+class YGeometryNode;
+class YRenderTarget;
+
+/***************************************
+	YBlurPyramid blurs a texture by downsampling into a chain of half
+	resolution render targets, then upsampling back to full resolution
+	(dual Kawase filter, 5 taps down / 8 taps up).
+	Cost is roughly constant in radius (radius selects number of levels
+	and tap offset), and the entire blur stays GPU resident (no readback).
+	Render targets are created on first use and recreated when the
+	source dimensions change.
+	Texture orientation is preserved (texel row N of source is row N of result).
+	SoftwareRender::BlurPyramid() (--software-render) mirrors these passes, any
+	change to level count, taps or offset must be made in both.
+	Filtering precision is implementation defined, so results differ between
+	drivers by a few LSB (Mesa llvmpipe rounds texture filtering upwards).
+****************************************/
+class YBlurPyramid
+{
+public:
+	static const int	kMaxLevels = 7;
+
+						YBlurPyramid();
+						~YBlurPyramid();
+
+	YTexture			*Render(YTexture *source, const float radius);
+
+private:
+	YRenderTarget		*GetLevel(const int level);
+	void				DestroyLevels();
+	void				RenderPass(YShader *shader, const GLint location_texture, const GLint location_half_pixel,
+								   YTexture *source, YRenderTarget *destination, const float offset);
+
+	YShader				*fShaderDownsample;
+	GLint				fLocationDownsample_uTextureUnit0;
+	GLint				fLocationDownsample_uHalfPixel;
+	YShader				*fShaderUpsample;
+	GLint				fLocationUpsample_uTextureUnit0;
+	GLint				fLocationUpsample_uHalfPixel;
+	YGeometryNode		*fGeometryNode;
+
+	YRenderTarget		*fLevels[kMaxLevels + 1];	//	[0] = full resolution result
+	unsigned int		fWidth;
+	unsigned int		fHeight;
+};
+
+};	//	namespace yrender
+
+#endif	//#ifndef __YARRA_BLUR_PYRAMID_H__
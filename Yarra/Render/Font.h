@@ -9,6 +9,7 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 
 #ifndef __YARRA_SCENE_NODE_H__
 #include "Yarra/Render/SceneNode.h"
@@ -22,6 +23,7 @@ namespace yrender
 	
 class YGeometryNode;
 class YFontObject_FreeType;
+class YGlyphAtlas;
 
 /****************************
 	YFont base class.  The available fonts are:
@@ -32,7 +34,9 @@ class YFont
 {
 public:
 	virtual					~YFont() {}
-	virtual YGeometryNode	*CreateGeometry(const char *text) = 0;
+	virtual YGeometryNode	*CreateGeometry(const char *text) = 0;			//	client acquires ownership
+	virtual YGeometryNode	*GetGeometry(const char *text) = 0;				//	cached layout (owned by font), valid until next GetGeometry()
+	virtual YGeometryNode	*GetNextGeometry() {return nullptr;}			//	next part of layout too large for one draw (draw previous part first)
 	virtual void			PreRender(const ymath::YVector4 &colour) {}
 	virtual void			DrawText(const char *text) {}
 	
@@ -50,6 +54,13 @@ protected:
 /***************************
 	YFontFreetype uses freetype and FTGL.
 	Use it for loading TrueType fonts.
+	Font objects (face + size) are shared process wide, and remain cached
+	after the last YFontFreetype using them is destroyed.
+	Texture glyphs are packed into a shared YGlyphAtlas, layouts (geometry
+	per string) are cached per font object.
+	Extruded glyphs are tessellated once per font object with unit depth
+	(depth is applied per YFontFreetype), missing glyphs are tessellated
+	in parallel when the client provides sParallelFor.
 ****************************/
 class YFontFreetype : public YFont
 {
@@ -58,6 +69,8 @@ public:
 	explicit		YFontFreetype(const int size_pixels, const char *font_file, const float depth);		//	3D extruded font
 					~YFontFreetype();
 	YGeometryNode	*CreateGeometry(const char *text);
+	YGeometryNode	*GetGeometry(const char *text);
+	YGeometryNode	*GetNextGeometry();
 	void			PreRender(const ymath::YVector4 &colour);
 	
 protected:
@@ -65,10 +78,17 @@ protected:
 	void					InitFont(const int size_pixels, const char *font_file, const bool is3D = false, const float depth = 0.1f);
 	FTFont					*GetFTFont();
 	YFontObject_FreeType	*fCachedFont;
+	float					fDepth;
 
 private:
 	YGeometryNode	*CreateTextureGlyphGeometry(const char *text);
 	YGeometryNode	*CreateExtrudeGlyphGeometry(const char *text);
+	YGeometryNode	*LayoutTextureGlyphs(const char *text, const float pen_x, const float pen_y);
+
+	//	Glyphs of a layout which don't fit in the glyph atlas are laid out after the previous part is drawn
+	std::string		fNextText;
+	float			fNextPen[2];
+	YGeometryNode	*fSplitGeometry;
 
 public:
 	//	These members are only accessible by class FTTextureGlyphImpl
@@ -76,7 +96,8 @@ public:
 	static YGeometry_P3T2	*sVertexBuffer;
 	static YGeometry_P3T2	*sVertexBufferPointer;
 	static GLuint			sVertexBufferCharacterCount;
-	static GLuint			sFontTextureID;
+	static YGlyphAtlas		*sGlyphAtlas;
+	static bool				sGlyphAtlasFull;
 
 	//	These members are only accessible by class FTExtrudeGlyph
 	struct ExtrudeGeometry
@@ -85,6 +106,10 @@ public:
 		std::vector<YGeometry_P3N3T2>	geometry;
 	};
 	static std::vector<ExtrudeGeometry>		sExtrudeGeometry;
+
+	//	Optional client thread pool (3D glyph tessellation), kernel must be called for every [start, end) chunk before returning
+	typedef void (*ParallelForFunction)(const int count, const int chunk_size, const std::function<void(const int start, const int end)> &kernel);
+	static ParallelForFunction				sParallelFor;
 };
 
 /***************************
@@ -123,7 +148,6 @@ public:
 
 private:
 	std::string				fText;
-	YGeometryNode			*fGeometryNode;
 	YFont					*fFont;
 	ymath::YVector4			fColour;
 	bool					fAcquireFontOwnership;
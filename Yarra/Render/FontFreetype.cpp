@@ -6,12 +6,16 @@
 
 #include <string>
 #include <cassert>
+#include <cstring>
+#include <unordered_map>
 
 #include "Yarra/Render/Camera.h"
 #include "Yarra/Render/MatrixStack.h"
 #include "Yarra/Render/SceneNode.h"
 #include "Yarra/Render/Shader.h"
 #include "Yarra/Render/Texture.h"
+#include "Yarra/Render/RenderState.h"
+#include "Yarra/Render/GlyphAtlas.h"
 
 #include "FTGL/ftgl.h"
 #include "Yarra/Render/Font.h"
@@ -20,25 +24,31 @@ namespace yrender
 {
 	
 /*************************************************************************
-	Font creation is expensive.  We can maintain every created font 
-	in a cache to accelerate font creation time for the scenario where
-	a destroyed font is later requested again.
-	This behaviour can be disabled if requested.
+	Font creation is expensive.  Every created font object (face + size)
+	is kept in a process wide cache, so a destroyed font which is later
+	requested again (eg. text effect font changed, or many title effects
+	using the same font) does not reload the face or rasterise glyphs.
+	Unused font objects are evicted (least recently used) when more than
+	kMaxUnusedFonts exist.  GL resources (shaders, glyph atlas, cached
+	layouts) are released when the last YFontFreetype is destroyed.
 **************************************************************************/
-#define KEEP_FONT_CACHE			
-
 static const int kVertexBufferSize = 0x200;
+static const size_t kMaxUnusedFonts = 16;
+static const size_t kMaxLayouts = 64;			//	cached layouts per font object
 
 //======================
 static std::vector <YFontObject_FreeType *> sFontCache;
 static int sTotalFontCount = 0;
+static uint64_t sFontUseCounter = 0;
 
 YGeometry_P3T2 * YFontFreetype :: sVertexBuffer = NULL;
 YGeometry_P3T2 * YFontFreetype :: sVertexBufferPointer = NULL;
 GLuint YFontFreetype :: sVertexBufferCharacterCount = 0;
-GLuint YFontFreetype :: sFontTextureID = 0;
+YGlyphAtlas * YFontFreetype :: sGlyphAtlas = nullptr;
+bool YFontFreetype :: sGlyphAtlasFull = false;
 
 std::vector<YFontFreetype::ExtrudeGeometry> YFontFreetype::sExtrudeGeometry;
+YFontFreetype::ParallelForFunction YFontFreetype::sParallelFor = nullptr;
 
 /************************************
 	TextureGlyph Shader
@@ -179,32 +189,44 @@ public:
 	int					mFontSize;
 	bool				mIs3D;
 	int					mCount;
+	uint64_t			mLastUsed;
 
 public:
 	FTFont				*mFont;
-	GLuint				mTextureID;
+
+	//	Layout cache (geometry per string)
+	struct LAYOUT
+	{
+		YGeometryNode	*geometry;
+		ymath::YVector3	size;
+		unsigned int	atlas_epoch;		//	texture fonts, stale if glyph atlas evicted glyphs
+		float			depth;				//	extruded fonts
+		uint64_t		last_used;
+	};
+	std::unordered_map<std::string, LAYOUT>	mLayouts;
+	uint64_t			mLayoutCounter;
 
 	/*	FUNCTION:		YFontObject_FreeType :: YFontObject_FreeType
 		ARGUMENTS:		font_size		- font size
 						font_file		- path to font file
 						is3D
-						depth (only used for 3D fonts)
 		RETURN:			n/a
-		DESCRIPTION:	Constructor.
+		DESCRIPTION:	Constructor.  Extruded glyphs have unit depth (scaled by YFontFreetype)
 	*/
-	YFontObject_FreeType(const int font_size, const char *font_file, bool is3D, float depth)
+	YFontObject_FreeType(const int font_size, const char *font_file, bool is3D)
 	{
 		mFontFile.assign(font_file);
 		mFontSize = font_size;
 		mIs3D = is3D;
 		mCount = 1;
-		mTextureID = 0;
+		mLastUsed = 0;
+		mLayoutCounter = 0;
 
 		//	create font
 		if (is3D)
 		{
 			mFont = new FTExtrudeFont(font_file);
-			mFont->Depth(depth);
+			mFont->Depth(1.0f);
 		}
 		else
 			mFont = new FTGLTextureFont(font_file);
@@ -218,10 +240,70 @@ public:
 
 	~YFontObject_FreeType()
 	{
+		ClearLayouts();
 		delete mFont;
 	}
+
+	/*	FUNCTION:		YFontObject_FreeType :: ClearLayouts
+		ARGUMENTS:		none
+		RETURN:			n/a
+		DESCRIPTION:	Delete cached geometry (GL context must be valid)
+	*/
+	void ClearLayouts()
+	{
+		for (auto &i : mLayouts)
+			delete i.second.geometry;
+		mLayouts.clear();
+	}
+
+	/*	FUNCTION:		YFontObject_FreeType :: EvictLayout
+		ARGUMENTS:		none
+		RETURN:			n/a
+		DESCRIPTION:	Delete least recently used layout
+	*/
+	void EvictLayout()
+	{
+		auto lru = mLayouts.begin();
+		for (auto it = mLayouts.begin(); it != mLayouts.end(); ++it)
+		{
+			if (it->second.last_used < lru->second.last_used)
+				lru = it;
+		}
+		if (lru != mLayouts.end())
+		{
+			delete lru->second.geometry;
+			mLayouts.erase(lru);
+		}
+	}
 };
 
+/*	FUNCTION:		TrimFontCache
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	Delete least recently used unused font objects (keep kMaxUnusedFonts)
+*/
+static void TrimFontCache()
+{
+	size_t count_unused = 0;
+	for (auto i : sFontCache)
+	{
+		if (i->mCount == 0)
+			count_unused++;
+	}
+	while (count_unused > kMaxUnusedFonts)
+	{
+		auto lru = sFontCache.end();
+		for (auto i = sFontCache.begin(); i != sFontCache.end(); ++i)
+		{
+			if (((*i)->mCount == 0) && ((lru == sFontCache.end()) || ((*i)->mLastUsed < (*lru)->mLastUsed)))
+				lru = i;
+		}
+		delete *lru;
+		sFontCache.erase(lru);
+		count_unused--;
+	}
+}
+
 /**********************************************
 	A YFontFreetype is a wrapper for FreeType GL Fonts.
 	YFontFreetype objects share font objects of same size/type.
@@ -260,10 +342,13 @@ void YFontFreetype :: InitFont(const int font_size, const char *font_file, bool
 
 		sShader2D = new Shader2D;
 		sShader3D = new Shader3D;
+		sGlyphAtlas = new YGlyphAtlas;
 	}
 
 	assert((font_file != NULL) && (*font_file != 0));
 	assert(font_size > 0);
+	fDepth = depth;
+	fSplitGeometry = nullptr;
 		
 	//	Check if font with size already created
 	for (std::vector <YFontObject_FreeType *>::iterator i = sFontCache.begin(); i != sFontCache.end(); ++i)
@@ -276,7 +361,7 @@ void YFontFreetype :: InitFont(const int font_size, const char *font_file, bool
 		}
 	}
 	//	Otherwise, create the font object
-	fCachedFont = new YFontObject_FreeType(font_size, font_file, is3D, depth);
+	fCachedFont = new YFontObject_FreeType(font_size, font_file, is3D);
 	sFontCache.push_back(fCachedFont);
 }
 
@@ -287,42 +372,82 @@ void YFontFreetype :: InitFont(const int font_size, const char *font_file, bool
 */
 YFontFreetype :: ~YFontFreetype()
 {
-#if defined (KEEP_FONT_CACHE)
-	/*	We will NOT destroy YFontObject_FreeType until the total font count is zero.
-		This way we avoid reinitialising the FreeType font if the font is recreated moments later.
+	/*	Font object remains cached (cheap recreation), only GL resources are released
+		when the last font is destroyed (GL context may be destroyed next).
 	*/
+	delete fSplitGeometry;
+	fCachedFont->mCount--;
+	fCachedFont->mLastUsed = ++sFontUseCounter;
+	TrimFontCache();
+
 	if (--sTotalFontCount == 0)
 	{
-		for (std::vector <YFontObject_FreeType *>::iterator i = sFontCache.begin(); i != sFontCache.end(); ++i)
-			delete *i;
-		sFontCache.clear();
-		delete [] sVertexBuffer;
-		delete sShader2D;		sShader2D = nullptr;
-		delete sShader3D;		sShader3D = nullptr;
+		for (auto i : sFontCache)
+			i->ClearLayouts();
+		delete [] sVertexBuffer;	sVertexBuffer = nullptr;
+		delete sShader2D;			sShader2D = nullptr;
+		delete sShader3D;			sShader3D = nullptr;
+		delete sGlyphAtlas;			sGlyphAtlas = nullptr;
 	}
-#else
-	/*	Release font object from cache last instance used. Beware - subsequent creation will be expensive. */
-	for (std::vector <YFontObject_FreeType *>::iterator i = sFontCache.begin(); i != sFontCache.end(); ++i)
+}
+
+/*	FUNCTION:		YFontFreetype :: GetGeometry
+	ARGUMENTS:		text
+	RETURN:			geometry node - owned by font layout cache, valid until next GetGeometry()
+	DESCRIPTION:	Cached text geometry node (rebuilt if glyph atlas evicted glyphs)
+					If the glyphs don't fit in the atlas, this is the first part (see GetNextGeometry())
+*/
+YGeometryNode * YFontFreetype :: GetGeometry(const char *text)
+{
+	fSize.Set(0.0f, 0.0f, 0.0f);
+	fNextText.clear();
+	if ((text == nullptr) || (*text == 0))
+		return nullptr;
+
+	auto &layouts = fCachedFont->mLayouts;
+	auto it = layouts.find(text);
+	if (it != layouts.end())
 	{
-		if (fCachedFont == *i)
+		if (fCachedFont->mIs3D ? (it->second.depth == fDepth) : (it->second.atlas_epoch == sGlyphAtlas->GetEpoch()))
 		{
-			if (--(*i)->mCount == 0)
-			{
-				delete *i;
-				sFontCache.erase(i);
-				break;
-			}
+			it->second.last_used = ++fCachedFont->mLayoutCounter;
+			fSize = it->second.size;
+			return it->second.geometry;
 		}
+		delete it->second.geometry;
+		layouts.erase(it);
 	}
-	if (--sTotalFontCount == 0)
+	if (layouts.size() >= kMaxLayouts)
+		fCachedFont->EvictLayout();
+
+	YGeometryNode *geometry = CreateGeometry(text);
+	if (!fNextText.empty())
 	{
-		YAssert(sFontCache.empty());
-		delete [] sVertexBuffer;
-		sVertexBuffer = NULL;
-		delete sShader;
-		sShader = 0;
+		//	Not cached, drawing the next part evicts glyphs of this part
+		delete fSplitGeometry;
+		fSplitGeometry = geometry;
+		return geometry;
 	}
-#endif
+	layouts[text] = {geometry, fSize, sGlyphAtlas->GetEpoch(), fDepth, ++fCachedFont->mLayoutCounter};
+	return geometry;
+}
+
+/*	FUNCTION:		YFontFreetype :: GetNextGeometry
+	ARGUMENTS:		none
+	RETURN:			geometry node - owned by font, valid until next GetGeometry()/GetNextGeometry(), nullptr when no parts remain
+	DESCRIPTION:	Next part of layout with more glyphs than fit in the glyph atlas
+					The previous part must be drawn first (its glyphs may be evicted)
+*/
+YGeometryNode * YFontFreetype :: GetNextGeometry()
+{
+	if (fNextText.empty())
+		return nullptr;
+
+	const std::string text(fNextText);
+	YGeometryNode *geometry = LayoutTextureGlyphs(text.c_str(), fNextPen[0], fNextPen[1]);
+	delete fSplitGeometry;
+	fSplitGeometry = geometry;
+	return geometry;
 }
 
 /*	FUNCTION:		YFontFreetype :: CreateGeometry
@@ -350,20 +475,8 @@ YGeometryNode * YFontFreetype :: CreateTextureGlyphGeometry(const char *text)
 		return nullptr;
 		
 	assert(strlen(text) < kVertexBufferSize);
-#if 0
-	sVertexBufferPointer = sVertexBuffer;
-	sVertexBufferCharacterCount = 0;
-	fCachedFont->mFont->Render(text);
-	fCachedFont->mTextureID = sFontTextureID;
-	YGeometryNode *node = new YGeometryNode(GL_TRIANGLES, Y_GEOMETRY_P3T2, (float *)sVertexBuffer, sVertexBufferCharacterCount * 6, Y_SHADER_CUSTOM);
-#else
-	//	Haiku Mesa for unknown reasons does not draw the very first triangle - Work around the issue by adding a zero triangle
-	sVertexBufferPointer = sVertexBuffer + 3;
-	sVertexBufferCharacterCount = 0;
-	fCachedFont->mFont->Render(text);
-	fCachedFont->mTextureID = sFontTextureID;
-	YGeometryNode *node = new YGeometryNode(GL_TRIANGLES, Y_GEOMETRY_P3T2, (float *)sVertexBuffer, sVertexBufferCharacterCount * 6 + 3, Y_SHADER_CUSTOM);
-#endif
+
+	YGeometryNode *node = LayoutTextureGlyphs(text, 0.0f, 0.0f);
 
 #if 0
 	YGeometry_P3T2 *p = sVertexBuffer;
@@ -383,6 +496,56 @@ YGeometryNode * YFontFreetype :: CreateTextureGlyphGeometry(const char *text)
 	return node;
 }
 
+/*	FUNCTION:		YFontFreetype :: LayoutTextureGlyphs
+	ARGUMENTS:		text
+					pen_x, pen_y	- start position
+	RETURN:			geometry node - client acquires ownership
+	DESCRIPTION:	Glyphs of this layout are never evicted while laying out.  If the glyph atlas is full of them,
+					the geometry ends before the first glyph which didn't fit and the remaining text is kept in fNextText
+*/
+YGeometryNode * YFontFreetype :: LayoutTextureGlyphs(const char *text, const float pen_x, const float pen_y)
+{
+	fNextText.clear();
+	sGlyphAtlas->BeginLayout();
+	sGlyphAtlasFull = false;
+
+	//	Haiku Mesa for unknown reasons does not draw the very first triangle - Work around the issue by adding a zero triangle
+	sVertexBufferPointer = sVertexBuffer + 3;
+	sVertexBufferCharacterCount = 0;
+	fCachedFont->mFont->Render(text, -1, FTPoint(pen_x, pen_y));
+
+	if (sGlyphAtlasFull)
+	{
+		//	Lay out again one character at a time to find the split (glyphs before it are still resident)
+		sGlyphAtlasFull = false;
+		sVertexBufferPointer = sVertexBuffer + 3;
+		sVertexBufferCharacterCount = 0;
+		FTPoint pen(pen_x, pen_y);
+		for (const char *c = text; *c; )
+		{
+			const char *next = c + 1;
+			while ((*next & 0xc0) == 0x80)		//	UTF-8 continuation bytes
+				next++;
+
+			YGeometry_P3T2 *vertex_pointer = sVertexBufferPointer;
+			const GLuint character_count = sVertexBufferCharacterCount;
+			const FTPoint next_pen = fCachedFont->mFont->Render(c, 1, pen);
+			if (sGlyphAtlasFull)
+			{
+				sVertexBufferPointer = vertex_pointer;
+				sVertexBufferCharacterCount = character_count;
+				fNextText.assign(c);
+				fNextPen[0] = pen.Xf();
+				fNextPen[1] = pen.Yf();
+				break;
+			}
+			pen = next_pen;
+			c = next;
+		}
+	}
+	return new YGeometryNode(GL_TRIANGLES, Y_GEOMETRY_P3T2, (float *)sVertexBuffer, sVertexBufferCharacterCount * 6 + 3, Y_SHADER_CUSTOM);
+}
+
 /*	FUNCTION:		YFontFreetype :: CreateExtrudeGlyphGeometry
 	ARGUMENTS:		text
 	RETURN:			geometry node - client acquires ownership
@@ -394,9 +557,21 @@ YGeometryNode * YFontFreetype :: CreateExtrudeGlyphGeometry(const char *text)
 	if ((text == nullptr) || (*text == 0))
 		return nullptr;
 
+	//	Create missing glyphs (tessellation deferred), then tessellate in parallel
+	FTExtrudeFont *font = (FTExtrudeFont *)fCachedFont->mFont;
+	font->Advance(text);
+	std::vector<FTExtrudeGlyph *> pending = font->TakePendingGlyphs();
+	if (sParallelFor && (pending.size() > 1))
+	{
+		sParallelFor((int)pending.size(), 1, [&pending](const int start, const int end)
+		{
+			for (int i=start; i < end; i++)
+				pending[i]->Tessellate();
+		});
+	}
+
 	sExtrudeGeometry.clear();
 	fCachedFont->mFont->Render(text);
-	fCachedFont->mTextureID = sFontTextureID;
 
 	std::vector<YGeometry_P3N3T2> vertices;
 	vertices.reserve(3*1024);
@@ -447,6 +622,9 @@ YGeometryNode * YFontFreetype :: CreateExtrudeGlyphGeometry(const char *text)
 				printf("YFontFreetype::CreateExtrudeGlyphGeometry() - unhandled type (%d)\n", i.type);
 		}
 	}
+	//	Glyphs have unit depth (side normals are perpendicular to z, unaffected by scale)
+	for (auto &v : vertices)
+		v.mPosition[2] *= fDepth;
 	YGeometryNode *node = new YGeometryNode(GL_TRIANGLES, Y_GEOMETRY_P3N3T2, (float *)vertices.data(), vertices.size());
 	fSize.x = fCachedFont->mFont->Advance(text);
 	fSize.y = fCachedFont->mFont->Ascender();
@@ -470,8 +648,8 @@ void YFontFreetype :: PreRender(const YVector4 &colour)
 	{
 		sShader2D->SetColour(colour);
 		sShader2D->Activate();
+		yRenderState.BindTexture(GL_TEXTURE_2D, sGlyphAtlas->GetTextureID());
 	}
-	glBindTexture(GL_TEXTURE_2D, fCachedFont->mTextureID);
 }
 
 };	// namespace yrender
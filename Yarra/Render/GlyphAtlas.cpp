@@ -0,0 +1,229 @@
+/*	PROJECT:		Yarra Engine
+	AUTHORS:		Zenja Solaja, Melbourne Australia
+	COPYRIGHT:		Yarra Engine	2008-2021, ZenYes Pty Ltd
+	DESCRIPTION:	Shared glyph atlas (dynamically packed, LRU shelves)
+*/
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "Yarra/Platform.h"
+#include "RenderState.h"
+
+#include "GlyphAtlas.h"
+
+namespace yrender
+{
+
+static const int kGlyphPadding = 1;				//	zero border, prevents bleeding with GL_LINEAR
+static const YGlyphAtlas::UV kEmptyGlyph = {0.0f, 0.0f, 0.0f, 0.0f};
+static const int kGlyphTooLarge = -1;
+static const int kAtlasFull = -2;
+
+/*	FUNCTION:		YGlyphAtlas :: YGlyphAtlas
+	ARGUMENTS:		width, height (clamped to GL_MAX_TEXTURE_SIZE)
+	RETURN:			n/a
+	DESCRIPTION:	Constructor (GL context must be locked)
+*/
+YGlyphAtlas :: YGlyphAtlas(const int width, const int height)
+	: fNextShelfY(0), fUseCounter(0), fLayoutStart(0), fEpoch(0)
+{
+	GLint max_texture_size = 1024;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+	fWidth = std::min(width, (int)max_texture_size);
+	fHeight = std::min(height, (int)max_texture_size);
+
+	glGenTextures(1, &fTextureID);
+	yRenderState.BindTexture(GL_TEXTURE_2D, fTextureID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+	//	The shader will take the RED component and map it to ALPHA.  Contents undefined, every glyph is uploaded with a zero border.
+#if !defined (GL_ES_VERSION_2_0)
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, fWidth, fHeight, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+#else
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, fWidth, fHeight, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, nullptr);
+#endif
+}
+
+/*	FUNCTION:		YGlyphAtlas :: ~YGlyphAtlas
+	ARGUMENTS:		n/a
+	RETURN:			n/a
+	DESCRIPTION:	Destructor (GL context must be locked)
+*/
+YGlyphAtlas :: ~YGlyphAtlas()
+{
+	yRenderState.DeleteTextures(1, &fTextureID);
+}
+
+/*	FUNCTION:		YGlyphAtlas :: BeginLayout
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	Glyphs requested from now on are protected from eviction (until next BeginLayout)
+*/
+void YGlyphAtlas :: BeginLayout()
+{
+	fLayoutStart = fUseCounter;
+}
+
+/*	FUNCTION:		YGlyphAtlas :: Flush
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	Evict every glyph
+*/
+void YGlyphAtlas :: Flush()
+{
+	fGlyphs.clear();
+	fShelves.clear();
+	fNextShelfY = 0;
+	fEpoch++;
+}
+
+/*	FUNCTION:		YGlyphAtlas :: EvictShelf
+	ARGUMENTS:		shelf
+	RETURN:			n/a
+	DESCRIPTION:	Evict all glyphs in shelf, shelf space is reused
+*/
+void YGlyphAtlas :: EvictShelf(const int shelf)
+{
+	for (auto key : fShelves[shelf].glyphs)
+		fGlyphs.erase(key);
+	fShelves[shelf].glyphs.clear();
+	fShelves[shelf].x = 0;
+	fEpoch++;
+}
+
+/*	FUNCTION:		YGlyphAtlas :: Remove
+	ARGUMENTS:		key
+	RETURN:			n/a
+	DESCRIPTION:	Glyph object destroyed (key may be reused)
+*/
+void YGlyphAtlas :: Remove(const void *key)
+{
+	auto it = fGlyphs.find(key);
+	if (it == fGlyphs.end())
+		return;
+
+	SHELF &shelf = fShelves[it->second.shelf];
+	shelf.glyphs.erase(std::find(shelf.glyphs.begin(), shelf.glyphs.end(), key));
+	if (shelf.glyphs.empty())
+		shelf.x = 0;
+	fGlyphs.erase(it);
+}
+
+/*	FUNCTION:		YGlyphAtlas :: AllocateShelf
+	ARGUMENTS:		width, height (including padding)
+	RETURN:			shelf index, kGlyphTooLarge or kAtlasFull (glyphs of current layout fill atlas)
+	DESCRIPTION:	Best fit existing shelf, new shelf, LRU shelf, or flush atlas if current layout has no glyphs yet (in that order)
+*/
+int YGlyphAtlas :: AllocateShelf(const int width, const int height)
+{
+	if ((width > fWidth) || (height > fHeight))
+		return kGlyphTooLarge;
+
+	//	Best fit shelf (limit wasted height)
+	int best = -1;
+	for (int i=0; i < (int)fShelves.size(); i++)
+	{
+		const SHELF &shelf = fShelves[i];
+		if ((shelf.height >= height) && (shelf.height <= height + height/2 + 1) && (shelf.x + width <= fWidth) &&
+			((best < 0) || (shelf.height < fShelves[best].height)))
+			best = i;
+	}
+	if (best >= 0)
+		return best;
+
+	//	New shelf
+	if (fNextShelfY + height <= fHeight)
+	{
+		fShelves.push_back({fNextShelfY, height, 0, 0});
+		fNextShelfY += height;
+		return (int)fShelves.size() - 1;
+	}
+
+	//	Least recently used shelf (not used in current layout)
+	int lru = -1;
+	for (int i=0; i < (int)fShelves.size(); i++)
+	{
+		const SHELF &shelf = fShelves[i];
+		if ((shelf.height >= height) && (shelf.last_used <= fLayoutStart) &&
+			((lru < 0) || (shelf.last_used < fShelves[lru].last_used)))
+			lru = i;
+	}
+	if (lru >= 0)
+	{
+		EvictShelf(lru);
+		return lru;
+	}
+
+	//	Texture co-ords already returned in this layout must remain valid
+	if (fUseCounter > fLayoutStart)
+		return kAtlasFull;
+
+	yplatform::Debug("[YGlyphAtlas] Atlas full, flushing\n");
+	Flush();
+	return AllocateShelf(width, height);
+}
+
+/*	FUNCTION:		YGlyphAtlas :: GetGlyph
+	ARGUMENTS:		key			- glyph object
+					width		- bitmap width
+					height		- bitmap rows
+					pixels		- 8 bit coverage (width*height)
+	RETURN:			texture coordinates (empty for zero sized glyphs), nullptr if atlas is full of glyphs used since BeginLayout()
+	DESCRIPTION:	Upload glyph if not resident
+*/
+const YGlyphAtlas::UV * YGlyphAtlas :: GetGlyph(const void *key, const int width, const int height, const unsigned char *pixels)
+{
+	auto it = fGlyphs.find(key);
+	if (it != fGlyphs.end())
+	{
+		fShelves[it->second.shelf].last_used = ++fUseCounter;
+		return &it->second.uv;
+	}
+	if ((width <= 0) || (height <= 0))
+		return &kEmptyGlyph;
+
+	const int padded_width = width + 2*kGlyphPadding;
+	const int padded_height = height + 2*kGlyphPadding;
+	const int shelf_idx = AllocateShelf(padded_width, padded_height);
+	if (shelf_idx == kAtlasFull)
+		return nullptr;
+	if (shelf_idx < 0)
+	{
+		yplatform::Debug("[YGlyphAtlas] Glyph too large (%d x %d)\n", width, height);
+		return &kEmptyGlyph;
+	}
+	SHELF &shelf = fShelves[shelf_idx];
+	const int x = shelf.x;
+	const int y = shelf.y;
+	shelf.x += padded_width;
+	shelf.last_used = ++fUseCounter;
+	shelf.glyphs.push_back(key);
+
+	fUploadBuffer.assign((size_t)padded_width*padded_height, 0);
+	for (int row=0; row < height; row++)
+		memcpy(fUploadBuffer.data() + (row + kGlyphPadding)*padded_width + kGlyphPadding, pixels + row*width, width);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	yRenderState.BindTexture(GL_TEXTURE_2D, fTextureID);
+#if !defined (GL_ES_VERSION_2_0)
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, padded_width, padded_height, GL_RED, GL_UNSIGNED_BYTE, fUploadBuffer.data());
+#else
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, padded_width, padded_height, GL_LUMINANCE, GL_UNSIGNED_BYTE, fUploadBuffer.data());
+#endif
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	GLYPH &glyph = fGlyphs[key];
+	glyph.shelf = shelf_idx;
+	glyph.uv.u0 = float(x + kGlyphPadding)/float(fWidth);
+	glyph.uv.v0 = float(y + kGlyphPadding)/float(fHeight);
+	glyph.uv.u1 = float(x + kGlyphPadding + width)/float(fWidth);
+	glyph.uv.v1 = float(y + kGlyphPadding + height)/float(fHeight);
+	return &glyph.uv;
+}
+
+};	//	namespace yrender
@@ -0,0 +1,95 @@
+/*	PROJECT:		Yarra Engine
+	AUTHORS:		Zenja Solaja, Melbourne Australia
+	COPYRIGHT:		Yarra Engine	2008-2021, ZenYes Pty Ltd
+	DESCRIPTION:	Shared glyph atlas (dynamically packed, LRU shelves)
+*/
+
+#ifndef __YARRA_GLYPH_ATLAS_H__
+#define __YARRA_GLYPH_ATLAS_H__
+
+#ifndef _YARRA_PLATFORM_H_
+#include "Yarra/Platform.h"
+#endif
+
+#ifndef _GLIBCXX_CSTDINT
+#include <cstdint>
+#endif
+
+#ifndef _GLIBCXX_UNORDERED_MAP
+#include <unordered_map>
+#endif
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+namespace yrender
+{
+
+/***************************************
+	YGlyphAtlas is a single GL_RED texture shared by every texture font.
+	Glyphs are keyed by glyph object (unique per face, size and glyph index),
+	the caller keeps the rasterised bitmap so an evicted glyph is re-uploaded
+	without involving FreeType.
+	Glyphs are packed into shelves (rows of similar height).  When full, the
+	least recently used shelf is evicted, glyphs used since BeginLayout() are
+	never evicted.  If only glyphs of the current layout remain, GetGlyph()
+	fails and the caller must draw the layout in parts (a layout without
+	glyphs yet may flush the atlas, so every part makes progress).
+	Any eviction increments the epoch, cached geometry built with an older
+	epoch has stale texture coordinates.
+	Not thread safe, single GL context.
+****************************************/
+class YGlyphAtlas
+{
+public:
+	struct UV
+	{
+		float	u0, v0;
+		float	u1, v1;
+	};
+
+						YGlyphAtlas(const int width = 4096, const int height = 4096);
+						~YGlyphAtlas();
+
+	void				BeginLayout();
+	const UV			*GetGlyph(const void *key, const int width, const int height, const unsigned char *pixels);
+	void				Remove(const void *key);
+	void				Flush();
+
+	const GLuint		GetTextureID() const	{return fTextureID;}
+	const unsigned int	GetEpoch() const		{return fEpoch;}
+
+private:
+	struct SHELF
+	{
+		int							y;
+		int							height;
+		int							x;				//	next free column
+		uint64_t					last_used;
+		std::vector<const void *>	glyphs;
+	};
+	struct GLYPH
+	{
+		UV				uv;
+		int				shelf;
+	};
+	int					AllocateShelf(const int width, const int height);
+	void				EvictShelf(const int shelf);
+
+	GLuint				fTextureID;
+	int					fWidth;
+	int					fHeight;
+	int					fNextShelfY;
+	std::vector<SHELF>	fShelves;
+	std::unordered_map<const void *, GLYPH>	fGlyphs;
+	std::vector<unsigned char>	fUploadBuffer;
+
+	uint64_t			fUseCounter;
+	uint64_t			fLayoutStart;
+	unsigned int		fEpoch;
+};
+
+};	//	namespace yrender
+
+#endif	//#ifndef __YARRA_GLYPH_ATLAS_H__
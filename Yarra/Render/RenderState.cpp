@@ -0,0 +1,423 @@
+/*	PROJECT:		Yarra Engine
+	AUTHORS:		Zenja Solaja, Melbourne Australia
+	COPYRIGHT:		Yarra Engine	2008-2021, ZenYes Pty Ltd
+	DESCRIPTION:	Shadow copy of GL state (skip redundant state changes)
+*/
+
+#include <cassert>
+#include <cstring>
+
+#include "Yarra/Platform.h"
+#include "RenderState.h"
+
+namespace yrender
+{
+
+YRenderState yRenderState;
+
+/*	FUNCTION:		YRenderState :: YRenderState
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	Constructor
+*/
+YRenderState :: YRenderState()
+{
+	fCountCalls = 0;
+	fCountSkipped = 0;
+	Reset();
+}
+
+/*	FUNCTION:		YRenderState :: Reset
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	New GL context, forget everything (including uniform values)
+*/
+void YRenderState :: Reset()
+{
+	fUniforms.clear();
+	Invalidate();
+}
+
+/*	FUNCTION:		YRenderState :: Invalidate
+	ARGUMENTS:		none
+	RETURN:			n/a
+	DESCRIPTION:	GL state modified outside YRenderState, next state change is always sent.
+					Uniform values are program state and remain valid.
+*/
+void YRenderState :: Invalidate()
+{
+	fProgram = kUnknown;
+	fProgramUniforms = nullptr;
+	fActiveTexture = kUnknown;
+	for (int i=0; i < kMaxTextureUnits; i++)
+	{
+		fTexture2D[i] = kUnknown;
+		fTexture3D[i] = kUnknown;
+	}
+	fBlendEnabled = kUnknown;
+	fBlendSource = kUnknown;
+	fBlendDestination = kUnknown;
+}
+
+/****************************************************
+	Program
+*****************************************************/
+
+/*	FUNCTION:		YRenderState :: UseProgram
+	ARGUMENTS:		program
+	RETURN:			n/a
+	DESCRIPTION:	glUseProgram()
+*/
+void YRenderState :: UseProgram(const GLuint program)
+{
+	if (program == fProgram)
+	{
+		fCountSkipped++;
+		return;
+	}
+	glUseProgram(program);
+	fCountCalls++;
+	fProgram = program;
+	fProgramUniforms = (program != 0) ? &fUniforms[program] : nullptr;
+}
+
+/*	FUNCTION:		YRenderState :: DeleteProgram
+	ARGUMENTS:		program
+	RETURN:			n/a
+	DESCRIPTION:	glDeleteProgram(), forget shadow uniforms (program name will be reused)
+*/
+void YRenderState :: DeleteProgram(const GLuint program)
+{
+	if (program == 0)
+		return;
+	glDeleteProgram(program);
+	fUniforms.erase(program);
+	if (program == fProgram)
+	{
+		//	Deleted program remains in use until another program is bound
+		fProgram = kUnknown;
+		fProgramUniforms = nullptr;
+	}
+	else if (fProgramUniforms)
+		fProgramUniforms = &fUniforms[fProgram];	//	erase() may rehash
+}
+
+/****************************************************
+	Textures
+*****************************************************/
+
+/*	FUNCTION:		YRenderState :: ActiveTexture
+	ARGUMENTS:		texture_unit (GL_TEXTURE0 ..)
+	RETURN:			n/a
+	DESCRIPTION:	glActiveTexture()
+*/
+void YRenderState :: ActiveTexture(const GLenum texture_unit)
+{
+	if (texture_unit == fActiveTexture)
+	{
+		fCountSkipped++;
+		return;
+	}
+	glActiveTexture(texture_unit);
+	fCountCalls++;
+	fActiveTexture = texture_unit;
+}
+
+/*	FUNCTION:		YRenderState :: BindTexture
+	ARGUMENTS:		target (only GL_TEXTURE_2D and GL_TEXTURE_3D are shadowed)
+					texture
+	RETURN:			n/a
+	DESCRIPTION:	glBindTexture() on active texture unit
+*/
+void YRenderState :: BindTexture(const GLenum target, const GLuint texture)
+{
+	const int unit = (fActiveTexture == kUnknown) ? -1 : (int)(fActiveTexture - GL_TEXTURE0);
+	GLuint *shadow = nullptr;
+	if ((unit >= 0) && (unit < kMaxTextureUnits))
+	{
+		if (target == GL_TEXTURE_2D)
+			shadow = &fTexture2D[unit];
+		else if (target == GL_TEXTURE_3D)
+			shadow = &fTexture3D[unit];
+	}
+	if (shadow && (*shadow == texture))
+	{
+		fCountSkipped++;
+		return;
+	}
+	glBindTexture(target, texture);
+	fCountCalls++;
+	if (shadow)
+		*shadow = texture;
+}
+
+/*	FUNCTION:		YRenderState :: BindTexture
+	ARGUMENTS:		target
+					texture
+					texture_unit
+	RETURN:			n/a
+	DESCRIPTION:	glActiveTexture() + glBindTexture()
+*/
+void YRenderState :: BindTexture(const GLenum target, const GLuint texture, const GLenum texture_unit)
+{
+	ActiveTexture(texture_unit);
+	BindTexture(target, texture);
+}
+
+/*	FUNCTION:		YRenderState :: DeleteTextures
+	ARGUMENTS:		count
+					textures
+	RETURN:			n/a
+	DESCRIPTION:	glDeleteTextures(), deleted textures are unbound by GL
+*/
+void YRenderState :: DeleteTextures(const GLsizei count, const GLuint *textures)
+{
+	glDeleteTextures(count, textures);
+	for (GLsizei t=0; t < count; t++)
+	{
+		for (int i=0; i < kMaxTextureUnits; i++)
+		{
+			if (fTexture2D[i] == textures[t])
+				fTexture2D[i] = 0;
+			if (fTexture3D[i] == textures[t])
+				fTexture3D[i] = 0;
+		}
+	}
+}
+
+/****************************************************
+	Blend
+*****************************************************/
+
+/*	FUNCTION:		YRenderState :: SetBlend
+	ARGUMENTS:		enable
+	RETURN:			n/a
+	DESCRIPTION:	glEnable(GL_BLEND) / glDisable(GL_BLEND)
+*/
+void YRenderState :: SetBlend(const bool enable)
+{
+	if (fBlendEnabled == (enable ? 1 : 0))
+	{
+		fCountSkipped++;
+		return;
+	}
+	if (enable)
+		glEnable(GL_BLEND);
+	else
+		glDisable(GL_BLEND);
+	fCountCalls++;
+	fBlendEnabled = enable ? 1 : 0;
+}
+
+/*	FUNCTION:		YRenderState :: BlendFunc
+	ARGUMENTS:		source_factor
+					destination_factor
+	RETURN:			n/a
+	DESCRIPTION:	glBlendFunc()
+*/
+void YRenderState :: BlendFunc(const GLenum source_factor, const GLenum destination_factor)
+{
+	if ((source_factor == fBlendSource) && (destination_factor == fBlendDestination))
+	{
+		fCountSkipped++;
+		return;
+	}
+	glBlendFunc(source_factor, destination_factor);
+	fCountCalls++;
+	fBlendSource = source_factor;
+	fBlendDestination = destination_factor;
+}
+
+/****************************************************
+	Uniforms
+*****************************************************/
+
+/*	FUNCTION:		YRenderState :: GetShadowUniform
+	ARGUMENTS:		location
+					type
+	RETURN:			shadow uniform of current program, nullptr if program unknown
+	DESCRIPTION:	Locations are small integers, stored in a vector per program
+*/
+YRenderState::SHADOW_UNIFORM * YRenderState :: GetShadowUniform(const GLint location, const GLenum type)
+{
+	if (!fProgramUniforms)
+		return nullptr;
+	if ((size_t)location >= fProgramUniforms->size())
+	{
+		SHADOW_UNIFORM empty;
+		memset(&empty, 0, sizeof(SHADOW_UNIFORM));
+		fProgramUniforms->resize(location + 1, empty);
+	}
+	SHADOW_UNIFORM *shadow = &(*fProgramUniforms)[location];
+	if (shadow->type != type)
+	{
+		memset(shadow, 0, sizeof(SHADOW_UNIFORM));
+		shadow->type = type;
+		shadow->valid = false;
+	}
+	return shadow;
+}
+
+/*	FUNCTION:		YRenderState :: Uniform1f
+	ARGUMENTS:		location
+					v0
+	RETURN:			n/a
+	DESCRIPTION:	glUniform1f()
+*/
+void YRenderState :: Uniform1f(const GLint location, const GLfloat v0)
+{
+	if (location < 0)
+		return;
+	SHADOW_UNIFORM *shadow = GetShadowUniform(location, GL_FLOAT);
+	if (shadow && shadow->valid && (shadow->f[0] == v0))
+	{
+		fCountSkipped++;
+		return;
+	}
+	glUniform1f(location, v0);
+	fCountCalls++;
+	if (shadow)
+	{
+		shadow->f[0] = v0;
+		shadow->valid = true;
+	}
+}
+
+/*	FUNCTION:		YRenderState :: Uniform2f
+	ARGUMENTS:		location
+					v0, v1
+	RETURN:			n/a
+	DESCRIPTION:	glUniform2f()
+*/
+void YRenderState :: Uniform2f(const GLint location, const GLfloat v0, const GLfloat v1)
+{
+	const GLfloat v[2] = {v0, v1};
+	Uniform2fv(location, v);
+}
+
+/*	FUNCTION:		YRenderState :: Uniform1i
+	ARGUMENTS:		location
+					v0
+	RETURN:			n/a
+	DESCRIPTION:	glUniform1i() (also samplers)
+*/
+void YRenderState :: Uniform1i(const GLint location, const GLint v0)
+{
+	if (location < 0)
+		return;
+	SHADOW_UNIFORM *shadow = GetShadowUniform(location, GL_INT);
+	if (shadow && shadow->valid && (shadow->i[0] == v0))
+	{
+		fCountSkipped++;
+		return;
+	}
+	glUniform1i(location, v0);
+	fCountCalls++;
+	if (shadow)
+	{
+		shadow->i[0] = v0;
+		shadow->valid = true;
+	}
+}
+
+/*	FUNCTION:		YRenderState :: Uniform2fv
+	ARGUMENTS:		location
+					v
+	RETURN:			n/a
+	DESCRIPTION:	glUniform2fv()
+*/
+void YRenderState :: Uniform2fv(const GLint location, const GLfloat *v)
+{
+	if (location < 0)
+		return;
+	SHADOW_UNIFORM *shadow = GetShadowUniform(location, GL_FLOAT_VEC2);
+	if (shadow && shadow->valid && (memcmp(shadow->f, v, 2*sizeof(GLfloat)) == 0))
+	{
+		fCountSkipped++;
+		return;
+	}
+	glUniform2fv(location, 1, v);
+	fCountCalls++;
+	if (shadow)
+	{
+		memcpy(shadow->f, v, 2*sizeof(GLfloat));
+		shadow->valid = true;
+	}
+}
+
+/*	FUNCTION:		YRenderState :: Uniform3fv
+	ARGUMENTS:		location
+					v
+	RETURN:			n/a
+	DESCRIPTION:	glUniform3fv()
+*/
+void YRenderState :: Uniform3fv(const GLint location, const GLfloat *v)
+{
+	if (location < 0)
+		return;
+	SHADOW_UNIFORM *shadow = GetShadowUniform(location, GL_FLOAT_VEC3);
+	if (shadow && shadow->valid && (memcmp(shadow->f, v, 3*sizeof(GLfloat)) == 0))
+	{
+		fCountSkipped++;
+		return;
+	}
+	glUniform3fv(location, 1, v);
+	fCountCalls++;
+	if (shadow)
+	{
+		memcpy(shadow->f, v, 3*sizeof(GLfloat));
+		shadow->valid = true;
+	}
+}
+
+/*	FUNCTION:		YRenderState :: Uniform4fv
+	ARGUMENTS:		location
+					v
+	RETURN:			n/a
+	DESCRIPTION:	glUniform4fv()
+*/
+void YRenderState :: Uniform4fv(const GLint location, const GLfloat *v)
+{
+	if (location < 0)
+		return;
+	SHADOW_UNIFORM *shadow = GetShadowUniform(location, GL_FLOAT_VEC4);
+	if (shadow && shadow->valid && (memcmp(shadow->f, v, 4*sizeof(GLfloat)) == 0))
+	{
+		fCountSkipped++;
+		return;
+	}
+	glUniform4fv(location, 1, v);
+	fCountCalls++;
+	if (shadow)
+	{
+		memcpy(shadow->f, v, 4*sizeof(GLfloat));
+		shadow->valid = true;
+	}
+}
+
+/*	FUNCTION:		YRenderState :: UniformMatrix4fv
+	ARGUMENTS:		location
+					m (column major, not transposed)
+	RETURN:			n/a
+	DESCRIPTION:	glUniformMatrix4fv()
+*/
+void YRenderState :: UniformMatrix4fv(const GLint location, const GLfloat *m)
+{
+	if (location < 0)
+		return;
+	SHADOW_UNIFORM *shadow = GetShadowUniform(location, GL_FLOAT_MAT4);
+	if (shadow && shadow->valid && (memcmp(shadow->f, m, 16*sizeof(GLfloat)) == 0))
+	{
+		fCountSkipped++;
+		return;
+	}
+	glUniformMatrix4fv(location, 1, GL_FALSE, m);
+	fCountCalls++;
+	if (shadow)
+	{
+		memcpy(shadow->f, m, 16*sizeof(GLfloat));
+		shadow->valid = true;
+	}
+}
+
+};	//	namespace yrender
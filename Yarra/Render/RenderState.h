@@ -0,0 +1,112 @@
+/*	PROJECT:		Yarra Engine
+	AUTHORS:		Zenja Solaja, Melbourne Australia
+	COPYRIGHT:		Yarra Engine	2008-2021, ZenYes Pty Ltd
+	DESCRIPTION:	Shadow copy of GL state (skip redundant state changes)
+*/
+
+#ifndef __YARRA_RENDER_STATE_H__
+#define __YARRA_RENDER_STATE_H__
+
+#ifndef _YARRA_PLATFORM_H_
+#include "Yarra/Platform.h"
+#endif
+
+#ifndef _GLIBCXX_UNORDERED_MAP
+#include <unordered_map>
+#endif
+
+#ifndef _GLIBCXX_VECTOR
+#include <vector>
+#endif
+
+namespace yrender
+{
+
+/***************************************
+	YRenderState keeps a shadow copy of the bound program, bound textures
+	per texture unit, blend state and uniform values (per program).
+	State changes which match the shadow copy are not sent to GL.
+	Rules:
+		- all program / texture binds must go through YRenderState,
+		  otherwise call Invalidate() (eg. start of frame)
+		- uniforms of a program must either all go through YRenderState
+		  (Uniform*()) or never, uniform values are program state and
+		  survive Invalidate()
+		- programs and textures must be deleted with DeleteProgram() /
+		  DeleteTextures() since GL reuses names
+		- Reset() when the GL context is recreated
+	Not thread safe, single GL context.
+****************************************/
+class YRenderState
+{
+public:
+	static const int	kMaxTextureUnits = 8;
+
+						YRenderState();
+
+	void				Reset();
+	void				Invalidate();
+
+	//	Program
+	void				UseProgram(const GLuint program);
+	void				DeleteProgram(const GLuint program);
+
+	//	Textures
+	void				ActiveTexture(const GLenum texture_unit);
+	void				BindTexture(const GLenum target, const GLuint texture);
+	void				BindTexture(const GLenum target, const GLuint texture, const GLenum texture_unit);
+	void				DeleteTextures(const GLsizei count, const GLuint *textures);
+
+	//	Blend
+	void				SetBlend(const bool enable);
+	void				BlendFunc(const GLenum source_factor, const GLenum destination_factor);
+
+	//	Uniforms (current program)
+	void				Uniform1f(const GLint location, const GLfloat v0);
+	void				Uniform2f(const GLint location, const GLfloat v0, const GLfloat v1);
+	void				Uniform1i(const GLint location, const GLint v0);
+	void				Uniform2fv(const GLint location, const GLfloat *v);
+	void				Uniform3fv(const GLint location, const GLfloat *v);
+	void				Uniform4fv(const GLint location, const GLfloat *v);
+	void				UniformMatrix4fv(const GLint location, const GLfloat *m);
+
+	//	Statistics (calls sent to GL / redundant calls skipped)
+	void				ResetCounters()			{fCountCalls = 0; fCountSkipped = 0;}
+	const int			GetCallCount() const	{return fCountCalls;}
+	const int			GetSkippedCount() const	{return fCountSkipped;}
+
+private:
+	enum {kUnknown = 0xffffffff};
+	struct SHADOW_UNIFORM
+	{
+		GLenum			type;
+		bool			valid;
+		union
+		{
+			GLfloat		f[16];
+			GLint		i[4];
+		};
+	};
+	SHADOW_UNIFORM		*GetShadowUniform(const GLint location, const GLenum type);
+
+	GLuint				fProgram;
+	std::vector<SHADOW_UNIFORM>		*fProgramUniforms;
+	std::unordered_map<GLuint, std::vector<SHADOW_UNIFORM>>	fUniforms;
+
+	GLenum				fActiveTexture;
+	GLuint				fTexture2D[kMaxTextureUnits];
+	GLuint				fTexture3D[kMaxTextureUnits];
+
+	GLuint				fBlendEnabled;
+	GLenum				fBlendSource;
+	GLenum				fBlendDestination;
+
+	int					fCountCalls;
+	int					fCountSkipped;
+};
+
+extern YRenderState		yRenderState;
+
+};	//	namespace yrender
+
+#endif	//#ifndef __YARRA_RENDER_STATE_H__
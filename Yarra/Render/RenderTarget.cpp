@@ -9,6 +9,7 @@
 
 #include "Platform.h"
 #include "Texture.h"
+#include "RenderState.h"
 
 #include "RenderTarget.h"
 
@@ -85,7 +86,7 @@ YRenderTarget :: YRenderTarget(const GLuint internal_format, GLuint width, GLuin
 
 	glBindFramebuffer(GL_FRAMEBUFFER, fFrameBufferID);
 
-	glBindTexture(GL_TEXTURE_2D, fTexture);
+	yRenderState.BindTexture(GL_TEXTURE_2D, fTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, internal_format, (GLsizei)fWidth, (GLsizei)fHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -117,6 +118,8 @@ YRenderTarget :: YRenderTarget(const GLuint internal_format, GLuint width, GLuin
 		}
 	}
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	fTextureWrapper = new YTexture(fTexture, fWidth, fHeight, false);
 }
 
 /*	FUNCTION:		YRenderTarget :: ~YRenderTarget
@@ -126,9 +129,10 @@ YRenderTarget :: YRenderTarget(const GLuint internal_format, GLuint width, GLuin
 */
 YRenderTarget :: ~YRenderTarget()
 {
+	delete fTextureWrapper;
 	glDeleteFramebuffers(1, &fFrameBufferID);
 	glDeleteRenderbuffers(1, &fRenderBufferID);
-	glDeleteTextures(1, &fTexture);
+	yRenderState.DeleteTextures(1, &fTexture);
 }
 
 /*	FUNCTION:		YRenderTarget :: Activate
@@ -184,8 +188,25 @@ void YRenderTarget :: Deactivate()
 */
 void YRenderTarget :: BindTexture(const GLuint texture_unit)
 {
-	glActiveTexture(texture_unit);
-	glBindTexture(GL_TEXTURE_2D, fTexture);
+	yRenderState.BindTexture(GL_TEXTURE_2D, fTexture, texture_unit);
+}
+
+/*	FUNCTION:		YRenderTarget :: CopyTo
+	ARGUMENTS:		destination
+	RETURN:			n/a
+	DESCRIPTION:	GPU side copy (colour + depth) to destination target, no CPU readback
+*/
+void YRenderTarget :: CopyTo(YRenderTarget *destination)
+{
+	assert(destination && (destination != this));
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fFrameBufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination->fFrameBufferID);
+	glBlitFramebuffer(0, 0, (GLint)fWidth, (GLint)fHeight, 0, 0, (GLint)destination->fWidth, (GLint)destination->fHeight,
+					  GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	YRenderTarget *current = GetCurrentRenderTarget();
+	glBindFramebuffer(GL_FRAMEBUFFER, current ? current->fFrameBufferID : 0);
 }
 
 };	//	namespace yrender
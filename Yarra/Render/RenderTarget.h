@@ -9,6 +9,8 @@
 
 namespace yrender
 {
+
+class YTexture;
 	
 /*********************************
 	Render target
@@ -22,6 +24,8 @@ class YRenderTarget
 	GLuint		fWidth; 
 	GLuint		fHeight;
 
+	YTexture	*fTextureWrapper;		//	non owning YTexture of colour attachment
+
 public:
 				YRenderTarget(const GLuint internal_format = GL_RGBA, GLuint width = 1920, GLuint height = 1080);
 				~YRenderTarget();
@@ -30,6 +34,10 @@ public:
 	void		ActivateTransparentBuffer();
 	void		Deactivate();
 	void		BindTexture(const GLuint texture_unit = 0);
+	void		CopyTo(YRenderTarget *destination);
+	YTexture	*GetTexture() {return fTextureWrapper;}
+	const GLuint	GetWidth() const	{return fWidth;}
+	const GLuint	GetHeight() const	{return fHeight;}
 
 /**********************************
 	Render target manager
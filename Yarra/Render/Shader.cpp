@@ -6,6 +6,8 @@
 */
 
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 
 #include "Yarra/Platform.h"
 #include "Yarra/FileManager.h"
@@ -13,6 +15,7 @@
 #include "SceneNode.h"
 #include "Shader.h"
 #include "MatrixStack.h"
+#include "RenderState.h"
 
 //	32 bit version of Mesa lacks OpenGL 4.3 definition of GL_PROGRAM
 #ifndef GL_PROGRAM
@@ -39,6 +42,86 @@ namespace yrender
 
 #define SHADER_VERBOSITY_LEVEL		0		/*	0 - only errors, 1 - info log	*/
 
+/*************************************
+	Program binary cache
+	File layout: PROGRAM_BINARY_HEADER followed by driver specific binary
+**************************************/
+std::string					YShader::sCacheDirectory;
+YShader::CACHE_STATISTICS	YShader::sCacheStatistics = {0, 0, 0.0, 0.0};
+
+static const uint32_t	kProgramBinaryMagic = 0x59504231;		//	'YPB1'
+static const uint32_t	kProgramBinaryMaxLength = 16*1024*1024;
+struct PROGRAM_BINARY_HEADER
+{
+	uint32_t	magic;
+	uint32_t	format;
+	uint32_t	length;
+	uint32_t	reserved;
+	uint64_t	key;
+};
+
+/*	FUNCTION:		ProgramBinaryHash
+	ARGUMENTS:		hash
+					text (including terminator, acts as separator)
+	RETURN:			updated hash
+	DESCRIPTION:	FNV-1a 64 bit
+*/
+static uint64_t ProgramBinaryHash(uint64_t hash, const char *text)
+{
+	if (!text)
+		text = "";
+	do
+	{
+		hash ^= (uint8_t)*text;
+		hash *= 0x100000001b3ULL;
+	} while (*text++);
+	return hash;
+}
+
+/*	FUNCTION:		ProgramBinaryKey
+	ARGUMENTS:		attribute_binding
+					vertex_shader_source_text
+					fragment_shader_source_text
+					fragdata_binding
+	RETURN:			cache key
+	DESCRIPTION:	Hash of everything which affects the linked program (GL context must be current)
+*/
+static uint64_t ProgramBinaryKey(const std::vector<std::string> *attribute_binding,
+								 const char *vertex_shader_source_text,
+								 const char *fragment_shader_source_text,
+								 const std::vector<std::string> *fragdata_binding)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	hash = ProgramBinaryHash(hash, (const char *)glGetString(GL_VENDOR));
+	hash = ProgramBinaryHash(hash, (const char *)glGetString(GL_RENDERER));
+	hash = ProgramBinaryHash(hash, (const char *)glGetString(GL_VERSION));
+	hash = ProgramBinaryHash(hash, kGLSLVersion);
+	hash = ProgramBinaryHash(hash, vertex_shader_source_text);
+	hash = ProgramBinaryHash(hash, fragment_shader_source_text);
+	for (auto &i : *attribute_binding)
+		hash = ProgramBinaryHash(hash, i.c_str());
+	hash = ProgramBinaryHash(hash, "#");
+	if (fragdata_binding)
+	{
+		for (auto &i : *fragdata_binding)
+			hash = ProgramBinaryHash(hash, i.c_str());
+	}
+	return hash;
+}
+
+/*	FUNCTION:		ProgramBinaryFilename
+	ARGUMENTS:		directory
+					key
+	RETURN:			cache filename
+	DESCRIPTION:	One file per program
+*/
+static std::string ProgramBinaryFilename(const std::string &directory, const uint64_t key)
+{
+	char buffer[32];
+	sprintf(buffer, "/%016llx.bin", (unsigned long long)key);
+	return directory + buffer;
+}
+
 /*	FUNCTION:		YBuffer_ReadFileToMemory
 	ARGUMENTS:		filename
 					filesize
@@ -185,6 +268,20 @@ YShader :: YShader(	const std::vector<std::string> *attribute_binding,
 	fProgram = 0;
 	fNumberAttributes = 0;
 
+	//	Program binary cache
+	const double start_time = yplatform::GetElapsedTime();
+	uint64_t cache_key = 0;
+	if (!sCacheDirectory.empty() && vertex_shader_source_text && fragment_shader_source_text)
+	{
+		cache_key = ProgramBinaryKey(attribute_binding, vertex_shader_source_text, fragment_shader_source_text, fragdata_binding);
+		if (LoadProgramBinary(cache_key, attribute_binding))
+		{
+			sCacheStatistics.loaded++;
+			sCacheStatistics.load_time += yplatform::GetElapsedTime() - start_time;
+			return;
+		}
+	}
+
 	GLuint vertex_object = 0, fragment_object = 0;
 	bool success;
 	do 
@@ -218,6 +315,13 @@ YShader :: YShader(	const std::vector<std::string> *attribute_binding,
 
 	FreeObject(vertex_object);
 	FreeObject(fragment_object);
+
+	if (!fProgram)
+		return;		//	missing shader source
+	if (cache_key)
+		SaveProgramBinary(cache_key);
+	sCacheStatistics.compiled++;
+	sCacheStatistics.compile_time += yplatform::GetElapsedTime() - start_time;
 }
 
 /*	FUNCTION:		YShader :: ~YShader
@@ -239,9 +343,7 @@ YShader :: ~YShader()
 void YShader :: EnableProgram()
 {
 	if (fProgram)
-	{
-		glUseProgram(fProgram);
-	}
+		yRenderState.UseProgram(fProgram);
 }
 
 /*	FUNCTION:		YShader :: DisableProgram
@@ -252,7 +354,7 @@ void YShader :: EnableProgram()
 void YShader :: DisableProgram()
 {
 	if (fProgram)
-		glUseProgram(0);
+		yRenderState.UseProgram(0);
 }
 
 /****************************************************
@@ -422,7 +524,7 @@ YShader :: CreateProgram(const GLuint shader1, const GLuint shader2,
 	{
 		yplatform::Debug("YShader::CreateProgram() - exceeded GL_MAX_VERTEX_ATTRIBS (count=%d, max=%d)\n",
 			attributes->size(), maxVertexAttribs);
-		glDeleteProgram(fProgram);
+		yRenderState.DeleteProgram(fProgram);
 		fProgram = 0;
 		throw(GL_PROGRAM);
 	}
@@ -461,6 +563,11 @@ YShader :: CreateProgram(const GLuint shader1, const GLuint shader2,
 	if (shader2)
 		glAttachShader(fProgram, shader2);
 
+#if !defined (GL_ES_VERSION_2_0)
+	if (!sCacheDirectory.empty())
+		glProgramParameteri(fProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+
 	//	Link program object
 	glLinkProgram(fProgram);
 
@@ -471,7 +578,7 @@ YShader :: CreateProgram(const GLuint shader1, const GLuint shader2,
 	if (!linked)
 	{
 		PrintProgramInfoLog();
-		glDeleteProgram(fProgram);
+		yRenderState.DeleteProgram(fProgram);
 		fProgram = 0;
 		throw(GL_PROGRAM);
 	}
@@ -496,10 +603,135 @@ YShader :: FreeProgram()
 {
 	//	TODO need to detach shaders first
 	if (fProgram)
-		glDeleteProgram(fProgram);
+		yRenderState.DeleteProgram(fProgram);
 	fProgram = 0;
 }
 
+/****************************************************
+	Program binary cache
+*****************************************************/
+
+/*	FUNCTION:		YShader :: SetProgramBinaryCache
+	ARGUMENTS:		directory (must exist, nullptr to disable)
+	RETURN:			n/a
+	DESCRIPTION:	Enable program binary cache.  Call before creating shaders.
+*/
+void YShader :: SetProgramBinaryCache(const char *directory)
+{
+	if (directory)
+		sCacheDirectory.assign(directory);
+	else
+		sCacheDirectory.clear();
+}
+
+/*	FUNCTION:		YShader :: LoadProgramBinary
+	ARGUMENTS:		key
+					attribute_binding
+	RETURN:			true if program created from cache
+	DESCRIPTION:	Create program with glProgramBinary().
+					Binaries rejected by the driver are removed from the cache.
+*/
+const bool YShader :: LoadProgramBinary(const uint64_t key, const std::vector<std::string> *attribute_binding)
+{
+#if defined (GL_ES_VERSION_2_0)
+	return false;
+#else
+	assert(fProgram == 0);
+
+	static GLint number_formats = -1;
+	if (number_formats < 0)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &number_formats);
+	if (number_formats <= 0)
+	{
+		sCacheDirectory.clear();	//	driver doesn't support program binaries
+		return false;
+	}
+
+	std::string filename = ProgramBinaryFilename(sCacheDirectory, key);
+	FILE *file = fopen(filename.c_str(), "rb");
+	if (!file)
+		return false;
+
+	PROGRAM_BINARY_HEADER header;
+	std::vector<uint8_t> binary;
+	bool valid = (fread(&header, sizeof(PROGRAM_BINARY_HEADER), 1, file) == 1) &&
+				 (header.magic == kProgramBinaryMagic) && (header.key == key) &&
+				 (header.length > 0) && (header.length <= kProgramBinaryMaxLength);
+	if (valid)
+	{
+		binary.resize(header.length);
+		valid = (fread(binary.data(), 1, header.length, file) == header.length);
+	}
+	fclose(file);
+
+	if (valid)
+	{
+		fProgram = glCreateProgram();
+		glProgramBinary(fProgram, header.format, binary.data(), header.length);
+		GLint linked = GL_FALSE;
+		glGetProgramiv(fProgram, GL_LINK_STATUS, &linked);
+		while (glGetError() != GL_NO_ERROR) ;		//	format rejected (eg. driver update)
+		if (linked != GL_TRUE)
+		{
+			yRenderState.DeleteProgram(fProgram);
+			fProgram = 0;
+			valid = false;
+		}
+	}
+	if (!valid)
+	{
+		yplatform::Debug("YShader::LoadProgramBinary(%s) stale binary\n", filename.c_str());
+		remove(filename.c_str());
+		return false;
+	}
+
+	fNumberAttributes = (GLuint)attribute_binding->size();
+	return true;
+#endif
+}
+
+/*	FUNCTION:		YShader :: SaveProgramBinary
+	ARGUMENTS:		key
+	RETURN:			n/a
+	DESCRIPTION:	Store linked program with glGetProgramBinary().
+					Written to temporary file and renamed, so readers never see a partial binary.
+*/
+void YShader :: SaveProgramBinary(const uint64_t key)
+{
+#if !defined (GL_ES_VERSION_2_0)
+	assert(fProgram != 0);
+
+	GLint length = 0;
+	glGetProgramiv(fProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+	if ((length <= 0) || (length > (GLint)kProgramBinaryMaxLength))
+		return;
+
+	std::vector<uint8_t> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(fProgram, length, &length, &format, binary.data());
+	if ((glGetError() != GL_NO_ERROR) || (length <= 0))
+		return;
+
+	PROGRAM_BINARY_HEADER header;
+	memset(&header, 0, sizeof(PROGRAM_BINARY_HEADER));
+	header.magic = kProgramBinaryMagic;
+	header.format = format;
+	header.length = (uint32_t)length;
+	header.key = key;
+
+	std::string filename = ProgramBinaryFilename(sCacheDirectory, key);
+	std::string temp_filename = filename + ".tmp";
+	FILE *file = fopen(temp_filename.c_str(), "wb");
+	if (!file)
+		return;
+	bool valid = (fwrite(&header, sizeof(PROGRAM_BINARY_HEADER), 1, file) == 1) &&
+				 (fwrite(binary.data(), 1, length, file) == (size_t)length);
+	fclose(file);
+	if (!valid || (rename(temp_filename.c_str(), filename.c_str()) != 0))
+		remove(temp_filename.c_str());
+#endif
+}
+
 /****************************************************
 	Source management
 *****************************************************/
@@ -19,6 +19,10 @@
 #include <vector>
 #endif
 
+#ifndef _GLIBCXX_CSTDINT
+#include <cstdint>
+#endif
+
 namespace yrender
 {
 	
@@ -32,6 +36,10 @@ namespace yrender
 		YShader("vertex_shader.vs", "fragement_shader.fs", &attributes);
 	Obviously, the attribute indices will correspond to the attribute order.
 	The fragdata binding defaults to "out vec4 fragColour"
+	Programs created from source text can be cached as program binaries
+	(glProgramBinary), see SetProgramBinaryCache().  The cache key is a hash
+	of the sources, bindings and driver strings, invalid or stale binaries
+	fall back to source compilation.
 *****************************************************************/
 class YShader
 {
@@ -69,8 +77,24 @@ public:
 	void				FreeObject(const GLuint id);
 	void				FreeProgram();
 	const GLuint		GetProgram() {return fProgram;}
+
+	//	Program binary cache (directory must exist, nullptr disables cache)
+	static void			SetProgramBinaryCache(const char *directory);
+	struct CACHE_STATISTICS
+	{
+		int				compiled;			//	linked from source (failures not counted)
+		int				loaded;				//	created from program binary cache
+		double			compile_time;		//	seconds
+		double			load_time;			//	seconds
+	};
+	static const CACHE_STATISTICS	&GetCacheStatistics() {return sCacheStatistics;}
 	
 private:
+	const bool			LoadProgramBinary(const uint64_t key, const std::vector<std::string> *attribute_binding);
+	void				SaveProgramBinary(const uint64_t key);
+	static std::string		sCacheDirectory;
+	static CACHE_STATISTICS	sCacheStatistics;
+
 	char				*LoadSourceFile(const char *filename);
 	const bool			PrintShaderInfoLog(const GLuint obj);
 	void				PrintProgramInfoLog();
@@ -8,6 +8,7 @@
 
 #include "Yarra/Render/MatrixStack.h"
 #include "Yarra/Render/SceneNode.h"
+#include "Yarra/Render/RenderState.h"
 #include "Yarra/Render/Font.h"
 
 namespace yrender
@@ -20,7 +21,7 @@ namespace yrender
 	DESCRIPTION:	Constructor
 */
 YTextScene :: YTextScene(YFont *font, bool acquire_font_ownership)
-	: fFont(font), fAcquireFontOwnership(acquire_font_ownership), fGeometryNode(nullptr),
+	: fFont(font), fAcquireFontOwnership(acquire_font_ownership),
 	fHorizontalAlignment(ALIGN_HCENTER), fVerticalAlignment(ALIGN_VCENTER) 
 {
 	assert(font != nullptr);
@@ -35,7 +36,6 @@ YTextScene :: YTextScene(YFont *font, bool acquire_font_ownership)
 */
 YTextScene :: ~YTextScene()
 {
-	delete fGeometryNode;
 	if (fAcquireFontOwnership)
 		delete fFont;
 }
@@ -43,7 +43,7 @@ YTextScene :: ~YTextScene()
 /*	FUNCTION:		YTextScene :: SetText
 	ARGUMENTS:		text
 	RETURN:			n/a
-	DESCRIPTION:	Set text
+	DESCRIPTION:	Set text (geometry is owned by font layout cache)
 */
 void YTextScene :: SetText(const char *text)
 {
@@ -51,9 +51,7 @@ void YTextScene :: SetText(const char *text)
 		return;
 
 	fText.assign(text);
-	
-	delete fGeometryNode;
-	fGeometryNode = fFont->CreateGeometry(text);
+	fFont->GetGeometry(text);
 	fGeometrySize = fFont->GetGeometrySize();
 }
 
@@ -74,10 +72,12 @@ void YTextScene :: SetColour(const YVector4 &colour)
 */
 void YTextScene :: Render(float delta_time)
 {
-	if (fGeometryNode == nullptr)
+	//	Layout may have been evicted / rebuilt since SetText()
+	YGeometryNode *geometry_node = fFont->GetGeometry(fText.c_str());
+	if (geometry_node == nullptr)
 		return;
 
-	glEnable(GL_BLEND);
+	yRenderState.SetBlend(true);
 	yMatrixStack.Push();
 	mSpatial.Transform();
 
@@ -97,7 +97,11 @@ void YTextScene :: Render(float delta_time)
 	yMatrixStack.Translate(offset.x, offset.y, offset.z);
 
 	fFont->PreRender(fColour);
-	fGeometryNode->Render(delta_time);
+	geometry_node->Render(delta_time);
+
+	//	Text with more glyphs than fit in the glyph atlas is drawn in parts
+	while ((geometry_node = fFont->GetNextGeometry()) != nullptr)
+		geometry_node->Render(delta_time);
 	yMatrixStack.Pop();
 //	glDisable(GL_BLEND);
 }
@@ -10,6 +10,7 @@
 
 #include "Yarra/Platform.h"
 #include "Texture.h"
+#include "RenderState.h"
 
 namespace yrender
 {
@@ -45,6 +46,23 @@ YTexture :: YTexture(const char *filename, const unsigned int texture_flags)
 }
 
 /*	FUNCTION:		YTexture :: YTexture
+	ARGUMENTS:		texture_id
+					width
+					height
+					take_ownership
+	RETURN:			n/a
+	DESCRIPTION:	Constructor, wrap existing texture (eg. render target colour attachment)
+*/
+YTexture :: YTexture(const GLuint texture_id, const unsigned int width, const unsigned int height, const bool take_ownership)
+	: fTextureId(texture_id), fOwnsTexture(take_ownership)
+{
+	fWidth = width;
+	fHeight = height;
+	fActiveTexture = GL_TEXTURE0;
+	fInternalFormat = GL_RGBA;
+}
+
+/*	FUNCTION:		YTexture :: Init
 	ARGUMENTS:		width
 					height
 	RETURN:			n/a
@@ -56,9 +74,10 @@ void YTexture :: Init(const unsigned int width, const unsigned int height, const
 	fHeight = height;
 	fActiveTexture = GL_TEXTURE0;
 	fInternalFormat = GL_RGBA;
+	fOwnsTexture = true;
 
 	glGenTextures(1, &fTextureId);
-	glBindTexture(GL_TEXTURE_2D, fTextureId);
+	yRenderState.BindTexture(GL_TEXTURE_2D, fTextureId);
 	
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture_flags & YTF_MAG_FILTER_NEAREST ? GL_NEAREST : GL_LINEAR);		
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture_flags & YTF_MIN_FILTER_NEAREST ? GL_NEAREST : GL_LINEAR);
@@ -120,8 +139,7 @@ void YTexture :: Upload(BBitmap *bitmap)
 	return;
 #endif
 	
-	glActiveTexture(fActiveTexture);
-	glBindTexture(GL_TEXTURE_2D, fTextureId);
+	yRenderState.BindTexture(GL_TEXTURE_2D, fTextureId, fActiveTexture);
 	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, fInternalFormat, GL_UNSIGNED_BYTE, bitmap->Bits());
 }
 
@@ -144,7 +162,8 @@ void YTexture :: Upload(const char *filename)
 */
 YTexture :: ~YTexture()
 {
-	glDeleteTextures(1, &fTextureId);	
+	if (fOwnsTexture)
+		yRenderState.DeleteTextures(1, &fTextureId);
 }
 
 /*	FUNCTION:		YTexture :: Render
@@ -154,8 +173,7 @@ YTexture :: ~YTexture()
 */
 void YTexture :: Render(float delta_time)
 {
-	glActiveTexture(fActiveTexture);
-	glBindTexture(GL_TEXTURE_2D, fTextureId);	
+	yRenderState.BindTexture(GL_TEXTURE_2D, fTextureId, fActiveTexture);
 }
 
 };	//	namespace yrender
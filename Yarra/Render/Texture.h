@@ -31,6 +31,7 @@ public:
 	};
 			YTexture(const unsigned int width, const unsigned int height, const unsigned int texture_flags = 0);
 			YTexture(const char *filename, const unsigned int texture_flags = 0);
+			YTexture(const GLuint texture_id, const unsigned int width, const unsigned int height, const bool take_ownership);
 			~YTexture();
 	void	SetTextureUnitIndex(const unsigned int index) {fActiveTexture = (GLenum) (GL_TEXTURE0 + index);}
 	void	Upload(BBitmap *bitmap);
@@ -39,9 +40,11 @@ public:
 	
 	const unsigned int	GetWidth() const	{return fWidth;}
 	const unsigned int	GetHeight() const	{return fHeight;}
+	const GLuint		GetTextureId() const {return fTextureId;}
 	
 private:
 	GLuint			fTextureId;
+	bool			fOwnsTexture;
 	GLenum			fInternalFormat;
 	GLenum			fActiveTexture;
 	unsigned int	fWidth;